@@ -194,87 +194,120 @@ BOOST_PYTHON_MODULE(freeOrionAIInterface)
 //     PythonAI     //
 //////////////////////
 static dict         s_main_namespace = dict();
-static object       s_ai_module = object();
-static PythonAI*    s_ai = 0;
+static std::string  s_ai_path;
+static PythonAI*    s_current_ai = 0;       // the PythonAI whose script modules are in sys.modules
+static int          s_num_ais = 0;
+static bool         s_python_initialized = false;
 #ifdef FREEORION_MACOSX
 #include <sys/param.h>
 static char         s_python_home[MAXPATHLEN];
 static char         s_python_program_name[MAXPATHLEN];
 #endif
-PythonAI::PythonAI() {
-    Logger().debugStream() << "PythonAI::PythonAI()";
-    // in order to expose a getter for it to Python, s_save_state_string must be static, and not a member
-    // variable of class PythonAI, because the exposing is done outside the PythonAI class and there is no
-    // access to a pointer to PythonAI
-    if (s_ai)
-        throw std::runtime_error("Attempted to create more than one Python AI instance");
-
-    s_ai = this;
 
-    try {
+namespace {
+    /** Starts the Python interpreter shared by all PythonAIs, and returns
+      * true iff it is ready to import the AI scripts. */
+    bool InitializePython() {
+        try {
 #ifdef FREEORION_MACOSX
-        strcpy(s_python_home, GetPythonHome().string().c_str());
-        Py_SetPythonHome(s_python_home);
-        Logger().debugStream() << "Python home set to " << Py_GetPythonHome();
+            strcpy(s_python_home, GetPythonHome().string().c_str());
+            Py_SetPythonHome(s_python_home);
+            Logger().debugStream() << "Python home set to " << Py_GetPythonHome();
 
-        strcpy(s_python_program_name, (GetPythonHome() / "Python").string().c_str());
-        Py_SetProgramName(s_python_program_name);
-        Logger().debugStream() << "Python program name set to " << Py_GetProgramFullPath();
+            strcpy(s_python_program_name, (GetPythonHome() / "Python").string().c_str());
+            Py_SetProgramName(s_python_program_name);
+            Logger().debugStream() << "Python program name set to " << Py_GetProgramFullPath();
 #endif
-        Py_Initialize();                // initializes Python interpreter, allowing Python functions to be called from C++
-        Logger().debugStream() << "Python initialized";
-
-        Logger().debugStream() << "Python version: " << Py_GetVersion();
-        Logger().debugStream() << "Python prefix: " << Py_GetPrefix();
-        Logger().debugStream() << "Python module search path: " << Py_GetPath();
-
-        Logger().debugStream() << "Initializing C++ interfaces for Python";
-
-        initfreeOrionLogger();          // allows the "freeOrionLogger" C++ module to be imported within Python code
-        initfreeOrionAIInterface();     // allows the "freeOrionAIInterface" C++ module to be imported within Python code
-    } catch (...) {
-        Logger().errorStream() << "Unable to initialize Python interpreter.";
-        return;
+            Py_Initialize();                // initializes Python interpreter, allowing Python functions to be called from C++
+            Logger().debugStream() << "Python initialized";
+
+            Logger().debugStream() << "Python version: " << Py_GetVersion();
+            Logger().debugStream() << "Python prefix: " << Py_GetPrefix();
+            Logger().debugStream() << "Python module search path: " << Py_GetPath();
+
+            Logger().debugStream() << "Initializing C++ interfaces for Python";
+
+            initfreeOrionLogger();          // allows the "freeOrionLogger" C++ module to be imported within Python code
+            initfreeOrionAIInterface();     // allows the "freeOrionAIInterface" C++ module to be imported within Python code
+        } catch (...) {
+            Logger().errorStream() << "Unable to initialize Python interpreter.";
+            return false;
+        }
+
+        try {
+            // get main namespace, needed to run other interpreted code
+            object main_module = import("__main__");
+            s_main_namespace = extract<dict>(main_module.attr("__dict__"));
+        } catch (error_already_set err) {
+            Logger().errorStream() << "Unable to set up main namespace in Python.";
+            PyErr_Print();
+            return false;
+        }
+
+        try {
+            // set up Logging by redirecting stdout and stderr to exposed logging functions
+            std::string logger_script = "import sys\n"
+                                        "import freeOrionLogger\n"
+                                        "class debugLogger:\n"
+                                        "  def write(self, stng):\n"
+                                        "    freeOrionLogger.log(stng)\n"
+                                        "class errorLogger:\n"
+                                        "  def write(self, stng):\n"
+                                        "    freeOrionLogger.error(stng)\n"
+                                        "sys.stdout = debugLogger()\n"
+                                        "sys.stderr = errorLogger()\n"
+                                        "print ('Python stdout and stderr redirected')";
+            object ignored = exec(logger_script.c_str(), s_main_namespace, s_main_namespace);
+        } catch (error_already_set err) {
+            Logger().errorStream() << "Unable to redirect Python stdout and stderr.";
+            return false;
+        }
+
+        try {
+            // tell Python the path in which to locate AI script file
+            s_ai_path = (GetResourceDir() / "AI").string();
+            std::string path_command = "sys.path.append(r'" + s_ai_path + "')";
+            object ignored = exec(path_command.c_str(), s_main_namespace, s_main_namespace);
+
+            // removes the AI script modules from sys.modules and returns them,
+            // so that each PythonAI can have its own
+            std::string take_modules_script = "def takeAIModules(ai_path):\n"
+                                              "  taken = {}\n"
+                                              "  for name, module in sys.modules.items():\n"
+                                              "    if (getattr(module, '__file__', None) or '').startswith(ai_path):\n"
+                                              "      taken[name] = sys.modules.pop(name)\n"
+                                              "  return taken\n";
+            ignored = exec(take_modules_script.c_str(), s_main_namespace, s_main_namespace);
+        } catch (error_already_set err) {
+            PyErr_Print();
+            return false;
+        }
+        return true;
     }
+}
 
-    try {
-        // get main namespace, needed to run other interpreted code
-        object main_module = import("__main__");
-        s_main_namespace = extract<dict>(main_module.attr("__dict__"));
-    } catch (error_already_set err) {
-        Logger().errorStream() << "Unable to set up main namespace in Python.";
-        PyErr_Print();
+PythonAI::PythonAI() :
+    m_ai_module(),
+    m_modules(),
+    m_save_state_string()
+{
+    Logger().debugStream() << "PythonAI::PythonAI()";
+    // in order to expose a getter for it to Python, s_save_state_string must be static, and not a member
+    // variable of class PythonAI, because the exposing is done outside the PythonAI class and there is no
+    // access to a pointer to PythonAI.  The current PythonAI's string is kept in it.
+    if (!s_num_ais++)
+        s_python_initialized = InitializePython();
+    if (!s_python_initialized)
         return;
-    }
 
-    try {
-        // set up Logging by redirecting stdout and stderr to exposed logging functions
-        std::string logger_script = "import sys\n"
-                                    "import freeOrionLogger\n"
-                                    "class debugLogger:\n"
-                                    "  def write(self, stng):\n"
-                                    "    freeOrionLogger.log(stng)\n"
-                                    "class errorLogger:\n"
-                                    "  def write(self, stng):\n"
-                                    "    freeOrionLogger.error(stng)\n"
-                                    "sys.stdout = debugLogger()\n"
-                                    "sys.stderr = errorLogger()\n"
-                                    "print ('Python stdout and stderr redirected')";
-        object ignored = exec(logger_script.c_str(), s_main_namespace, s_main_namespace);
-    } catch (error_already_set err) {
-        Logger().errorStream() << "Unable to redirect Python stdout and stderr.";
-        return;
-    }
+    MakeCurrent();
 
     try {
-        // tell Python the path in which to locate AI script file
-        std::string AI_path = (GetResourceDir() / "AI").string();
-        std::string path_command = "sys.path.append(r'" + AI_path + "')";
-        object ignored = exec(path_command.c_str(), s_main_namespace, s_main_namespace);
-
-        // import AI script file and run initialization function
-        s_ai_module = import("FreeOrionAI");
-        object initAIPythonFunction = s_ai_module.attr("initFreeOrionAI");
+        // import AI script file and run initialization function.  As the
+        // script modules of any other PythonAI have been taken out of
+        // sys.modules, this AI gets new ones.
+        m_ai_module = import("FreeOrionAI");
+        object initAIPythonFunction = m_ai_module.attr("initFreeOrionAI");
         initAIPythonFunction();
 
         //ignored = exec(fo_interface_import_script.c_str(), s_main_namespace, s_main_namespace);
@@ -288,13 +321,47 @@ PythonAI::PythonAI() {
 
 PythonAI::~PythonAI() {
     Logger().debugStream() << "Cleaning up / destructing Python AI";
+    m_ai_module = object();
+    m_modules = object();
+    if (s_current_ai == this) {
+        s_current_ai = 0;
+        if (s_python_initialized && 1 < s_num_ais) {
+            // drop this AI's modules, so that they aren't taken for another's
+            try {
+                s_main_namespace["takeAIModules"](s_ai_path);
+            } catch (error_already_set err) {
+                PyErr_Print();
+            }
+        }
+    }
+    if (--s_num_ais)
+        return;
     Py_Finalize();      // stops Python interpreter and release its resources
-    s_ai = 0;
+    s_python_initialized = false;
     s_main_namespace = dict();
-    s_ai_module = object();
+}
+
+void PythonAI::MakeCurrent() {
+    if (s_current_ai == this || !s_python_initialized)
+        return;
+    try {
+        object taken = s_main_namespace["takeAIModules"](s_ai_path);
+        if (s_current_ai) {
+            s_current_ai->m_modules = taken;
+            s_current_ai->m_save_state_string = s_save_state_string;
+        }
+        if (m_modules.ptr() != Py_None)
+            import("sys").attr("modules").attr("update")(m_modules);
+        m_modules = object();
+        s_save_state_string = m_save_state_string;
+        s_current_ai = this;
+    } catch (error_already_set err) {
+        PyErr_Print();
+    }
 }
 
 void PythonAI::GenerateOrders() {
+    MakeCurrent();
     Logger().debugStream() << "PythonAI::GenerateOrders : initializing turn";
     AIInterface::InitTurn();
 
@@ -302,7 +369,7 @@ void PythonAI::GenerateOrders() {
     try {
         // call Python function that generates orders for current turn
         //Logger().debugStream() << "PythonAI::GenerateOrders : getting generate orders object";
-        object generateOrdersPythonFunction = s_ai_module.attr("generateOrders");
+        object generateOrdersPythonFunction = m_ai_module.attr("generateOrders");
         //Logger().debugStream() << "PythonAI::GenerateOrders : generating orders";
         generateOrdersPythonFunction();
     } catch (error_already_set err) {
@@ -321,9 +388,10 @@ void PythonAI::GenerateCombatOrders(const CombatData& combat_data)
 { AIBase::GenerateCombatOrders(combat_data); }
 
 void PythonAI::HandleChatMessage(int sender_id, const std::string& msg) {
+    MakeCurrent();
     try {
         // call Python function that responds or ignores a chat message
-        object handleChatMessagePythonFunction = s_ai_module.attr("handleChatMessage");
+        object handleChatMessagePythonFunction = m_ai_module.attr("handleChatMessage");
         handleChatMessagePythonFunction(sender_id, msg);
     } catch (error_already_set err) {
         PyErr_Print();
@@ -331,9 +399,10 @@ void PythonAI::HandleChatMessage(int sender_id, const std::string& msg) {
 }
 
 void PythonAI::HandleDiplomaticMessage(const DiplomaticMessage& msg) {
+    MakeCurrent();
     try {
         // call Python function to inform of diplomatic message change
-        object handleDiplomaticMessagePythonFunction = s_ai_module.attr("handleDiplomaticMessage");
+        object handleDiplomaticMessagePythonFunction = m_ai_module.attr("handleDiplomaticMessage");
         handleDiplomaticMessagePythonFunction(msg);
     } catch (error_already_set err) {
         PyErr_Print();
@@ -341,9 +410,10 @@ void PythonAI::HandleDiplomaticMessage(const DiplomaticMessage& msg) {
 }
 
 void PythonAI::HandleDiplomaticStatusUpdate(const DiplomaticStatusUpdateInfo& u) {
+    MakeCurrent();
     try {
         // call Python function to inform of diplomatic status update
-        object handleDiplomaticStatusUpdatePythonFunction = s_ai_module.attr("handleDiplomaticStatusUpdate");
+        object handleDiplomaticStatusUpdatePythonFunction = m_ai_module.attr("handleDiplomaticStatusUpdate");
         handleDiplomaticStatusUpdatePythonFunction(u);
     } catch (error_already_set err) {
         PyErr_Print();
@@ -351,10 +421,11 @@ void PythonAI::HandleDiplomaticStatusUpdate(const DiplomaticStatusUpdateInfo& u)
 }
 
 void PythonAI::StartNewGame() {
+    MakeCurrent();
     s_save_state_string = "";
     try {
         // call Python function that sets up the AI to be able to generate orders for a new game
-        object startNewGamePythonFunction = s_ai_module.attr("startNewGame");
+        object startNewGamePythonFunction = m_ai_module.attr("startNewGame");
         startNewGamePythonFunction(m_aggression);
     } catch (error_already_set err) {
         PyErr_Print();
@@ -362,11 +433,12 @@ void PythonAI::StartNewGame() {
 }
 
 void PythonAI::ResumeLoadedGame(const std::string& save_state_string) {
+    MakeCurrent();
     //Logger().debugStream() << "PythonAI::ResumeLoadedGame(" << save_state_string << ")";
     s_save_state_string = save_state_string;
     try {
         // call Python function that deals with the new state string sent by the server
-        object resumeLoadedGamePythonFunction = s_ai_module.attr("resumeLoadedGame");
+        object resumeLoadedGamePythonFunction = m_ai_module.attr("resumeLoadedGame");
         resumeLoadedGamePythonFunction(s_save_state_string);
     } catch (error_already_set err) {
         PyErr_Print();
@@ -374,10 +446,11 @@ void PythonAI::ResumeLoadedGame(const std::string& save_state_string) {
 }
 
 const std::string& PythonAI::GetSaveStateString() {
+    MakeCurrent();
     try {
         // call Python function that serializes AI state for storage in save file and sets s_save_state_string
         // to contain that string
-        object prepareForSavePythonFunction = s_ai_module.attr("prepareForSave");
+        object prepareForSavePythonFunction = m_ai_module.attr("prepareForSave");
         prepareForSavePythonFunction();
     } catch (error_already_set err) {
         PyErr_Print();
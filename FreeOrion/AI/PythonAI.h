@@ -4,6 +4,11 @@
 
 #include <string>
 
+/** AI implemented by the Python scripts in the AI resource directory.  A
+    process may have several PythonAIs, one for each AI player it hosts.  They
+    share one Python interpreter, but each imports its own copies of the AI
+    script modules, so that the module-level state of each AI is its own.
+    Calls to a PythonAI first make its modules the ones in sys.modules. */
 class PythonAI : public AIBase {
 public:
     /** \name structors */ //@{
@@ -20,4 +25,11 @@ public:
     virtual void                StartNewGame();
     virtual void                ResumeLoadedGame(const std::string& save_state_string);
     virtual const std::string&  GetSaveStateString();
+
+private:
+    void                        MakeCurrent();  ///< puts this AI's script modules in sys.modules, in place of those of the last current PythonAI
+
+    boost::python::object       m_ai_module;            ///< this AI's FreeOrionAI module
+    boost::python::object       m_modules;              ///< dict of this AI's script modules while another PythonAI is current, or None
+    std::string                 m_save_state_string;    ///< this AI's save state string while another PythonAI is current
 };
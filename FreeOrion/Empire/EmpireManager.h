@@ -15,6 +15,7 @@
 #include <string>
 
 class Empire;
+struct TurnUpdateBaseline;
 
 struct DiplomaticStatusUpdateInfo {
     DiplomaticStatusUpdateInfo();
@@ -56,6 +57,13 @@ public:
     const DiplomaticMessage&    GetDiplomaticMessage(int empire1, int empire2) const;
 
     std::string         Dump() const;
+
+    /** Writes to \a ar the empires that have changed since the state recorded
+      * in \a baseline, as serialized for the encoding empire, and records the
+      * new state in \a baseline.  Used for delta turn updates; see
+      * SerializeDelta in Serialize.h. */
+    template <class Archive>
+    void                SerializeDelta(Archive& ar, TurnUpdateBaseline& baseline) const;
     //@}
 
     /** \name Mutators */ //@{
@@ -89,6 +97,11 @@ public:
 
     /** Removes and deletes all empires from the manager. */
     void        Clear();
+
+    /** Applies changes written by SerializeDelta to this EmpireManager.
+      * Returns false if the result differs from what was serialized. */
+    template <class Archive>
+    bool        DeserializeDelta(Archive& ar);
     //@}
 
     typedef boost::signal<void (int, int)>  DiploSignalType;
@@ -0,0 +1,226 @@
+// -*- C++ -*-
+#ifndef _Benchmark_h_
+#define _Benchmark_h_
+
+#include "../util/OptionsDB.h"
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/function.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+/** Exit statuses shared by all benchmarks. */
+enum BenchmarkExitStatus {
+    BENCHMARK_SUCCESS = 0,
+    BENCHMARK_FAILURE = 1,  ///< bad command line, or the benchmark couldn't run
+    BENCHMARK_MISMATCH = 2  ///< the results differ from those expected
+};
+
+
+/** 64-bit FNV-1a hash of the values fed to it.  Benchmarks print one of these
+    over their results, so that changes can be checked for behaviour
+    regressions as well as for speed. */
+class Checksum {
+public:
+    Checksum() :
+        m_hash(14695981039346656037ULL)
+    {}
+
+    void Add(const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            m_hash ^= bytes[i];
+            m_hash *= 1099511628211ULL;
+        }
+    }
+    void Add(int i)
+    { Add(&i, sizeof(i)); }
+    void Add(float f)
+    { Add(&f, sizeof(f)); }
+    void Add(const Checksum& checksum)
+    { Add(&checksum.m_hash, sizeof(checksum.m_hash)); }
+
+    std::string ToString() const {
+        std::ostringstream stream;
+        stream << std::hex << std::setw(16) << std::setfill('0') << m_hash;
+        return stream.str();
+    }
+
+private:
+    boost::uint64_t m_hash;
+};
+
+/** Measures wall clock time since its construction. */
+class Stopwatch {
+public:
+    Stopwatch() :
+        m_start(boost::posix_time::microsec_clock::universal_time())
+    {}
+
+    double ElapsedSeconds() const {
+        boost::posix_time::time_duration elapsed =
+            boost::posix_time::microsec_clock::universal_time() - m_start;
+        return elapsed.total_microseconds() / 1.0e6;
+    }
+
+private:
+    boost::posix_time::ptime m_start;
+};
+
+/** The command line options of a benchmark.  Each option is declared with
+    the variable it sets and a description for the help text, and takes a
+    value unless it is a flag. */
+class BenchmarkArgs {
+public:
+    /** Called with the value of an option; throws std::invalid_argument or
+        boost::bad_lexical_cast if the value is unacceptable. */
+    typedef boost::function<void (const std::string&)> Handler;
+
+    explicit BenchmarkArgs(const std::string& program_name) :
+        m_program_name(program_name),
+        m_help_requested(false)
+    {}
+
+    const std::string& ProgramName() const
+    { return m_program_name; }
+
+    /** Declares option \a name, whose value is converted to a \a T and
+        stored in \a value. */
+    template <class T>
+    void Add(const std::string& name, T& value, const std::string& description)
+    { AddHandler(name, boost::bind(&Assign<T>, boost::ref(value), _1), description); }
+
+    /** Declares option \a name, whose value is passed to \a handler. */
+    void AddHandler(const std::string& name, const Handler& handler, const std::string& description)
+    { m_options.push_back(Option(name, handler, 0, description)); }
+
+    /** Declares option \a name, which takes no value, and sets \a value to
+        true if given. */
+    void AddFlag(const std::string& name, bool& value, const std::string& description)
+    { m_options.push_back(Option(name, Handler(), &value, description)); }
+
+    /** Declares --resource-dir, which sets the location of the content
+        files. */
+    void AddResourceDir()
+    { AddHandler("--resource-dir", &SetResourceDir, "location of the content files"); }
+
+    /** Sets the declared options from \a argv.  Returns false if help was
+        asked for, or an option is unknown, lacks its value or has an
+        unacceptable one. */
+    bool Parse(int argc, char* argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            if (arg == "-h" || arg == "--help") {
+                m_help_requested = true;
+                return false;
+            }
+            const Option* option = Find(arg);
+            if (!option) {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return false;
+            }
+            if (option->flag) {
+                *option->flag = true;
+                continue;
+            }
+            if (i + 1 == argc) {
+                std::cerr << "Missing value for " << arg << std::endl;
+                return false;
+            }
+            const std::string value = argv[++i];
+            try {
+                option->handler(value);
+            } catch (const boost::bad_lexical_cast&) {
+                std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+                return false;
+            } catch (const std::invalid_argument&) {
+                std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /** Prints the help text, and returns BENCHMARK_SUCCESS if it was asked
+        for, or the exit status for a bad command line otherwise. */
+    int Usage() const {
+        std::cout << "Usage: " << m_program_name << " [OPTION [VALUE]]...\n\n";
+        for (std::vector<Option>::const_iterator it = m_options.begin(); it != m_options.end(); ++it) {
+            std::string description = it->description;
+            for (std::string::size_type pos = 0; (pos = description.find('\n', pos)) != std::string::npos; pos += DESCRIPTION_COLUMN + 1)
+                description.insert(pos + 1, DESCRIPTION_COLUMN, ' ');
+            std::cout << "  " << std::left << std::setw(DESCRIPTION_COLUMN - 3) << it->name << " " << description << "\n";
+        }
+        std::cout << std::flush;
+        return m_help_requested ? BENCHMARK_SUCCESS : BENCHMARK_FAILURE;
+    }
+
+private:
+    enum { DESCRIPTION_COLUMN = 21 };
+
+    struct Option {
+        Option(const std::string& name_, const Handler& handler_, bool* flag_, const std::string& description_) :
+            name(name_),
+            handler(handler_),
+            flag(flag_),
+            description(description_)
+        {}
+
+        std::string name;
+        Handler     handler;
+        bool*       flag;       ///< set by flags, which have no handler
+        std::string description;
+    };
+
+    template <class T>
+    static void Assign(T& value, const std::string& text)
+    { value = boost::lexical_cast<T>(text); }
+
+    static void SetResourceDir(const std::string& dir)
+    { GetOptionsDB().Set<std::string>("resource-dir", dir); }
+
+    const Option* Find(const std::string& name) const {
+        for (std::vector<Option>::const_iterator it = m_options.begin(); it != m_options.end(); ++it) {
+            if (it->name == name)
+                return &*it;
+        }
+        return 0;
+    }
+
+    std::string         m_program_name;
+    std::vector<Option> m_options;
+    bool                m_help_requested;
+};
+
+/** Prints \a checksum, and returns BENCHMARK_MISMATCH if \a expected is
+    given and differs from it, or BENCHMARK_SUCCESS otherwise. */
+inline int CheckChecksum(const std::string& checksum, const std::string& expected) {
+    std::cout << "checksum: " << checksum << std::endl;
+    if (!expected.empty() && expected != checksum) {
+        std::cerr << "checksum mismatch: expected " << expected << std::endl;
+        return BENCHMARK_MISMATCH;
+    }
+    return BENCHMARK_SUCCESS;
+}
+
+/** Returns the exit status returned by \a benchmark, or BENCHMARK_FAILURE if
+    it throws, after reporting the exception as caught by \a program_name. */
+inline int RunBenchmark(const std::string& program_name, const boost::function<int ()>& benchmark) {
+    try {
+        return benchmark();
+    } catch (const std::exception& e) {
+        std::cerr << program_name << " caught exception: " << e.what() << std::endl;
+        return BENCHMARK_FAILURE;
+    }
+}
+
+#endif
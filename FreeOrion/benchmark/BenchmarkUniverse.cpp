@@ -0,0 +1,114 @@
+#include "BenchmarkUniverse.h"
+
+#include "Benchmark.h"
+
+#include "../Empire/Empire.h"
+#include "../Empire/EmpireManager.h"
+#include "../universe/Fleet.h"
+#include "../universe/Planet.h"
+#include "../universe/Ship.h"
+#include "../universe/ShipDesign.h"
+#include "../universe/System.h"
+#include "../util/AppInterface.h"
+
+#include <GG/Clr.h>
+
+#include <boost/lexical_cast.hpp>
+
+#include <cmath>
+#include <stdexcept>
+
+
+const int BENCHMARK_SYSTEM_ORBITS = 7;
+
+void CreateBenchmarkUniverse(int systems, int planets_per_system, int empires, int ships_per_empire) {
+    Universe& universe = GetUniverse();
+    EmpireManager& empire_manager = Empires();
+
+    const PredefinedShipDesignManager& predefined_designs = GetPredefinedShipDesignManager();
+    predefined_designs.AddShipDesignsToUniverse();
+    const int design_id = predefined_designs.GenericDesignID("SD_MARK_A1");
+    if (design_id == ShipDesign::INVALID_DESIGN_ID)
+        throw std::runtime_error("Unknown premade ship design: SD_MARK_A1");
+
+    for (int empire_id = 0; empire_id < empires; ++empire_id) {
+        const std::string id_string = boost::lexical_cast<std::string>(empire_id);
+        empire_manager.CreateEmpire(empire_id, "Empire " + id_string, "Player " + id_string,
+                                    GG::Clr(255, 255, 255, 255));
+    }
+
+    const int grid_width = static_cast<int>(std::ceil(std::sqrt(static_cast<double>(systems))));
+    std::vector<System*> grid;
+    for (int i = 0; i < systems; ++i) {
+        System* system = new System(STAR_YELLOW, BENCHMARK_SYSTEM_ORBITS,
+                                    "System " + boost::lexical_cast<std::string>(i),
+                                    100.0 * (i % grid_width), 100.0 * (i / grid_width));
+        universe.Insert(system);
+        grid.push_back(system);
+        if (i % grid_width) {
+            system->AddStarlane(grid[i - 1]->ID());
+            grid[i - 1]->AddStarlane(system->ID());
+        }
+        if (grid_width <= i) {
+            system->AddStarlane(grid[i - grid_width]->ID());
+            grid[i - grid_width]->AddStarlane(system->ID());
+        }
+
+        for (int orbit = 0; orbit < planets_per_system; ++orbit) {
+            Planet* planet = new Planet(PT_TERRAN, SZ_MEDIUM);
+            planet->Rename(system->Name() + " " + boost::lexical_cast<std::string>(orbit));
+            universe.Insert(planet);
+            system->Insert(planet, orbit);
+            planet->SetOwner((i * planets_per_system + orbit) % empires);
+            planet->GetMeter(METER_POPULATION)->Set(10.0, 10.0);
+            planet->GetMeter(METER_INDUSTRY)->Set(5.0, 5.0);
+            planet->GetMeter(METER_DEFENSE)->Set(15.0, 15.0);
+            planet->GetMeter(METER_SHIELD)->Set(15.0, 15.0);
+        }
+    }
+
+    // ships are in fleets of ten, each in the next system in turn
+    const int SHIPS_PER_FLEET = 10;
+    int fleet_system = 0;
+    for (int empire_id = 0; empire_id < empires; ++empire_id) {
+        Empire* empire = empire_manager.Lookup(empire_id);
+        Fleet* fleet = 0;
+        for (int i = 0; i < ships_per_empire; ++i) {
+            if (!(i % SHIPS_PER_FLEET)) {
+                System* system = grid[fleet_system++ % grid.size()];
+                fleet = new Fleet("Fleet", system->X(), system->Y(), empire_id);
+                universe.Insert(fleet);
+                system->Insert(fleet);
+            }
+            Ship* ship = new Ship(empire_id, design_id, "", empire_id);
+            ship->Rename(empire->NewShipName());
+            fleet->AddShip(universe.Insert(ship));
+        }
+    }
+
+    for (EmpireManager::iterator it = empire_manager.begin(); it != empire_manager.end(); ++it) {
+        for (ObjectMap::const_iterator<> obj_it = universe.Objects().const_begin();
+             obj_it != universe.Objects().const_end(); ++obj_it)
+        { universe.SetEmpireObjectVisibility(it->first, obj_it->ID(), VIS_PARTIAL_VISIBILITY); }
+    }
+    universe.UpdateEmpireLatestKnownObjectsAndVisibilityTurns();
+}
+
+std::string UniverseChecksum(const Universe& universe) {
+    Checksum checksum;
+    for (ObjectMap::const_iterator<> it = universe.Objects().const_begin();
+         it != universe.Objects().const_end(); ++it)
+    {
+        checksum.Add(it->ID());
+        checksum.Add(it->Owner());
+        checksum.Add(it->SystemID());
+        checksum.Add(static_cast<float>(it->X()));
+        checksum.Add(it->Name().data(), it->Name().size());
+    }
+    const std::vector<int> empire_ids = universe.EmpireKnownObjectsEmpireIDs();
+    for (std::vector<int>::const_iterator it = empire_ids.begin(); it != empire_ids.end(); ++it) {
+        checksum.Add(*it);
+        checksum.Add(universe.EmpireKnownObjects(*it).NumObjects());
+    }
+    return checksum.ToString();
+}
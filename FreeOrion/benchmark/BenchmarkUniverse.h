@@ -0,0 +1,27 @@
+// -*- C++ -*-
+#ifndef _BenchmarkUniverse_h_
+#define _BenchmarkUniverse_h_
+
+#include <string>
+
+class Universe;
+
+
+/** Creates \a empires empires, and in the universe a square grid of
+    \a systems systems joined by starlanes to their neighbours, each with
+    \a planets_per_system planets owned by the empires in turn, and
+    \a ships_per_empire ships for each empire in fleets spread over the
+    systems.  Every empire knows about every object.  Used by benchmarks that
+    need a universe of the size of a late game. */
+void CreateBenchmarkUniverse(int systems, int planets_per_system, int empires, int ships_per_empire);
+
+/** The largest number of planets per system CreateBenchmarkUniverse() can
+    create. */
+extern const int BENCHMARK_SYSTEM_ORBITS;
+
+/** Returns a checksum of the objects in \a universe and the number known to
+    each empire, which should be unchanged by serializing and deserializing
+    the universe. */
+std::string UniverseChecksum(const Universe& universe);
+
+#endif
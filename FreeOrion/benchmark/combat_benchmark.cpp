@@ -0,0 +1,344 @@
+/** Headless combat benchmark.  Builds a single system containing ships and
+    planets belonging to several mutually hostile empires, then repeatedly
+    auto-resolves combat there and, optionally, runs the OpenSteer
+    PathingEngine over the same ships.  Reports timings, heap allocation
+    counts, and a checksum of the results so that changes to the combat code
+    can be checked for both speed and behaviour regressions. */
+
+#include "Benchmark.h"
+
+#include "../combat/CombatSystem.h"
+#include "../combat/OpenSteer/CombatShip.h"
+#include "../Empire/Empire.h"
+#include "../Empire/EmpireManager.h"
+#include "../parse/Parse.h"
+#include "../server/ServerApp.h"
+#include "../universe/Fleet.h"
+#include "../universe/Planet.h"
+#include "../universe/Ship.h"
+#include "../universe/ShipDesign.h"
+#include "../universe/System.h"
+#include "../util/Directories.h"
+#include "../util/MultiplayerCommon.h"
+#include "../util/OptionsDB.h"
+
+#include <GG/Clr.h>
+
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation counting
+////////////////////////////////////////////////////////////////////////////////
+namespace {
+    bool                        g_count_allocations = false;
+    boost::detail::atomic_count g_allocations(0);
+
+    void* CountedAlloc(std::size_t size) {
+        if (g_count_allocations)
+            ++g_allocations;
+        void* retval = std::malloc(size ? size : 1);
+        if (!retval)
+            throw std::bad_alloc();
+        return retval;
+    }
+}
+
+void* operator new(std::size_t size) throw(std::bad_alloc)
+{ return CountedAlloc(size); }
+
+void* operator new[](std::size_t size) throw(std::bad_alloc)
+{ return CountedAlloc(size); }
+
+void operator delete(void* p) throw()
+{ std::free(p); }
+
+void operator delete[](void* p) throw()
+{ std::free(p); }
+
+
+namespace {
+    const int BENCHMARK_SYSTEM_ORBITS = 10;
+
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            empires(2),
+            ships_per_empire(50),
+            planets_per_empire(1),
+            iterations(100),
+            pathing_turns(0),
+            pathing_threads(1),
+            designs(1, "SD_MARK_A1"),
+            expected_checksum()
+        {}
+
+        int                         empires;
+        int                         ships_per_empire;
+        int                         planets_per_empire;
+        int                         iterations;
+        int                         pathing_turns;
+        int                         pathing_threads;
+        std::vector<std::string>    designs;
+        std::string                 expected_checksum;
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options) {
+        return 1 <= options.empires && 0 <= options.ships_per_empire &&
+            0 <= options.planets_per_empire && 0 <= options.iterations &&
+            0 <= options.pathing_turns && 1 <= options.pathing_threads && options.pathing_threads <= 64 &&
+            !options.designs.empty();
+    }
+
+    void SetDesigns(std::vector<std::string>& designs, const std::string& value) {
+        designs.clear();
+        boost::algorithm::split(designs, value, boost::algorithm::is_any_of(","));
+    }
+
+    /** Sets a ship's meters from its design, standing in for the effects
+        application the server would otherwise do. */
+    void InitShipMeters(Ship* ship) {
+        const ShipDesign* design = ship->Design();
+        ship->UniverseObject::GetMeter(METER_MAX_STRUCTURE)->Set(design->Structure(), design->Structure());
+        ship->UniverseObject::GetMeter(METER_STRUCTURE)->Set(design->Structure(), design->Structure());
+        ship->UniverseObject::GetMeter(METER_MAX_SHIELD)->Set(design->Shields(), design->Shields());
+        ship->UniverseObject::GetMeter(METER_SHIELD)->Set(design->Shields(), design->Shields());
+        ship->UniverseObject::GetMeter(METER_DETECTION)->Set(design->Detection(), design->Detection());
+        ship->UniverseObject::GetMeter(METER_BATTLE_SPEED)->Set(design->BattleSpeed(), design->BattleSpeed());
+
+        const std::vector<std::string>& parts = design->Parts();
+        for (std::vector<std::string>::const_iterator it = parts.begin(); it != parts.end(); ++it) {
+            const PartType* part = GetPartType(*it);
+            if (!part || (part->Class() != PC_SHORT_RANGE && part->Class() != PC_POINT_DEFENSE))
+                continue;
+            const DirectFireStats& stats = boost::get<DirectFireStats>(part->Stats());
+            ship->GetPartMeter(METER_DAMAGE, *it)->Set(stats.m_damage, stats.m_damage);
+            ship->GetPartMeter(METER_ROF, *it)->Set(stats.m_ROF, stats.m_ROF);
+            ship->GetPartMeter(METER_RANGE, *it)->Set(stats.m_range, stats.m_range);
+        }
+    }
+
+    /** Creates the empires, and a system containing their ships and planets.
+        Returns the id of the system. */
+    int CreateScenario(const BenchmarkOptions& options) {
+        Universe& universe = GetUniverse();
+        EmpireManager& empires = Empires();
+
+        const PredefinedShipDesignManager& predefined_designs = GetPredefinedShipDesignManager();
+        predefined_designs.AddShipDesignsToUniverse();
+        std::vector<int> design_ids;
+        for (std::vector<std::string>::const_iterator it = options.designs.begin(); it != options.designs.end(); ++it) {
+            int design_id = predefined_designs.GenericDesignID(*it);
+            if (design_id == ShipDesign::INVALID_DESIGN_ID)
+                throw std::runtime_error("Unknown premade ship design: " + *it);
+            design_ids.push_back(design_id);
+        }
+
+        System* system = new System(STAR_YELLOW, BENCHMARK_SYSTEM_ORBITS, "Benchmark", 0.0, 0.0);
+        int system_id = universe.Insert(system);
+
+        int orbit = 0;
+        for (int empire_id = 0; empire_id < options.empires; ++empire_id) {
+            Empire* empire = empires.CreateEmpire(empire_id, "Empire " + boost::lexical_cast<std::string>(empire_id),
+                                                  "Player " + boost::lexical_cast<std::string>(empire_id),
+                                                  GG::Clr(255, 255, 255, 255));
+
+            Fleet* fleet = new Fleet("Fleet", system->X(), system->Y(), empire_id);
+            universe.Insert(fleet);
+            system->Insert(fleet);
+
+            for (int i = 0; i < options.ships_per_empire; ++i) {
+                Ship* ship = new Ship(empire_id, design_ids[i % design_ids.size()], "", empire_id);
+                ship->Rename(empire->NewShipName());
+                int ship_id = universe.Insert(ship);
+                fleet->AddShip(ship_id);
+                InitShipMeters(ship);
+            }
+
+            for (int i = 0; i < options.planets_per_empire; ++i) {
+                Planet* planet = new Planet(PT_TERRAN, SZ_MEDIUM);
+                universe.Insert(planet);
+                system->Insert(planet, orbit++ % BENCHMARK_SYSTEM_ORBITS);
+                planet->SetOwner(empire_id);
+                planet->GetMeter(METER_POPULATION)->Set(10.0, 10.0);
+                planet->GetMeter(METER_MAX_DEFENSE)->Set(15.0, 15.0);
+                planet->GetMeter(METER_DEFENSE)->Set(15.0, 15.0);
+                planet->GetMeter(METER_MAX_SHIELD)->Set(15.0, 15.0);
+                planet->GetMeter(METER_SHIELD)->Set(15.0, 15.0);
+                planet->GetMeter(METER_CONSTRUCTION)->Set(10.0, 10.0);
+            }
+        }
+
+        for (EmpireManager::iterator it1 = empires.begin(); it1 != empires.end(); ++it1) {
+            EmpireManager::iterator it2 = it1;
+            for (++it2; it2 != empires.end(); ++it2)
+                empires.SetDiplomaticStatus(it1->first, it2->first, DIPLO_WAR);
+
+            for (ObjectMap::const_iterator<> obj_it = universe.Objects().const_begin();
+                 obj_it != universe.Objects().const_end(); ++obj_it)
+            { universe.SetEmpireObjectVisibility(it1->first, obj_it->ID(), VIS_PARTIAL_VISIBILITY); }
+        }
+
+        return system_id;
+    }
+
+    void AddToChecksum(const CombatInfo& combat_info, Checksum& checksum) {
+        for (ObjectMap::const_iterator<> it = combat_info.objects.const_begin();
+             it != combat_info.objects.const_end(); ++it)
+        {
+            const UniverseObject* obj = *it;
+            checksum.Add(obj->ID());
+            checksum.Add(obj->CurrentMeterValue(METER_STRUCTURE));
+            checksum.Add(obj->CurrentMeterValue(METER_SHIELD));
+            checksum.Add(obj->CurrentMeterValue(METER_DEFENSE));
+            checksum.Add(obj->CurrentMeterValue(METER_CONSTRUCTION));
+        }
+        for (std::set<int>::const_iterator it = combat_info.damaged_object_ids.begin();
+             it != combat_info.damaged_object_ids.end(); ++it)
+        { checksum.Add(*it); }
+    }
+
+    /** Auto-resolves combat in the benchmark system \a iterations times, each
+        time starting from the unchanged universe state. */
+    void RunAutoResolve(int system_id, int iterations, Checksum& checksum) {
+        double setup_seconds = 0.0;
+        double resolve_seconds = 0.0;
+        long setup_allocations = 0;
+        long resolve_allocations = 0;
+        std::size_t participants = 0;
+        std::string first_result;
+        int inconsistent_iterations = 0;
+
+        for (int i = 0; i < iterations; ++i) {
+            long allocations_before = g_allocations;
+            Stopwatch setup_timer;
+            CombatInfo combat_info(system_id);
+            setup_seconds += setup_timer.ElapsedSeconds();
+            setup_allocations += g_allocations - allocations_before;
+
+            participants = combat_info.objects.NumObjects();
+
+            allocations_before = g_allocations;
+            Stopwatch resolve_timer;
+            AutoResolveCombat(combat_info);
+            resolve_seconds += resolve_timer.ElapsedSeconds();
+            resolve_allocations += g_allocations - allocations_before;
+
+            // every iteration starts from the same state, so should produce
+            // the same result
+            Checksum iteration_checksum;
+            AddToChecksum(combat_info, iteration_checksum);
+            if (!i)
+                first_result = iteration_checksum.ToString();
+            else if (iteration_checksum.ToString() != first_result)
+                ++inconsistent_iterations;
+        }
+
+        if (!iterations)
+            return;
+
+        checksum.Add(&first_result[0], first_result.size());
+        checksum.Add(inconsistent_iterations);
+        if (inconsistent_iterations)
+            std::cerr << inconsistent_iterations << " combats had results differing from the first" << std::endl;
+
+        std::cout << "AutoResolveCombat: " << iterations << " combats of " << participants << " objects\n"
+                  << "  setup:   " << setup_seconds << " s, " << (setup_allocations / iterations) << " allocations per combat\n"
+                  << "  resolve: " << resolve_seconds << " s (" << (iterations / std::max(resolve_seconds, 1.0e-9)) << " combats/s), "
+                  << (resolve_allocations / iterations) << " allocations per combat\n";
+    }
+
+    /** Runs \a turns combat turns of the PathingEngine over the ships in the
+        benchmark system, using the same update schedule as the server. */
+    void RunPathing(int system_id, int turns, Checksum& checksum) {
+        if (!turns)
+            return;
+
+        System* system = GetSystem(system_id);
+        std::map<int, std::vector<CombatSetupGroup> > setup_groups;
+        CombatData combat_data(system, setup_groups);
+        PathingEngine& pathing_engine = combat_data.m_pathing_engine;
+
+        const std::size_t MIN_ITERATIONS = 60;
+        const std::size_t ITERATIONS =
+            std::max(MIN_ITERATIONS,
+                     PathingEngine::SECONDS_PER_TURN * PathingEngine::TARGET_OBJECT_UPDATES_PER_SEC);
+        const double ITERATION_DURATION = 1.0 * PathingEngine::SECONDS_PER_TURN / ITERATIONS;
+
+        long allocations_before = g_allocations;
+        Stopwatch timer;
+        for (int turn = 1; turn <= turns; ++turn) {
+            pathing_engine.TurnStarted(turn);
+            for (std::size_t i = 0; i < ITERATIONS; ++i) {
+                pathing_engine.Update(ITERATION_DURATION, true);
+            }
+        }
+        double seconds = timer.ElapsedSeconds();
+        long allocations = g_allocations - allocations_before;
+
+        std::vector<int> ship_ids = system->FindObjectIDs<Ship>();
+        for (std::vector<int>::const_iterator it = ship_ids.begin(); it != ship_ids.end(); ++it) {
+            CombatShipPtr ship = pathing_engine.FindShip(*it);
+            if (!ship)
+                continue;
+            checksum.Add(*it);
+            checksum.Add(ship->position().x);
+            checksum.Add(ship->position().y);
+            checksum.Add(ship->position().z);
+            checksum.Add(ship->StructureAndShield());
+        }
+
+        const std::size_t updates = turns * ITERATIONS;
+        std::cout << "PathingEngine: " << turns << " turns, " << updates << " updates, "
+                  << GetOptionsDB().Get<int>("combat-pathing-threads") << " thread(s)\n"
+                  << "  " << seconds << " s (" << (updates / std::max(seconds, 1.0e-9)) << " updates/s), "
+                  << (allocations / static_cast<long>(updates)) << " allocations per update\n";
+    }
+
+    int Run(const BenchmarkOptions& options) {
+        parse::init();
+
+        ServerApp app;
+        GetOptionsDB().Set<int>("combat-pathing-threads", options.pathing_threads);
+        int system_id = CreateScenario(options);
+
+        std::cout << options.empires << " empires, " << options.ships_per_empire << " ships and "
+                  << options.planets_per_empire << " planets per empire" << std::endl;
+
+        g_count_allocations = true;
+        Checksum checksum;
+        RunAutoResolve(system_id, options.iterations, checksum);
+        RunPathing(system_id, options.pathing_turns, checksum);
+        g_count_allocations = false;
+
+        return CheckChecksum(checksum.ToString(), options.expected_checksum);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    InitDirs(argv[0]);
+
+    BenchmarkOptions options;
+    BenchmarkArgs args("combat_benchmark");
+    args.Add("--empires", options.empires, "number of mutually hostile empires (default 2)");
+    args.Add("--ships", options.ships_per_empire, "ships per empire (default 50)");
+    args.Add("--planets", options.planets_per_empire, "populated, defended planets per empire (default 1)");
+    args.AddHandler("--designs", boost::bind(&SetDesigns, boost::ref(options.designs), _1),
+                    "comma-separated premade ship designs, assigned to ships in rotation (default SD_MARK_A1)");
+    args.Add("--iterations", options.iterations, "number of times combat is auto-resolved (default 100)");
+    args.Add("--pathing-turns", options.pathing_turns, "number of PathingEngine combat turns to run afterwards (default 0)");
+    args.Add("--pathing-threads", options.pathing_threads, "value of the combat-pathing-threads option (default 1)");
+    args.AddResourceDir();
+    args.Add("--expect", options.expected_checksum, "exit with status 2 if the result checksum differs from this");
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    return RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options)));
+}
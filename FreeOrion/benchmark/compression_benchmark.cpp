@@ -0,0 +1,166 @@
+/** Network compression benchmark.  Loads a saved game, creates the full
+    TURN_UPDATE message the server would send each player in it, and
+    compresses and decompresses each message with every codec this build
+    supports.  Reports the compression ratio and the time taken by each
+    codec, and a checksum of the messages so that changes to serialization
+    can be told apart from changes to compression. */
+
+#include "Benchmark.h"
+
+#include "../Empire/EmpireManager.h"
+#include "../network/Message.h"
+#include "../parse/Parse.h"
+#include "../server/SaveLoad.h"
+#include "../server/ServerApp.h"
+#include "../universe/Species.h"
+#include "../universe/Universe.h"
+#include "../util/Directories.h"
+#include "../util/MultiplayerCommon.h"
+#include "../util/OptionsDB.h"
+
+
+#include <iostream>
+
+
+namespace {
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            save_file(),
+            iterations(10),
+            expected_checksum()
+        {}
+
+        std::string save_file;
+        int         iterations;
+        std::string expected_checksum;
+    };
+
+    struct CodecResult {
+        CodecResult() :
+            compressed_bytes(0),
+            compress_seconds(0.0),
+            decompress_seconds(0.0)
+        {}
+
+        std::size_t compressed_bytes;   ///< total over all messages, in one iteration
+        double      compress_seconds;   ///< total over all messages and iterations
+        double      decompress_seconds; ///< total over all messages and iterations
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options)
+    { return !options.save_file.empty() && 1 <= options.iterations; }
+
+    std::string CodecName(Message::Compression compression) {
+        switch (compression) {
+        case Message::NO_COMPRESSION:   return "none";
+        case Message::ZLIB_COMPRESSION: return "zlib";
+        case Message::LZ4_COMPRESSION:  return "lz4";
+        default:                        return "unknown";
+        }
+    }
+
+    /** Creates the TURN_UPDATE for each player in the saved game, as the
+        server would send it just after loading the game. */
+    std::vector<Message> CreateTurnUpdates(const std::string& save_file) {
+        ServerSaveGameData server_save_game_data;
+        std::vector<PlayerSaveGameData> player_save_game_data;
+        LoadGame(save_file, server_save_game_data, player_save_game_data,
+                 GetUniverse(), Empires(), GetSpeciesManager());
+        GetUniverse().InitializeSystemGraph();
+
+        std::map<int, PlayerInfo> players;
+        for (std::size_t i = 0; i < player_save_game_data.size(); ++i) {
+            const PlayerSaveGameData& data = player_save_game_data[i];
+            players[i] = PlayerInfo(data.m_name, data.m_empire_id, data.m_client_type, !i);
+        }
+
+        std::vector<Message> retval;
+        for (std::map<int, PlayerInfo>::const_iterator it = players.begin(); it != players.end(); ++it) {
+            retval.push_back(TurnUpdateMessage(it->first, it->second.empire_id,
+                                               server_save_game_data.m_current_turn, Empires(),
+                                               GetUniverse(), GetSpeciesManager(), players));
+        }
+        return retval;
+    }
+
+    CodecResult RunCodec(Message::Compression compression, const std::vector<Message>& messages,
+                         int iterations, Checksum& checksum)
+    {
+        CodecResult result;
+        for (std::vector<Message>::const_iterator it = messages.begin(); it != messages.end(); ++it) {
+            Message compressed;
+            Stopwatch compress_timer;
+            for (int i = 0; i < iterations; ++i)
+                compressed = CompressMessage(*it, compression);
+            result.compress_seconds += compress_timer.ElapsedSeconds();
+            result.compressed_bytes += compressed.Size();
+
+            Message decompressed;
+            Stopwatch decompress_timer;
+            for (int i = 0; i < iterations; ++i)
+                decompressed = DecompressMessage(compressed);
+            result.decompress_seconds += decompress_timer.ElapsedSeconds();
+
+            if (decompressed != *it)
+                throw std::runtime_error(CodecName(compression) + " round trip changed a message");
+        }
+        checksum.Add(static_cast<int>(result.compressed_bytes));
+        return result;
+    }
+
+    int Run(const BenchmarkOptions& options) {
+        parse::init();
+
+        ServerApp app;
+        GetOptionsDB().Set<int>("network-compression-threshold", 0);
+
+        Stopwatch serialize_timer;
+        std::vector<Message> messages = CreateTurnUpdates(options.save_file);
+        double serialize_seconds = serialize_timer.ElapsedSeconds();
+
+        Checksum checksum;
+        std::size_t uncompressed_bytes = 0;
+        for (std::vector<Message>::const_iterator it = messages.begin(); it != messages.end(); ++it) {
+            uncompressed_bytes += it->Size();
+            checksum.Add(it->Data(), it->Size());
+        }
+
+        std::cout << messages.size() << " turn updates, " << uncompressed_bytes << " bytes, created in "
+                  << serialize_seconds << " s\n";
+
+        const double MB = 1024.0 * 1024.0;
+        const unsigned int available = AvailableCompressions();
+        for (int codec = Message::ZLIB_COMPRESSION; codec <= Message::LZ4_COMPRESSION; ++codec) {
+            Message::Compression compression = static_cast<Message::Compression>(codec);
+            if (!(available & (1u << codec))) {
+                std::cout << CodecName(compression) << ": not available in this build\n";
+                continue;
+            }
+            CodecResult result = RunCodec(compression, messages, options.iterations, checksum);
+            const double total_mb = uncompressed_bytes * options.iterations / MB;
+            std::cout << CodecName(compression) << ": " << result.compressed_bytes << " bytes, ratio "
+                      << (result.compressed_bytes ? 1.0 * uncompressed_bytes / result.compressed_bytes : 0.0) << "\n"
+                      << "  compress:   " << result.compress_seconds << " s ("
+                      << (total_mb / std::max(result.compress_seconds, 1.0e-9)) << " MB/s)\n"
+                      << "  decompress: " << result.decompress_seconds << " s ("
+                      << (total_mb / std::max(result.decompress_seconds, 1.0e-9)) << " MB/s)\n";
+        }
+
+        return CheckChecksum(checksum.ToString(), options.expected_checksum);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    InitDirs(argv[0]);
+
+    BenchmarkOptions options;
+    BenchmarkArgs args("compression_benchmark");
+    args.Add("--save", options.save_file, "saved game whose turn updates are compressed");
+    args.Add("--iterations", options.iterations, "number of times each message is compressed with each codec (default 10)");
+    args.AddResourceDir();
+    args.Add("--expect", options.expected_checksum, "exit with status 2 if the message checksum differs from this");
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    return RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options)));
+}
@@ -0,0 +1,170 @@
+/** Universe deserialization benchmark.  Generates a universe of the size of a
+    late game, then serializes and deserializes it the way games are loaded,
+    with the objects in one map and in separately serialized chunks, and the
+    way full turn updates are received, each with one deserialization thread
+    and with several.  Reports the serialized size and the wall time taken to
+    deserialize in each case, and a checksum of the universe so that changes
+    to serialization can be checked for behaviour regressions. */
+
+#include "Benchmark.h"
+#include "BenchmarkUniverse.h"
+
+#include "../parse/Parse.h"
+#include "../server/ServerApp.h"
+#include "../universe/Universe.h"
+#include "../util/Directories.h"
+#include "../util/OptionsDB.h"
+#include "../util/Serialize.h"
+
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <iostream>
+#include <sstream>
+
+
+namespace {
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            systems(2500),
+            planets_per_system(5),
+            empires(4),
+            ships_per_empire(8000),
+            chunk_size(1024),
+            threads(std::max(2u, boost::thread::hardware_concurrency())),
+            iterations(3),
+            expected_checksum()
+        {}
+
+        int         systems;
+        int         planets_per_system;
+        int         empires;
+        int         ships_per_empire;
+        int         chunk_size;
+        int         threads;
+        int         iterations;
+        std::string expected_checksum;
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options) {
+        return 1 <= options.systems && 0 <= options.planets_per_system &&
+            options.planets_per_system <= BENCHMARK_SYSTEM_ORBITS && 1 <= options.empires &&
+            0 <= options.ships_per_empire && 1 <= options.chunk_size && 1 <= options.threads &&
+            options.threads <= 64 && 1 <= options.iterations;
+    }
+
+    /** Serializes the universe as a saved game does, with objects in chunks
+        of \a chunk_size, or in one map if \a chunk_size is zero. */
+    std::string SerializeUniverse(int chunk_size) {
+        GetOptionsDB().Set<int>("serialization-object-chunk-size", chunk_size);
+        std::ostringstream os;
+        {
+            FREEORION_OARCHIVE_TYPE oa(os);
+            Serialize(oa, GetUniverse());
+        }
+        return os.str();
+    }
+
+    /** Serializes the full turn update the first empire's player receives
+        after joining the game. */
+    std::string SerializeTurnUpdate() {
+        const int empire_id = GetUniverse().EmpireKnownObjectsEmpireIDs().front();
+        GetUniverse().EncodingEmpire() = empire_id;
+        TurnUpdateBaseline baseline;
+        std::ostringstream os;
+        {
+            FREEORION_OARCHIVE_TYPE oa(os);
+            SerializeDelta(oa, GetUniverse(), baseline);
+        }
+        GetUniverse().EncodingEmpire() = ALL_EMPIRES;
+        return os.str();
+    }
+
+    /** Deserializes \a data \a iterations times into a new universe with
+        \a threads deserialization threads, as a loaded game if \a turn_update
+        is false, or as a turn update otherwise.  Returns the average time
+        taken, and the checksum of the last universe in \a checksum. */
+    double Deserialize(const std::string& data, bool turn_update, int threads, int iterations,
+                       std::string& checksum)
+    {
+        GetOptionsDB().Set<int>("deserialization-threads", threads);
+        double seconds = 0.0;
+        for (int i = 0; i < iterations; ++i) {
+            Universe universe;
+            std::istringstream is(data);
+            FREEORION_IARCHIVE_TYPE ia(is);
+            Stopwatch timer;
+            if (turn_update)
+                DeserializeDelta(ia, universe);
+            else
+                ::Deserialize(ia, universe);
+            seconds += timer.ElapsedSeconds();
+            checksum = UniverseChecksum(universe);
+        }
+        return seconds / iterations;
+    }
+
+    /** Deserializes \a data with one thread and with \a threads threads,
+        printing the times taken under \a name, and throws if the universe
+        deserialized differs from \a expected_checksum. */
+    void RunCase(const std::string& name, const std::string& data, bool turn_update,
+                 const BenchmarkOptions& options, const std::string& expected_checksum)
+    {
+        const double MB = 1024.0 * 1024.0;
+        std::cout << name << ": " << data.size() << " bytes (" << (data.size() / MB) << " MB)\n";
+        const int thread_counts[] = { 1, options.threads };
+        for (int i = 0; i < 2; ++i) {
+            std::string checksum;
+            const double seconds = Deserialize(data, turn_update, thread_counts[i], options.iterations, checksum);
+            std::cout << "  " << thread_counts[i] << (thread_counts[i] == 1 ? " thread:  " : " threads: ")
+                      << seconds << " s" << std::endl;
+            if (checksum != expected_checksum)
+                throw std::runtime_error(name + " deserialization changed the universe");
+        }
+    }
+
+    int Run(const BenchmarkOptions& options) {
+        parse::init();
+
+        ServerApp app;
+
+        CreateBenchmarkUniverse(options.systems, options.planets_per_system, options.empires,
+                                options.ships_per_empire);
+        const std::string checksum = UniverseChecksum(GetUniverse());
+        std::cout << GetUniverse().Objects().NumObjects() << " objects, "
+                  << GetUniverse().EmpireKnownObjectsEmpireIDs().size() << " empires' known objects" << std::endl;
+
+        RunCase("load, single map", SerializeUniverse(0), false, options, checksum);
+        RunCase("load, chunks of " + boost::lexical_cast<std::string>(options.chunk_size),
+                SerializeUniverse(options.chunk_size), false, options, checksum);
+
+        // a turn update holds only what the first empire knows, so its
+        // checksum is that of a universe deserialized from one
+        const std::string turn_update = SerializeTurnUpdate();
+        std::string turn_update_checksum;
+        Deserialize(turn_update, true, 1, 1, turn_update_checksum);
+        RunCase("turn update", turn_update, true, options, turn_update_checksum);
+
+        return CheckChecksum(checksum, options.expected_checksum);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    InitDirs(argv[0]);
+
+    BenchmarkOptions options;
+    BenchmarkArgs args("deserialization_benchmark");
+    args.Add("--systems", options.systems, "number of systems in the generated universe (default 2500)");
+    args.Add("--planets", options.planets_per_system, "planets per system (default 5)");
+    args.Add("--empires", options.empires, "number of empires (default 4)");
+    args.Add("--ships", options.ships_per_empire, "ships per empire (default 8000)");
+    args.Add("--chunk-size", options.chunk_size, "objects per chunk in the chunked layout (default 1024)");
+    args.Add("--threads", options.threads, "deserialization threads to compare with one (default: number of cores)");
+    args.Add("--iterations", options.iterations, "number of times each case is deserialized (default 3)");
+    args.AddResourceDir();
+    args.Add("--expect", options.expected_checksum, "exit with status 2 if the universe checksum differs from this");
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    return RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options)));
+}
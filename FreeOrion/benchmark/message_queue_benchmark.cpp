@@ -0,0 +1,143 @@
+/** Message queue benchmark.  Passes messages from a producer thread to a
+    consumer thread through a MessageQueue, the way ClientNetworking passes
+    incoming messages from its networking thread to the main thread, and
+    reports how many messages per second get through.  Also times round trips
+    of synchronous responses, which the consumer blocks waiting for.  A
+    checksum of the messages received shows whether any were lost, reordered
+    or corrupted on the way. */
+
+#include "Benchmark.h"
+
+#include "../network/Message.h"
+#include "../network/MessageQueue.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <iostream>
+
+
+namespace {
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            messages(1000000),
+            message_size(64),
+            round_trips(10000),
+            expected_checksum()
+        {}
+
+        int         messages;
+        int         message_size;
+        int         round_trips;
+        std::string expected_checksum;
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options)
+    { return 0 <= options.messages && 0 <= options.message_size && 0 <= options.round_trips; }
+
+    /** The text of the message with sequence number \a i. */
+    std::string MessageText(int i, int size) {
+        std::string retval(size, ' ');
+        for (int j = 0; j < size; ++j)
+            retval[j] = static_cast<char>('a' + (i + j) % 26);
+        return retval;
+    }
+
+    /** Pushes \a count messages onto \a queue, with the sending player set to
+        each message's sequence number. */
+    void Produce(MessageQueue& queue, int count, int size) {
+        for (int i = 0; i < count; ++i) {
+            Message message(Message::TURN_PROGRESS, i, 0, MessageText(i, size));
+            queue.PushBack(message);
+        }
+    }
+
+    /** Answers each of \a count requests in \a requests with a synchronous
+        response in \a responses.  The requests stand in for the messages the
+        main thread sends to the server, and the responses for the server's
+        replies arriving on the networking thread. */
+    void Respond(MessageQueue& requests, MessageQueue& responses, int count) {
+        for (int i = 0; i < count; ++i) {
+            Message request;
+            requests.EraseFirstSynchronousResponse(request);
+            Message response(Message::DISPATCH_NEW_OBJECT_ID, request.SendingPlayer(), 0, "", true);
+            responses.PushBack(response);
+        }
+    }
+
+    /** Pops messages until \a count have been received, checking that they
+        arrive in order, and adds each to \a checksum.  Returns the number of
+        messages that were out of order. */
+    int Consume(MessageQueue& queue, int count, Checksum& checksum) {
+        int out_of_order = 0;
+        int received = 0;
+        Message message;
+        while (received < count) {
+            if (queue.Empty()) {
+                boost::this_thread::yield();
+                continue;
+            }
+            queue.PopFront(message);
+            if (message.SendingPlayer() != received)
+                ++out_of_order;
+            checksum.Add(message.SendingPlayer());
+            checksum.Add(message.Data(), message.Size());
+            ++received;
+        }
+        return out_of_order;
+    }
+
+    int Run(const BenchmarkOptions& options) {
+        Checksum checksum;
+
+        MessageQueue queue;
+        Stopwatch throughput_timer;
+        boost::thread producer(boost::bind(&Produce, boost::ref(queue), options.messages, options.message_size));
+        int out_of_order = Consume(queue, options.messages, checksum);
+        producer.join();
+        double throughput_seconds = throughput_timer.ElapsedSeconds();
+
+        std::cout << options.messages << " messages of " << options.message_size << " bytes in "
+                  << throughput_seconds << " s ("
+                  << (options.messages / std::max(throughput_seconds, 1.0e-9)) << " messages/s)\n";
+
+        MessageQueue requests;
+        MessageQueue responses;
+        boost::thread responder(boost::bind(&Respond, boost::ref(requests), boost::ref(responses), options.round_trips));
+        Stopwatch round_trip_timer;
+        for (int i = 0; i < options.round_trips; ++i) {
+            Message request(Message::REQUEST_NEW_OBJECT_ID, i, 0, "", true);
+            requests.PushBack(request);
+            Message response;
+            responses.EraseFirstSynchronousResponse(response);
+            if (response.SendingPlayer() != i)
+                ++out_of_order;
+            checksum.Add(response.SendingPlayer());
+        }
+        responder.join();
+        double round_trip_seconds = round_trip_timer.ElapsedSeconds();
+
+        std::cout << options.round_trips << " synchronous round trips in " << round_trip_seconds << " s ("
+                  << (round_trip_seconds * 1.0e6 / std::max(options.round_trips, 1)) << " us each)\n";
+
+        const int retval = CheckChecksum(checksum.ToString(), options.expected_checksum);
+        if (out_of_order) {
+            std::cerr << out_of_order << " messages arrived out of order" << std::endl;
+            return BENCHMARK_MISMATCH;
+        }
+        return retval;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    BenchmarkArgs args("message_queue_benchmark");
+    args.Add("--messages", options.messages, "number of messages passed from the producer to the consumer (default 1000000)");
+    args.Add("--message-size", options.message_size, "size of each message's text (default 64)");
+    args.Add("--round-trips", options.round_trips, "number of synchronous responses waited for (default 10000)");
+    args.Add("--expect", options.expected_checksum, "exit with status 2 if the message checksum differs from this");
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    return RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options)));
+}
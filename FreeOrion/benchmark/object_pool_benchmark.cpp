@@ -0,0 +1,173 @@
+/** Object pool benchmark.  Generates a universe of the size of a late game,
+    then applies the full turn update of one empire to a client's universe
+    repeatedly, as a client receiving turn updates does, and iterates over
+    the client's objects.  Reports the wall time taken by each, and the
+    number of objects allocated and of heap allocations made for them, with
+    UniverseObjects allocated from per-type pools or, with --no-pools, one at
+    a time.  Comparing the two, also under a profiler counting cache misses
+    such as perf stat -e cache-misses, shows what the pools change. */
+
+#include "Benchmark.h"
+#include "BenchmarkUniverse.h"
+
+#include "../parse/Parse.h"
+#include "../server/ServerApp.h"
+#include "../universe/Building.h"
+#include "../universe/Field.h"
+#include "../universe/Fleet.h"
+#include "../universe/ObjectPool.h"
+#include "../universe/Planet.h"
+#include "../universe/Ship.h"
+#include "../universe/Universe.h"
+#include "../util/Directories.h"
+#include "../util/Serialize.h"
+
+
+#include <iostream>
+#include <sstream>
+
+
+namespace {
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            systems(1000),
+            planets_per_system(5),
+            empires(4),
+            ships_per_empire(4000),
+            updates(10),
+            iterations(100),
+            no_pools(false),
+            expected_checksum()
+        {}
+
+        int         systems;
+        int         planets_per_system;
+        int         empires;
+        int         ships_per_empire;
+        int         updates;
+        int         iterations;
+        bool        no_pools;
+        std::string expected_checksum;
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options) {
+        return 1 <= options.systems && 0 <= options.planets_per_system &&
+            options.planets_per_system <= BENCHMARK_SYSTEM_ORBITS && 1 <= options.empires &&
+            0 <= options.ships_per_empire && 1 <= options.updates && 1 <= options.iterations;
+    }
+
+    /** Serializes the full turn update the first empire's player receives
+        after joining the game. */
+    std::string SerializeTurnUpdate() {
+        const int empire_id = GetUniverse().EmpireKnownObjectsEmpireIDs().front();
+        GetUniverse().EncodingEmpire() = empire_id;
+        TurnUpdateBaseline baseline;
+        std::ostringstream os;
+        {
+            FREEORION_OARCHIVE_TYPE oa(os);
+            SerializeDelta(oa, GetUniverse(), baseline);
+        }
+        GetUniverse().EncodingEmpire() = ALL_EMPIRES;
+        return os.str();
+    }
+
+    /** Returns the sum of the positions and systems of the objects in
+        \a universe, which touches each object once. */
+    double IterateObjects(const Universe& universe) {
+        double retval = 0.0;
+        for (ObjectMap::const_iterator<> it = universe.Objects().const_begin();
+             it != universe.Objects().const_end(); ++it)
+        { retval += it->X() + it->Y() + it->SystemID(); }
+        return retval;
+    }
+
+    /** Returns the total of the statistics of all pooled types. */
+    ObjectPoolStats TotalStats() {
+        ObjectPoolStats retval;
+        const ObjectPoolStats stats[] = {
+            ObjectPool<Ship>::Stats(), ObjectPool<Fleet>::Stats(), ObjectPool<Planet>::Stats(),
+            ObjectPool<Building>::Stats(), ObjectPool<Field>::Stats()
+        };
+        for (std::size_t i = 0; i < sizeof(stats) / sizeof(stats[0]); ++i) {
+            retval.allocations += stats[i].allocations;
+            retval.deallocations += stats[i].deallocations;
+            retval.global_allocations += stats[i].global_allocations;
+            retval.global_bytes += stats[i].global_bytes;
+        }
+        return retval;
+    }
+
+    void PrintStats(const std::string& name, const ObjectPoolStats& before, const ObjectPoolStats& after) {
+        std::cout << name << ": " << after.allocations - before.allocations << " objects allocated, "
+                  << after.global_allocations - before.global_allocations << " heap allocations of "
+                  << after.global_bytes - before.global_bytes << " bytes" << std::endl;
+    }
+
+    int Run(const BenchmarkOptions& options) {
+        parse::init();
+
+        ServerApp app;
+
+        std::cout << "object pools " << (ObjectPools::Enabled() ? "enabled" : "disabled") << std::endl;
+
+        ObjectPoolStats stats = TotalStats();
+        Stopwatch create_timer;
+        CreateBenchmarkUniverse(options.systems, options.planets_per_system, options.empires,
+                                options.ships_per_empire);
+        std::cout << GetUniverse().Objects().NumObjects() << " objects created in "
+                  << create_timer.ElapsedSeconds() << " s" << std::endl;
+        ObjectPoolStats new_stats = TotalStats();
+        PrintStats("creation", stats, new_stats);
+        stats = new_stats;
+
+        // the client's universe is replaced by each full update, freeing
+        // every object and allocating its replacement
+        const std::string turn_update = SerializeTurnUpdate();
+        Universe client_universe;
+        Stopwatch update_timer;
+        for (int i = 0; i < options.updates; ++i) {
+            std::istringstream is(turn_update);
+            FREEORION_IARCHIVE_TYPE ia(is);
+            DeserializeDelta(ia, client_universe);
+        }
+        std::cout << "turn update: " << update_timer.ElapsedSeconds() / options.updates << " s" << std::endl;
+        new_stats = TotalStats();
+        PrintStats("turn updates", stats, new_stats);
+        stats = new_stats;
+
+        Stopwatch iteration_timer;
+        double sum = 0.0;
+        for (int i = 0; i < options.iterations; ++i)
+            sum += IterateObjects(client_universe);
+        std::cout << "iteration over " << client_universe.Objects().NumObjects() << " client objects: "
+                  << iteration_timer.ElapsedSeconds() / options.iterations << " s (sum " << sum << ")" << std::endl;
+
+        std::cout << ObjectPools::StatsReport();
+
+        return CheckChecksum(UniverseChecksum(client_universe), options.expected_checksum);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    InitDirs(argv[0]);
+
+    BenchmarkOptions options;
+    BenchmarkArgs args("object_pool_benchmark");
+    args.Add("--systems", options.systems, "number of systems in the generated universe (default 1000)");
+    args.Add("--planets", options.planets_per_system, "planets per system (default 5)");
+    args.Add("--empires", options.empires, "number of empires (default 4)");
+    args.Add("--ships", options.ships_per_empire, "ships per empire (default 4000)");
+    args.Add("--updates", options.updates, "number of turn updates applied to the client's universe (default 10)");
+    args.Add("--iterations", options.iterations, "number of times the client's objects are iterated over (default 100)");
+    args.AddFlag("--no-pools", options.no_pools, "allocate each object on its own, rather than from pools");
+    args.AddResourceDir();
+    args.Add("--expect", options.expected_checksum, "exit with status 2 if the client universe checksum differs from this");
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    // must be set before the first pooled object is allocated
+    if (options.no_pools)
+        ObjectPools::Enabled() = false;
+
+    return RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options)));
+}
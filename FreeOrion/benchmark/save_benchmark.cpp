@@ -0,0 +1,180 @@
+/** Saved game benchmark.  Generates a universe of the size of a late game,
+    with many systems, planets, fleets and ships and empires that know about
+    all of them, or loads a saved game, then saves and loads it with each save
+    compression codec this build supports.  Reports the wall time taken to
+    save and load and the size of the save file for each codec, and a
+    checksum of the universe so that changes to serialization can be checked
+    for behaviour regressions. */
+
+#include "Benchmark.h"
+#include "BenchmarkUniverse.h"
+
+#include "../Empire/Empire.h"
+#include "../Empire/EmpireManager.h"
+#include "../parse/Parse.h"
+#include "../server/SaveLoad.h"
+#include "../server/ServerApp.h"
+#include "../universe/Species.h"
+#include "../util/BlockCompression.h"
+#include "../util/Directories.h"
+#include "../util/MultiplayerCommon.h"
+#include "../util/OptionsDB.h"
+#include "../util/OrderSet.h"
+
+#include <boost/filesystem/exception.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include <iostream>
+
+
+namespace fs = boost::filesystem;
+
+namespace {
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            save_file(),
+            systems(400),
+            planets_per_system(4),
+            empires(8),
+            ships_per_empire(500),
+            iterations(3),
+            expected_checksum()
+        {}
+
+        std::string save_file;
+        int         systems;
+        int         planets_per_system;
+        int         empires;
+        int         ships_per_empire;
+        int         iterations;
+        std::string expected_checksum;
+    };
+
+    struct CodecResult {
+        CodecResult() :
+            file_bytes(0),
+            save_seconds(0.0),
+            load_seconds(0.0)
+        {}
+
+        boost::uintmax_t    file_bytes;
+        double              save_seconds;   ///< total over all iterations
+        double              load_seconds;   ///< total over all iterations
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options) {
+        return 1 <= options.systems && 0 <= options.planets_per_system &&
+            options.planets_per_system <= BENCHMARK_SYSTEM_ORBITS && 1 <= options.empires &&
+            0 <= options.ships_per_empire && 1 <= options.iterations;
+    }
+
+    /** Creates the benchmark universe, and the save game data of a player
+        for each empire. */
+    void CreateUniverse(const BenchmarkOptions& options, ServerSaveGameData& server_save_game_data,
+                        std::vector<PlayerSaveGameData>& player_save_game_data)
+    {
+        CreateBenchmarkUniverse(options.systems, options.planets_per_system, options.empires,
+                                options.ships_per_empire);
+        for (EmpireManager::const_iterator it = Empires().begin(); it != Empires().end(); ++it) {
+            player_save_game_data.push_back(
+                PlayerSaveGameData(it->second->PlayerName(), it->first,
+                                   boost::shared_ptr<OrderSet>(new OrderSet()),
+                                   boost::shared_ptr<SaveGameUIData>(), "",
+                                   Networking::CLIENT_TYPE_AI_PLAYER));
+        }
+        server_save_game_data = ServerSaveGameData(1, std::map<int, std::set<std::string> >());
+    }
+
+    /** Saves and loads the game \a iterations times with \a codec, checking
+        that loading restores the universe with checksum \a checksum. */
+    CodecResult RunCodec(BlockCompression::Codec codec, const std::string& save_file, int iterations,
+                         ServerSaveGameData& server_save_game_data,
+                         std::vector<PlayerSaveGameData>& player_save_game_data,
+                         const std::string& checksum)
+    {
+        GetOptionsDB().Set<std::string>("save-compression", BlockCompression::CodecName(codec));
+
+        CodecResult result;
+        for (int i = 0; i < iterations; ++i) {
+            Stopwatch save_timer;
+            SaveGame(save_file, server_save_game_data, player_save_game_data,
+                     GetUniverse(), Empires(), GetSpeciesManager());
+            result.save_seconds += save_timer.ElapsedSeconds();
+            result.file_bytes = fs::file_size(save_file);
+
+            // the latest known objects of empires are otherwise only loaded
+            // when first needed, which the time taken should include
+            Stopwatch load_timer;
+            LoadGame(save_file, server_save_game_data, player_save_game_data,
+                     GetUniverse(), Empires(), GetSpeciesManager());
+            GetUniverse().LoadDeferredEmpireKnownObjects();
+            result.load_seconds += load_timer.ElapsedSeconds();
+
+            if (UniverseChecksum(GetUniverse()) != checksum)
+                throw std::runtime_error(BlockCompression::CodecName(codec) + " save and load changed the universe");
+        }
+        return result;
+    }
+
+    int Run(const BenchmarkOptions& options, const std::string& benchmark_save_file) {
+        parse::init();
+
+        ServerApp app;
+
+        ServerSaveGameData server_save_game_data;
+        std::vector<PlayerSaveGameData> player_save_game_data;
+        if (!options.save_file.empty()) {
+            LoadGame(options.save_file, server_save_game_data, player_save_game_data,
+                     GetUniverse(), Empires(), GetSpeciesManager());
+            GetUniverse().LoadDeferredEmpireKnownObjects();
+        } else {
+            CreateUniverse(options, server_save_game_data, player_save_game_data);
+        }
+
+        const std::string checksum = UniverseChecksum(GetUniverse());
+        std::cout << GetUniverse().Objects().NumObjects() << " objects, "
+                  << GetUniverse().EmpireKnownObjectsEmpireIDs().size() << " empires' known objects" << std::endl;
+
+        const double MB = 1024.0 * 1024.0;
+        for (int codec = BlockCompression::NO_CODEC; codec <= BlockCompression::LZ4_CODEC; ++codec) {
+            BlockCompression::Codec block_codec = static_cast<BlockCompression::Codec>(codec);
+            if (!BlockCompression::CodecAvailable(block_codec)) {
+                std::cout << BlockCompression::CodecName(block_codec) << ": not available in this build\n";
+                continue;
+            }
+            CodecResult result = RunCodec(block_codec, benchmark_save_file, options.iterations,
+                                          server_save_game_data, player_save_game_data, checksum);
+            std::cout << BlockCompression::CodecName(block_codec) << ": " << result.file_bytes << " bytes ("
+                      << (result.file_bytes / MB) << " MB)\n"
+                      << "  save: " << (result.save_seconds / options.iterations) << " s\n"
+                      << "  load: " << (result.load_seconds / options.iterations) << " s" << std::endl;
+        }
+
+        return CheckChecksum(checksum, options.expected_checksum);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    InitDirs(argv[0]);
+
+    BenchmarkOptions options;
+    BenchmarkArgs args("save_benchmark");
+    args.Add("--save", options.save_file, "saved game to benchmark, instead of a generated universe");
+    args.Add("--systems", options.systems, "number of systems in the generated universe (default 400)");
+    args.Add("--planets", options.planets_per_system, "planets per system (default 4)");
+    args.Add("--empires", options.empires, "number of empires (default 8)");
+    args.Add("--ships", options.ships_per_empire, "ships per empire (default 500)");
+    args.Add("--iterations", options.iterations, "number of times the game is saved and loaded with each codec (default 3)");
+    args.AddResourceDir();
+    args.Add("--expect", options.expected_checksum, "exit with status 2 if the universe checksum differs from this");
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    const std::string benchmark_save_file = (GetUserDir() / "save_benchmark.sav").string();
+    int retval = RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options), benchmark_save_file));
+
+    try {
+        fs::remove(benchmark_save_file);
+    } catch (const fs::filesystem_error&) {}
+    return retval;
+}
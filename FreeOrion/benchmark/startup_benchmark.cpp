@@ -0,0 +1,199 @@
+/** Game startup benchmark.  Starts a server, connects to it as the human
+    player of a single player game, and hosts a new game with a number of AI
+    players, or loads a saved game, the way the human client does.  Reports
+    the wall time until the server is connected to, until it acknowledges the
+    host, and until the first turn begins with the arrival of the GAME_START
+    message, by which time all the AI clients have been started and joined the
+    game.  Run with --max-seconds, it fails when the time to the first turn is
+    longer, so that it can be used as a test of startup latency. */
+
+#include "Benchmark.h"
+
+#include "../network/ClientNetworking.h"
+#include "../network/Message.h"
+#include "../util/Directories.h"
+#include "../util/MultiplayerCommon.h"
+#include "../util/OptionsDB.h"
+#include "../util/Process.h"
+
+#include <boost/lexical_cast.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+
+namespace {
+    const std::string HOST_PLAYER_NAME = "Benchmark";
+
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            save_file(),
+            ai_players(4),
+            systems(100),
+            iterations(3),
+            timeout_seconds(300),
+            max_seconds(0.0)
+        {}
+
+        std::string save_file;
+        int         ai_players;
+        int         systems;
+        int         iterations;
+        int         timeout_seconds;
+        double      max_seconds;
+    };
+
+    /** The times, from starting the server, at which each step of starting
+        a game was reached. */
+    struct StartupTimes {
+        StartupTimes() :
+            connected(0.0),
+            host_acknowledged(0.0),
+            first_turn(0.0)
+        {}
+
+        double connected;
+        double host_acknowledged;
+        double first_turn;
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options) {
+        return 0 <= options.ai_players && 1 <= options.systems && 1 <= options.iterations &&
+            1 <= options.timeout_seconds && 0.0 <= options.max_seconds;
+    }
+
+    std::string ServerExe() {
+#ifdef FREEORION_WIN32
+        return (GetBinDir() / "freeoriond.exe").string();
+#else
+        return (GetBinDir() / "freeoriond").string();
+#endif
+    }
+
+    Process StartServer() {
+        const std::string server_exe = ServerExe();
+        std::vector<std::string> args;
+        args.push_back("\"" + server_exe + "\"");
+        args.push_back("--resource-dir");
+        args.push_back("\"" + GetOptionsDB().Get<std::string>("resource-dir") + "\"");
+        return Process(server_exe, args);
+    }
+
+    /** The setup data the human client sends to host the game. */
+    SinglePlayerSetupData SetupData(const BenchmarkOptions& options) {
+        SinglePlayerSetupData setup_data;
+        if (!options.save_file.empty()) {
+            // the players are read from the saved game
+            setup_data.m_new_game = false;
+            setup_data.m_filename = options.save_file;
+            return setup_data;
+        }
+
+        setup_data.m_size = options.systems;
+
+        // the empire names, colours and species left blank are chosen by the server
+        PlayerSetupData human_player_setup_data;
+        human_player_setup_data.m_player_name = HOST_PLAYER_NAME;
+        human_player_setup_data.m_empire_name = HOST_PLAYER_NAME;
+        human_player_setup_data.m_client_type = Networking::CLIENT_TYPE_HUMAN_PLAYER;
+        setup_data.m_players.push_back(human_player_setup_data);
+
+        for (int ai_i = 1; ai_i <= options.ai_players; ++ai_i) {
+            PlayerSetupData ai_setup_data;
+            ai_setup_data.m_player_name = "AI_" + boost::lexical_cast<std::string>(ai_i);
+            ai_setup_data.m_client_type = Networking::CLIENT_TYPE_AI_PLAYER;
+            setup_data.m_players.push_back(ai_setup_data);
+        }
+        return setup_data;
+    }
+
+    /** Starts a server and a game on it, and returns the times taken to
+        reach each step of starting the game.  Throws std::runtime_error if
+        the game doesn't start within \a timeout_seconds. */
+    StartupTimes StartGame(const BenchmarkOptions& options) {
+        StartupTimes times;
+        Stopwatch stopwatch;
+        Process server = StartServer();
+
+        ClientNetworking networking;
+        if (!networking.ConnectToLocalHostServer(boost::posix_time::seconds(options.timeout_seconds)))
+            throw std::runtime_error("unable to connect to the server");
+        times.connected = stopwatch.ElapsedSeconds();
+
+        networking.SendMessage(HostSPGameMessage(SetupData(options)));
+
+        while (!times.first_turn) {
+            if (options.timeout_seconds < stopwatch.ElapsedSeconds())
+                throw std::runtime_error("timed out waiting for the first turn");
+            if (!networking.Connected())
+                throw std::runtime_error("the server disconnected");
+            if (!networking.WaitForMessage(100))
+                continue;
+
+            Message message;
+            networking.GetMessage(message);
+            switch (message.Type()) {
+            case Message::HOST_SP_GAME:
+                networking.SetPlayerID(message.ReceivingPlayer());
+                networking.SetHostPlayerID(message.ReceivingPlayer());
+                times.host_acknowledged = stopwatch.ElapsedSeconds();
+                break;
+            case Message::GAME_START:
+                times.first_turn = stopwatch.ElapsedSeconds();
+                break;
+            case Message::ERROR:
+            case Message::END_GAME:
+                throw std::runtime_error("the server ended the game: " + message.Text());
+            default:
+                break;
+            }
+        }
+
+        // the server exits once its only human player has gone, and is
+        // killed when the Process is destroyed if it hasn't
+        networking.DisconnectFromServer();
+        return times;
+    }
+
+    int Run(const BenchmarkOptions& options) {
+        double total_seconds = 0.0;
+        double slowest_seconds = 0.0;
+        for (int i = 0; i < options.iterations; ++i) {
+            StartupTimes times = StartGame(options);
+            std::cout << "game " << i + 1 << ": connected after " << times.connected << " s, "
+                      << "host acknowledged after " << times.host_acknowledged << " s, "
+                      << "first turn after " << times.first_turn << " s" << std::endl;
+            total_seconds += times.first_turn;
+            slowest_seconds = std::max(slowest_seconds, times.first_turn);
+        }
+
+        std::cout << "time to first turn: " << (total_seconds / options.iterations) << " s mean, "
+                  << slowest_seconds << " s max" << std::endl;
+
+        if (options.max_seconds && options.max_seconds < slowest_seconds) {
+            std::cerr << "time to first turn exceeded " << options.max_seconds << " s" << std::endl;
+            return BENCHMARK_MISMATCH;
+        }
+        return BENCHMARK_SUCCESS;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    InitDirs(argv[0]);
+
+    BenchmarkOptions options;
+    BenchmarkArgs args("startup_benchmark");
+    args.Add("--save", options.save_file, "saved game to load, instead of starting a new game");
+    args.Add("--ais", options.ai_players, "number of AI players in a new game (default 4)");
+    args.Add("--systems", options.systems, "number of systems in a new game (default 100)");
+    args.Add("--iterations", options.iterations, "number of times a game is started (default 3)");
+    args.Add("--timeout", options.timeout_seconds, "seconds to wait for each game to start before giving up (default 300)");
+    args.Add("--max-seconds", options.max_seconds,
+             "exit with status 2 if any game takes longer than this to reach its first turn");
+    args.AddResourceDir();
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    return RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options)));
+}
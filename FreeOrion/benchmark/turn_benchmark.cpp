@@ -0,0 +1,315 @@
+/** Turn processing benchmark.  Generates a universe from a seed, size and
+    galaxy shape, the way the server does for a new game, or loads a saved
+    game, then processes a number of turns as the server does once all
+    players' orders are in, with no players connected.  The empires' orders
+    are empty, or are scripted to send their idle fleets to random systems.
+    Reports the wall time taken by each phase of each turn, and a checksum of
+    the game state after each turn.  The checksums can be recorded to a file,
+    and later runs compared against it, so that changes to turn processing
+    can be checked for behaviour regressions. */
+
+#include "Benchmark.h"
+#include "BenchmarkUniverse.h"
+
+#include "../Empire/Empire.h"
+#include "../Empire/EmpireManager.h"
+#include "../parse/Parse.h"
+#include "../server/SaveLoad.h"
+#include "../server/ServerApp.h"
+#include "../universe/Fleet.h"
+#include "../universe/Species.h"
+#include "../universe/System.h"
+#include "../util/Directories.h"
+#include "../util/MultiplayerCommon.h"
+#include "../util/Order.h"
+#include "../util/OrderSet.h"
+#include "../util/Random.h"
+
+#include <boost/filesystem/fstream.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <iostream>
+#include <stdexcept>
+
+
+namespace {
+    struct BenchmarkOptions {
+        BenchmarkOptions() :
+            save_file(),
+            seed(1),
+            systems(150),
+            shape(SPIRAL_3),
+            empires(8),
+            turns(10),
+            move_fleets(false),
+            record_file(),
+            baseline_file()
+        {}
+
+        std::string save_file;
+        unsigned int seed;
+        int         systems;
+        Shape       shape;
+        int         empires;
+        int         turns;
+        bool        move_fleets;
+        std::string record_file;
+        std::string baseline_file;
+    };
+
+    /** The wall time taken by each phase of processing a turn. */
+    struct TurnTimes {
+        TurnTimes() :
+            pre_combat(0.0),
+            combat(0.0),
+            post_combat(0.0)
+        {}
+
+        double Total() const
+        { return pre_combat + combat + post_combat; }
+
+        double pre_combat;
+        double combat;
+        double post_combat;
+    };
+
+    bool ValidOptions(const BenchmarkOptions& options) {
+        return 1 <= options.systems && 0 <= options.shape && options.shape < GALAXY_SHAPES &&
+            1 <= options.empires && options.seed && 1 <= options.turns;
+    }
+
+    void SetOrders(bool& move_fleets, const std::string& value) {
+        if (value != "none" && value != "move")
+            throw std::invalid_argument("orders must be none or move");
+        move_fleets = value == "move";
+    }
+
+    /** Determines the empires' supply and resource pools, as the server does
+        before the first turn of a new or loaded game. */
+    void InitEmpires() {
+        EmpireManager& empires = Empires();
+        for (EmpireManager::iterator it = empires.begin(); it != empires.end(); ++it) {
+            if (empires.Eliminated(it->first))
+                continue;
+            Empire* empire = it->second;
+            empire->UpdateSupplyUnobstructedSystems();
+            empire->UpdateSystemSupplyRanges();
+            empire->UpdateSupply();
+            empire->InitResourcePools();
+            empire->UpdateResourcePools();
+        }
+    }
+
+    /** Generates a universe for a new game, as ServerApp::NewGameInit() does,
+        with an AI player for each empire. */
+    void CreateUniverse(ServerApp& app, const BenchmarkOptions& options) {
+        std::map<int, PlayerSetupData> player_setup_data;
+        for (int player_id = 1; player_id <= options.empires; ++player_id) {
+            PlayerSetupData& psd = player_setup_data[player_id];
+            psd.m_player_name = "AI_" + boost::lexical_cast<std::string>(player_id);
+            psd.m_client_type = Networking::CLIENT_TYPE_AI_PLAYER;
+        }
+
+        // objects created before the game starts are created on BEFORE_FIRST_TURN
+        GalaxySetupData galaxy_setup_data;
+        app.SetCurrentTurn(BEFORE_FIRST_TURN);
+        GetUniverse().CreateUniverse(options.systems,                   options.shape,
+                                     galaxy_setup_data.m_age,           galaxy_setup_data.m_starlane_freq,
+                                     galaxy_setup_data.m_planet_density, galaxy_setup_data.m_specials_freq,
+                                     galaxy_setup_data.m_monster_freq,  galaxy_setup_data.m_native_freq,
+                                     player_setup_data,                 options.seed);
+        app.SetCurrentTurn(1);
+
+        GetUniverse().UpdateEmpireLatestKnownObjectsAndVisibilityTurns();
+        InitEmpires();
+    }
+
+    /** Loads a saved game, as ServerApp::LoadGameInit() does. */
+    void LoadUniverse(ServerApp& app, const BenchmarkOptions& options) {
+        ServerSaveGameData server_save_game_data;
+        std::vector<PlayerSaveGameData> player_save_game_data;
+        LoadGame(options.save_file, server_save_game_data, player_save_game_data,
+                 GetUniverse(), Empires(), GetSpeciesManager());
+        GetUniverse().LoadDeferredEmpireKnownObjects();
+        app.SetCurrentTurn(server_save_game_data.m_current_turn);
+        InitEmpires();
+
+        // turn processing uses the same random numbers each run
+        Seed(options.seed);
+    }
+
+    /** Returns the orders of the empire with id \a empire_id for this turn.
+        With \a move_fleets, each of its fleets that isn't moving is sent to
+        a random system. */
+    OrderSet* EmpireOrders(int empire_id, bool move_fleets) {
+        OrderSet* orders = new OrderSet();
+        if (!move_fleets)
+            return orders;
+
+        const ObjectMap& objects = GetUniverse().Objects();
+        const std::vector<int> system_ids = objects.FindObjectIDs<System>();
+        if (system_ids.empty())
+            return orders;
+
+        const std::vector<const Fleet*> fleets = objects.FindObjects<Fleet>();
+        for (std::vector<const Fleet*>::const_iterator it = fleets.begin(); it != fleets.end(); ++it) {
+            const Fleet* fleet = *it;
+            if (!fleet->OwnedBy(empire_id) || fleet->SystemID() == INVALID_OBJECT_ID ||
+                (fleet->FinalDestinationID() != INVALID_OBJECT_ID && fleet->FinalDestinationID() != fleet->SystemID()))
+            { continue; }
+            const int destination_id = system_ids[RandSmallInt(0, static_cast<int>(system_ids.size()) - 1)];
+            orders->IssueOrder(OrderPtr(new FleetMoveOrder(empire_id, fleet->ID(), fleet->SystemID(), destination_id)));
+        }
+        return orders;
+    }
+
+    /** Returns a checksum of the game state: the universe's objects and
+        their meters, and the empires' stockpiles and researched techs. */
+    std::string GameStateChecksum() {
+        Checksum checksum;
+        const std::string universe_checksum = UniverseChecksum(GetUniverse());
+        checksum.Add(universe_checksum.data(), universe_checksum.size());
+
+        const ObjectMap& objects = GetUniverse().Objects();
+        for (ObjectMap::const_iterator<> it = objects.const_begin(); it != objects.const_end(); ++it) {
+            const std::map<MeterType, Meter>& meters = it->Meters();
+            for (std::map<MeterType, Meter>::const_iterator meter_it = meters.begin(); meter_it != meters.end(); ++meter_it) {
+                checksum.Add(static_cast<int>(meter_it->first));
+                checksum.Add(meter_it->second.Current());
+            }
+        }
+
+        for (EmpireManager::const_iterator it = Empires().begin(); it != Empires().end(); ++it) {
+            const Empire* empire = it->second;
+            checksum.Add(it->first);
+            for (int resource = RE_INDUSTRY; resource < NUM_RESOURCE_TYPES; ++resource)
+                checksum.Add(static_cast<float>(empire->ResourceStockpile(static_cast<ResourceType>(resource))));
+            checksum.Add(static_cast<int>(empire->AvailableTechs().size()));
+        }
+        return checksum.ToString();
+    }
+
+    /** Processes one turn, as the server does once all orders are in. */
+    TurnTimes TimeTurn(ServerApp& app, bool move_fleets) {
+        for (EmpireManager::const_iterator it = Empires().begin(); it != Empires().end(); ++it) {
+            if (!Empires().Eliminated(it->first))
+                app.SetEmpireTurnOrders(it->first, EmpireOrders(it->first, move_fleets));
+        }
+
+        TurnTimes times;
+        Stopwatch pre_combat_timer;
+        app.PreCombatProcessTurns();
+        times.pre_combat = pre_combat_timer.ElapsedSeconds();
+
+        Stopwatch combat_timer;
+        app.ProcessCombats();
+        times.combat = combat_timer.ElapsedSeconds();
+
+        Stopwatch post_combat_timer;
+        app.PostCombatProcessTurns();
+        times.post_combat = post_combat_timer.ElapsedSeconds();
+        return times;
+    }
+
+    std::vector<std::string> ReadBaseline(const std::string& baseline_file) {
+        boost::filesystem::ifstream ifs(baseline_file);
+        if (!ifs)
+            throw std::runtime_error("unable to read baseline file " + baseline_file);
+        std::vector<std::string> checksums;
+        std::string checksum;
+        while (ifs >> checksum)
+            checksums.push_back(checksum);
+        return checksums;
+    }
+
+    int Run(const BenchmarkOptions& options) {
+        int retval = BENCHMARK_SUCCESS;
+        std::vector<std::string> baseline;
+        if (!options.baseline_file.empty())
+            baseline = ReadBaseline(options.baseline_file);
+
+        parse::init();
+
+        ServerApp app;
+
+        Stopwatch setup_timer;
+        if (!options.save_file.empty())
+            LoadUniverse(app, options);
+        else
+            CreateUniverse(app, options);
+        std::cout << "set up turn " << app.CurrentTurn() << " in " << setup_timer.ElapsedSeconds() << " s: "
+                  << GetUniverse().Objects().NumObjects() << " objects, " << Empires().NumEmpires()
+                  << " empires" << std::endl;
+
+        for (EmpireManager::const_iterator it = Empires().begin(); it != Empires().end(); ++it) {
+            if (!Empires().Eliminated(it->first))
+                app.AddEmpireTurn(it->first);
+        }
+
+        std::vector<std::string> checksums;
+        TurnTimes total_times;
+        for (int i = 0; i < options.turns; ++i) {
+            const int turn = app.CurrentTurn();
+            const TurnTimes times = TimeTurn(app, options.move_fleets);
+            total_times.pre_combat += times.pre_combat;
+            total_times.combat += times.combat;
+            total_times.post_combat += times.post_combat;
+
+            checksums.push_back(GameStateChecksum());
+            std::cout << "turn " << turn << ": pre-combat " << times.pre_combat << " s, combat " << times.combat
+                      << " s, post-combat " << times.post_combat << " s, total " << times.Total()
+                      << " s, checksum " << checksums.back() << std::endl;
+
+            if (i < static_cast<int>(baseline.size()) && baseline[i] != checksums.back()) {
+                std::cerr << "turn " << turn << " checksum mismatch: expected " << baseline[i] << std::endl;
+                retval = BENCHMARK_MISMATCH;
+            }
+        }
+
+        std::cout << "mean turn: pre-combat " << (total_times.pre_combat / options.turns) << " s, combat "
+                  << (total_times.combat / options.turns) << " s, post-combat "
+                  << (total_times.post_combat / options.turns) << " s, total "
+                  << (total_times.Total() / options.turns) << " s" << std::endl;
+
+        if (!baseline.empty() && baseline.size() != checksums.size()) {
+            std::cerr << "baseline has " << baseline.size() << " turns' checksums, but "
+                      << checksums.size() << " turns were processed" << std::endl;
+            retval = BENCHMARK_MISMATCH;
+        }
+
+        if (!options.record_file.empty()) {
+            boost::filesystem::ofstream ofs(options.record_file);
+            for (std::vector<std::string>::const_iterator it = checksums.begin(); it != checksums.end(); ++it)
+                ofs << *it << "\n";
+            if (!ofs)
+                throw std::runtime_error("unable to write checksums to " + options.record_file);
+        }
+        return retval;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    InitDirs(argv[0]);
+
+    BenchmarkOptions options;
+    BenchmarkArgs args("turn_benchmark");
+    args.Add("--save", options.save_file, "saved game to process turns of, instead of a generated universe");
+    args.Add("--systems", options.systems, "number of systems in the generated universe (default 150)");
+    args.Add("--shape", options.shape, "galaxy shape, one of SPIRAL_2, SPIRAL_3, SPIRAL_4, CLUSTER,\n"
+             "ELLIPTICAL, IRREGULAR or RING (default SPIRAL_3)");
+    args.Add("--empires", options.empires, "number of empires in the generated universe (default 8)");
+    args.Add("--seed", options.seed, "nonzero seed of the random numbers used to generate the universe\n"
+             "and process turns (default 1)");
+    args.Add("--turns", options.turns, "number of turns processed (default 10)");
+    args.AddHandler("--orders", boost::bind(&SetOrders, boost::ref(options.move_fleets), _1),
+                    "empires' orders each turn: none, or move to send their idle fleets\n"
+                    "to random systems (default none)");
+    args.AddResourceDir();
+    args.Add("--record", options.record_file, "file to write the checksum of each turn to");
+    args.Add("--baseline", options.baseline_file, "file of checksums written by --record; exit with status 2 if a\n"
+             "turn's checksum differs from it");
+    if (!args.Parse(argc, argv) || !ValidOptions(options))
+        return args.Usage();
+
+    return RunBenchmark(args.ProgramName(), boost::bind(&Run, boost::cref(options)));
+}
@@ -25,13 +25,28 @@
 #include <boost/filesystem/fstream.hpp>
 
 
+namespace {
+    void AddOptions(OptionsDB& db) {
+        db.Add<std::string>("shared-memory-server", "OPTIONS_DB_SHARED_MEMORY_SERVER", "", Validator<std::string>(), false);
+        db.AddFlag("ai-pool-client", "OPTIONS_DB_AI_POOL_CLIENT", false);
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
+
+    /** How often a process hosting several AI players checks for messages to
+      * the others while waiting for a message to one of them. */
+    const int HOSTED_PLAYERS_POLL_MS = 10;
+}
+
 // static member(s)
 AIClientApp*  AIClientApp::s_app = 0;
 
 AIClientApp::AIClientApp(const std::vector<std::string>& args) :
     m_AI(0),
     m_player_name(""),
-    m_max_aggression(0)
+    m_max_aggression(0),
+    m_pooled(GetOptionsDB().Get<bool>("ai-pool-client")),
+    m_return_to_pool(false),
+    m_hosted(false)
 {
     if (s_app)
         throw std::runtime_error("Attempted to construct a second instance of singleton class AIClientApp");
@@ -65,11 +80,38 @@ AIClientApp::AIClientApp(const std::vector<std::string>& args) :
     Logger().setAdditivity(true);   // ...but allow the addition of others later
     Logger().setPriority(log4cpp::Priority::DEBUG);
     Logger().debug(PlayerName() + " logger initialized.");
+
+    // any further player names, before the options, are of other AI players
+    // this process hosts
+    for (std::size_t i = 3; i < args.size() && args[i].find('-') != 0; ++i) {
+        if (m_pooled) {
+            Logger().errorStream() << "AIClientApp::AIClientApp : pooled AI clients can't host other AI players; ignoring " << args[i];
+            continue;
+        }
+        Logger().debugStream() << "AIClientApp::AIClientApp : also hosting AI player " << args[i];
+        m_hosted_players.push_back(new AIClientApp(args[i], m_max_aggression));
+    }
 }
 
+AIClientApp::AIClientApp(const std::string& player_name, int max_aggression) :
+    ClientApp(true),
+    m_AI(0),
+    m_player_name(player_name),
+    m_max_aggression(max_aggression),
+    m_pooled(false),
+    m_return_to_pool(false),
+    m_hosted(true)
+{}
+
 AIClientApp::~AIClientApp() {
+    if (!m_hosted_players.empty()) {
+        for (std::vector<AIClientApp*>::iterator it = m_hosted_players.begin(); it != m_hosted_players.end(); ++it)
+            delete *it;
+        MakeCurrent();
+    }
     delete m_AI;
-    Logger().debug("Shutting down " + PlayerName() + " logger...");
+    if (!m_hosted)
+        Logger().debug("Shutting down " + PlayerName() + " logger...");
 }
 
 void AIClientApp::operator()()
@@ -89,11 +131,102 @@ const AIBase* AIClientApp::GetAI()
 void AIClientApp::Run() {
     m_AI = new PythonAI();
 
-    // connect
+    if (!m_hosted_players.empty()) {
+        RunHostedPlayers();
+        return;
+    }
+
+    while (1) {
+        ConnectToServer();
+
+        // join game, or if pooled, wait to be told which player to join as
+        if (m_pooled)
+            Networking().SendMessage(AIPoolReadyMessage());
+        else
+            Networking().SendMessage(JoinGameMessage(PlayerName(), Networking::CLIENT_TYPE_AI_PLAYER));
+
+        // respond to messages until disconnected.  The wait returns as soon as a
+        // message arrives; its timeout only bounds how long a disconnection can
+        // go unnoticed.
+        m_return_to_pool = false;
+        while (1) {
+            if (!Networking().Connected())
+                break;
+            if (Networking().WaitForMessage(250)) {
+                Message msg;
+                Networking().GetMessage(msg);
+                HandleMessage(msg);
+            }
+        }
+
+        if (!m_return_to_pool)
+            break;
+        ResetForNextGame();
+    }
+}
+
+void AIClientApp::RunHostedPlayers() {
+    std::vector<AIClientApp*> players(1, this);
+    players.insert(players.end(), m_hosted_players.begin(), m_hosted_players.end());
+    Logger().debugStream() << "AIClientApp::RunHostedPlayers : playing " << players.size() << " AI players";
+
+    for (std::size_t i = 0; i < players.size(); ++i) {
+        AIClientApp* player = players[i];
+        player->MakeCurrent();
+        // each AI imports its own copies of the AI scripts
+        if (!player->m_AI)
+            player->m_AI = new PythonAI();
+        player->ConnectToServer();
+        player->Networking().SendMessage(JoinGameMessage(player->PlayerName(), Networking::CLIENT_TYPE_AI_PLAYER));
+    }
+
+    // respond to each player's messages until all are disconnected.  The
+    // players share the Python interpreter and GetApp(), so only one message
+    // is handled at a time.
+    while (1) {
+        AIClientApp* connected_player = 0;
+        bool handled_message = false;
+        for (std::size_t i = 0; i < players.size(); ++i) {
+            AIClientApp* player = players[i];
+            if (!player->Networking().Connected())
+                continue;
+            if (!connected_player)
+                connected_player = player;
+            if (!player->Networking().MessageAvailable())
+                continue;
+            Message msg;
+            player->Networking().GetMessage(msg);
+            player->MakeCurrent();
+            player->HandleMessage(msg);
+            handled_message = true;
+        }
+        if (!connected_player)
+            break;
+        if (!handled_message)
+            connected_player->Networking().WaitForMessage(HOSTED_PLAYERS_POLL_MS);
+    }
+    MakeCurrent();
+}
+
+void AIClientApp::MakeCurrent() {
+    s_app = this;
+    SetCurrentApp(this);
+}
+
+void AIClientApp::ConnectToServer() {
+    // the shared memory the server set up for a process is used by its first player
+    const std::string shared_memory_server =
+        m_hosted ? "" : GetOptionsDB().Get<std::string>("shared-memory-server");
     const int MAX_TRIES = 10;
     int tries = 0;
     volatile bool connected = false;
-    while (tries < MAX_TRIES) {
+    if (!shared_memory_server.empty()) {
+        // if the shared memory the server set up for this AI can't be used,
+        // fall back to connecting over TCP like any other client
+        Logger().debugStream() << "Attempting to contact server through shared memory " << shared_memory_server;
+        connected = Networking().ConnectToSharedMemoryServer(shared_memory_server);
+    }
+    while (!connected && tries < MAX_TRIES) {
         Logger().debugStream() << "Attempting to contact server";
         connected = Networking().ConnectToLocalHostServer();
         if (!connected) {
@@ -108,22 +241,21 @@ void AIClientApp::Run() {
         Logger().fatalStream() << "AIClientApp::Initialize : Failed to connect to localhost server after " << MAX_TRIES << " tries.  Exiting.";
         Exit(1);
     }
+}
 
-    // join game
-    Networking().SendMessage(JoinGameMessage(PlayerName(), Networking::CLIENT_TYPE_AI_PLAYER));
-
-    // respond to messages until disconnected
-    while (1) {
-        if (!Networking().Connected())
-            break;
-        if (Networking().MessageAvailable()) {
-            Message msg;
-            Networking().GetMessage(msg);
-            HandleMessage(msg);
-        } else {
-            Sleep(250);
-        }
-    }
+void AIClientApp::ResetForNextGame() {
+    Logger().debugStream() << "AIClientApp::ResetForNextGame : " << PlayerName() << " returning to the AI client pool";
+    // the AI's own state is replaced when the next game starts or is loaded
+    m_networking.SetPlayerID(Networking::INVALID_PLAYER_ID);
+    m_networking.SetHostPlayerID(Networking::INVALID_PLAYER_ID);
+    m_empire_id = ALL_EMPIRES;
+    m_current_turn = INVALID_GAME_TURN;
+    m_last_turn_update_number = INVALID_TURN_UPDATE_NUMBER;
+    m_universe.Clear();
+    m_empires.Clear();
+    m_orders.Reset();
+    m_combat_orders.clear();
+    m_player_info.clear();
 }
 
 void AIClientApp::HandleMessage(const Message& msg) {
@@ -241,9 +373,15 @@ void AIClientApp::HandleMessage(const Message& msg) {
     case Message::TURN_UPDATE: {
         if (msg.SendingPlayer() == Networking::INVALID_PLAYER_ID) {
             //Logger().debugStream() << "AIClientApp::HandleMessage : extracting turn update message data";
-            ExtractMessageData(msg,             m_empire_id,        m_current_turn,
-                               m_empires,       m_universe,         GetSpeciesManager(),
-                               m_player_info);
+            int current_turn = m_current_turn;
+            int update_number = INVALID_TURN_UPDATE_NUMBER;
+            bool applied = ExtractMessageData(msg,          m_empire_id,        current_turn,
+                                              m_empires,    m_universe,         GetSpeciesManager(),
+                                              m_player_info, LastTurnUpdateNumber(), update_number);
+            AcknowledgeTurnUpdate(update_number, applied);
+            if (!applied)
+                break;  // server will resend the turn update as a full snapshot
+            m_current_turn = current_turn;
             //Logger().debugStream() << "AIClientApp::HandleMessage : generating orders";
             GetUniverse().InitializeSystemGraph(m_empire_id);
             m_AI->GenerateOrders();
@@ -253,8 +391,12 @@ void AIClientApp::HandleMessage(const Message& msg) {
     }
 
     case Message::TURN_PARTIAL_UPDATE:
-        if (msg.SendingPlayer() == Networking::INVALID_PLAYER_ID)
-            ExtractMessageData(msg, m_empire_id, m_universe);
+        if (msg.SendingPlayer() == Networking::INVALID_PLAYER_ID) {
+            int update_number = INVALID_TURN_UPDATE_NUMBER;
+            bool applied = ExtractMessageData(msg, m_empire_id, m_universe,
+                                              LastTurnUpdateNumber(), update_number);
+            AcknowledgeTurnUpdate(update_number, applied);
+        }
         break;
 
     case Message::TURN_PROGRESS:
@@ -285,11 +427,35 @@ void AIClientApp::HandleMessage(const Message& msg) {
         break;
 
     case Message::END_GAME: {
+        if (m_pooled) {
+            // disconnecting ends the current game's message loop in Run()
+            Logger().debugStream() << "Message::END_GAME : Returning to the AI client pool";
+            m_return_to_pool = true;
+            Networking().DisconnectFromServer();
+            break;
+        }
+        if (m_hosted || !m_hosted_players.empty()) {
+            // the process exits once all the AI players it hosts have left
+            Logger().debugStream() << "Message::END_GAME : " << PlayerName() << " leaving the game";
+            Networking().DisconnectFromServer();
+            break;
+        }
         Logger().debugStream() << "Message::END_GAME : Exiting";
         Exit(0);
         break;
     }
 
+    case Message::AI_POOL_ASSIGN: {
+        std::string player_name;
+        int max_aggression = 0;
+        ExtractMessageData(msg, player_name, max_aggression);
+        Logger().debugStream() << "AIClientApp::HandleMessage : Assigned AI player " << player_name;
+        SetPlayerName(player_name);
+        m_max_aggression = max_aggression;
+        Networking().SendMessage(JoinGameMessage(PlayerName(), Networking::CLIENT_TYPE_AI_PLAYER));
+        break;
+    }
+
     case Message::PLAYER_CHAT:
         m_AI->HandleChatMessage(msg.SendingPlayer(), msg.Text());
         break;
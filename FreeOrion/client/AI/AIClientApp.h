@@ -9,7 +9,12 @@ class AIBase;
 
 namespace log4cpp {class Category;}
 
-/** the application framework for an AI player FreeOrion client.*/
+/** the application framework for an AI player FreeOrion client.  An AI client
+    process may host several AI players, when it is given more than one player
+    name.  Each of the others has its own AIClientApp, with its own connection
+    to the server, game state and AI, and the process's content and Python
+    interpreter are shared between them.  GetApp() and ClientApp::GetApp()
+    return the AIClientApp of the player whose message is being handled. */
 class AIClientApp : public ClientApp {
 public:
    /** \name Structors */ //@{
@@ -28,17 +33,27 @@ public:
    const std::string&   PlayerName() const { return m_player_name; }
    //@}
 
-   static AIClientApp*  GetApp();       ///< returns a AIClientApp pointer to the singleton instance of the app
+   static AIClientApp*  GetApp();       ///< returns a AIClientApp pointer to the singleton instance of the app, or the current hosted player's
    const AIBase*        GetAI();        ///< returns pointer to AIBase implementation of AI for this client
 
 private:
+   AIClientApp(const std::string& player_name, int max_aggression); ///< constructs another AI player hosted by this process
+
    void                 Run();          ///< initializes app state, then executes main event handler/render loop (PollAndRender())
+   void                 RunHostedPlayers(); ///< plays all the AI players hosted by this process until they have all disconnected
+   void                 MakeCurrent();  ///< makes this the app returned by GetApp() and ClientApp::GetApp()
+   void                 ConnectToServer(); ///< connects to the server, or exits if unable to
    void                 HandleMessage(const Message& msg);
+   void                 ResetForNextGame(); ///< clears the state of the last game, before a pooled AI client returns to the pool
 
    AIBase*              m_AI;           ///< implementation of AI logic
    std::string          m_player_name;
    static AIClientApp*  s_app;
    int                  m_max_aggression;
+   bool                 m_pooled;           ///< true iff this is an AI client of the server's AI client pool, which plays many games
+   bool                 m_return_to_pool;   ///< set when a pooled AI client is told its game has ended
+   bool                 m_hosted;           ///< true iff this is one of the other AI players of a process hosting several
+   std::vector<AIClientApp*> m_hosted_players;  ///< the other AI players this process hosts, besides this one
 };
 
 #endif // _AIClientApp_h_
@@ -14,15 +14,18 @@
 // static member(s)
 ClientApp* ClientApp::s_app = 0;
 
-ClientApp::ClientApp() :
+ClientApp::ClientApp(bool hosted/* = false*/) :
     m_universe(),
     m_empire_id(ALL_EMPIRES),
-    m_current_turn(INVALID_GAME_TURN)
+    m_current_turn(INVALID_GAME_TURN),
+    m_last_turn_update_number(INVALID_TURN_UPDATE_NUMBER)
 {
 #ifdef FREEORION_BUILD_HUMAN
     EmpireEliminatedSignal.connect(boost::bind(&Universe::HandleEmpireElimination, &m_universe, _1));
 #endif
 
+    if (hosted)
+        return;
     if (s_app)
         throw std::runtime_error("Attempted to construct a second instance of ClientApp");
     s_app = this;
@@ -40,6 +43,9 @@ int ClientApp::EmpireID() const
 int ClientApp::CurrentTurn() const
 { return m_current_turn; }
 
+int ClientApp::LastTurnUpdateNumber() const
+{ return m_last_turn_update_number; }
+
 const Universe& ClientApp::GetUniverse() const
 { return m_universe; }
 
@@ -133,8 +139,17 @@ int ClientApp::GetNewDesignID() {
 ClientApp* ClientApp::GetApp()
 { return s_app; }
 
+void ClientApp::SetCurrentApp(ClientApp* app)
+{ s_app = app; }
+
 void ClientApp::SetEmpireID(int id)
 { m_empire_id = id; }
 
 void ClientApp::SetCurrentTurn(int turn)
 { m_current_turn = turn; }
+
+void ClientApp::AcknowledgeTurnUpdate(int update_number, bool applied) {
+    m_last_turn_update_number = applied ? update_number : INVALID_TURN_UPDATE_NUMBER;
+    if (update_number != INVALID_TURN_UPDATE_NUMBER)
+        m_networking.SendMessage(TurnUpdateAckMessage(m_networking.PlayerID(), update_number, applied));
+}
@@ -24,7 +24,10 @@ namespace log4cpp {class Category;};
 class ClientApp {
 public:
     /** \name Structors */ //@{
-    ClientApp();
+    /** Constructs the singleton ClientApp, or if \a hosted is true, one of
+      * several ClientApps of a process that plays several players, which is
+      * made the one returned by GetApp() with SetCurrentApp(). */
+    explicit ClientApp(bool hosted = false);
     virtual ~ClientApp();
     //@}
 
@@ -32,6 +35,7 @@ public:
     int                     PlayerID() const;         ///< returns the player ID of this client
     int                     EmpireID() const;         ///< returns the empire ID of this client
     int                     CurrentTurn() const;      ///< returns the current game turn
+    int                     LastTurnUpdateNumber() const; ///< returns the number of the last delta-encoded turn update applied, or INVALID_TURN_UPDATE_NUMBER
 
     int                     EmpirePlayerID(int empire_id) const; ///< returns the player ID for the player playing the empire with ID \a empire_id
 
@@ -61,6 +65,11 @@ public:
 
     void SetEmpireID(int id);                   ///< sets the empire ID of this client
     void SetCurrentTurn(int turn);              ///< sets the current game turn
+
+    /** Records whether the turn update numbered \a update_number was applied,
+      * and if it was delta-encoded, tells the server, so that a full snapshot
+      * is sent next if it was not. */
+    void AcknowledgeTurnUpdate(int update_number, bool applied);
     void SetSinglePlayerGame(bool sp = true);   ///< sets whether the current game is single player (sp = true) or multiplayer (sp = false)
 
     /** returns a universe object ID which can be used for new objects created by the client.
@@ -76,9 +85,11 @@ public:
         notification that one of these IDs has become invalidated.*/
     mutable boost::signal<void (int)> EmpireEliminatedSignal;
 
-    static ClientApp*       GetApp(); ///< returns the singleton ClientApp object
+    static ClientApp*       GetApp(); ///< returns the singleton ClientApp object, or the current one of a process hosting several players
 
 protected:
+    static void             SetCurrentApp(ClientApp* app);  ///< makes \a app the ClientApp returned by GetApp()
+
     Universe                  m_universe;
     EmpireManager             m_empires;
     OrderSet                  m_orders;
@@ -86,6 +97,7 @@ protected:
     ClientNetworking          m_networking;
     int                       m_empire_id;
     int                       m_current_turn;
+    int                       m_last_turn_update_number;
     std::map<int, PlayerInfo> m_player_info;    ///< indexed by player id, contains info about all players in the game
 
 private:
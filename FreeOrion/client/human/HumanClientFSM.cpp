@@ -6,6 +6,7 @@
 #include "../../universe/Species.h"
 #include "../../network/Networking.h"
 #include "../../util/MultiplayerCommon.h"
+#include "../../util/Serialize.h"
 #include "../../UI/ChatWnd.h"
 #include "../../UI/PlayerListWnd.h"
 #include "../../UI/CombatWnd.h"
@@ -495,7 +496,18 @@ boost::statechart::result PlayingGame::react(const TurnProgress& msg) {
 boost::statechart::result PlayingGame::react(const TurnPartialUpdate& msg) {
     if (TRACE_EXECUTION) Logger().debugStream() << "(HumanClientFSM) PlayingGame.TurnPartialUpdate";
 
-    ExtractMessageData(msg.m_message,   Client().EmpireID(),    GetUniverse());
+    int update_number = INVALID_TURN_UPDATE_NUMBER;
+    bool applied = false;
+    try {
+        applied = ExtractMessageData(msg.m_message,   Client().EmpireID(),    GetUniverse(),
+                                     Client().LastTurnUpdateNumber(),       update_number);
+    } catch (...) {
+        Client().AcknowledgeTurnUpdate(update_number, false);
+        throw;
+    }
+    Client().AcknowledgeTurnUpdate(update_number, applied);
+    if (!applied)
+        return discard_event();
 
     Client().GetClientUI()->GetMapWnd()->MidTurnUpdate();
 
@@ -591,16 +603,25 @@ boost::statechart::result WaitingForTurnData::react(const TurnUpdate& msg) {
     if (TRACE_EXECUTION) Logger().debugStream() << "(HumanClientFSM) PlayingGame.TurnUpdate";
 
     int current_turn = INVALID_GAME_TURN;
+    int update_number = INVALID_TURN_UPDATE_NUMBER;
+    bool applied = false;
 
     try {
-        ExtractMessageData(msg.m_message,   Client().EmpireID(),    current_turn,
-                           Empires(),       GetUniverse(),          GetSpeciesManager(),
-                           Client().Players());
+        applied = ExtractMessageData(msg.m_message,   Client().EmpireID(),    current_turn,
+                                     Empires(),       GetUniverse(),          GetSpeciesManager(),
+                                     Client().Players(), Client().LastTurnUpdateNumber(), update_number);
     } catch (...) {
+        Client().AcknowledgeTurnUpdate(update_number, false);
         Client().GetClientUI()->GetMessageWnd()->HandleLogMessage(UserString("ERROR_PROCESSING_SERVER_MESSAGE") + "\n");
         return discard_event();
     }
 
+    // a delta against an update this client doesn't have; keep waiting for
+    // the full snapshot the server sends in response to the acknowledgement
+    Client().AcknowledgeTurnUpdate(update_number, applied);
+    if (!applied)
+        return discard_event();
+
     Logger().debugStream() << "Extracted TurnUpdate message for turn: " << current_turn;
 
     Client().SetCurrentTurn(current_turn);
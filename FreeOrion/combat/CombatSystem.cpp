@@ -254,156 +254,6 @@ void CombatInfo::GetEmpireObjectVisibilityToSerialize(Universe::EmpireObjectVisi
 // AutoResolveCombat
 ////////////////////////////////////////////////
 namespace {
-    void AttackShipShip(Ship* attacker, float damage, Ship* target, std::set<int>& damaged_object_ids) {
-        if (!attacker || ! target) return;
-        if (damage <= 0.0f)
-            return;
-
-        const ShipDesign* attacker_design = attacker->Design();
-        if (!attacker_design)
-            return;
-
-        Meter* target_shield = target->UniverseObject::GetMeter(METER_SHIELD);
-        Meter* target_structure = target->UniverseObject::GetMeter(METER_STRUCTURE);
-        if (!target_shield || ! target_structure) {
-            Logger().errorStream() << "couldn't get target structure or shield meter";
-            return;
-        }
-
-        Logger().debugStream() << "AttackShipShip: attacker: " << attacker->Name() << " damage: " << damage
-                               << "  target: " << target->Name() << " shield: " << target_shield->Current()
-                                                                 << " structure: " << target_structure->Current();
-
-        // damage shields, limited by shield current value and damage amount.
-        // remaining damage, if any, above shield current value goes to structure
-        float shield_damage = std::min(target_shield->Current(), damage);
-        float structure_damage = 0.0f;
-        if (shield_damage >= target_shield->Current())
-            structure_damage = std::min(target_structure->Current(), damage - shield_damage);
-
-        if (shield_damage > 0 || structure_damage > 0)
-            damaged_object_ids.insert(target->ID());
-
-        if (shield_damage > 0) {
-            target_shield->AddToCurrent(-shield_damage);
-            Logger().debugStream() << "COMBAT: Ship " << attacker->Name() << " (" << attacker->ID() << ") does " << shield_damage << " shield damage to Ship " << target->Name() << " (" << target->ID() << ")";
-        }
-        if (structure_damage > 0) {
-            target_structure->AddToCurrent(-structure_damage);
-            Logger().debugStream() << "COMBAT: Ship " << attacker->Name() << " (" << attacker->ID() << ") does " << structure_damage << " structure damage to Ship " << target->Name() << " (" << target->ID() << ")";
-        }
-
-        attacker->SetLastTurnActiveInCombat(CurrentTurn());
-        target->SetLastTurnActiveInCombat(CurrentTurn());
-    }
-
-    void AttackShipPlanet(Ship* attacker, float damage, Planet* target, std::set<int>& damaged_object_ids) {
-        if (!attacker || ! target) return;
-        if (damage <= 0.0f)
-            return;
-
-        const ShipDesign* attacker_design = attacker->Design();
-        if (!attacker_design)
-            return;
-
-        Meter* target_shield = target->GetMeter(METER_SHIELD);
-        Meter* target_defense = target->UniverseObject::GetMeter(METER_DEFENSE);
-        Meter* target_construction = target->UniverseObject::GetMeter(METER_CONSTRUCTION);
-        if (!target_shield) {
-            Logger().errorStream() << "couldn't get target shield meter";
-            return;
-        }
-        if (!target_defense) {
-            Logger().errorStream() << "couldn't get target defense meter";
-            return;
-        }
-        if (!target_construction) {
-            Logger().errorStream() << "couldn't get target construction meter";
-            return;
-        }
-
-        Logger().debugStream() << "AttackShipPlanet: attacker: " << attacker->Name() << " damage: " << damage
-                               << "\ntarget: " << target->Name() << " shield: " << target_shield->Current()
-                                                                 << " defense: " << target_defense->Current()
-                                                                 << " infra: " << target_construction->Current();
-
-        // damage shields, limited by shield current value and damage amount.
-        // remaining damage, if any, above shield current value goes to defense.
-        // remaining damage, if any, above defense current value goes to construction
-        float shield_damage = std::min(target_shield->Current(), damage);
-        float defense_damage = 0.0f;
-        float construction_damage = 0.0f;
-        if (shield_damage >= target_shield->Current())
-            defense_damage = std::min(target_defense->Current(), damage - shield_damage);
-
-        if (shield_damage > 0 || defense_damage > 0 || construction_damage > 0)
-            damaged_object_ids.insert(target->ID());
-
-        if (defense_damage >= target_defense->Current())
-            construction_damage = std::min(target_construction->Current(), damage - shield_damage - defense_damage);
-
-        if (shield_damage >= 0) {
-            target_shield->AddToCurrent(-shield_damage);
-            Logger().debugStream() << "COMBAT: Ship " << attacker->Name() << " (" << attacker->ID() << ") does " << shield_damage << " shield damage to Planet " << target->Name() << " (" << target->ID() << ")";
-        }
-        if (defense_damage >= 0) {
-            target_defense->AddToCurrent(-defense_damage);
-            Logger().debugStream() << "COMBAT: Ship " << attacker->Name() << " (" << attacker->ID() << ") does " << defense_damage << " defense damage to Planet " << target->Name() << " (" << target->ID() << ")";
-        }
-        if (construction_damage >= 0) {
-            target_construction->AddToCurrent(-construction_damage);
-            Logger().debugStream() << "COMBAT: Ship " << attacker->Name() << " (" << attacker->ID() << ") does " << construction_damage << " instrastructure damage to Planet " << target->Name() << " (" << target->ID() << ")";
-        }
-
-        attacker->SetLastTurnActiveInCombat(CurrentTurn());
-        target->SetLastTurnAttackedByShip(CurrentTurn());
-    }
-
-    void AttackPlanetShip(Planet* attacker, Ship* target, std::set<int>& damaged_object_ids) {
-        if (!attacker || ! target) return;
-
-        float damage = attacker->UniverseObject::GetMeter(METER_DEFENSE)->Current();   // planet "Defense" meter is actually its attack power
-        if (damage <= 0.0)
-            return;
-
-        Meter* target_shield = target->UniverseObject::GetMeter(METER_SHIELD);
-        Meter* target_structure = target->UniverseObject::GetMeter(METER_STRUCTURE);
-        if (!target_shield || ! target_structure) {
-            Logger().errorStream() << "couldn't get target structure or shield meter";
-            return;
-        }
-
-        Logger().debugStream() << "AttackPlanetShip: attacker: " << attacker->Name() << " damage: " << damage
-                               << "\ntarget: " << target->Name() << " shield: " << target_shield->Current()
-                                                                 << " structure: " << target_structure->Current();
-
-        // damage shields, limited by shield current value and damage amount.
-        // remaining damage, if any, above shield current value goes to structure
-        float shield_damage = std::min(target_shield->Current(), damage);
-        float structure_damage = 0.0f;
-        if (shield_damage >= target_shield->Current())
-            structure_damage = std::min(target_structure->Current(), damage - shield_damage);
-
-        if (shield_damage > 0 || structure_damage > 0)
-            damaged_object_ids.insert(target->ID());
-
-        if (shield_damage >= 0) {
-            target_shield->AddToCurrent(-shield_damage);
-            Logger().debugStream() << "COMBAT: Planet " << attacker->Name() << " (" << attacker->ID() << ") does " << shield_damage << " shield damage to Ship " << target->Name() << " (" << target->ID() << ")";
-        }
-        if (structure_damage >= 0) {
-            target_structure->AddToCurrent(-structure_damage);
-            Logger().debugStream() << "COMBAT: Planet " << attacker->Name() << " (" << attacker->ID() << ") does " << structure_damage << " structure damage to Ship " << target->Name() << " (" << target->ID() << ")";
-        }
-
-        target->SetLastTurnActiveInCombat(CurrentTurn());
-    }
-
-    void AttackPlanetPlanet(Planet* attacker, Planet* target, std::set<int>& damaged_object_ids) {
-        Logger().debugStream() << "AttackPlanetPlanet does nothing!";
-        // intentionally left empty
-    }
-
     bool ObjectCanBeAttacked(const UniverseObject* obj) {
         if (!obj)
             return false;
@@ -506,288 +356,390 @@ namespace {
         }
         return retval;
     }
-}
 
-void AutoResolveCombat(CombatInfo& combat_info) {
-    if (combat_info.objects.Empty())
-        return;
+    /** Flat structure-of-arrays copy of the combat-relevant state of the
+      * objects participating in a battle.  Participants are stored in
+      * ascending object id order, so that selecting the n'th entry of a
+      * sorted index list picks the same object that advancing an iterator of
+      * a std::set<int> of object ids n times would.  Empires are likewise
+      * stored in ascending id order and referred to by index. */
+    struct CombatState {
+        CombatState() :
+            system(0),
+            verbose(false)
+        {}
 
-    const System* system = combat_info.objects.Object<System>(combat_info.system_id);
-    if (!system)
-        Logger().errorStream() << "AutoResolveCombat couldn't get system with id " << combat_info.system_id;
-    else
-        Logger().debugStream() << "AutoResolveCombat at " << system->Name();
+        int     EmpireIndex(int empire_id) const {
+            std::vector<int>::const_iterator it = std::lower_bound(empire_ids.begin(), empire_ids.end(), empire_id);
+            return static_cast<int>(it - empire_ids.begin());
+        }
+
+        const System*                   system;
+        bool                            verbose;
+
+        // participants, indexed by participant number
+        std::vector<UniverseObject*>    objects;
+        std::vector<int>                object_ids;
+        std::vector<UniverseObjectType> object_types;
+        std::vector<int>                owners;             ///< index into empire_ids of the owner of each participant
+        std::vector<float>              shield;
+        std::vector<float>              structure;          ///< ships only
+        std::vector<float>              defense;            ///< planets only
+        std::vector<float>              construction;       ///< planets only
+        std::vector<unsigned char>      damaged;
+        std::vector<unsigned char>      active_in_combat;   ///< ships only
+        std::vector<unsigned char>      attacked_by_ship;   ///< planets only
+
+        // weapons of participant i are weapon_damage[weapons_begin[i]] to
+        // weapon_damage[weapons_begin[i + 1] - 1].  planets have a single
+        // weapon, but attack with their defense meter's value at the time of
+        // the attack, so its entry is unused.
+        std::vector<std::size_t>        weapons_begin;
+        std::vector<float>              weapon_damage;
+
+        // sorted participant indices
+        std::vector<int>                attackers;          ///< all participants that can still attack
+        std::vector<std::vector<int> >  empire_attackers;   ///< participants that can still attack, by owner
+        std::vector<std::vector<int> >  empire_targets;     ///< participants that each empire can attack
+
+        std::vector<int>                empire_ids;         ///< sorted ids of empires, including ALL_EMPIRES for monsters, if present
+    };
 
-    if (GetOptionsDB().Get<bool>("verbose-logging")) {
-        Logger().debugStream() << "%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%";
-        Logger().debugStream() << "AutoResolveCombat objects before resolution: " << combat_info.objects.Dump();
+    void InsertSorted(std::vector<int>& vec, int value) {
+        std::vector<int>::iterator it = std::lower_bound(vec.begin(), vec.end(), value);
+        if (it == vec.end() || *it != value)
+            vec.insert(it, value);
     }
 
-    // reasonably unpredictable but reproducible random seeding
-    const int base_seed = combat_info.objects.begin()->ID() + CurrentTurn();
+    void EraseSorted(std::vector<int>& vec, int value) {
+        std::vector<int>::iterator it = std::lower_bound(vec.begin(), vec.end(), value);
+        if (it != vec.end() && *it == value)
+            vec.erase(it);
+    }
 
+    /** Copies the objects in \a combat_info that can attack or be attacked
+      * into \a state, along with each empire's initial attackers and valid
+      * targets. */
+    void PackCombatState(CombatInfo& combat_info, CombatState& state) {
+        state.system = combat_info.objects.Object<System>(combat_info.system_id);
+        state.verbose = GetOptionsDB().Get<bool>("verbose-logging");
+
+        // monsters' detection strength limits which ships they can see.
+        // targets' owners may also be empires not involved in the battle.
+        float monster_detection = 0.0;
+        std::set<int> empire_ids(combat_info.empire_ids);
+        for (ObjectMap::iterator<> it = combat_info.objects.begin(); it != combat_info.objects.end(); ++it) {
+            const UniverseObject* obj = *it;
+            if (obj->Unowned() && obj->ObjectType() == OBJ_SHIP)
+                monster_detection = std::max(monster_detection, obj->CurrentMeterValue(METER_DETECTION));
+            if (ObjectCanAttack(obj) || ObjectCanBeAttacked(obj))
+                empire_ids.insert(obj->Owner());
+        }
+        state.empire_ids.assign(empire_ids.begin(), empire_ids.end());
+        state.empire_attackers.resize(state.empire_ids.size());
+        state.empire_targets.resize(state.empire_ids.size());
+
+        // ObjectMap iterates in id order, so participant indices are id-sorted
+        for (ObjectMap::iterator<> it = combat_info.objects.begin(); it != combat_info.objects.end(); ++it) {
+            UniverseObject* obj = *it;
+            bool can_attack = ObjectCanAttack(obj);
+            bool can_be_attacked = ObjectCanBeAttacked(obj);
+            if (!can_attack && !can_be_attacked)
+                continue;
 
-    // compile list of valid objects to attack or be attacked in this combat
-    std::set<int> valid_target_object_ids;                          // all objects that can be attacked
-    std::set<int> valid_attacker_object_ids;                        // all objects that can attack
-    std::map<int, std::set<int> > empire_valid_attacker_object_ids; // objects that can attack that each empire owns
-    float monster_detection = 0.0;
+            UniverseObjectType obj_type = obj->ObjectType();
+            const Meter* shield = obj->UniverseObject::GetMeter(METER_SHIELD);
+            const Meter* structure = obj->UniverseObject::GetMeter(METER_STRUCTURE);
+            const Meter* defense = obj->UniverseObject::GetMeter(METER_DEFENSE);
+            const Meter* construction = obj->UniverseObject::GetMeter(METER_CONSTRUCTION);
+            if (!shield || (obj_type == OBJ_SHIP && !structure) ||
+                (obj_type == OBJ_PLANET && (!defense || !construction)))
+            {
+                Logger().errorStream() << "AutoResolveCombat couldn't get combat meters of object " << obj->Name() << " (" << obj->ID() << ")";
+                continue;
+            }
 
-    for (ObjectMap::iterator<> it = combat_info.objects.begin(); it != combat_info.objects.end(); ++it) {
-        const UniverseObject* obj = *it;
-        //Logger().debugStream() << "Considerting object " << obj->Name() << " owned by " << obj->Owner();
-        if (ObjectCanAttack(obj)) {
-            //Logger().debugStream() << "... can attack";
-            valid_attacker_object_ids.insert(it->ID());
-            empire_valid_attacker_object_ids[obj->Owner()].insert(it->ID());
-        }
-        if (ObjectCanBeAttacked(obj)) {
-            //Logger().debugStream() << "... can be attacked";
-            valid_target_object_ids.insert(it->ID());
-        }
-        if (obj->Unowned() && obj->ObjectType() == OBJ_SHIP)
-            monster_detection = std::max(monster_detection, obj->CurrentMeterValue(METER_DETECTION));
-    }
+            int index = static_cast<int>(state.objects.size());
+            int owner = state.EmpireIndex(obj->Owner());
+
+            state.objects.push_back(obj);
+            state.object_ids.push_back(obj->ID());
+            state.object_types.push_back(obj_type);
+            state.owners.push_back(owner);
+            state.shield.push_back(shield->Current());
+            state.structure.push_back(structure ? structure->Current() : 0.0f);
+            state.defense.push_back(defense ? defense->Current() : 0.0f);
+            state.construction.push_back(construction ? construction->Current() : 0.0f);
+            state.damaged.push_back(false);
+            state.active_in_combat.push_back(false);
+            state.attacked_by_ship.push_back(false);
+
+            state.weapons_begin.push_back(state.weapon_damage.size());
+            if (obj_type == OBJ_SHIP) {
+                std::vector<PartAttackInfo> weapons = ShipWeaponsStrengths(universe_object_cast<Ship*>(obj));
+                for (std::vector<PartAttackInfo>::const_iterator part_it = weapons.begin();
+                     part_it != weapons.end(); ++part_it)
+                { state.weapon_damage.push_back(static_cast<float>(part_it->part_attack)); }
+            } else {
+                state.weapon_damage.push_back(state.defense.back());
+            }
 
+            if (can_attack) {
+                state.attackers.push_back(index);
+                state.empire_attackers[owner].push_back(index);
+            }
 
-    // map from empire to set of IDs of objects that empire's objects
-    // could potentially target.
-    std::map<int, std::set<int> > empire_valid_target_object_ids;   // objects that each empire can attack
-    for (std::set<int>::const_iterator target_it = valid_target_object_ids.begin();
-         target_it != valid_target_object_ids.end(); ++target_it)
-    {
-        int object_id = *target_it;
-        const UniverseObject* obj = combat_info.objects.Object(object_id);
-        //Logger().debugStream() << "Considering attackability of object " << obj->Name() << " owned by " << obj->Owner();
-
-        // for all empires, can they attack this object?
-        for (std::set<int>::const_iterator empire_it = combat_info.empire_ids.begin();
-             empire_it != combat_info.empire_ids.end(); ++empire_it)
-        {
-            int attacking_empire_id = *empire_it;
-            if (attacking_empire_id == ALL_EMPIRES) {
-                if (ObjectAttackableByMonsters(obj, monster_detection)) {
-                    //Logger().debugStream() << "object: " << obj->Name() << " attackable by monsters";
-                    empire_valid_target_object_ids[ALL_EMPIRES].insert(object_id);
-                }
+            if (!can_be_attacked)
+                continue;
 
-            } else {
-                // call function to find if empires can attack objects...
-                if (ObjectAttackableByEmpire(obj, attacking_empire_id)) {
-                    //Logger().debugStream() << "object: " << obj->Name() << " attackable by empire " << attacking_empire_id;
-                    empire_valid_target_object_ids[attacking_empire_id].insert(object_id);
-                }
+            // for all empires, can they attack this object?
+            for (std::set<int>::const_iterator empire_it = combat_info.empire_ids.begin();
+                 empire_it != combat_info.empire_ids.end(); ++empire_it)
+            {
+                int attacking_empire_id = *empire_it;
+                bool attackable = attacking_empire_id == ALL_EMPIRES ?
+                    ObjectAttackableByMonsters(obj, monster_detection) :
+                    ObjectAttackableByEmpire(obj, attacking_empire_id);
+                if (attackable)
+                    state.empire_targets[state.EmpireIndex(attacking_empire_id)].push_back(index);
             }
         }
+        state.weapons_begin.push_back(state.weapon_damage.size());
     }
 
+    /** Applies \a damage from participant \a attacker to participant \a target
+      * in \a state.  Damage goes first to shields, then to structure of ships
+      * or defense and then construction of planets.  Planets attack with
+      * their current defense meter value instead of \a damage. */
+    void Attack(CombatState& state, int attacker, float damage, int target) {
+        UniverseObjectType attacker_type = state.object_types[attacker];
+        UniverseObjectType target_type = state.object_types[target];
 
-    // Each combat "round" a randomly-selected object in the battle attacks
-    // something, if it is able to do so.  The number of rounds scales with the
-    // number of objects, so the total actions per object is independent of
-    // number of objects in the battle
-    const int NUM_COMBAT_ROUNDS = 3*valid_attacker_object_ids.size();
+        if (attacker_type == OBJ_PLANET) {
+            if (target_type != OBJ_SHIP)
+                return; // planets don't attack planets
+            damage = state.defense[attacker];   // planet "Defense" meter is actually its attack power
+        }
+        if (damage <= 0.0f)
+            return;
 
-    for (int round = 1; round <= NUM_COMBAT_ROUNDS; ++round) {
-        Seed(base_seed + round);    // ensure each combat round produces different results
+        float& shield = state.shield[target];
+        float shield_damage = std::min(shield, damage);
 
-        // ensure something can attack and something can be attacked
-        if (valid_attacker_object_ids.empty()) {
-            Logger().debugStream() << "Nothing left can attack; combat over";
-            break;
-        }
-        if (empire_valid_target_object_ids.empty()) {
-            Logger().debugStream() << "Nothing left can be attacked; combat over";
-            break;
-        }
-        // empires may have valid targets, but nothing to attack with.  If all
-        // empires have no attackers or no valid targers, combat is over
-        bool someone_can_attack_something = false;
-        for (std::map<int, std::set<int> >::const_iterator attacker_it = empire_valid_attacker_object_ids.begin();
-             attacker_it != empire_valid_attacker_object_ids.end(); ++attacker_it)
-        {
-            if (empire_valid_target_object_ids.find(attacker_it->first) != empire_valid_target_object_ids.end()) {
-                someone_can_attack_something = true;
-                break;
+        if (target_type == OBJ_SHIP) {
+            float& structure = state.structure[target];
+            float structure_damage = 0.0f;
+            if (shield_damage >= shield)
+                structure_damage = std::min(structure, damage - shield_damage);
+
+            if (shield_damage > 0 || structure_damage > 0)
+                state.damaged[target] = true;
+
+            if (attacker_type == OBJ_SHIP) {
+                if (shield_damage > 0)
+                    shield -= shield_damage;
+                if (structure_damage > 0)
+                    structure -= structure_damage;
+                state.active_in_combat[attacker] = true;
+            } else {
+                shield -= shield_damage;
+                structure -= structure_damage;
             }
-        }
-        if (!someone_can_attack_something) {
-            Logger().debugStream() << "No empire has valid targets and something to attack with; combat over.";
-            break;
-        }
+            state.active_in_combat[target] = true;
 
-        Logger().debugStream() << "Combat at " << system->Name() << " (" << combat_info.system_id << ") Round " << round;
+            if (state.verbose)
+                Logger().debugStream() << "COMBAT: " << state.objects[attacker]->Name() << " (" << state.object_ids[attacker]
+                                       << ") does " << shield_damage << " shield and " << structure_damage << " structure damage to Ship "
+                                       << state.objects[target]->Name() << " (" << state.object_ids[target] << ")";
 
-        // select attacking object in battle
-        SmallIntDistType attacker_id_num_dist = SmallIntDist(0, valid_attacker_object_ids.size() - 1);
-        std::set<int>::const_iterator attacker_it = valid_attacker_object_ids.begin();
-        std::advance(attacker_it, attacker_id_num_dist());
-        assert(attacker_it != valid_attacker_object_ids.end());
-        int attacker_id = *attacker_it;
+        } else {
+            float& defense = state.defense[target];
+            float& construction = state.construction[target];
+            float defense_damage = 0.0f;
+            float construction_damage = 0.0f;
+            if (shield_damage >= shield)
+                defense_damage = std::min(defense, damage - shield_damage);
 
-        UniverseObject* attacker = combat_info.objects.Object(attacker_id);
-        if (!attacker) {
-            Logger().errorStream() << "AutoResolveCombat couldn't get object with id " << attacker_id;
-            continue;
-        }
-        Logger().debugStream() << "Attacker: " << attacker->Name();
+            if (shield_damage > 0 || defense_damage > 0)
+                state.damaged[target] = true;
 
+            if (defense_damage >= defense)
+                construction_damage = std::min(construction, damage - shield_damage - defense_damage);
 
-        Ship* attack_ship = universe_object_cast<Ship*>(attacker);
-        Planet* attack_planet = universe_object_cast<Planet*>(attacker);
+            shield -= shield_damage;
+            defense -= defense_damage;
+            construction -= construction_damage;
+
+            state.active_in_combat[attacker] = true;
+            state.attacked_by_ship[target] = true;
+
+            if (state.verbose)
+                Logger().debugStream() << "COMBAT: Ship " << state.objects[attacker]->Name() << " (" << state.object_ids[attacker]
+                                       << ") does " << shield_damage << " shield, " << defense_damage << " defense and "
+                                       << construction_damage << " infrastructure damage to Planet "
+                                       << state.objects[target]->Name() << " (" << state.object_ids[target] << ")";
+        }
+    }
 
-        // loop over weapons of attacking object.  each gets a shot at a
-        // randomly selected target object
-        std::vector<PartAttackInfo> weapons;
+    /** Returns true if participant \a index has been destroyed (ships) or
+      * knocked out of the battle (planets). */
+    bool OutOfCombat(const CombatState& state, int index) {
+        if (state.object_types[index] == OBJ_SHIP)
+            return state.structure[index] <= 0.0;
+        return state.shield[index] <= 0.0 &&
+               state.defense[index] <= 0.0 &&
+               state.construction[index] <= 0.0;
+    }
 
-        if (attack_ship) {
-            weapons = ShipWeaponsStrengths(attack_ship);
-            for (std::vector<PartAttackInfo>::const_iterator part_it = weapons.begin();
-                 part_it != weapons.end(); ++part_it)
+    /** Removes participant \a index from the lists of valid attackers and
+      * targets, and records its destruction if it is a ship. */
+    void RemoveFromCombat(CombatInfo& combat_info, CombatState& state, int index) {
+        int object_id = state.object_ids[index];
+        if (state.object_types[index] == OBJ_SHIP) {
+            Logger().debugStream() << "!! Target Ship " << object_id << " is destroyed!";
+            combat_info.destroyed_object_ids.insert(object_id);
+            // all empires in battle know object was destroyed
+            for (std::set<int>::const_iterator it = combat_info.empire_ids.begin();
+                 it != combat_info.empire_ids.end(); ++it)
             {
-                Logger().debugStream() << "weapon: " << part_it->part_type_name <<
-                                          " attack: " << part_it->part_attack;
+                if (*it != ALL_EMPIRES)
+                    combat_info.destroyed_object_knowers[*it].insert(object_id);
             }
-        } else if (attack_planet) { // treat planet defenses as short range
-            weapons.push_back(PartAttackInfo(PC_SHORT_RANGE, "", attack_planet->CurrentMeterValue(METER_DEFENSE)));
+        } else {
+            Logger().debugStream() << "!! Target Planet " << object_id << " is knocked out of battle";
         }
 
-        if (weapons.empty()) {
-            Logger().debugStream() << "no weapons' can't attack";
-            continue;   // no ability to attack!
+        EraseSorted(state.attackers, index);
+        for (std::size_t i = 0; i < state.empire_ids.size(); ++i) {
+            EraseSorted(state.empire_targets[i], index);
+            EraseSorted(state.empire_attackers[i], index);  // TODO: only erase from owner's entry in this list
         }
+    }
 
-        for (std::vector<PartAttackInfo>::const_iterator weapon_it = weapons.begin();
-             weapon_it != weapons.end(); ++weapon_it)
-        {
-            // select object from valid targets for this object's owner   TODO: with this weapon...
-            Logger().debugStream() << "Attacking with weapon " << weapon_it->part_type_name << " with power " << weapon_it->part_attack;
-
-            // get valid targets set for attacker owner.  need to do this for
-            // each weapon that is attacking, as the previous shot might have
-            // destroyed something
-            int attacker_owner_id = attacker->Owner();
-
-            std::map<int, std::set<int> >::iterator target_vec_it = empire_valid_target_object_ids.find(attacker_owner_id);
-            if (target_vec_it == empire_valid_target_object_ids.end()) {
-                Logger().debugStream() << "No targets for attacker with id: " << attacker_owner_id;
+    /** Runs the rounds of combat on \a state.  Each combat "round" a
+      * randomly-selected object in the battle attacks something, if it is
+      * able to do so.  The number of rounds scales with the number of
+      * objects, so the total actions per object is independent of number of
+      * objects in the battle. */
+    void ResolveCombatRounds(CombatInfo& combat_info, CombatState& state, int base_seed) {
+        const int NUM_COMBAT_ROUNDS = 3*state.attackers.size();
+        const std::size_t num_empires = state.empire_ids.size();
+
+        for (int round = 1; round <= NUM_COMBAT_ROUNDS; ++round) {
+            Seed(base_seed + round);    // ensure each combat round produces different results
+
+            // ensure something can attack and something can be attacked.
+            // empires may have valid targets, but nothing to attack with.  If
+            // all empires have no attackers or no valid targets, combat is over
+            if (state.attackers.empty()) {
+                Logger().debugStream() << "Nothing left can attack; combat over";
+                break;
+            }
+            bool someone_can_attack_something = false;
+            for (std::size_t i = 0; i < num_empires; ++i) {
+                if (!state.empire_attackers[i].empty() && !state.empire_targets[i].empty()) {
+                    someone_can_attack_something = true;
+                    break;
+                }
+            }
+            if (!someone_can_attack_something) {
+                Logger().debugStream() << "No empire has valid targets and something to attack with; combat over.";
                 break;
             }
 
-            const std::set<int>& valid_target_ids = target_vec_it->second;
-            if (valid_target_ids.empty())
-                break; // should be redundant with this entry being erased when emptied
-
+            if (state.verbose)
+                Logger().debugStream() << "Combat at " << (state.system ? state.system->Name() : "") << " (" << combat_info.system_id << ") Round " << round;
 
-            // select target object
-            SmallIntDistType target_id_num_dist = SmallIntDist(0, valid_target_ids.size() - 1);
-            std::set<int>::const_iterator target_it = valid_target_ids.begin();
-            std::advance(target_it, target_id_num_dist());
-            assert(target_it != valid_target_ids.end());
-            int target_id = *target_it;
+            // select attacking object in battle
+            SmallIntDistType attacker_num_dist = SmallIntDist(0, state.attackers.size() - 1);
+            int attacker = state.attackers[attacker_num_dist()];
+            int attacker_owner = state.owners[attacker];
 
-            UniverseObject* target = combat_info.objects.Object(target_id);
-            if (!target) {
-                Logger().errorStream() << "AutoResolveCombat couldn't get target object with id " << target_id;
+            // loop over weapons of attacking object.  each gets a shot at a
+            // randomly selected target object
+            std::size_t weapons_end = state.weapons_begin[attacker + 1];
+            if (state.weapons_begin[attacker] == weapons_end) {
+                if (state.verbose)
+                    Logger().debugStream() << "Attacker " << state.object_ids[attacker] << " has no weapons; can't attack";
                 continue;
             }
-            Logger().debugStream() << "Target: " << target->Name();
-
 
-            // do actual attacks, and mark attackers as valid targets for attacked object's owners
-            if (attack_ship) {
-                if (Ship* target_ship = universe_object_cast<Ship*>(target)) {
-                    AttackShipShip(attack_ship, weapon_it->part_attack, target_ship, combat_info.damaged_object_ids);
-                    empire_valid_target_object_ids[target_ship->Owner()].insert(attacker_id);
-                } else if (Planet* target_planet = universe_object_cast<Planet*>(target)) {
-                    AttackShipPlanet(attack_ship, weapon_it->part_attack,  target_planet, combat_info.damaged_object_ids);
-                    empire_valid_target_object_ids[target_planet->Owner()].insert(attacker_id);
-                }
-            } else if (attack_planet) {
-                if (Ship* target_ship = universe_object_cast<Ship*>(target)) {
-                    AttackPlanetShip(attack_planet, target_ship, combat_info.damaged_object_ids);
-                    empire_valid_target_object_ids[target_ship->Owner()].insert(attacker_id);
-                } else if (Planet* target_planet = universe_object_cast<Planet*>(target)) {
-                    AttackPlanetPlanet(attack_planet, target_planet, combat_info.damaged_object_ids);
-                    empire_valid_target_object_ids[target_planet->Owner()].insert(attacker_id);
+            for (std::size_t weapon = state.weapons_begin[attacker]; weapon != weapons_end; ++weapon) {
+                // get valid targets for attacker owner.  need to do this for
+                // each weapon that is attacking, as the previous shot might
+                // have destroyed something
+                const std::vector<int>& valid_targets = state.empire_targets[attacker_owner];
+                if (valid_targets.empty()) {
+                    Logger().debugStream() << "No targets for attacker with id: " << state.object_ids[attacker];
+                    break;
                 }
-            }
 
+                // select target object
+                SmallIntDistType target_num_dist = SmallIntDist(0, valid_targets.size() - 1);
+                int target = valid_targets[target_num_dist()];
 
-            // check for destruction of target object
-            if (target->ObjectType() == OBJ_SHIP) {
-                if (target->CurrentMeterValue(METER_STRUCTURE) <= 0.0) {
-                    Logger().debugStream() << "!! Target Ship is destroyed!";
-                    // object id destroyed
-                    combat_info.destroyed_object_ids.insert(target_id);
-                    // all empires in battle know object was destroyed
-                    for (std::set<int>::const_iterator it = combat_info.empire_ids.begin();
-                         it != combat_info.empire_ids.end(); ++it)
-                    {
-                        int empire_id = *it;
-                        if (empire_id != ALL_EMPIRES)
-                            combat_info.destroyed_object_knowers[empire_id].insert(target_id);
-                    }
-
-                    // remove destroyed ship's ID from lists of valid attackers and targets
-                    valid_attacker_object_ids.erase(target_id);
-                    valid_target_object_ids.erase(target_id);   // probably not necessary as this set isn't used in this loop
-
-                    for (target_vec_it = empire_valid_target_object_ids.begin();
-                         target_vec_it != empire_valid_target_object_ids.end(); ++target_vec_it)
-                    { target_vec_it->second.erase(target_id); }
-
-                    for (target_vec_it = empire_valid_attacker_object_ids.begin();
-                         target_vec_it != empire_valid_attacker_object_ids.end(); ++target_vec_it)
-                    { target_vec_it->second.erase(target_id); } // TODO: only erase from owner's entry in this list
-                }
+                // do actual attack, and mark attacker as valid target for
+                // attacked object's owner
+                Attack(state, attacker, state.weapon_damage[weapon], target);
+                InsertSorted(state.empire_targets[state.owners[target]], attacker);
 
-            } else if (target->ObjectType() == OBJ_PLANET) {
-                if (target->CurrentMeterValue(METER_SHIELD) <= 0.0 &&
-                    target->CurrentMeterValue(METER_DEFENSE) <= 0.0 &&
-                    target->CurrentMeterValue(METER_CONSTRUCTION) <= 0.0)
-                {
-                    Logger().debugStream() << "!! Target Planet is knocked out of battle";
+                // check for destruction of target object
+                if (OutOfCombat(state, target))
+                    RemoveFromCombat(combat_info, state, target);
+            }
+        }
+    }
 
-                    // remove disabled planet's ID from lists of valid attackers and targets
-                    valid_attacker_object_ids.erase(target_id);
-                    valid_target_object_ids.erase(target_id);   // probably not necessary as this set isn't used in this loop
+    /** Copies the meter values and combat activity in \a state back to the
+      * objects they were packed from. */
+    void UnpackCombatState(CombatInfo& combat_info, const CombatState& state) {
+        int current_turn = CurrentTurn();
+        for (std::size_t i = 0; i < state.objects.size(); ++i) {
+            UniverseObject* obj = state.objects[i];
+            obj->UniverseObject::GetMeter(METER_SHIELD)->SetCurrent(state.shield[i]);
+
+            if (Ship* ship = universe_object_cast<Ship*>(obj)) {
+                ship->UniverseObject::GetMeter(METER_STRUCTURE)->SetCurrent(state.structure[i]);
+                if (state.active_in_combat[i])
+                    ship->SetLastTurnActiveInCombat(current_turn);
+
+            } else if (Planet* planet = universe_object_cast<Planet*>(obj)) {
+                planet->UniverseObject::GetMeter(METER_DEFENSE)->SetCurrent(state.defense[i]);
+                planet->UniverseObject::GetMeter(METER_CONSTRUCTION)->SetCurrent(state.construction[i]);
+                if (state.attacked_by_ship[i])
+                    planet->SetLastTurnAttackedByShip(current_turn);
+            }
 
-                    for (target_vec_it = empire_valid_target_object_ids.begin();
-                         target_vec_it != empire_valid_target_object_ids.end(); ++target_vec_it)
-                    { target_vec_it->second.erase(target_id); }
+            if (state.damaged[i])
+                combat_info.damaged_object_ids.insert(state.object_ids[i]);
+        }
+    }
+}
 
-                    for (target_vec_it = empire_valid_attacker_object_ids.begin();
-                         target_vec_it != empire_valid_attacker_object_ids.end(); ++target_vec_it)
-                    { target_vec_it->second.erase(target_id); } // TODO: only erase from owner's entry in this list
-                }
-            }
+void AutoResolveCombat(CombatInfo& combat_info) {
+    if (combat_info.objects.Empty())
+        return;
 
-            // check if any empire has no remaining target or attacker objects.
-            // If so, remove that empire's entry
-            std::map<int, std::set<int> > temp = empire_valid_target_object_ids;
-            for (target_vec_it = empire_valid_target_object_ids.begin();
-                 target_vec_it != empire_valid_target_object_ids.end(); ++target_vec_it)
-            {
-                if (target_vec_it->second.empty()) {
-                    temp.erase(target_vec_it->first);
-                    Logger().debugStream() << "No valid targets left for empire with id: " << target_vec_it->first;
-                }
-            }
-            empire_valid_target_object_ids = temp;
+    const System* system = combat_info.objects.Object<System>(combat_info.system_id);
+    if (!system)
+        Logger().errorStream() << "AutoResolveCombat couldn't get system with id " << combat_info.system_id;
+    else
+        Logger().debugStream() << "AutoResolveCombat at " << system->Name();
 
-            temp = empire_valid_attacker_object_ids;
-            for (target_vec_it = empire_valid_attacker_object_ids.begin();
-                 target_vec_it != empire_valid_attacker_object_ids.end(); ++target_vec_it)
-            {
-                if (target_vec_it->second.empty()) {
-                    temp.erase(target_vec_it->first);
-                    Logger().debugStream() << "No valid attacking objects left for empire with id: " << target_vec_it->first;
-                }
-            }
-            empire_valid_attacker_object_ids = temp;
-        } // end for over weapons
-    } // end for over combat arounds
+    if (GetOptionsDB().Get<bool>("verbose-logging")) {
+        Logger().debugStream() << "%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%%";
+        Logger().debugStream() << "AutoResolveCombat objects before resolution: " << combat_info.objects.Dump();
+    }
+
+    // reasonably unpredictable but reproducible random seeding
+    const int base_seed = combat_info.objects.begin()->ID() + CurrentTurn();
+
+    // copy participants into contiguous arrays, fight on those, and then
+    // copy the results back into the objects
+    CombatState state;
+    PackCombatState(combat_info, state);
+    ResolveCombatRounds(combat_info, state, base_seed);
+    UnpackCombatState(combat_info, state);
 
     // ensure every participant knows what happened.
     // TODO: assemble list of objects to copy for each empire.  this should
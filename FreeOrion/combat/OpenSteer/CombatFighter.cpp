@@ -290,20 +290,33 @@ int CombatFighter::Owner() const
 
 void CombatFighter::update(const float elapsed_time, bool force)
 {
-    OpenSteer::Vec3 steer = m_last_steer;
-    if (force ||
-        m_pathing_engine->UpdateNumber() % PathingEngine::UPDATE_SETS ==
+    if (UpdateActions(force) == RECOMPUTE_STEERING)
+        UpdateSteering();
+    UpdateMotion(elapsed_time);
+}
+
+CombatObject::UpdateAction CombatFighter::UpdateActions(bool force)
+{
+    if (!force &&
+        m_pathing_engine->UpdateNumber() % PathingEngine::UPDATE_SETS !=
         serialNumber % PathingEngine::UPDATE_SETS) {
-        if (m_leader) {
-            if (m_last_queue_update_turn != m_turn)
-                UpdateMissionQueue();
-            if (m_last_fired_turn != m_turn)
-                FireAtHostiles();
-        }
-        steer = Steer();
+        return KEEP_STEERING;
     }
-    applySteeringForce(steer, elapsed_time);
-    m_last_steer = steer;
+    if (m_leader) {
+        if (m_last_queue_update_turn != m_turn)
+            UpdateMissionQueue();
+        if (m_last_fired_turn != m_turn)
+            FireAtHostiles();
+    }
+    return RECOMPUTE_STEERING;
+}
+
+void CombatFighter::UpdateSteering()
+{ m_last_steer = Steer(); }
+
+void CombatFighter::UpdateMotion(float elapsed_time)
+{
+    applySteeringForce(m_last_steer, elapsed_time);
     if (m_leader)
         m_proximity_token->UpdatePosition(position());
 }
@@ -397,6 +410,9 @@ void CombatFighter::TurnStarted(unsigned int number)
 void CombatFighter::SignalDestroyed()
 { Listener().FighterDestroyed(shared_from_this()); }
 
+void CombatFighter::SetProximityToken(ProximityDBToken* token)
+{ m_proximity_token = token; }
+
 void CombatFighter::SetWeakPtr(const CombatFighterPtr& ptr)
 { m_weak_ptr = ptr; }
 
@@ -700,12 +716,6 @@ void CombatFighter::FireAtHostiles()
 
 OpenSteer::Vec3 CombatFighter::Steer()
 {
-    static bool once = true;
-    if (once && Stats().m_type == BOMBER && m_leader) {
-        //m_instrument = true;
-        once = false;
-    }
-
     // A note about obstacle avoidance.  Avoidance of static obstacles (planets,
     // asteroid fields, etc.) are represented in static_obstacle_avoidance.  The
     // analogous avoidance of dynamic obstacles (ships, etc.) -- that is, an
@@ -722,9 +732,7 @@ OpenSteer::Vec3 CombatFighter::Steer()
     const float OBSTACLE_AVOIDANCE_TIME = 1.0;
 
     const OpenSteer::Vec3 static_obstacle_avoidance =
-        steerToAvoidObstacles(OBSTACLE_AVOIDANCE_TIME,
-                              m_pathing_engine->Obstacles().begin(),
-                              m_pathing_engine->Obstacles().end());
+        steerToAvoidObstacles(OBSTACLE_AVOIDANCE_TIME, m_pathing_engine->BatchedObstacles());
 
     if (static_obstacle_avoidance != OpenSteer::Vec3::zero)
         return static_obstacle_avoidance;
@@ -849,15 +857,14 @@ OpenSteer::Vec3 CombatFighter::Steer()
         std::swap(neighbors, neighbors_to_use);
     }
 
-    const OpenSteer::Vec3 separation_vec = steerForSeparation(SEPARATION_RADIUS,
-                                                              SEPARATION_ANGLE,
-                                                              neighbors_to_use);
-    const OpenSteer::Vec3 alignment_vec  = steerForAlignment(ALIGNMENT_RADIUS,
-                                                             ALIGNMENT_ANGLE,
-                                                             neighbors_to_use);
-    const OpenSteer::Vec3 cohesion_vec  = steerForCohesion(COHESION_RADIUS,
-                                                           COHESION_ANGLE,
-                                                           neighbors_to_use);
+    OpenSteer::Vec3 separation_vec;
+    OpenSteer::Vec3 alignment_vec;
+    OpenSteer::Vec3 cohesion_vec;
+    steerForFlocking(SEPARATION_RADIUS, SEPARATION_ANGLE,
+                     ALIGNMENT_RADIUS, ALIGNMENT_ANGLE,
+                     COHESION_RADIUS, COHESION_ANGLE,
+                     neighbors_to_use, m_flocking_scratch,
+                     separation_vec, alignment_vec, cohesion_vec);
 
     return
         mission_vec * m_mission_weight +
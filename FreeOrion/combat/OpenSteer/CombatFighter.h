@@ -79,6 +79,9 @@ public:
     virtual int             Owner() const;
 
     virtual void update(const float elapsed_time, bool force);
+    virtual UpdateAction UpdateActions(bool force);
+    virtual void UpdateSteering();
+    virtual void UpdateMotion(float elapsed_time);
     virtual void regenerateLocalSpace(const OpenSteer::Vec3& newVelocity,
                                       const float elapsedTime);
 
@@ -93,6 +96,7 @@ public:
     virtual void    Damage(const CombatFighterPtr& source);
     virtual void    TurnStarted(unsigned int number);
     virtual void    SignalDestroyed();
+    virtual void    SetProximityToken(ProximityDBToken* token);
 
     void SetWeakPtr(const CombatFighterPtr& ptr);
     CombatFighterPtr shared_from_this();
@@ -138,6 +142,10 @@ private:
 
     FighterStats        m_stats;
 
+    // Reused by Steer() on every update, so that flocking does not allocate
+    // once per fighter per step.  Not serialized.
+    OpenSteer::VehicleArrays    m_flocking_scratch;
+
     PathingEngine*      m_pathing_engine;
 
     // TODO: Temporary only!
@@ -20,6 +20,13 @@ public:
         NON_PD_DAMAGE
     };
 
+    /** What an object's update should do after UpdateActions() returns. */
+    enum UpdateAction {
+        KEEP_STEERING,      ///< move using the previous update's steering force
+        RECOMPUTE_STEERING, ///< call UpdateSteering() before moving
+        REMOVED_FROM_ENGINE ///< the object removed itself from its PathingEngine and must not be updated further
+    };
+
     CombatObject();
 
     void SetListener(CombatEventListener& listener);
@@ -38,6 +45,30 @@ public:
     virtual void    TurnStarted(unsigned int number) = 0;
     virtual void    SignalDestroyed() = 0;
 
+    /** Takes ownership of \a token, this object's token in its
+        PathingEngine's proximity database.  Only used after loading, since
+        tokens are not serialized. */
+    virtual void    SetProximityToken(ProximityDBToken* token) = 0;
+
+    /** \name Two-Phase Update
+        update() is equivalent to calling UpdateActions(), UpdateSteering() if
+        requested, and UpdateMotion().  PathingEngine::Update() may instead call
+        each of these on all objects before moving on to the next, so that
+        steering forces can be computed concurrently. */ //@{
+    /** Performs the parts of an update that may modify other objects or the
+        PathingEngine, such as updating missions and firing weapons. */
+    virtual UpdateAction    UpdateActions(bool force) = 0;
+
+    /** Computes a new steering force.  Only reads the state of other objects
+        and of the PathingEngine, so it may be called concurrently for
+        different objects, as long as none of them is moving. */
+    virtual void            UpdateSteering() = 0;
+
+    /** Applies the current steering force for \a elapsed_time, and records the
+        resulting position in the PathingEngine's proximity database. */
+    virtual void            UpdateMotion(float elapsed_time) = 0;
+    //@}
+
 protected:
     CombatEventListener& Listener();
 
@@ -280,18 +280,31 @@ void CombatShip::ClearFighterMissions()
 
 void CombatShip::update(const float elapsed_time, bool force)
 {
-    OpenSteer::Vec3 steer = m_last_steer;
-    if (force ||
-        m_pathing_engine->UpdateNumber() % PathingEngine::UPDATE_SETS ==
+    if (UpdateActions(force) == RECOMPUTE_STEERING)
+        UpdateSteering();
+    UpdateMotion(elapsed_time);
+}
+
+CombatObject::UpdateAction CombatShip::UpdateActions(bool force)
+{
+    if (!force &&
+        m_pathing_engine->UpdateNumber() % PathingEngine::UPDATE_SETS !=
         serialNumber % PathingEngine::UPDATE_SETS) {
-        if (m_last_queue_update_turn != m_turn)
-            UpdateMissionQueue();
-        if (GetShip().IsArmed())
-            FireAtHostiles();
-        steer = Steer();
+        return KEEP_STEERING;
     }
-    applySteeringForce(steer, elapsed_time);
-    m_last_steer = steer;
+    if (m_last_queue_update_turn != m_turn)
+        UpdateMissionQueue();
+    if (GetShip().IsArmed())
+        FireAtHostiles();
+    return RECOMPUTE_STEERING;
+}
+
+void CombatShip::UpdateSteering()
+{ m_last_steer = Steer(); }
+
+void CombatShip::UpdateMotion(float elapsed_time)
+{
+    applySteeringForce(m_last_steer, elapsed_time);
     m_proximity_token->UpdatePosition(position());
 }
 
@@ -344,6 +357,9 @@ void CombatShip::TurnStarted(unsigned int number)
 void CombatShip::SignalDestroyed()
 { Listener().ShipDestroyed(shared_from_this()); }
 
+void CombatShip::SetProximityToken(ProximityDBToken* token)
+{ m_proximity_token = token; }
+
 void CombatShip::SetWeakPtr(const CombatShipPtr& ptr)
 { m_weak_ptr = ptr; }
 
@@ -793,9 +809,7 @@ OpenSteer::Vec3 CombatShip::Steer()
     const float OBSTACLE_AVOIDANCE_TIME = 6.0;
 
     const OpenSteer::Vec3 avoidance =
-        steerToAvoidObstacles(OBSTACLE_AVOIDANCE_TIME,
-                              m_pathing_engine->Obstacles().begin(),
-                              m_pathing_engine->Obstacles().end());
+        steerToAvoidObstacles(OBSTACLE_AVOIDANCE_TIME, m_pathing_engine->BatchedObstacles());
 
     if (avoidance != OpenSteer::Vec3::zero)
         return avoidance;
@@ -71,33 +71,49 @@ int Missile::Owner() const
 
 void Missile::update(const float elapsed_time, bool force)
 {
-    OpenSteer::Vec3 steer = m_last_steer;
-    if (force ||
-        m_pathing_engine->UpdateNumber() % PathingEngine::UPDATE_SETS ==
+    UpdateAction action = UpdateActions(force);
+    if (action == REMOVED_FROM_ENGINE)
+        return;
+    if (action == RECOMPUTE_STEERING)
+        UpdateSteering();
+    UpdateMotion(elapsed_time);
+}
+
+CombatObject::UpdateAction Missile::UpdateActions(bool force)
+{
+    if (!force &&
+        m_pathing_engine->UpdateNumber() % PathingEngine::UPDATE_SETS !=
         serialNumber % PathingEngine::UPDATE_SETS) {
-        const float AT_DESTINATION = speed();
-        const float AT_DEST_SQUARED = AT_DESTINATION * AT_DESTINATION;
-        float distance_squared = (m_destination - position()).lengthSquared();
-        CombatObjectPtr target = m_target.lock();
-        if (distance_squared < AT_DEST_SQUARED) {
-            if (target) {
-                Listener().MissileExploded(shared_from_this());
-                target->Damage(Stats().m_damage, NON_PD_DAMAGE);
-            } else {
-                Listener().MissileRemoved(shared_from_this());
-            }
-            delete m_proximity_token;
-            m_proximity_token = 0;
-            m_pathing_engine->RemoveObject(shared_from_this());
-            return;
+        return KEEP_STEERING;
+    }
+    const float AT_DESTINATION = speed();
+    const float AT_DEST_SQUARED = AT_DESTINATION * AT_DESTINATION;
+    float distance_squared = (m_destination - position()).lengthSquared();
+    CombatObjectPtr target = m_target.lock();
+    if (distance_squared < AT_DEST_SQUARED) {
+        if (target) {
+            Listener().MissileExploded(shared_from_this());
+            target->Damage(Stats().m_damage, NON_PD_DAMAGE);
         } else {
-            if (target)
-                m_destination = target->position();
+            Listener().MissileRemoved(shared_from_this());
         }
-        steer = Steer();
+        delete m_proximity_token;
+        m_proximity_token = 0;
+        m_pathing_engine->RemoveObject(shared_from_this());
+        return REMOVED_FROM_ENGINE;
+    } else {
+        if (target)
+            m_destination = target->position();
     }
-    applySteeringForce(steer, elapsed_time);
-    m_last_steer = steer;
+    return RECOMPUTE_STEERING;
+}
+
+void Missile::UpdateSteering()
+{ m_last_steer = Steer(); }
+
+void Missile::UpdateMotion(float elapsed_time)
+{
+    applySteeringForce(m_last_steer, elapsed_time);
     m_proximity_token->UpdatePosition(position());
 }
 
@@ -121,6 +137,9 @@ void Missile::TurnStarted(unsigned int number)
 void Missile::SignalDestroyed()
 { Listener().MissileRemoved(shared_from_this()); }
 
+void Missile::SetProximityToken(ProximityDBToken* token)
+{ m_proximity_token = token; }
+
 void Missile::SetWeakPtr(const MissilePtr& ptr)
 { m_weak_ptr = ptr; }
 
@@ -170,9 +189,7 @@ OpenSteer::Vec3 Missile::Steer()
     const float OBSTACLE_AVOIDANCE_TIME = 2.0;
 
     const OpenSteer::Vec3 avoidance =
-        steerToAvoidObstacles(OBSTACLE_AVOIDANCE_TIME,
-                              m_pathing_engine->Obstacles().begin(),
-                              m_pathing_engine->Obstacles().end());
+        steerToAvoidObstacles(OBSTACLE_AVOIDANCE_TIME, m_pathing_engine->BatchedObstacles());
 
     if (avoidance != OpenSteer::Vec3::zero)
         return avoidance;
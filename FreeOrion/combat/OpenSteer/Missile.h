@@ -31,6 +31,9 @@ public:
     virtual int Owner() const;
 
     virtual void update(const float elapsed_time, bool force);
+    virtual UpdateAction UpdateActions(bool force);
+    virtual void UpdateSteering();
+    virtual void UpdateMotion(float elapsed_time);
     virtual void regenerateLocalSpace(const OpenSteer::Vec3& newVelocity,
                                       const float elapsedTime);
 
@@ -38,6 +41,7 @@ public:
     virtual void Damage(const CombatFighterPtr& source);
     virtual void TurnStarted(unsigned int number);
     virtual void SignalDestroyed();
+    virtual void SetProximityToken(ProximityDBToken* token);
 
     void SetWeakPtr(const MissilePtr& ptr);
     MissilePtr shared_from_this();
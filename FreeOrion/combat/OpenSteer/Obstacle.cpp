@@ -114,6 +114,97 @@ firstPathIntersectionWithObstacleGroup (const AbstractVehicle& vehicle,
 }
 
 
+// ----------------------------------------------------------------------------
+// ObstacleBatch
+
+
+void
+OpenSteer::ObstacleBatch::
+clear (void)
+{
+    _spheres.clear ();
+    _sphereObstacles.clear ();
+    _sphereOrder.clear ();
+    _otherObstacles.clear ();
+    _otherOrder.clear ();
+}
+
+
+void
+OpenSteer::ObstacleBatch::
+push_back (const AbstractObstacle* obstacle)
+{
+    const std::size_t order = _sphereOrder.size () + _otherOrder.size ();
+
+    // a sphere seen from inside or both ways can need avoiding even when
+    // the path misses it, so only those seen from outside are batched
+    const SphereObstacle* sphere = dynamic_cast<const SphereObstacle*> (obstacle);
+    if (sphere && sphere->seenFrom () == AbstractObstacle::outside)
+    {
+        _spheres.push_back (sphere->center, sphere->radius);
+        _sphereObstacles.push_back (obstacle);
+        _sphereOrder.push_back (order);
+    }
+    else
+    {
+        _otherObstacles.push_back (obstacle);
+        _otherOrder.push_back (order);
+    }
+}
+
+
+void
+OpenSteer::ObstacleBatch::
+firstPathIntersection (const AbstractVehicle& vehicle,
+                       AbstractObstacle::PathIntersection& nearest,
+                       AbstractObstacle::PathIntersection& next) const
+{
+    const Vec3 position = vehicle.position ();
+    const Vec3 forward = vehicle.forward ();
+    const float radius = vehicle.radius ();
+
+    // test the candidate spheres and the other obstacles in the order they
+    // were added, so that ties are broken as in
+    // firstPathIntersectionWithObstacleGroup
+    next.intersect = false;
+    nearest.intersect = false;
+    std::size_t s = nextPathCandidate (position, forward, radius, _spheres, 0);
+    std::size_t o = 0;
+    while (s < _sphereObstacles.size () || o < _otherObstacles.size ())
+    {
+        const AbstractObstacle* obstacle;
+        if (o == _otherObstacles.size () ||
+            (s < _sphereObstacles.size () && _sphereOrder[s] < _otherOrder[o]))
+        {
+            obstacle = _sphereObstacles[s];
+            s = nextPathCandidate (position, forward, radius, _spheres, s + 1);
+        }
+        else
+        {
+            obstacle = _otherObstacles[o++];
+        }
+
+        obstacle->findIntersectionWithVehiclePath (vehicle, next);
+
+        const bool firstFound = !nearest.intersect;
+        const bool nearestFound = (next.intersect &&
+                                   (next.distance < nearest.distance));
+        if (firstFound || nearestFound) nearest = next;
+    }
+}
+
+
+OpenSteer::Vec3
+OpenSteer::ObstacleBatch::
+steerToAvoid (const AbstractVehicle& vehicle,
+              const float minTimeToCollision) const
+{
+    AbstractObstacle::PathIntersection nearest, next;
+    firstPathIntersection (vehicle, nearest, next);
+    return nearest.steerToAvoidIfNeeded (vehicle, minTimeToCollision);
+}
+
+
 // ----------------------------------------------------------------------------
 // PathIntersection
 // determine steering once path intersections have been found
@@ -44,6 +44,7 @@
 #include "Vec3.h"
 #include "LocalSpace.h"
 #include "AbstractVehicle.h"
+#include "Vec3Batch.h"
 
 
 namespace OpenSteer {
@@ -231,6 +232,41 @@ namespace OpenSteer {
     };
 
 
+    // ----------------------------------------------------------------------------
+    // ObstacleBatch: a group of obstacles (which it does not own) arranged so
+    // that SphereObstacles seen from outside that a vehicle's path certainly
+    // misses are skipped several at a time (see nextPathCandidate) instead
+    // of being tested one by one.  Finds the same intersection that
+    // Obstacle::firstPathIntersectionWithObstacleGroup would over the
+    // obstacles in the order they were added.
+
+
+    class ObstacleBatch
+    {
+    public:
+        void clear (void);
+        void push_back (const AbstractObstacle* obstacle);
+
+        // find first vehicle path intersection with the obstacles
+        void firstPathIntersection (const AbstractVehicle& vehicle,
+                                    AbstractObstacle::PathIntersection& nearest,
+                                    AbstractObstacle::PathIntersection& next)
+            const;
+
+        // steering for a vehicle to avoid the nearest obstacle, if needed
+        Vec3 steerToAvoid (const AbstractVehicle& vehicle,
+                           const float minTimeToCollision)
+            const;
+
+    private:
+        SphereArrays _spheres;
+        std::vector<const AbstractObstacle*> _sphereObstacles;
+        std::vector<std::size_t> _sphereOrder; // position among all obstacles
+        std::vector<const AbstractObstacle*> _otherObstacles;
+        std::vector<std::size_t> _otherOrder;
+    };
+
+
     // ----------------------------------------------------------------------------
     // LocalSpaceObstacle: a mixture of LocalSpace and Obstacle methods
 
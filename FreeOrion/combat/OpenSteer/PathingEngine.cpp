@@ -2,9 +2,15 @@
 
 #include "../../universe/ShipDesign.h"
 #include "../../universe/System.h"
+#include "../../util/OptionsDB.h"
 
 #include <boost/cast.hpp>
 #include <boost/assign/list_of.hpp>
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 
 
 const unsigned int ENTER_STARLANE_DELAY_TURNS = 5;
@@ -16,12 +22,121 @@ const unsigned int MISSILE_FLAG = 1 << 3;
 const unsigned int FIGHTER_FLAGS = INTERCEPTOR_FLAG | BOMBER_FLAG;
 const unsigned int NONFIGHTER_FLAGS = ~(INTERCEPTOR_FLAG | BOMBER_FLAG);
 
+namespace {
+    void AddOptions(OptionsDB& db) {
+        db.Add("combat-pathing-threads", "OPTIONS_DB_COMBAT_PATHING_THREADS", 1, RangedValidator<int>(1, 64));
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
+
+    struct UpdateSteeringFn
+    {
+        UpdateSteeringFn(const std::vector<CombatObject*>& objects) :
+            m_objects(&objects)
+            {}
+        void operator()(std::size_t i) const
+            { (*m_objects)[i]->UpdateSteering(); }
+        const std::vector<CombatObject*>* m_objects;
+    };
+}
+
 unsigned int EnemyOfEmpireFlags(int empire_id) {
     // TODO: Use diplomatic status here, instead of just returning all empires
     // that are not us.
     return ~(1 << static_cast<unsigned int>(empire_id));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// PathingEngine::UpdateThreadPool
+////////////////////////////////////////////////////////////////////////////////
+/** A fixed set of worker threads that, together with the calling thread, call
+    a function on each index in a range.  The range is split into one
+    contiguous block per thread. */
+class PathingEngine::UpdateThreadPool
+{
+public:
+    explicit UpdateThreadPool(std::size_t threads) :
+        m_num_threads(threads),
+        m_size(0),
+        m_generation(0),
+        m_pending(0),
+        m_stop(false)
+    {
+        for (std::size_t i = 1; i < m_num_threads; ++i)
+            m_threads.create_thread(boost::bind(&UpdateThreadPool::ThreadMain, this, i));
+    }
+
+    ~UpdateThreadPool() {
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_stop = true;
+        }
+        m_work_ready.notify_all();
+        m_threads.join_all();
+    }
+
+    /** Calls \a fn(i) for each i in [0, \a size), and returns once all calls
+        have completed. */
+    void Run(std::size_t size, const boost::function<void (std::size_t)>& fn) {
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_fn = fn;
+            m_size = size;
+            m_pending = m_num_threads - 1;
+            ++m_generation;
+        }
+        m_work_ready.notify_all();
+
+        RunBlock(0, fn, size);
+
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (m_pending)
+            m_work_done.wait(lock);
+    }
+
+private:
+    void ThreadMain(std::size_t thread_index) {
+        std::size_t last_generation = 0;
+        while (true) {
+            boost::function<void (std::size_t)> fn;
+            std::size_t size = 0;
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                while (!m_stop && m_generation == last_generation)
+                    m_work_ready.wait(lock);
+                if (m_stop)
+                    return;
+                last_generation = m_generation;
+                fn = m_fn;
+                size = m_size;
+            }
+
+            RunBlock(thread_index, fn, size);
+
+            boost::mutex::scoped_lock lock(m_mutex);
+            if (!--m_pending)
+                m_work_done.notify_one();
+        }
+    }
+
+    void RunBlock(std::size_t thread_index, const boost::function<void (std::size_t)>& fn, std::size_t size) {
+        std::size_t begin = size * thread_index / m_num_threads;
+        std::size_t end = size * (thread_index + 1) / m_num_threads;
+        for (std::size_t i = begin; i < end; ++i)
+            fn(i);
+    }
+
+    const std::size_t                       m_num_threads;
+    boost::thread_group                     m_threads;
+    boost::mutex                            m_mutex;
+    boost::condition_variable               m_work_ready;
+    boost::condition_variable               m_work_done;
+    boost::function<void (std::size_t)>     m_fn;
+    std::size_t                             m_size;
+    std::size_t                             m_generation;
+    std::size_t                             m_pending;
+    bool                                    m_stop;
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 // PathingEngine
 ////////////////////////////////////////////////////////////////////////////////
@@ -34,7 +149,9 @@ const std::map<int, UniverseObject*>* PathingEngine::s_combat_universe = 0;
 PathingEngine::PathingEngine() :
     m_next_fighter_id(0),
     m_update_number(0),
-    m_proximity_database(new ProximityDB(OpenSteer::Vec3(), 2.0 * SystemRadius(), 100))
+    m_proximity_database(new ProximityDB(OpenSteer::Vec3(), 2.0 * SystemRadius(), 100)),
+    m_update_threads(GetOptionsDB().Get<int>("combat-pathing-threads")),
+    m_update_thread_pool()
 {}
 
 PathingEngine::~PathingEngine() {
@@ -54,6 +171,9 @@ const ProximityDB& PathingEngine::GetProximityDB() const
 const PathingEngine::ObstacleVec& PathingEngine::Obstacles() const
 { return m_obstacles; }
 
+const OpenSteer::ObstacleBatch& PathingEngine::BatchedObstacles() const
+{ return m_batched_obstacles; }
+
 CombatFighterPtr PathingEngine::NearestHostileFighterInRange(const OpenSteer::Vec3& position,
                                                              int empire_id, float range) const
 {
@@ -182,13 +302,45 @@ void PathingEngine::TurnStarted(unsigned int number) {
 }
 
 void PathingEngine::Update(const float elapsed_time, bool force) {
-    // We use a temporary pointer, because an object may remove itself from the
-    // engine during its update.
-    for (std::set<CombatObjectPtr>::iterator it = m_objects.begin();
-         it != m_objects.end(); ) {
-        CombatObjectPtr ptr = *it++;
-        ptr->update(elapsed_time, force);
+    // With one thread, the pool has no workers and the steering forces are
+    // computed on this thread, in the same phases as with several, so that
+    // the results don't depend on the number of threads.
+    if (!m_update_thread_pool)
+        m_update_thread_pool.reset(new UpdateThreadPool(m_update_threads));
+
+    // Objects may add or remove objects (including themselves) from the
+    // engine in their UpdateActions(), so those are done serially, on a copy
+    // of m_objects.  Objects added during this update start moving on the
+    // next one.
+    std::vector<CombatObjectPtr> objects(m_objects.begin(), m_objects.end());
+    std::vector<bool> recompute_steering(objects.size(), false);
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+        if (m_objects.find(objects[i]) == m_objects.end())
+            continue;
+        recompute_steering[i] =
+            objects[i]->UpdateActions(force) == CombatObject::RECOMPUTE_STEERING;
+    }
+
+    // Nothing moves while steering forces are being computed, so every object
+    // sees the positions all objects had at the start of this update, no
+    // matter how the work is split up among threads.
+    std::vector<CombatObject*> moving_objects;
+    std::vector<CombatObject*> steering_objects;
+    moving_objects.reserve(objects.size());
+    for (std::size_t i = 0; i < objects.size(); ++i) {
+        if (m_objects.find(objects[i]) == m_objects.end())
+            continue;
+        moving_objects.push_back(objects[i].get());
+        if (recompute_steering[i])
+            steering_objects.push_back(objects[i].get());
+    }
+    m_update_thread_pool->Run(steering_objects.size(), UpdateSteeringFn(steering_objects));
+
+    // The proximity database is not thread-safe, so objects move serially.
+    for (std::size_t i = 0; i < moving_objects.size(); ++i) {
+        moving_objects[i]->UpdateMotion(elapsed_time);
     }
+
     ++m_update_number;
 }
 
@@ -276,11 +428,15 @@ void PathingEngine::RemoveFighterFormation(const CombatFighterFormationPtr& form
 ProximityDB& PathingEngine::GetProximityDB()
 { return *m_proximity_database; }
 
-void PathingEngine::ClearObstacles()
-{ m_obstacles.clear(); }
+void PathingEngine::ClearObstacles() {
+    m_obstacles.clear();
+    m_batched_obstacles.clear();
+}
 
-void PathingEngine::AddObstacle(OpenSteer::AbstractObstacle* obstacle)
-{ m_obstacles.push_back(obstacle); }
+void PathingEngine::AddObstacle(OpenSteer::AbstractObstacle* obstacle) {
+    m_obstacles.push_back(obstacle);
+    m_batched_obstacles.push_back(obstacle);
+}
 
 void PathingEngine::RemoveFighter(const CombatFighterPtr& fighter,
                                   std::set<CombatFighterFormationPtr>::iterator formation_it)
@@ -14,6 +14,7 @@
 #endif
 
 #include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <set>
 
@@ -34,6 +35,7 @@ public:
 
     const ProximityDB& GetProximityDB() const;
     const ObstacleVec& Obstacles() const;
+    const OpenSteer::ObstacleBatch& BatchedObstacles() const;
 
     CombatFighterPtr NearestHostileFighterInRange(const OpenSteer::Vec3& position,
                                                   int empire_id, float range) const;
@@ -86,6 +88,8 @@ public:
     static const std::map<int, UniverseObject*>* s_combat_universe;
 
 private:
+    class UpdateThreadPool;
+
     void RemoveFighter(const CombatFighterPtr& fighter,
                        std::set<CombatFighterFormationPtr>::iterator formation_it);
 
@@ -96,11 +100,14 @@ private:
     Attackees m_attackees;
     ProximityDB* m_proximity_database;
     ObstacleVec m_obstacles;
+    OpenSteer::ObstacleBatch m_batched_obstacles; // m_obstacles, for obstacle avoidance; not serialized
 
     // not serialized
     std::map<int, CombatShipPtr> m_ships_by_id;
     std::map<int, CombatFighterPtr> m_leaders_by_id;
     std::map<int, CombatFighterPtr> m_fighters_by_id;
+    std::size_t m_update_threads;
+    boost::scoped_ptr<UpdateThreadPool> m_update_thread_pool;
 
     friend class boost::serialization::access;
     template <class Archive>
@@ -4,43 +4,33 @@
 
 #include "Vec3.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
 #include <map>
 #include <vector>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && 1 <= _M_IX86_FP)
+#define PROXIMITY_DATABASE_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
 
+/** A uniform grid of cells, each of which holds a compact vector of the
+    positions, type flags and empire flags of the objects in it.  Objects are
+    added with Insert(), which returns a token the object uses to report its
+    movement and which removes the object from the database when deleted.
+    Removal swaps the last entry of a cell into the vacated slot, so cells
+    stay contiguous.  Objects outside of the grid are kept in the nearest
+    cell on its boundary.  Tokens are not serialized; loading creates a new
+    token for each entry, to be handed to its object via Tokens(). */
 template <typename T>
 class ProximityDatabase
 {
-public:
-    struct StoredType
-    {
-        StoredType() :
-            m_t(),
-            m_type_flags(0),
-            m_empire_ids(0)
-            {}
-
-        StoredType(T t,
-                   unsigned int type_flags,
-                   unsigned int empire_ids) :
-            m_t(t),
-            m_type_flags(type_flags),
-            m_empire_ids(empire_ids)
-            {}
-
-        T m_t;
-        unsigned int m_type_flags;
-        unsigned int m_empire_ids;
-
-        template <class Archive>
-        void serialize(Archive& ar, const unsigned int version)
-            {
-                ar  & BOOST_SERIALIZATION_NVP(m_t)
-                    & BOOST_SERIALIZATION_NVP(m_type_flags)
-                    & BOOST_SERIALIZATION_NVP(m_empire_ids);
-            }
-    };
+private:
+    class Entry;
 
+public:
     class TokenType
     {
     public:
@@ -52,31 +42,22 @@ public:
 
     private:
         TokenType() :
-            m_object(),
-            m_old_index(-1),
+            m_cell_index(0),
+            m_slot(0),
             m_db(0)
             {}
 
-        TokenType(const StoredType& object, std::size_t index, ProximityDatabase& db) :
-            m_object(object),
-            m_old_index(index),
+        TokenType(std::size_t cell_index, std::size_t slot, ProximityDatabase& db) :
+            m_cell_index(cell_index),
+            m_slot(slot),
             m_db(&db)
             {}
 
-        StoredType m_object;
-        std::size_t m_old_index;
+        std::size_t m_cell_index;
+        std::size_t m_slot;
         ProximityDatabase* m_db;
 
         friend class ProximityDatabase<T>;
-
-        friend class boost::serialization::access;
-        template <class Archive>
-        void serialize(Archive& ar, const unsigned int version)
-            {
-                ar  & BOOST_SERIALIZATION_NVP(m_object)
-                    & BOOST_SERIALIZATION_NVP(m_old_index)
-                    & BOOST_SERIALIZATION_NVP(m_db);
-            }
     };
 
     ProximityDatabase(const OpenSteer::Vec3& center,
@@ -93,10 +74,22 @@ public:
 
     TokenType* Insert(T t, unsigned int type_flags = -1, unsigned int empire_ids = -1)
         {
-            StoredType stored_val(t, type_flags, empire_ids);
             std::size_t index = GridIndexOf(t->position());
-            m_grid_cells[index][t] = stored_val;
-            return new TokenType(stored_val, index, *this);
+            TokenType* retval = new TokenType(index, m_grid_cells[index].size(), *this);
+            m_grid_cells[index].push_back(Entry(t->position(), type_flags, empire_ids, t, retval));
+            return retval;
+        }
+
+    /** Adds the token of each object in the database to \a tokens.  Used to
+        give objects back their tokens after the database is loaded. */
+    void Tokens(std::map<T, TokenType*>& tokens) const
+        {
+            for (std::size_t i = 0; i < m_grid_cells.size(); ++i) {
+                const GridCell& cell = m_grid_cells[i];
+                for (std::size_t j = 0; j < cell.size(); ++j) {
+                    tokens[cell[j].m_t] = cell[j].m_token;
+                }
+            }
         }
 
     void FindAll(std::vector<T>& results,
@@ -104,13 +97,10 @@ public:
                  unsigned int empire_ids = -1)
         {
             for (std::size_t i = 0; i < m_grid_cells.size(); ++i) {
-                for (typename std::map<T, StoredType>::iterator it = m_grid_cells[i].begin();
-                     it != m_grid_cells[i].end();
-                     ++it) {
-                    if (type_flags & it->second.m_type_flags &&
-                        empire_ids & it->second.m_empire_ids) {
-                        results.push_back(it->first);
-                    }
+                const GridCell& cell = m_grid_cells[i];
+                for (std::size_t j = 0; j < cell.size(); ++j) {
+                    if (cell[j].Matches(type_flags, empire_ids))
+                        results.push_back(cell[j].m_t);
                 }
             }
         }
@@ -120,46 +110,164 @@ public:
                       std::vector<T>& results,
                       unsigned int type_flags = -1,
                       unsigned int empire_ids = -1)
-        { FindInRadiusImpl(center, radius, results, type_flags, empire_ids, false); }
+        {
+            float radius_squared = radius * radius;
+            SphereCellRange range = SphereCells(center, radius);
+            for (std::size_t x = range.m_begin[0]; x <= range.m_end[0]; ++x) {
+                for (std::size_t y = range.m_begin[1]; y <= range.m_end[1]; ++y) {
+                    for (std::size_t z = range.m_begin[2]; z <= range.m_end[2]; ++z) {
+                        if (radius_squared < CellDistanceSquared(center, x, y, z))
+                            continue;
+                        SearchCell(m_grid_cells[GridIndexOf(x, y, z)], center, radius_squared,
+                                   type_flags, empire_ids, &results, 0);
+                    }
+                }
+            }
+        }
 
     T FindNearestInRadius(const OpenSteer::Vec3& center,
                           const float radius,
                           unsigned int type_flags = -1,
                           unsigned int empire_ids = -1)
         {
-            std::vector<T> results;
-            FindInRadiusImpl(center, radius, results, type_flags, empire_ids, true);
-            return results[0];
+            T retval = 0;
+            float nearest_dist_squared = radius * radius;
+            SphereCellRange range = SphereCells(center, radius);
+            for (std::size_t x = range.m_begin[0]; x <= range.m_end[0]; ++x) {
+                for (std::size_t y = range.m_begin[1]; y <= range.m_end[1]; ++y) {
+                    for (std::size_t z = range.m_begin[2]; z <= range.m_end[2]; ++z) {
+                        if (nearest_dist_squared < CellDistanceSquared(center, x, y, z))
+                            continue;
+                        SearchCell(m_grid_cells[GridIndexOf(x, y, z)], center, nearest_dist_squared,
+                                   type_flags, empire_ids, 0, &retval);
+                    }
+                }
+            }
+            return retval;
         }
 
     T FindNearest(const OpenSteer::Vec3& center,
                   unsigned int type_flags = -1,
                   unsigned int empire_ids = -1)
         {
-            // TODO: Consider adding an initial pass that looks in some default
-            // nearby range first -- then fails over to a full search -- as an
-            // optimization.
+            // Search cubic shells of cells of increasing size around the
+            // cell containing center.  Once the nearest object found so far
+            // is closer than anything outside the searched cube can be, stop.
             T retval = 0;
             float nearest_dist_squared = FLT_MAX;
-            for (std::size_t i = 0; i < m_grid_cells.size(); ++i) {
-                for (typename std::map<T, StoredType>::iterator it = m_grid_cells[i].begin();
-                     it != m_grid_cells[i].end();
-                     ++it) {
-                    if (type_flags & it->second.m_type_flags &&
-                        empire_ids & it->second.m_empire_ids) {
-                        float dist_squared =
-                            (center - it->first->position()).lengthSquared();
-                        if (dist_squared < nearest_dist_squared) {
-                            nearest_dist_squared = dist_squared;
-                            retval = it->first;
+            std::size_t center_indices[3];
+            GridIndicesOf(center, center_indices[0], center_indices[1], center_indices[2]);
+            for (std::size_t shell = 0; shell < m_cells_per_side; ++shell) {
+                std::size_t begin[3];
+                std::size_t end[3];
+                bool covers_grid = true;
+                float unsearched_dist = FLT_MAX;
+                for (int axis = 0; axis < 3; ++axis) {
+                    begin[axis] = center_indices[axis] < shell ? 0 : center_indices[axis] - shell;
+                    end[axis] = std::min(center_indices[axis] + shell, m_cells_per_side - 1);
+                    if (begin[axis] != 0) {
+                        covers_grid = false;
+                        unsearched_dist = std::min(unsearched_dist, Coord(center, axis) - CellLowerBound(begin[axis], axis));
+                    }
+                    if (end[axis] != m_cells_per_side - 1) {
+                        covers_grid = false;
+                        unsearched_dist = std::min(unsearched_dist, CellUpperBound(end[axis], axis) - Coord(center, axis));
+                    }
+                }
+
+                for (std::size_t x = begin[0]; x <= end[0]; ++x) {
+                    bool x_on_shell = x + shell == center_indices[0] || x == center_indices[0] + shell;
+                    for (std::size_t y = begin[1]; y <= end[1]; ++y) {
+                        bool xy_on_shell = x_on_shell || y + shell == center_indices[1] || y == center_indices[1] + shell;
+                        for (std::size_t z = begin[2]; z <= end[2]; ++z) {
+                            // cells not on the shell's surface were searched already
+                            if (!xy_on_shell && z + shell != center_indices[2] && z != center_indices[2] + shell)
+                                continue;
+                            if (nearest_dist_squared < CellDistanceSquared(center, x, y, z))
+                                continue;
+                            SearchCell(m_grid_cells[GridIndexOf(x, y, z)], center, nearest_dist_squared,
+                                       type_flags, empire_ids, 0, &retval);
                         }
                     }
                 }
+
+                if (covers_grid || (retval && nearest_dist_squared <= unsearched_dist * unsearched_dist))
+                    break;
             }
             return retval;
         }
 
 private:
+    /** The data kept for each object in the database.  The position and type
+        flags come first so that SSE code can load them with one instruction
+        per entry. */
+    class Entry
+    {
+    public:
+        Entry() :
+            m_x(0.0f),
+            m_y(0.0f),
+            m_z(0.0f),
+            m_type_flags(0),
+            m_empire_ids(0),
+            m_t(),
+            m_token(0)
+            {}
+
+        Entry(const OpenSteer::Vec3& position,
+              unsigned int type_flags,
+              unsigned int empire_ids,
+              T t,
+              TokenType* token) :
+            m_x(position.x),
+            m_y(position.y),
+            m_z(position.z),
+            m_type_flags(type_flags),
+            m_empire_ids(empire_ids),
+            m_t(t),
+            m_token(token)
+            {}
+
+        bool Matches(unsigned int type_flags, unsigned int empire_ids) const
+            { return (type_flags & m_type_flags) && (empire_ids & m_empire_ids); }
+
+        float DistanceSquared(const OpenSteer::Vec3& p) const
+            {
+                float dx = m_x - p.x;
+                float dy = m_y - p.y;
+                float dz = m_z - p.z;
+                return dx * dx + dy * dy + dz * dz;
+            }
+
+        float m_x;
+        float m_y;
+        float m_z;
+        unsigned int m_type_flags;
+        unsigned int m_empire_ids;
+        T m_t;
+        TokenType* m_token; // not serialized
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version)
+            {
+                ar  & BOOST_SERIALIZATION_NVP(m_x)
+                    & BOOST_SERIALIZATION_NVP(m_y)
+                    & BOOST_SERIALIZATION_NVP(m_z)
+                    & BOOST_SERIALIZATION_NVP(m_type_flags)
+                    & BOOST_SERIALIZATION_NVP(m_empire_ids)
+                    & BOOST_SERIALIZATION_NVP(m_t);
+            }
+    };
+
+    typedef std::vector<Entry> GridCell;
+
+    /** Inclusive per-axis grid index ranges. */
+    struct SphereCellRange
+    {
+        std::size_t m_begin[3];
+        std::size_t m_end[3];
+    };
+
     ProximityDatabase() :
         m_origin(),
         m_dimensions(0),
@@ -170,21 +278,144 @@ private:
 
     void UpdatePosition(TokenType& token, const OpenSteer::Vec3& p)
         {
-            std::size_t old_index = token.m_old_index;
+            std::size_t old_index = token.m_cell_index;
             std::size_t new_index = GridIndexOf(p);
-            if (old_index != new_index) {
-                m_grid_cells[old_index].erase(token.m_object.m_t);
-                m_grid_cells[new_index][token.m_object.m_t] = token.m_object;
-                token.m_old_index = new_index;
+            Entry& entry = m_grid_cells[old_index][token.m_slot];
+            if (old_index == new_index) {
+                entry.m_x = p.x;
+                entry.m_y = p.y;
+                entry.m_z = p.z;
+            } else {
+                Entry moved(p, entry.m_type_flags, entry.m_empire_ids, entry.m_t, &token);
+                Erase(token);
+                token.m_cell_index = new_index;
+                token.m_slot = m_grid_cells[new_index].size();
+                m_grid_cells[new_index].push_back(moved);
             }
         }
 
     void Erase(const TokenType& token)
         {
-            assert(token.m_old_index < m_grid_cells.size());
-            assert(m_grid_cells[token.m_old_index].find(token.m_object.m_t) !=
-                   m_grid_cells[token.m_old_index].end());
-            m_grid_cells[token.m_old_index].erase(token.m_object.m_t);
+            assert(token.m_cell_index < m_grid_cells.size());
+            GridCell& cell = m_grid_cells[token.m_cell_index];
+            assert(token.m_slot < cell.size() && cell[token.m_slot].m_token == &token);
+            if (token.m_slot != cell.size() - 1) {
+                cell[token.m_slot] = cell.back();
+                cell[token.m_slot].m_token->m_slot = token.m_slot;
+            }
+            cell.pop_back();
+        }
+
+    /** Adds the objects in \a cell that match \a type_flags and \a empire_ids
+        and are no farther than sqrt(\a max_dist_squared) from \a center to \a
+        results, if nonzero.  Otherwise, sets \a nearest to the closest such
+        object, if any, and shrinks \a max_dist_squared to its distance. */
+    void SearchCell(const GridCell& cell,
+                    const OpenSteer::Vec3& center,
+                    float& max_dist_squared,
+                    unsigned int type_flags,
+                    unsigned int empire_ids,
+                    std::vector<T>* results,
+                    T* nearest)
+        {
+            std::size_t i = 0;
+#if PROXIMITY_DATABASE_USE_SSE
+            const __m128 center_x = _mm_set1_ps(center.x);
+            const __m128 center_y = _mm_set1_ps(center.y);
+            const __m128 center_z = _mm_set1_ps(center.z);
+            float dist_squared[4];
+            for (; i + 4 <= cell.size(); i += 4) {
+                __m128 x = _mm_loadu_ps(&cell[i].m_x);
+                __m128 y = _mm_loadu_ps(&cell[i + 1].m_x);
+                __m128 z = _mm_loadu_ps(&cell[i + 2].m_x);
+                __m128 flags = _mm_loadu_ps(&cell[i + 3].m_x);
+                _MM_TRANSPOSE4_PS(x, y, z, flags);
+                x = _mm_sub_ps(x, center_x);
+                y = _mm_sub_ps(y, center_y);
+                z = _mm_sub_ps(z, center_z);
+                __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+                int in_range = _mm_movemask_ps(_mm_cmple_ps(d, _mm_set1_ps(max_dist_squared)));
+                if (!in_range)
+                    continue;
+                _mm_storeu_ps(dist_squared, d);
+                for (std::size_t j = 0; j < 4; ++j) {
+                    if (in_range & (1 << j))
+                        ConsiderEntry(cell[i + j], dist_squared[j], max_dist_squared,
+                                      type_flags, empire_ids, results, nearest);
+                }
+            }
+#endif
+            for (; i < cell.size(); ++i) {
+                float dist_squared = cell[i].DistanceSquared(center);
+                if (dist_squared <= max_dist_squared)
+                    ConsiderEntry(cell[i], dist_squared, max_dist_squared,
+                                  type_flags, empire_ids, results, nearest);
+            }
+        }
+
+    static void ConsiderEntry(const Entry& entry,
+                              float dist_squared,
+                              float& max_dist_squared,
+                              unsigned int type_flags,
+                              unsigned int empire_ids,
+                              std::vector<T>* results,
+                              T* nearest)
+        {
+            if (dist_squared > max_dist_squared || !entry.Matches(type_flags, empire_ids))
+                return;
+            if (results) {
+                results->push_back(entry.m_t);
+            } else {
+                *nearest = entry.m_t;
+                max_dist_squared = dist_squared;
+            }
+        }
+
+    static float Coord(const OpenSteer::Vec3& vec, int axis)
+        { return axis == 0 ? vec.x : (axis == 1 ? vec.y : vec.z); }
+
+    /** Returns the lowest coordinate along \a axis of cells with index \a i;
+        the cells on the low boundary of the grid extend to -infinity. */
+    float CellLowerBound(std::size_t i, int axis) const
+        { return i == 0 ? -FLT_MAX : Coord(m_origin, axis) + i * m_cell_dimensions; }
+
+    /** Returns the highest coordinate along \a axis of cells with index \a i;
+        the cells on the high boundary of the grid extend to +infinity. */
+    float CellUpperBound(std::size_t i, int axis) const
+        { return i == m_cells_per_side - 1 ? FLT_MAX : Coord(m_origin, axis) + (i + 1) * m_cell_dimensions; }
+
+    /** Returns the squared distance from \a p to the nearest point in the
+        cell with indices \a x, \a y, \a z. */
+    float CellDistanceSquared(const OpenSteer::Vec3& p, std::size_t x, std::size_t y, std::size_t z) const
+        {
+            std::size_t indices[3] = {x, y, z};
+            float retval = 0.0f;
+            for (int axis = 0; axis < 3; ++axis) {
+                float coord = Coord(p, axis);
+                float lower = CellLowerBound(indices[axis], axis);
+                float upper = CellUpperBound(indices[axis], axis);
+                float d = coord < lower ? lower - coord : (upper < coord ? coord - upper : 0.0f);
+                retval += d * d;
+            }
+            return retval;
+        }
+
+    SphereCellRange SphereCells(const OpenSteer::Vec3& center, float radius)
+        {
+            SphereCellRange retval;
+            OpenSteer::Vec3 extent(radius, radius, radius);
+            GridIndicesOf(center - extent, retval.m_begin[0], retval.m_begin[1], retval.m_begin[2]);
+            GridIndicesOf(center + extent, retval.m_end[0], retval.m_end[1], retval.m_end[2]);
+            return retval;
+        }
+
+    std::size_t GridIndexOf(float rel_pos)
+        {
+            if (!(0.0f < rel_pos))
+                return 0;
+            std::size_t retval = static_cast<std::size_t>(std::min(rel_pos / m_cell_dimensions,
+                                                                   static_cast<float>(m_cells_per_side)));
+            return std::min(retval, m_cells_per_side - 1);
         }
 
     void GridIndicesOf(const OpenSteer::Vec3& vec,
@@ -193,32 +424,18 @@ private:
                        std::size_t& z_index)
         {
             OpenSteer::Vec3 rel_pos(vec - m_origin);
-            if (rel_pos.x < 0 || m_dimensions < rel_pos.x)
-                x_index = 0;
-            else
-                x_index = static_cast<std::size_t>(rel_pos.x / m_cell_dimensions);
-            if (rel_pos.y < 0 || m_dimensions < rel_pos.y)
-                y_index = 0;
-            else
-                y_index = static_cast<std::size_t>(rel_pos.y / m_cell_dimensions);
-            if (rel_pos.z < 0 || m_dimensions < rel_pos.z)
-                z_index = 0;
-            else
-                z_index = static_cast<std::size_t>(rel_pos.z / m_cell_dimensions);
+            x_index = GridIndexOf(rel_pos.x);
+            y_index = GridIndexOf(rel_pos.y);
+            z_index = GridIndexOf(rel_pos.z);
         }
 
     std::size_t GridIndexOf(const OpenSteer::Vec3& vec)
         {
-            std::size_t retval = 0;
             std::size_t x_index;
             std::size_t y_index;
             std::size_t z_index;
             GridIndicesOf(vec, x_index, y_index, z_index);
-            retval =
-                x_index * m_cells_per_side * m_cells_per_side +
-                y_index * m_cells_per_side +
-                z_index;
-            return retval;
+            return GridIndexOf(x_index, y_index, z_index);
         }
 
     std::size_t GridIndexOf(std::size_t x_index, std::size_t y_index, std::size_t z_index)
@@ -229,90 +446,22 @@ private:
                 z_index;
         }
 
-    void FindInRadiusImpl(const OpenSteer::Vec3& center,
-                          const float radius,
-                          std::vector<T>& results,
-                          unsigned int type_flags,
-                          unsigned int empire_ids,
-                          bool find_nearest)
-        {
-            if (find_nearest) {
-                results.resize(1);
-                results[0] = 0;
-            }
-
-            std::size_t grid_radius =
-                static_cast<std::size_t>(std::ceil(radius / m_cell_dimensions));
-            std::size_t x_index;
-            std::size_t y_index;
-            std::size_t z_index;
-            GridIndicesOf(center, x_index, y_index, z_index);
-
-            std::size_t x_begin = x_index - grid_radius;
-            std::size_t x_end = x_index + grid_radius;
-            if (x_index < x_begin)
-                x_begin = 0;
-            else if (m_cells_per_side <= x_end)
-                x_end = m_cells_per_side - 1;
-
-            std::size_t y_begin = y_index - grid_radius;
-            std::size_t y_end = y_index + grid_radius;
-            if (y_index < y_begin)
-                y_begin = 0;
-            else if (m_cells_per_side <= y_end)
-                y_end = m_cells_per_side - 1;
-
-            std::size_t z_end = z_index + grid_radius;
-            std::size_t z_begin = z_index - grid_radius;
-            if (z_index < z_begin)
-                z_begin = 0;
-            else if (m_cells_per_side <= z_end)
-                z_end = m_cells_per_side - 1;
-
-            float nearest_dist_squared = FLT_MAX;
-            for (std::size_t x = x_begin; x < x_end; ++x) {
-                for (std::size_t y = y_begin; y < y_end; ++y) {
-                    for (std::size_t z = z_begin; z < z_end; ++z) {
-                        std::map<T, StoredType>& cell = m_grid_cells[GridIndexOf(x, y, z)];
-                        for (typename std::map<T, StoredType>::iterator it = cell.begin();
-                             it != cell.end();
-                             ++it) {
-                            if (type_flags & it->second.m_type_flags &&
-                                empire_ids & it->second.m_empire_ids) {
-                                if (find_nearest) {
-                                    float dist_squared =
-                                        (center - it->first->position()).lengthSquared();
-                                    if (dist_squared < nearest_dist_squared) {
-                                        nearest_dist_squared = dist_squared;
-                                        results[0] = it->first;
-                                    }
-                                } else {
-                                    results.push_back(it->first);
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-        }
-
     OpenSteer::Vec3 m_origin;
     float m_dimensions;
     float m_cell_dimensions;
     std::size_t m_cells_per_side;
 
-    typedef std::map<T, StoredType> GridCell;
     std::vector<GridCell> m_grid_cells;
 
-    struct SerializableCellOccupant
+    struct SerializableCell
     {
         std::size_t m_cell_index;
-        std::pair<T, StoredType> m_value;
+        GridCell m_entries;
         template <class Archive>
         void serialize(Archive& ar, const unsigned int version)
             {
                 ar  & BOOST_SERIALIZATION_NVP(m_cell_index)
-                    & BOOST_SERIALIZATION_NVP(m_value);
+                    & BOOST_SERIALIZATION_NVP(m_entries);
             }
     };
 
@@ -327,27 +476,29 @@ private:
                 & BOOST_SERIALIZATION_NVP(m_cell_dimensions)
                 & BOOST_SERIALIZATION_NVP(m_cells_per_side);
 
-            std::vector<SerializableCellOccupant> cell_occupants;
+            std::vector<SerializableCell> occupied_cells;
             if (Archive::is_saving::value) {
                 for (std::size_t i = 0; i < m_grid_cells.size(); ++i) {
-                    SerializableCellOccupant o;
-                    o.m_cell_index = i;
-                    for (typename GridCell::const_iterator it = m_grid_cells[i].begin();
-                         it != m_grid_cells[i].end();
-                         ++it) {
-                        o.m_value = *it;
-                        cell_occupants.push_back(o);
-                    }
+                    if (m_grid_cells[i].empty())
+                        continue;
+                    occupied_cells.push_back(SerializableCell());
+                    occupied_cells.back().m_cell_index = i;
+                    occupied_cells.back().m_entries = m_grid_cells[i];
                 }
             }
 
-            ar & BOOST_SERIALIZATION_NVP(cell_occupants);
+            ar & BOOST_SERIALIZATION_NVP(occupied_cells);
 
             if (Archive::is_loading::value) {
+                m_grid_cells.clear();
                 m_grid_cells.resize(m_cells_per_side * m_cells_per_side * m_cells_per_side);
-                for (std::size_t i = 0; i < cell_occupants.size(); ++i) {
-                    m_grid_cells[cell_occupants[i].m_cell_index].insert(
-                        cell_occupants[i].m_value);
+                for (std::size_t i = 0; i < occupied_cells.size(); ++i) {
+                    std::size_t cell_index = occupied_cells[i].m_cell_index;
+                    GridCell& cell = m_grid_cells[cell_index];
+                    cell.swap(occupied_cells[i].m_entries);
+                    for (std::size_t j = 0; j < cell.size(); ++j) {
+                        cell[j].m_token = new TokenType(cell_index, j, *this);
+                    }
                 }
             }
         }
@@ -50,6 +50,7 @@
 #include "AbstractVehicle.h"
 #include "Obstacle.h"
 #include "Utilities.h"
+#include "Vec3Batch.h"
 
 
 namespace OpenSteer {
@@ -128,6 +129,9 @@ namespace OpenSteer {
         Vec3 steerToAvoidObstacles (const float minTimeToCollision,
                                     Iter first, Iter last);
 
+        Vec3 steerToAvoidObstacles (const float minTimeToCollision,
+                                    const ObstacleBatch& obstacles);
+
 
         // ------------------------------------------------------------------------
         // Unaligned collision avoidance behavior: avoid colliding with other
@@ -205,6 +209,26 @@ namespace OpenSteer {
                                const AVGroup& flock);
 
 
+        // ------------------------------------------------------------------------
+        // Separation, alignment and cohesion together, in a single batched
+        // pass over the flock (see accumulateFlocking in Vec3Batch.h);
+        // scratch holds the flock's positions and headings, and is kept by
+        // the caller so its storage can be reused from one call to the next
+
+
+        void steerForFlocking (const float separationMaxDistance,
+                               const float separationCosMaxAngle,
+                               const float alignmentMaxDistance,
+                               const float alignmentCosMaxAngle,
+                               const float cohesionMaxDistance,
+                               const float cohesionCosMaxAngle,
+                               const AVGroup& flock,
+                               VehicleArrays& scratch,
+                               Vec3& separation,
+                               Vec3& alignment,
+                               Vec3& cohesion);
+
+
         // ------------------------------------------------------------------------
         // pursuit of another vehicle (& version with ceiling on prediction time)
 
@@ -449,6 +473,21 @@ steerToAvoidObstacles (const float minTimeToCollision,
     return avoidance;
 }
 
+template <class Super>
+OpenSteer::Vec3
+OpenSteer::SteerLibraryMixin<Super>::
+steerToAvoidObstacles (const float minTimeToCollision,
+                       const ObstacleBatch& obstacles)
+{
+    const Vec3 avoidance = obstacles.steerToAvoid (*this, minTimeToCollision);
+
+    // XXX more annotation modularity problems (assumes spherical obstacle)
+    if (avoidance != Vec3::zero)
+        annotateAvoidObstacle (minTimeToCollision * speed());
+
+    return avoidance;
+}
+
 
 // ----------------------------------------------------------------------------
 // Unaligned collision avoidance behavior: avoid colliding with other nearby
@@ -810,6 +849,55 @@ steerForCohesion (const float maxDistance,
 }
 
 
+// ----------------------------------------------------------------------------
+// Separation, alignment and cohesion: gives the same results as calling
+// steerForSeparation, steerForAlignment and steerForCohesion, up to floating
+// point rounding, with one pass over the flock's positions and headings
+
+
+template<class Super>
+void
+OpenSteer::SteerLibraryMixin<Super>::
+steerForFlocking (const float separationMaxDistance,
+                  const float separationCosMaxAngle,
+                  const float alignmentMaxDistance,
+                  const float alignmentCosMaxAngle,
+                  const float cohesionMaxDistance,
+                  const float cohesionCosMaxAngle,
+                  const AVGroup& flock,
+                  VehicleArrays& scratch,
+                  Vec3& separation,
+                  Vec3& alignment,
+                  Vec3& cohesion)
+{
+    // copy the other vehicles' positions and headings into arrays
+    scratch.clear ();
+    scratch.reserve (flock.size());
+    for (AVIterator otherVehicle = flock.begin(); otherVehicle != flock.end(); ++otherVehicle)
+    {
+        if (*otherVehicle != this)
+            scratch.push_back ((**otherVehicle).position(), (**otherVehicle).forward());
+    }
+
+    FlockingSums sums;
+    accumulateFlocking (position(), forward(), scratch,
+                        BoidNeighborhood (radius()*3, separationMaxDistance, separationCosMaxAngle),
+                        BoidNeighborhood (radius()*3, alignmentMaxDistance, alignmentCosMaxAngle),
+                        BoidNeighborhood (radius()*3, cohesionMaxDistance, cohesionCosMaxAngle),
+                        sums);
+
+    separation = sums.separation.normalize();
+
+    alignment = Vec3::zero;
+    if (sums.alignmentNeighbors > 0)
+        alignment = ((sums.alignment / (float)sums.alignmentNeighbors) - forward()).normalize();
+
+    cohesion = Vec3::zero;
+    if (sums.cohesionNeighbors > 0)
+        cohesion = ((sums.cohesion / (float)sums.cohesionNeighbors) - position()).normalize();
+}
+
+
 // ----------------------------------------------------------------------------
 // pursuit of another vehicle (& version with ceiling on prediction time)
 
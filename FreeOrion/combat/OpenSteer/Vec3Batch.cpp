@@ -0,0 +1,415 @@
+#include "Vec3Batch.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#define OPENSTEER_VEC3BATCH_USE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// only AVX floating point instructions are used, so AVX2 isn't required
+#if defined(__AVX__)
+#define OPENSTEER_VEC3BATCH_USE_AVX 1
+#include <immintrin.h>
+#endif
+
+
+namespace {
+    /** A BoidNeighborhood with its distances squared, as used by the tests
+        below. */
+    struct SquaredNeighborhood
+    {
+        SquaredNeighborhood(const OpenSteer::BoidNeighborhood& neighborhood) :
+            m_min_squared(neighborhood.minDistance * neighborhood.minDistance),
+            m_max_squared(neighborhood.maxDistance * neighborhood.maxDistance),
+            m_cos_max_angle(neighborhood.cosMaxAngle)
+        {}
+
+        float m_min_squared;
+        float m_max_squared;
+        float m_cos_max_angle;
+    };
+
+    /** Equivalent to SteerLibraryMixin::inBoidNeighborhood(), given the
+        squared distance to the other vehicle, the distance, and the dot
+        product of our forward vector with the (unnormalized) offset to the
+        other vehicle.  Comparing the dot product against cos * distance
+        instead of normalizing the offset first makes a zero offset fail the
+        angle test, as its NaN forwardness did in the original. */
+    inline bool InNeighborhood(float distance_squared, float distance, float forward_dot,
+                               const SquaredNeighborhood& neighborhood)
+    {
+        return distance_squared < neighborhood.m_min_squared ||
+            (distance_squared <= neighborhood.m_max_squared &&
+             neighborhood.m_cos_max_angle * distance < forward_dot);
+    }
+
+    /** Relative error allowed for in PathCandidate() and its batched
+        versions; many times that of the float arithmetic involved. */
+    const float PATH_CANDIDATE_TOLERANCE = 1.0e-5f;
+
+    /** Returns true unless a vehicle's path, along the unit vector whose dot
+        product with the offset to a sphere is \a forward_dot, certainly
+        misses the sphere, the squared distance to whose center is
+        \a distance_squared, grown by the vehicle's radius to
+        \a sphere_radius: unless the line of the path misses it, or meets
+        it only behind the vehicle. */
+    inline bool PathCandidate(float distance_squared, float forward_dot, float sphere_radius)
+    {
+        const float r2 = sphere_radius * sphere_radius;
+        const float tolerance =
+            PATH_CANDIDATE_TOLERANCE * (forward_dot * forward_dot + distance_squared + r2);
+        const float discriminant = forward_dot * forward_dot - distance_squared + r2 + tolerance;
+        return 0.0f <= discriminant && 0.0f <= forward_dot + std::sqrt(discriminant);
+    }
+
+    int CountBits(int mask)
+    {
+        int retval = 0;
+        for (; mask; mask &= mask - 1)
+            ++retval;
+        return retval;
+    }
+
+#if OPENSTEER_VEC3BATCH_USE_SSE2
+    inline __m128 InNeighborhood(__m128 distance_squared, __m128 distance, __m128 forward_dot,
+                                 __m128 min_squared, __m128 max_squared, __m128 cos_max_angle)
+    {
+        return _mm_or_ps(_mm_cmplt_ps(distance_squared, min_squared),
+                         _mm_and_ps(_mm_cmple_ps(distance_squared, max_squared),
+                                    _mm_cmplt_ps(_mm_mul_ps(cos_max_angle, distance), forward_dot)));
+    }
+
+    inline __m128 PathCandidate(__m128 distance_squared, __m128 forward_dot, __m128 sphere_radius)
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 fdot2 = _mm_mul_ps(forward_dot, forward_dot);
+        const __m128 r2 = _mm_mul_ps(sphere_radius, sphere_radius);
+        const __m128 tolerance = _mm_mul_ps(_mm_set1_ps(PATH_CANDIDATE_TOLERANCE),
+                                            _mm_add_ps(_mm_add_ps(fdot2, distance_squared), r2));
+        const __m128 discriminant = _mm_add_ps(_mm_add_ps(_mm_sub_ps(fdot2, distance_squared), r2), tolerance);
+        const __m128 hits_line = _mm_cmple_ps(zero, discriminant);
+        const __m128 far_root = _mm_add_ps(forward_dot, _mm_sqrt_ps(_mm_max_ps(discriminant, zero)));
+        return _mm_and_ps(hits_line, _mm_cmple_ps(zero, far_root));
+    }
+
+    inline float HorizontalSum(__m128 v)
+    {
+        float f[4];
+        _mm_storeu_ps(f, v);
+        return (f[0] + f[1]) + (f[2] + f[3]);
+    }
+#endif
+
+#if OPENSTEER_VEC3BATCH_USE_AVX
+    inline __m256 InNeighborhood(__m256 distance_squared, __m256 distance, __m256 forward_dot,
+                                 __m256 min_squared, __m256 max_squared, __m256 cos_max_angle)
+    {
+        return _mm256_or_ps(_mm256_cmp_ps(distance_squared, min_squared, _CMP_LT_OQ),
+                            _mm256_and_ps(_mm256_cmp_ps(distance_squared, max_squared, _CMP_LE_OQ),
+                                          _mm256_cmp_ps(_mm256_mul_ps(cos_max_angle, distance), forward_dot, _CMP_LT_OQ)));
+    }
+
+    inline __m256 PathCandidate(__m256 distance_squared, __m256 forward_dot, __m256 sphere_radius)
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 fdot2 = _mm256_mul_ps(forward_dot, forward_dot);
+        const __m256 r2 = _mm256_mul_ps(sphere_radius, sphere_radius);
+        const __m256 tolerance = _mm256_mul_ps(_mm256_set1_ps(PATH_CANDIDATE_TOLERANCE),
+                                               _mm256_add_ps(_mm256_add_ps(fdot2, distance_squared), r2));
+        const __m256 discriminant = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(fdot2, distance_squared), r2), tolerance);
+        const __m256 hits_line = _mm256_cmp_ps(zero, discriminant, _CMP_LE_OQ);
+        const __m256 far_root = _mm256_add_ps(forward_dot, _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero)));
+        return _mm256_and_ps(hits_line, _mm256_cmp_ps(zero, far_root, _CMP_LE_OQ));
+    }
+
+    inline float HorizontalSum(__m256 v)
+    {
+        float f[8];
+        _mm256_storeu_ps(f, v);
+        return ((f[0] + f[1]) + (f[2] + f[3])) + ((f[4] + f[5]) + (f[6] + f[7]));
+    }
+#endif
+}
+
+
+void
+OpenSteer::VehicleArrays::clear (void)
+{
+    px.clear(); py.clear(); pz.clear();
+    fx.clear(); fy.clear(); fz.clear();
+}
+
+
+void
+OpenSteer::VehicleArrays::reserve (std::size_t n)
+{
+    px.reserve(n); py.reserve(n); pz.reserve(n);
+    fx.reserve(n); fy.reserve(n); fz.reserve(n);
+}
+
+
+void
+OpenSteer::VehicleArrays::push_back (const Vec3& position, const Vec3& forward)
+{
+    px.push_back(position.x); py.push_back(position.y); pz.push_back(position.z);
+    fx.push_back(forward.x); fy.push_back(forward.y); fz.push_back(forward.z);
+}
+
+
+void
+OpenSteer::SphereArrays::clear (void)
+{
+    cx.clear(); cy.clear(); cz.clear();
+    r.clear();
+}
+
+
+void
+OpenSteer::SphereArrays::push_back (const Vec3& center, float radius)
+{
+    cx.push_back(center.x); cy.push_back(center.y); cz.push_back(center.z);
+    r.push_back(radius);
+}
+
+
+void
+OpenSteer::accumulateFlocking (const Vec3& position,
+                               const Vec3& forward,
+                               const VehicleArrays& flock,
+                               const BoidNeighborhood& separation,
+                               const BoidNeighborhood& alignment,
+                               const BoidNeighborhood& cohesion,
+                               FlockingSums& sums)
+{
+    const SquaredNeighborhood sep(separation);
+    const SquaredNeighborhood align(alignment);
+    const SquaredNeighborhood coh(cohesion);
+
+    const std::size_t n = flock.size();
+    std::size_t i = 0;
+
+#if OPENSTEER_VEC3BATCH_USE_AVX
+    {
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 cx = _mm256_set1_ps(position.x);
+        const __m256 cy = _mm256_set1_ps(position.y);
+        const __m256 cz = _mm256_set1_ps(position.z);
+        const __m256 fwd_x = _mm256_set1_ps(forward.x);
+        const __m256 fwd_y = _mm256_set1_ps(forward.y);
+        const __m256 fwd_z = _mm256_set1_ps(forward.z);
+        const __m256 sep_min = _mm256_set1_ps(sep.m_min_squared);
+        const __m256 sep_max = _mm256_set1_ps(sep.m_max_squared);
+        const __m256 sep_cos = _mm256_set1_ps(sep.m_cos_max_angle);
+        const __m256 align_min = _mm256_set1_ps(align.m_min_squared);
+        const __m256 align_max = _mm256_set1_ps(align.m_max_squared);
+        const __m256 align_cos = _mm256_set1_ps(align.m_cos_max_angle);
+        const __m256 coh_min = _mm256_set1_ps(coh.m_min_squared);
+        const __m256 coh_max = _mm256_set1_ps(coh.m_max_squared);
+        const __m256 coh_cos = _mm256_set1_ps(coh.m_cos_max_angle);
+
+        __m256 sep_x = zero, sep_y = zero, sep_z = zero;
+        __m256 align_x = zero, align_y = zero, align_z = zero;
+        __m256 coh_x = zero, coh_y = zero, coh_z = zero;
+
+        for (; i + 8 <= n; i += 8) {
+            const __m256 x = _mm256_loadu_ps(&flock.px[i]);
+            const __m256 y = _mm256_loadu_ps(&flock.py[i]);
+            const __m256 z = _mm256_loadu_ps(&flock.pz[i]);
+            const __m256 ox = _mm256_sub_ps(x, cx);
+            const __m256 oy = _mm256_sub_ps(y, cy);
+            const __m256 oz = _mm256_sub_ps(z, cz);
+            const __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)),
+                                            _mm256_mul_ps(oz, oz));
+            const __m256 dist = _mm256_sqrt_ps(d2);
+            const __m256 fdot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fwd_x, ox), _mm256_mul_ps(fwd_y, oy)),
+                                              _mm256_mul_ps(fwd_z, oz));
+
+            const __m256 in_sep = _mm256_and_ps(InNeighborhood(d2, dist, fdot, sep_min, sep_max, sep_cos),
+                                                _mm256_cmp_ps(d2, zero, _CMP_NEQ_UQ));
+            const __m256 neg_d2 = _mm256_sub_ps(zero, d2);
+            sep_x = _mm256_add_ps(sep_x, _mm256_and_ps(in_sep, _mm256_div_ps(ox, neg_d2)));
+            sep_y = _mm256_add_ps(sep_y, _mm256_and_ps(in_sep, _mm256_div_ps(oy, neg_d2)));
+            sep_z = _mm256_add_ps(sep_z, _mm256_and_ps(in_sep, _mm256_div_ps(oz, neg_d2)));
+
+            const __m256 in_align = InNeighborhood(d2, dist, fdot, align_min, align_max, align_cos);
+            align_x = _mm256_add_ps(align_x, _mm256_and_ps(in_align, _mm256_loadu_ps(&flock.fx[i])));
+            align_y = _mm256_add_ps(align_y, _mm256_and_ps(in_align, _mm256_loadu_ps(&flock.fy[i])));
+            align_z = _mm256_add_ps(align_z, _mm256_and_ps(in_align, _mm256_loadu_ps(&flock.fz[i])));
+            sums.alignmentNeighbors += CountBits(_mm256_movemask_ps(in_align));
+
+            const __m256 in_coh = InNeighborhood(d2, dist, fdot, coh_min, coh_max, coh_cos);
+            coh_x = _mm256_add_ps(coh_x, _mm256_and_ps(in_coh, x));
+            coh_y = _mm256_add_ps(coh_y, _mm256_and_ps(in_coh, y));
+            coh_z = _mm256_add_ps(coh_z, _mm256_and_ps(in_coh, z));
+            sums.cohesionNeighbors += CountBits(_mm256_movemask_ps(in_coh));
+        }
+
+        sums.separation += Vec3(HorizontalSum(sep_x), HorizontalSum(sep_y), HorizontalSum(sep_z));
+        sums.alignment += Vec3(HorizontalSum(align_x), HorizontalSum(align_y), HorizontalSum(align_z));
+        sums.cohesion += Vec3(HorizontalSum(coh_x), HorizontalSum(coh_y), HorizontalSum(coh_z));
+    }
+#endif
+
+#if OPENSTEER_VEC3BATCH_USE_SSE2
+    {
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 cx = _mm_set1_ps(position.x);
+        const __m128 cy = _mm_set1_ps(position.y);
+        const __m128 cz = _mm_set1_ps(position.z);
+        const __m128 fwd_x = _mm_set1_ps(forward.x);
+        const __m128 fwd_y = _mm_set1_ps(forward.y);
+        const __m128 fwd_z = _mm_set1_ps(forward.z);
+        const __m128 sep_min = _mm_set1_ps(sep.m_min_squared);
+        const __m128 sep_max = _mm_set1_ps(sep.m_max_squared);
+        const __m128 sep_cos = _mm_set1_ps(sep.m_cos_max_angle);
+        const __m128 align_min = _mm_set1_ps(align.m_min_squared);
+        const __m128 align_max = _mm_set1_ps(align.m_max_squared);
+        const __m128 align_cos = _mm_set1_ps(align.m_cos_max_angle);
+        const __m128 coh_min = _mm_set1_ps(coh.m_min_squared);
+        const __m128 coh_max = _mm_set1_ps(coh.m_max_squared);
+        const __m128 coh_cos = _mm_set1_ps(coh.m_cos_max_angle);
+
+        __m128 sep_x = zero, sep_y = zero, sep_z = zero;
+        __m128 align_x = zero, align_y = zero, align_z = zero;
+        __m128 coh_x = zero, coh_y = zero, coh_z = zero;
+
+        for (; i + 4 <= n; i += 4) {
+            const __m128 x = _mm_loadu_ps(&flock.px[i]);
+            const __m128 y = _mm_loadu_ps(&flock.py[i]);
+            const __m128 z = _mm_loadu_ps(&flock.pz[i]);
+            const __m128 ox = _mm_sub_ps(x, cx);
+            const __m128 oy = _mm_sub_ps(y, cy);
+            const __m128 oz = _mm_sub_ps(z, cz);
+            const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)),
+                                         _mm_mul_ps(oz, oz));
+            const __m128 dist = _mm_sqrt_ps(d2);
+            const __m128 fdot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(fwd_x, ox), _mm_mul_ps(fwd_y, oy)),
+                                           _mm_mul_ps(fwd_z, oz));
+
+            const __m128 in_sep = _mm_and_ps(InNeighborhood(d2, dist, fdot, sep_min, sep_max, sep_cos),
+                                             _mm_cmpneq_ps(d2, zero));
+            const __m128 neg_d2 = _mm_sub_ps(zero, d2);
+            sep_x = _mm_add_ps(sep_x, _mm_and_ps(in_sep, _mm_div_ps(ox, neg_d2)));
+            sep_y = _mm_add_ps(sep_y, _mm_and_ps(in_sep, _mm_div_ps(oy, neg_d2)));
+            sep_z = _mm_add_ps(sep_z, _mm_and_ps(in_sep, _mm_div_ps(oz, neg_d2)));
+
+            const __m128 in_align = InNeighborhood(d2, dist, fdot, align_min, align_max, align_cos);
+            align_x = _mm_add_ps(align_x, _mm_and_ps(in_align, _mm_loadu_ps(&flock.fx[i])));
+            align_y = _mm_add_ps(align_y, _mm_and_ps(in_align, _mm_loadu_ps(&flock.fy[i])));
+            align_z = _mm_add_ps(align_z, _mm_and_ps(in_align, _mm_loadu_ps(&flock.fz[i])));
+            sums.alignmentNeighbors += CountBits(_mm_movemask_ps(in_align));
+
+            const __m128 in_coh = InNeighborhood(d2, dist, fdot, coh_min, coh_max, coh_cos);
+            coh_x = _mm_add_ps(coh_x, _mm_and_ps(in_coh, x));
+            coh_y = _mm_add_ps(coh_y, _mm_and_ps(in_coh, y));
+            coh_z = _mm_add_ps(coh_z, _mm_and_ps(in_coh, z));
+            sums.cohesionNeighbors += CountBits(_mm_movemask_ps(in_coh));
+        }
+
+        sums.separation += Vec3(HorizontalSum(sep_x), HorizontalSum(sep_y), HorizontalSum(sep_z));
+        sums.alignment += Vec3(HorizontalSum(align_x), HorizontalSum(align_y), HorizontalSum(align_z));
+        sums.cohesion += Vec3(HorizontalSum(coh_x), HorizontalSum(coh_y), HorizontalSum(coh_z));
+    }
+#endif
+
+    for (; i < n; ++i) {
+        const Vec3 other(flock.px[i], flock.py[i], flock.pz[i]);
+        const Vec3 offset = other - position;
+        const float d2 = offset.dot(offset);
+        const float dist = std::sqrt(d2);
+        const float fdot = forward.dot(offset);
+
+        if (d2 && InNeighborhood(d2, dist, fdot, sep))
+            sums.separation += offset / -d2;
+
+        if (InNeighborhood(d2, dist, fdot, align)) {
+            sums.alignment += Vec3(flock.fx[i], flock.fy[i], flock.fz[i]);
+            ++sums.alignmentNeighbors;
+        }
+
+        if (InNeighborhood(d2, dist, fdot, coh)) {
+            sums.cohesion += other;
+            ++sums.cohesionNeighbors;
+        }
+    }
+}
+
+
+std::size_t
+OpenSteer::nextPathCandidate (const Vec3& position,
+                              const Vec3& forward,
+                              float radius,
+                              const SphereArrays& spheres,
+                              std::size_t first)
+{
+    const std::size_t n = spheres.size();
+    std::size_t i = first;
+
+#if OPENSTEER_VEC3BATCH_USE_AVX
+    {
+        const __m256 px = _mm256_set1_ps(position.x);
+        const __m256 py = _mm256_set1_ps(position.y);
+        const __m256 pz = _mm256_set1_ps(position.z);
+        const __m256 fwd_x = _mm256_set1_ps(forward.x);
+        const __m256 fwd_y = _mm256_set1_ps(forward.y);
+        const __m256 fwd_z = _mm256_set1_ps(forward.z);
+        const __m256 vehicle_radius = _mm256_set1_ps(radius);
+
+        for (; i + 8 <= n; i += 8) {
+            const __m256 ox = _mm256_sub_ps(_mm256_loadu_ps(&spheres.cx[i]), px);
+            const __m256 oy = _mm256_sub_ps(_mm256_loadu_ps(&spheres.cy[i]), py);
+            const __m256 oz = _mm256_sub_ps(_mm256_loadu_ps(&spheres.cz[i]), pz);
+            const __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ox, ox), _mm256_mul_ps(oy, oy)),
+                                            _mm256_mul_ps(oz, oz));
+            const __m256 fdot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(fwd_x, ox), _mm256_mul_ps(fwd_y, oy)),
+                                              _mm256_mul_ps(fwd_z, oz));
+            const int mask = _mm256_movemask_ps(
+                PathCandidate(d2, fdot, _mm256_add_ps(_mm256_loadu_ps(&spheres.r[i]), vehicle_radius)));
+            if (mask) {
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (mask & (1 << bit))
+                        return i + bit;
+                }
+            }
+        }
+    }
+#endif
+
+#if OPENSTEER_VEC3BATCH_USE_SSE2
+    {
+        const __m128 px = _mm_set1_ps(position.x);
+        const __m128 py = _mm_set1_ps(position.y);
+        const __m128 pz = _mm_set1_ps(position.z);
+        const __m128 fwd_x = _mm_set1_ps(forward.x);
+        const __m128 fwd_y = _mm_set1_ps(forward.y);
+        const __m128 fwd_z = _mm_set1_ps(forward.z);
+        const __m128 vehicle_radius = _mm_set1_ps(radius);
+
+        for (; i + 4 <= n; i += 4) {
+            const __m128 ox = _mm_sub_ps(_mm_loadu_ps(&spheres.cx[i]), px);
+            const __m128 oy = _mm_sub_ps(_mm_loadu_ps(&spheres.cy[i]), py);
+            const __m128 oz = _mm_sub_ps(_mm_loadu_ps(&spheres.cz[i]), pz);
+            const __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ox, ox), _mm_mul_ps(oy, oy)),
+                                         _mm_mul_ps(oz, oz));
+            const __m128 fdot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(fwd_x, ox), _mm_mul_ps(fwd_y, oy)),
+                                           _mm_mul_ps(fwd_z, oz));
+            const int mask = _mm_movemask_ps(
+                PathCandidate(d2, fdot, _mm_add_ps(_mm_loadu_ps(&spheres.r[i]), vehicle_radius)));
+            if (mask) {
+                for (int bit = 0; bit < 4; ++bit) {
+                    if (mask & (1 << bit))
+                        return i + bit;
+                }
+            }
+        }
+    }
+#endif
+
+    for (; i < n; ++i) {
+        const Vec3 offset = Vec3(spheres.cx[i], spheres.cy[i], spheres.cz[i]) - position;
+        if (PathCandidate(offset.dot(offset), forward.dot(offset), spheres.r[i] + radius))
+            return i;
+    }
+    return n;
+}
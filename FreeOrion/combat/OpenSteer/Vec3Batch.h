@@ -0,0 +1,110 @@
+// -*- C++ -*-
+#ifndef OPENSTEER_VEC3BATCH_H
+#define OPENSTEER_VEC3BATCH_H
+
+#include "Vec3.h"
+
+#include <vector>
+
+
+namespace OpenSteer {
+
+    /**
+     * The positions and forward directions of a group of vehicles, stored as
+     * one array per component, so that the batched kernels below can load
+     * several vehicles' worth of each component at once.
+     */
+    struct VehicleArrays
+    {
+        void clear (void);
+        void reserve (std::size_t n);
+        void push_back (const Vec3& position, const Vec3& forward);
+        std::size_t size (void) const {return px.size();}
+
+        std::vector<float> px, py, pz;  ///< positions
+        std::vector<float> fx, fy, fz;  ///< forward (unit heading) vectors
+    };
+
+    /**
+     * The region used by one boid behavior to decide which other vehicles
+     * are its neighbors; see SteerLibraryMixin::inBoidNeighborhood.
+     */
+    struct BoidNeighborhood
+    {
+        BoidNeighborhood (float minDistance_, float maxDistance_, float cosMaxAngle_) :
+            minDistance (minDistance_),
+            maxDistance (maxDistance_),
+            cosMaxAngle (cosMaxAngle_)
+        {}
+
+        float minDistance;
+        float maxDistance;
+        float cosMaxAngle;
+    };
+
+    /**
+     * Unnormalized results of accumulateFlocking().
+     */
+    struct FlockingSums
+    {
+        FlockingSums (void) :
+            alignmentNeighbors (0),
+            cohesionNeighbors (0)
+        {}
+
+        Vec3 separation;        ///< sum of -offset / distance^2 over separation neighbors
+        Vec3 alignment;         ///< sum of forward vectors of alignment neighbors
+        int alignmentNeighbors;
+        Vec3 cohesion;          ///< sum of positions of cohesion neighbors
+        int cohesionNeighbors;
+    };
+
+    /**
+     * Accumulates, in a single pass over @a flock, the separation, alignment
+     * and cohesion sums for a vehicle at @a position heading along
+     * @a forward.  Each vehicle in @a flock is tested against each of the
+     * three neighborhoods the same way inBoidNeighborhood() would test it.
+     * Uses SSE2 (or AVX, if the build enables it, as -mavx or -mavx2 do)
+     * to process several vehicles at once where available.  @a flock must
+     * not contain the vehicle itself.
+     */
+    void accumulateFlocking (const Vec3& position,
+                             const Vec3& forward,
+                             const VehicleArrays& flock,
+                             const BoidNeighborhood& separation,
+                             const BoidNeighborhood& alignment,
+                             const BoidNeighborhood& cohesion,
+                             FlockingSums& sums);
+
+    /**
+     * The centers and radii of a group of spheres, stored as one array per
+     * component, for nextPathCandidate().
+     */
+    struct SphereArrays
+    {
+        void clear (void);
+        void push_back (const Vec3& center, float radius);
+        std::size_t size (void) const {return r.size();}
+
+        std::vector<float> cx, cy, cz;  ///< centers
+        std::vector<float> r;           ///< radii
+    };
+
+    /**
+     * Returns the index of the first of @a spheres, from @a first on, that
+     * the path of a vehicle of radius @a radius at @a position heading
+     * along @a forward may run into ahead of it, or @a spheres.size() if
+     * there is none.  The test errs on the side of including spheres, so
+     * that it never skips one SphereObstacle::findIntersectionWithVehiclePath()
+     * would find an intersection with; that still has to decide about those
+     * returned.  Uses SSE2 or AVX where available, like accumulateFlocking().
+     */
+    std::size_t nextPathCandidate (const Vec3& position,
+                                   const Vec3& forward,
+                                   float radius,
+                                   const SphereArrays& spheres,
+                                   std::size_t first);
+
+} // namespace OpenSteer
+
+#endif // OPENSTEER_VEC3BATCH_H
@@ -2,6 +2,7 @@
 
 #include "ClientNetworking.h"
 
+#include "MessageStatistics.h"
 #include "Networking.h"
 #include "../util/AppInterface.h"
 #include "../util/MultiplayerCommon.h"
@@ -12,6 +13,7 @@
 #include <boost/lexical_cast.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/thread/thread.hpp>
+#include <boost/thread/thread_time.hpp>
 
 
 using boost::asio::ip::tcp;
@@ -20,6 +22,10 @@ using namespace Networking;
 namespace {
     const bool TRACE_EXECUTION = false;
 
+    /** How long DisconnectFromServer() waits for the networking thread to
+        finish with the connection. */
+    const int DISCONNECT_TIMEOUT_MS = 1000;
+
     const int HEADER_SIZE = ClientNetworking::MessageHeaderBuffer::static_size *
                             sizeof(ClientNetworking::MessageHeaderBuffer::value_type);
 
@@ -122,14 +128,20 @@ namespace {
 ////////////////////////////////////////////////
 // ClientNetworking
 ////////////////////////////////////////////////
+ClientNetworking::OutgoingMessage::OutgoingMessage(const Message& message_) :
+    message(message_),
+    queued_time(boost::posix_time::microsec_clock::universal_time())
+{}
+
 ClientNetworking::ClientNetworking() :
     m_player_id(Networking::INVALID_PLAYER_ID),
     m_host_player_id(Networking::INVALID_PLAYER_ID),
     m_io_service(),
     m_socket(m_io_service),
-    m_incoming_messages(m_mutex),
+    m_incoming_messages(),
     m_connected(false),
-    m_cancel_retries(false)
+    m_cancel_retries(false),
+    m_send_compression(Message::NO_COMPRESSION)
 {}
 
 bool ClientNetworking::Connected() const {
@@ -190,6 +202,10 @@ bool ClientNetworking::ConnectToServer(
             m_io_service.reset();
             if (Connected()) {
                 m_socket.set_option(boost::asio::socket_base::linger(true, SOCKET_LINGER_TIME));
+                // tell the server which codecs we can decode; until it
+                // replies with its own, messages are sent uncompressed
+                m_send_compression = Message::NO_COMPRESSION;
+                m_outgoing_messages.push_back(OutgoingMessage(CompressionSetupMessage()));
                 if (TRACE_EXECUTION)
                     Logger().debugStream() << "ClientNetworking::ConnectToServer : starting "
                                            << "networking thread";
@@ -220,10 +236,39 @@ bool ClientNetworking::ConnectToLocalHostServer(
     return retval;
 }
 
+bool ClientNetworking::ConnectToSharedMemoryServer(const std::string& name) {
+    try {
+        m_shared_memory_stream = SharedMemoryStream::Open(m_io_service, name);
+    } catch (const std::exception& e) {
+        Logger().errorStream() << "ClientNetworking::ConnectToSharedMemoryServer unable to connect to server: " << e.what();
+        return false;
+    }
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_connected = true;
+    }
+    // the server doesn't compress messages to clients on the same machine,
+    // so there is no codec to negotiate
+    m_send_compression = Message::NO_COMPRESSION;
+    if (TRACE_EXECUTION)
+        Logger().debugStream() << "ClientNetworking::ConnectToSharedMemoryServer : starting "
+                               << "networking thread";
+    boost::thread(boost::bind(&ClientNetworking::NetworkingThread, this));
+    return true;
+}
+
 void ClientNetworking::DisconnectFromServer() {
-    if (Connected())
-        m_io_service.post(boost::bind(&ClientNetworking::DisconnectFromServerImpl, this));
-    Sleep(1000); // HACK! wait a bit for the disconnect to occur
+    if (!Connected())
+        return;
+    m_io_service.post(boost::bind(&ClientNetworking::DisconnectFromServerImpl, this));
+    const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(DISCONNECT_TIMEOUT_MS);
+    boost::mutex::scoped_lock lock(m_mutex);
+    while (m_connected) {
+        if (!m_disconnected.timed_wait(lock, deadline)) {
+            Logger().errorStream() << "ClientNetworking::DisconnectFromServer : timed out waiting for disconnection";
+            break;
+        }
+    }
 }
 
 void ClientNetworking::SetPlayerID(int player_id) {
@@ -256,6 +301,9 @@ void ClientNetworking::GetMessage(Message& message) {
                                << message;
 }
 
+bool ClientNetworking::WaitForMessage(int timeout_ms)
+{ return m_incoming_messages.WaitForMessage(timeout_ms); }
+
 void ClientNetworking::SendSynchronousMessage(Message message, Message& response_message) {
     if (TRACE_EXECUTION)
         Logger().debugStream() << "ClientNetworking::SendSynchronousMessage : sending message "
@@ -325,11 +373,15 @@ void ClientNetworking::NetworkingThread() {
     } catch (const boost::system::system_error& error) {
         HandleException(error);
     }
+    // destroying the stream waits for its pending writes, which may still be
+    // reading from m_outgoing_messages
+    m_shared_memory_stream.reset();
     m_incoming_messages.Clear();
     m_outgoing_messages.clear();
     m_io_service.reset();
     boost::mutex::scoped_lock lock(m_mutex);
     m_connected = false;
+    m_disconnected.notify_all();
     if (TRACE_EXECUTION)
         Logger().debugStream() << "ClientNetworking::NetworkingThread() : Networking thread "
                                << "terminated.";
@@ -343,7 +395,22 @@ void ClientNetworking::HandleMessageBodyRead(boost::system::error_code error,
     } else {
         assert(static_cast<int>(bytes_transferred) <= m_incoming_header[4]);
         if (static_cast<int>(bytes_transferred) == m_incoming_header[4]) {
-            m_incoming_messages.PushBack(m_incoming_message);
+            try {
+                Message message = DecompressMessage(m_incoming_message);
+                boost::posix_time::time_duration elapsed =
+                    boost::posix_time::microsec_clock::universal_time() - m_incoming_header_time;
+                GetMessageStatistics().Record(MessageStatistics::RECEIVE, message.Type(), m_player_id,
+                                              HEADER_SIZE + bytes_transferred,
+                                              elapsed.total_microseconds() / 1.0e6);
+                if (message.Type() == Message::COMPRESSION_SETUP)
+                    HandleCompressionSetup(message);
+                else
+                    m_incoming_messages.PushBack(message);
+            } catch (const std::exception& e) {
+                Logger().errorStream() << "ClientNetworking::HandleMessageBodyRead : dropping "
+                                       << MessageTypeStr(m_incoming_message.Type())
+                                       << " message: " << e.what();
+            }
             AsyncReadMessage();
         }
     }
@@ -357,24 +424,18 @@ void ClientNetworking::HandleMessageHeaderRead(boost::system::error_code error,
     } else {
         assert(bytes_transferred <= HEADER_SIZE);
         if (bytes_transferred == HEADER_SIZE) {
+            m_incoming_header_time = boost::posix_time::microsec_clock::universal_time();
             BufferToHeader(m_incoming_header.c_array(), m_incoming_message);
             m_incoming_message.Resize(m_incoming_header[4]);
-            boost::asio::async_read(
-                m_socket,
-                boost::asio::buffer(m_incoming_message.Data(), m_incoming_message.Size()),
-                boost::bind(&ClientNetworking::HandleMessageBodyRead,
-                            this,
-                            boost::asio::placeholders::error,
-                            boost::asio::placeholders::bytes_transferred));
+            AsyncRead(boost::asio::buffer(m_incoming_message.Data(), m_incoming_message.Size()),
+                      boost::bind(&ClientNetworking::HandleMessageBodyRead, this, _1, _2));
         }
     }
 }
 
 void ClientNetworking::AsyncReadMessage() {
-    boost::asio::async_read(m_socket, boost::asio::buffer(m_incoming_header),
-                            boost::bind(&ClientNetworking::HandleMessageHeaderRead, this,
-                                        boost::asio::placeholders::error,
-                                        boost::asio::placeholders::bytes_transferred));
+    AsyncRead(boost::asio::buffer(m_incoming_header),
+              boost::bind(&ClientNetworking::HandleMessageHeaderRead, this, _1, _2));
 }
 
 void ClientNetworking::HandleMessageWrite(boost::system::error_code error,
@@ -385,6 +446,11 @@ void ClientNetworking::HandleMessageWrite(boost::system::error_code error,
     } else {
         assert(static_cast<int>(bytes_transferred) <= HEADER_SIZE + m_outgoing_header[4]);
         if (static_cast<int>(bytes_transferred) == HEADER_SIZE + m_outgoing_header[4]) {
+            const OutgoingMessage& sent = m_outgoing_messages.front();
+            boost::posix_time::time_duration elapsed =
+                boost::posix_time::microsec_clock::universal_time() - sent.queued_time;
+            GetMessageStatistics().Record(MessageStatistics::SEND, sent.message.Type(), m_player_id,
+                                          bytes_transferred, elapsed.total_microseconds() / 1.0e6);
             m_outgoing_messages.pop_front();
             if (!m_outgoing_messages.empty())
                 AsyncWriteMessage();
@@ -393,24 +459,58 @@ void ClientNetworking::HandleMessageWrite(boost::system::error_code error,
 }
 
 void ClientNetworking::AsyncWriteMessage() {
-    HeaderToBuffer(m_outgoing_messages.front(), m_outgoing_header.c_array());
+    const Message& message = m_outgoing_messages.front().message;
+    HeaderToBuffer(message, m_outgoing_header.c_array());
     std::vector<boost::asio::const_buffer> buffers;
     buffers.push_back(boost::asio::buffer(m_outgoing_header));
-    buffers.push_back(boost::asio::buffer(m_outgoing_messages.front().Data(),
-                                          m_outgoing_messages.front().Size()));
-    boost::asio::async_write(m_socket, buffers,
-                             boost::bind(&ClientNetworking::HandleMessageWrite, this,
-                                         boost::asio::placeholders::error,
-                                         boost::asio::placeholders::bytes_transferred));
+    buffers.push_back(boost::asio::buffer(message.Data(), message.Size()));
+    AsyncWrite(buffers, boost::bind(&ClientNetworking::HandleMessageWrite, this, _1, _2));
+}
+
+void ClientNetworking::AsyncRead(const boost::asio::mutable_buffer& buffer,
+                                 const SharedMemoryStream::CompletionHandler& handler)
+{
+    if (m_shared_memory_stream)
+        m_shared_memory_stream->AsyncRead(buffer, handler);
+    else
+        boost::asio::async_read(m_socket, boost::asio::mutable_buffers_1(buffer), handler);
+}
+
+void ClientNetworking::AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers,
+                                  const SharedMemoryStream::CompletionHandler& handler)
+{
+    if (m_shared_memory_stream)
+        m_shared_memory_stream->AsyncWrite(buffers, handler);
+    else
+        boost::asio::async_write(m_socket, buffers, handler);
 }
 
 void ClientNetworking::SendMessageImpl(Message message) {
     bool start_write = m_outgoing_messages.empty();
-    m_outgoing_messages.push_back(Message());
-    swap(m_outgoing_messages.back(), message);
+    // the queued time is taken before compression, which counts as sending
+    OutgoingMessage outgoing(message);
+    outgoing.message = CompressMessage(message, m_send_compression);
+    m_outgoing_messages.push_back(outgoing);
     if (start_write)
         AsyncWriteMessage();
 }
 
-void ClientNetworking::DisconnectFromServerImpl()
-{ m_socket.close(); }
+void ClientNetworking::HandleCompressionSetup(const Message& message) {
+    unsigned int peer_compressions = 0;
+    ExtractMessageData(message, peer_compressions);
+
+    // compression costs more than it saves on loopback connections
+    boost::system::error_code error;
+    const bool local = m_shared_memory_stream || m_socket.remote_endpoint(error).address().is_loopback();
+    m_send_compression = local ? Message::NO_COMPRESSION : ChooseCompression(peer_compressions);
+    if (TRACE_EXECUTION)
+        Logger().debugStream() << "ClientNetworking::HandleCompressionSetup : sending messages "
+                               << "with compression " << m_send_compression;
+}
+
+void ClientNetworking::DisconnectFromServerImpl() {
+    if (m_shared_memory_stream)
+        m_shared_memory_stream->Close();
+    else
+        m_socket.close();
+}
@@ -4,10 +4,13 @@
 
 #include "Message.h"
 #include "MessageQueue.h"
+#include "SharedMemoryStream.h"
 
 #include <boost/array.hpp>
 #include <boost/asio.hpp>
 
+#include <list>
+
 
 /** Encapsulates the networking facilities of the client.  The client must
     execute its networking code in a separate thread from its main processing
@@ -19,9 +22,9 @@
     is created and terminates when the client is connected to and disconnected
     from the server, respectively.  The entire public interface is safe to
     call from the main thread at all times.  Note that the main thread must
-    periodically request the next incoming message; the arrival of incoming
-    messages is never explicitly signalled to the main thread.  The same
-    applies to unintentional disconnects from the server.  The client must
+    periodically request the next incoming message, though it may block in
+    WaitForMessage() until one arrives.  Unintentional disconnects from the
+    server are never explicitly signalled to the main thread; the client must
     periodically check Connected().
 
     The ClientNetworking has three modes of operation.  First, it can discover
@@ -44,7 +47,7 @@ class ClientNetworking {
 public:
     /** The type of list returned by a call to DiscoverLANServers(). */
     typedef std::vector<std::pair<boost::asio::ip::address, std::string> >  ServerList;
-    typedef boost::array<int, 5>                                            MessageHeaderBuffer;
+    typedef boost::array<int, MESSAGE_HEADER_INTS>                          MessageHeaderBuffer;
 
     /** \name Structors */ //@{
     ClientNetworking(); ///< Basic ctor.
@@ -82,8 +85,15 @@ public:
     bool ConnectToLocalHostServer(boost::posix_time::seconds timeout =
                                   boost::posix_time::seconds(5));
 
+    /** Connects to a server on the same machine through the shared memory
+        segment named \a name, created by the server with
+        ServerNetworking::AddSharedMemoryConnection().  Once connected, the
+        connection behaves just like a TCP connection. */
+    bool ConnectToSharedMemoryServer(const std::string& name);
+
     /** Sends \a message to the server.  This function actually just enqueues
-        the message for sending and returns immediately. */
+        the message for sending and returns immediately.  Large messages are
+        compressed with the codec negotiated when connecting, if any. */
     void SendMessage(Message message);
 
     /** Gets the next incoming message from the server, places it into \a
@@ -93,11 +103,17 @@ public:
         case. */
     void GetMessage(Message& message);
 
+    /** Blocks until there is an incoming message available, or until \a
+        timeout_ms milliseconds have passed, and returns MessageAvailable().
+        Disconnection from the server does not end the wait early. */
+    bool WaitForMessage(int timeout_ms);
+
     /** Sends \a message to the server, then blocks until it sees the first
         synchronous response from the server. */
     void SendSynchronousMessage(Message message, Message& response_message);
 
-    /** Disconnects the client from the server. */
+    /** Disconnects the client from the server, and waits until the
+        networking thread has finished with the connection. */
     void DisconnectFromServer();
 
     /** Sets player ID for this client. */
@@ -108,6 +124,12 @@ public:
     //@}
 
 private:
+    struct OutgoingMessage {
+        explicit OutgoingMessage(const Message& message_);
+        Message                     message;
+        boost::posix_time::ptime    queued_time;
+    };
+
     void HandleException(const boost::system::system_error& error);
     void HandleConnection(boost::asio::ip::tcp::resolver::iterator* it,
                           boost::asio::deadline_timer* timer,
@@ -119,7 +141,12 @@ private:
     void AsyncReadMessage();
     void HandleMessageWrite(        boost::system::error_code error, std::size_t bytes_transferred);
     void AsyncWriteMessage();
+    void AsyncRead(const boost::asio::mutable_buffer& buffer,
+                   const SharedMemoryStream::CompletionHandler& handler);
+    void AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers,
+                    const SharedMemoryStream::CompletionHandler& handler);
     void SendMessageImpl(Message message);
+    void HandleCompressionSetup(const Message& message);
     void DisconnectFromServerImpl();
 
     int                             m_player_id;
@@ -127,14 +154,18 @@ private:
 
     boost::asio::io_service         m_io_service;
     boost::asio::ip::tcp::socket    m_socket;
+    SharedMemoryStreamPtr           m_shared_memory_stream; // used instead of m_socket, if set
     mutable boost::mutex            m_mutex;
+    boost::condition                m_disconnected;      // notified with m_mutex held when m_connected becomes false
     MessageQueue                    m_incoming_messages; // accessed from multiple threads, but its interface is threadsafe
-    std::list<Message>              m_outgoing_messages;
+    std::list<OutgoingMessage>      m_outgoing_messages;
     bool                            m_connected;         // accessed from multiple threads
     bool                            m_cancel_retries;
+    Message::Compression            m_send_compression; // only accessed from the networking thread once connected
 
     MessageHeaderBuffer             m_incoming_header;
     Message                         m_incoming_message;
+    boost::posix_time::ptime        m_incoming_header_time;
     MessageHeaderBuffer             m_outgoing_header;
 };
 
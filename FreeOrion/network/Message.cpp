@@ -1,5 +1,7 @@
 #include "Message.h"
 
+#include "MessageStatistics.h"
+
 #include "../combat/CombatOrder.h"
 #include "../combat/OpenSteer/CombatObject.h"
 #include "../Empire/EmpireManager.h"
@@ -28,7 +30,13 @@
 #include <boost/timer.hpp>
 
 #include <zlib.h>
+#ifdef FREEORION_HAVE_LZ4
+#include <lz4.h>
+#endif
 
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
 #include <sstream>
@@ -36,6 +44,16 @@
 
 
 namespace {
+    void AddOptions(OptionsDB& db) {
+        db.Add("network-compression", "OPTIONS_DB_NETWORK_COMPRESSION", std::string("lz4"));
+        db.Add("network-compression-threshold", "OPTIONS_DB_NETWORK_COMPRESSION_THRESHOLD", 16384, RangedValidator<int>(0, 1 << 30));
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
+
+    /** Compressed bodies larger than this are assumed to be corrupt, rather
+      * than allocating however much memory their size prefix asks for. */
+    const int MAX_UNCOMPRESSED_MESSAGE_SIZE = 1 << 30;
+
     const std::string MESSAGE_SCOPE_PREFIX = "Message::";
     const std::string DUMMY_EMPTY_MESSAGE = "Lathanda";
     const std::string ACKNOWLEDGEMENT = "ACK";
@@ -44,6 +62,31 @@ namespace {
             boost::algorithm::erase_first_copy(str, MESSAGE_SCOPE_PREFIX) :
             str;
     }
+
+    /** Returns the number to give an update about to be serialized against
+      * \a baseline, and sets \a base_update_number to the number of the
+      * update it will be a delta against, or INVALID_TURN_UPDATE_NUMBER if it
+      * will be a full snapshot. */
+    int BeginTurnUpdate(TurnUpdateBaseline& baseline, int& base_update_number) {
+        int update_number = baseline.next_update_number++;
+        base_update_number = baseline.last_update_number;
+        if (baseline.Empty())
+            baseline.snapshot_update_number = update_number;
+        return update_number;
+    }
+
+    /** Checks whether an update numbered \a update_number that is a delta
+      * against \a base_update_number can be applied by a client whose last
+      * applied update is \a last_update_number. */
+    bool CanApplyTurnUpdate(int update_number, int base_update_number, int last_update_number) {
+        if (update_number == INVALID_TURN_UPDATE_NUMBER || base_update_number == INVALID_TURN_UPDATE_NUMBER)
+            return true;    // not delta-encoded, or a full snapshot
+        if (base_update_number == last_update_number)
+            return true;
+        Logger().errorStream() << "Received turn update " << update_number << " encoded as a delta against update "
+                               << base_update_number << ", but the last update applied was " << last_update_number;
+        return false;
+    }
 }
 
 ////////////////////////////////////////////////
@@ -85,6 +128,10 @@ namespace GG {
     GG_ENUM_MAP_INSERT(Message::VICTORY_DEFEAT)
     GG_ENUM_MAP_INSERT(Message::END_GAME)
     GG_ENUM_MAP_INSERT(Message::MODERATOR_ACTION)
+    GG_ENUM_MAP_INSERT(Message::TURN_UPDATE_ACK)
+    GG_ENUM_MAP_INSERT(Message::COMPRESSION_SETUP)
+    GG_ENUM_MAP_INSERT(Message::AI_POOL_READY)
+    GG_ENUM_MAP_INSERT(Message::AI_POOL_ASSIGN)
     GG_ENUM_MAP_END
 }
 
@@ -143,6 +190,100 @@ std::ostream& operator<<(std::ostream& os, const Message& msg) {
 }
 
 
+////////////////////////////////////////////////
+// MessageBodyBuffer
+////////////////////////////////////////////////
+MessageBodyBuffer::MessageBodyBuffer() :
+    m_data(0)
+{}
+
+MessageBodyBuffer::~MessageBodyBuffer()
+{ std::free(m_data); }
+
+std::size_t MessageBodyBuffer::Size() const
+{ return pptr() - pbase(); }
+
+char* MessageBodyBuffer::Release() {
+    const std::size_t size = Size();
+    char* retval = m_data;
+    // give back the unused part of the last doubling, if the allocator can
+    if (retval && size) {
+        if (char* shrunk = static_cast<char*>(std::realloc(retval, size)))
+            retval = shrunk;
+    }
+    m_data = 0;
+    setp(0, 0);
+    return retval;
+}
+
+MessageBodyBuffer::int_type MessageBodyBuffer::overflow(int_type c) {
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+        return traits_type::not_eof(c);
+    Reserve(Size() + 1);
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+    return c;
+}
+
+std::streamsize MessageBodyBuffer::xsputn(const char* s, std::streamsize n) {
+    if (epptr() - pptr() < n)
+        Reserve(Size() + n);
+    std::memcpy(pptr(), s, n);
+    // pbump takes an int, so large writes are advanced in steps
+    for (std::streamsize remaining = n; remaining; ) {
+        const int step = static_cast<int>(std::min<std::streamsize>(remaining, INT_MAX));
+        pbump(step);
+        remaining -= step;
+    }
+    return n;
+}
+
+void MessageBodyBuffer::Reserve(std::size_t capacity) {
+    const std::size_t old_capacity = epptr() - pbase();
+    if (capacity <= old_capacity)
+        return;
+    const std::size_t MIN_CAPACITY = 256;
+    const std::size_t new_capacity = std::max(std::max(capacity, 2 * old_capacity), MIN_CAPACITY);
+    const std::size_t size = Size();
+    char* data = static_cast<char*>(std::realloc(m_data, new_capacity));
+    if (!data)
+        throw std::bad_alloc();
+    m_data = data;
+    setp(m_data, m_data + new_capacity);
+    for (std::size_t remaining = size; remaining; ) {
+        const int step = static_cast<int>(std::min<std::size_t>(remaining, INT_MAX));
+        pbump(step);
+        remaining -= step;
+    }
+}
+
+MessageOStream::MessageOStream() :
+    std::ostream(0),
+    m_buffer(),
+    m_creation_time(boost::posix_time::microsec_clock::universal_time())
+{ rdbuf(&m_buffer); }
+
+MessageIStream::Buffer::Buffer(const char* data, std::size_t size) {
+    // the get area is never written through, despite setg() taking char*
+    char* begin = const_cast<char*>(data);
+    setg(begin, begin, begin + size);
+}
+
+MessageIStream::MessageIStream(const Message& message) :
+    std::istream(0),
+    m_buffer(message.Data(), message.Size()),
+    m_message(message),
+    m_creation_time(boost::posix_time::microsec_clock::universal_time())
+{ rdbuf(&m_buffer); }
+
+MessageIStream::~MessageIStream() {
+    boost::posix_time::time_duration elapsed =
+        boost::posix_time::microsec_clock::universal_time() - m_creation_time;
+    GetMessageStatistics().Record(MessageStatistics::DESERIALIZE, m_message, m_message.Size(),
+                                  elapsed.total_microseconds() / 1.0e6);
+}
+
+
 ////////////////////////////////////////////////
 // Message
 ////////////////////////////////////////////////
@@ -151,6 +292,7 @@ Message::Message() :
     m_sending_player(0),
     m_receiving_player(0),
     m_synchronous_response(false),
+    m_compression(NO_COMPRESSION),
     m_message_size(0),
     m_message_text()
 {}
@@ -164,10 +306,33 @@ Message::Message(MessageType type,
     m_sending_player(sending_player),
     m_receiving_player(receiving_player),
     m_synchronous_response(synchronous_response),
+    m_compression(NO_COMPRESSION),
     m_message_size(text.size()),
     m_message_text(new char[text.size()])
 { std::copy(text.begin(), text.end(), m_message_text.get()); }
 
+Message::Message(MessageType type,
+                 int sending_player,
+                 int receiving_player,
+                 MessageOStream& body,
+                 bool synchronous_response/* = false*/) :
+    m_type(type),
+    m_sending_player(sending_player),
+    m_receiving_player(receiving_player),
+    m_synchronous_response(synchronous_response),
+    m_compression(NO_COMPRESSION),
+    m_message_size(0),
+    m_message_text()
+{
+    body.flush();
+    m_message_size = body.m_buffer.Size();
+    m_message_text.reset(body.m_buffer.Release(), &std::free);
+    boost::posix_time::time_duration elapsed =
+        boost::posix_time::microsec_clock::universal_time() - body.m_creation_time;
+    GetMessageStatistics().Record(MessageStatistics::SERIALIZE, *this, m_message_size,
+                                  elapsed.total_microseconds() / 1.0e6);
+}
+
 Message::MessageType Message::Type() const
 { return m_type; }
 
@@ -180,6 +345,9 @@ int Message::ReceivingPlayer() const
 bool Message::SynchronousResponse() const
 { return m_synchronous_response; }
 
+Message::Compression Message::BodyCompression() const
+{ return m_compression; }
+
 std::size_t Message::Size() const
 { return m_message_size; }
 
@@ -202,6 +370,7 @@ void Message::Swap(Message& rhs) {
     std::swap(m_sending_player, rhs.m_sending_player);
     std::swap(m_receiving_player, rhs.m_receiving_player);
     std::swap(m_synchronous_response, rhs.m_synchronous_response);
+    std::swap(m_compression, rhs.m_compression);
     std::swap(m_message_size, rhs.m_message_size);
     std::swap(m_message_text, rhs.m_message_text);
 }
@@ -211,6 +380,7 @@ bool operator==(const Message& lhs, const Message& rhs) {
         lhs.Type() == rhs.Type() &&
         lhs.SendingPlayer() == rhs.SendingPlayer() &&
         lhs.ReceivingPlayer() == rhs.ReceivingPlayer() &&
+        lhs.BodyCompression() == rhs.BodyCompression() &&
         lhs.Text() == rhs.Text();
 }
 
@@ -226,6 +396,7 @@ void BufferToHeader(const int* header_buf, Message& message) {
     message.m_receiving_player = header_buf[2];
     message.m_synchronous_response = header_buf[3];
     message.m_message_size = header_buf[4];
+    message.m_compression = static_cast<Message::Compression>(header_buf[5]);
 }
 
 void HeaderToBuffer(const Message& message, int* header_buf) {
@@ -234,51 +405,166 @@ void HeaderToBuffer(const Message& message, int* header_buf) {
     header_buf[2] = message.ReceivingPlayer();
     header_buf[3] = message.SynchronousResponse();
     header_buf[4] = message.Size();
+    header_buf[5] = message.BodyCompression();
+}
+
+////////////////////////////////////////////////
+// Message compression
+////////////////////////////////////////////////
+unsigned int AvailableCompressions() {
+    unsigned int retval = (1u << Message::NO_COMPRESSION) | (1u << Message::ZLIB_COMPRESSION);
+#ifdef FREEORION_HAVE_LZ4
+    retval |= 1u << Message::LZ4_COMPRESSION;
+#endif
+    return retval;
+}
+
+Message::Compression ChooseCompression(unsigned int peer_compressions) {
+    const unsigned int usable = AvailableCompressions() & peer_compressions;
+    const std::string preferred = GetOptionsDB().Get<std::string>("network-compression");
+    if (preferred == "none")
+        return Message::NO_COMPRESSION;
+    if (preferred == "lz4" && (usable & (1u << Message::LZ4_COMPRESSION)))
+        return Message::LZ4_COMPRESSION;
+    // zlib is the fallback for any other value, or if LZ4 is unavailable
+    if (usable & (1u << Message::ZLIB_COMPRESSION))
+        return Message::ZLIB_COMPRESSION;
+    return Message::NO_COMPRESSION;
+}
+
+Message CompressMessage(const Message& message, Message::Compression compression) {
+    const int size = message.Size();
+    if (compression == Message::NO_COMPRESSION || message.BodyCompression() != Message::NO_COMPRESSION ||
+        size < GetOptionsDB().Get<int>("network-compression-threshold"))
+    { return message; }
+
+    boost::shared_array<char> buffer;
+    std::size_t compressed_size = 0;
+    switch (compression) {
+    case Message::ZLIB_COMPRESSION: {
+        uLongf dest_len = compressBound(size);
+        buffer.reset(new char[sizeof(int) + dest_len]);
+        if (compress2(reinterpret_cast<Bytef*>(buffer.get() + sizeof(int)), &dest_len,
+                      reinterpret_cast<const Bytef*>(message.Data()), size, Z_DEFAULT_COMPRESSION) != Z_OK)
+        {
+            Logger().errorStream() << "CompressMessage : zlib failed to compress " << MessageTypeStr(message.Type());
+            return message;
+        }
+        compressed_size = dest_len;
+        break;
+    }
+#ifdef FREEORION_HAVE_LZ4
+    case Message::LZ4_COMPRESSION: {
+        const int bound = LZ4_compressBound(size);
+        buffer.reset(new char[sizeof(int) + bound]);
+        const int result = LZ4_compress_default(message.Data(), buffer.get() + sizeof(int), size, bound);
+        if (result <= 0) {
+            Logger().errorStream() << "CompressMessage : LZ4 failed to compress " << MessageTypeStr(message.Type());
+            return message;
+        }
+        compressed_size = result;
+        break;
+    }
+#endif
+    default:
+        return message;
+    }
+
+    if (static_cast<int>(sizeof(int) + compressed_size) >= size)
+        return message;
+    std::memcpy(buffer.get(), &size, sizeof(int));
+
+    Message retval(message.Type(), message.SendingPlayer(), message.ReceivingPlayer(), "",
+                   message.SynchronousResponse());
+    retval.m_compression = compression;
+    retval.m_message_size = sizeof(int) + compressed_size;
+    retval.m_message_text = buffer;
+    return retval;
+}
+
+Message DecompressMessage(const Message& message) {
+    if (message.BodyCompression() == Message::NO_COMPRESSION)
+        return message;
+
+    int size = 0;
+    if (message.Size() < sizeof(int))
+        throw std::runtime_error("DecompressMessage : compressed message body too short");
+    std::memcpy(&size, message.Data(), sizeof(int));
+    if (size < 0 || MAX_UNCOMPRESSED_MESSAGE_SIZE < size)
+        throw std::runtime_error("DecompressMessage : invalid uncompressed message size");
+
+    const char* compressed = message.Data() + sizeof(int);
+    const std::size_t compressed_size = message.Size() - sizeof(int);
+    boost::shared_array<char> buffer(new char[size]);
+    switch (message.BodyCompression()) {
+    case Message::ZLIB_COMPRESSION: {
+        uLongf dest_len = size;
+        if (uncompress(reinterpret_cast<Bytef*>(buffer.get()), &dest_len,
+                       reinterpret_cast<const Bytef*>(compressed), compressed_size) != Z_OK ||
+            dest_len != static_cast<uLongf>(size))
+        { throw std::runtime_error("DecompressMessage : zlib failed to decompress message body"); }
+        break;
+    }
+#ifdef FREEORION_HAVE_LZ4
+    case Message::LZ4_COMPRESSION:
+        if (LZ4_decompress_safe(compressed, buffer.get(), compressed_size, size) != size)
+            throw std::runtime_error("DecompressMessage : LZ4 failed to decompress message body");
+        break;
+#endif
+    default:
+        throw std::runtime_error("DecompressMessage : message body compressed with an unsupported codec");
+    }
+
+    Message retval(message.Type(), message.SendingPlayer(), message.ReceivingPlayer(), "",
+                   message.SynchronousResponse());
+    retval.m_message_size = size;
+    retval.m_message_text = buffer;
+    return retval;
 }
 
 ////////////////////////////////////////////////
 // Message named ctors
 ////////////////////////////////////////////////
 Message ErrorMessage(const std::string& problem, bool fatal/* = true*/) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(problem)
            << BOOST_SERIALIZATION_NVP(fatal);
     }
-    return Message(Message::ERROR, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::ERROR, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message ErrorMessage(int player_id, const std::string& problem, bool fatal/* = true*/) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(problem)
            << BOOST_SERIALIZATION_NVP(fatal);
     }
-    return Message(Message::ERROR, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::ERROR, Networking::INVALID_PLAYER_ID, player_id, os);
 }
 
 Message HostSPGameMessage(const SinglePlayerSetupData& setup_data) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(setup_data);
     }
-    return Message(Message::HOST_SP_GAME, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::HOST_SP_GAME, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message HostMPGameMessage(const std::string& host_player_name)
 { return Message(Message::HOST_MP_GAME, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, host_player_name); }
 
 Message JoinGameMessage(const std::string& player_name, Networking::ClientType client_type) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(player_name)
            << BOOST_SERIALIZATION_NVP(client_type);
     }
-    return Message(Message::JOIN_GAME, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::JOIN_GAME, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message HostIDMessage(int host_player_id) {
@@ -291,7 +577,7 @@ Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
                          const Universe& universe, const SpeciesManager& species,
                          const std::map<int, PlayerInfo>& players)
 {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(single_player_game)
@@ -305,7 +591,7 @@ Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
         oa << BOOST_SERIALIZATION_NVP(players)
            << BOOST_SERIALIZATION_NVP(loaded_game_data);
     }
-    return Message(Message::GAME_START, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::GAME_START, Networking::INVALID_PLAYER_ID, player_id, os);
 }
 
 Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
@@ -314,7 +600,7 @@ Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
                          const std::map<int, PlayerInfo>& players,
                          const OrderSet& orders, const SaveGameUIData* ui_data)
 {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(single_player_game)
@@ -335,7 +621,7 @@ Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
         bool save_state_string_available = false;
         oa << BOOST_SERIALIZATION_NVP(save_state_string_available);
     }
-    return Message(Message::GAME_START, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::GAME_START, Networking::INVALID_PLAYER_ID, player_id, os);
 }
 
 Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
@@ -344,7 +630,7 @@ Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
                          const std::map<int, PlayerInfo>& players,
                          const OrderSet& orders, const std::string* save_state_string)
 {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(single_player_game)
@@ -365,7 +651,7 @@ Message GameStartMessage(int player_id, bool single_player_game, int empire_id,
         if (save_state_string_available)
             oa << boost::serialization::make_nvp("save_state_string", *save_state_string);
     }
-    return Message(Message::GAME_START, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::GAME_START, Networking::INVALID_PLAYER_ID, player_id, os);
 }
 
 Message HostSPAckMessage(int player_id)
@@ -378,62 +664,135 @@ Message JoinAckMessage(int player_id)
 { return Message(Message::JOIN_GAME, Networking::INVALID_PLAYER_ID, player_id, ACKNOWLEDGEMENT); }
 
 Message TurnOrdersMessage(int sender, const OrderSet& orders) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         Serialize(oa, orders);
     }
-    return Message(Message::TURN_ORDERS, sender, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::TURN_ORDERS, sender, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message TurnProgressMessage(Message::TurnProgressPhase phase_id, int player_id) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(phase_id);
     }
-    return Message(Message::TURN_PROGRESS, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::TURN_PROGRESS, Networking::INVALID_PLAYER_ID, player_id, os);
 }
 
 Message PlayerStatusMessage(int player_id, int about_player_id, Message::PlayerStatus player_status) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(about_player_id)
            << BOOST_SERIALIZATION_NVP(player_status);
     }
-    return Message(Message::PLAYER_STATUS, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::PLAYER_STATUS, Networking::INVALID_PLAYER_ID, player_id, os);
 }
 
 Message TurnUpdateMessage(int player_id, int empire_id, int current_turn,
                           const EmpireManager& empires, const Universe& universe,
-                          const SpeciesManager& species, const std::map<int, PlayerInfo>& players)
+                          const SpeciesManager& species, const std::map<int, PlayerInfo>& players,
+                          TurnUpdateBaseline* baseline/* = 0*/)
 {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         GetUniverse().EncodingEmpire() = empire_id;
+
+        // delta encoding tracks a single empire's knowledge; observers and
+        // moderators get full updates
+        if (empire_id == ALL_EMPIRES)
+            baseline = 0;
+
+        int update_number = INVALID_TURN_UPDATE_NUMBER;
+        int base_update_number = INVALID_TURN_UPDATE_NUMBER;
+        if (baseline) {
+            if (!baseline->DeltaAllowed())
+                baseline->Clear();
+            update_number = BeginTurnUpdate(*baseline, base_update_number);
+        }
+
         oa << BOOST_SERIALIZATION_NVP(current_turn)
-           << BOOST_SERIALIZATION_NVP(empires)
-           << BOOST_SERIALIZATION_NVP(species);
-        Serialize(oa, universe);
+           << BOOST_SERIALIZATION_NVP(update_number)
+           << BOOST_SERIALIZATION_NVP(base_update_number);
+        if (baseline) {
+            SerializeDelta(oa, empires, *baseline);
+            oa << BOOST_SERIALIZATION_NVP(species);
+            SerializeDelta(oa, universe, *baseline);
+            baseline->last_update_number = update_number;
+            baseline->turn_update_number = update_number;
+            baseline->turn = current_turn;
+        } else {
+            oa << BOOST_SERIALIZATION_NVP(empires)
+               << BOOST_SERIALIZATION_NVP(species);
+            Serialize(oa, universe);
+        }
         oa << BOOST_SERIALIZATION_NVP(players);
     }
-    return Message(Message::TURN_UPDATE, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::TURN_UPDATE, Networking::INVALID_PLAYER_ID, player_id, os);
 }
 
-Message TurnPartialUpdateMessage(int player_id, int empire_id, const Universe& universe) {
-    std::ostringstream os;
+Message TurnPartialUpdateMessage(int player_id, int empire_id, const Universe& universe,
+                                 TurnUpdateBaseline* baseline/* = 0*/)
+{
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         GetUniverse().EncodingEmpire() = empire_id;
-        Serialize(oa, universe);
+
+        // partial updates are only sent as deltas against a TURN_UPDATE
+        if (empire_id == ALL_EMPIRES || (baseline && baseline->Empty()))
+            baseline = 0;
+
+        int update_number = INVALID_TURN_UPDATE_NUMBER;
+        int base_update_number = INVALID_TURN_UPDATE_NUMBER;
+        if (baseline)
+            update_number = BeginTurnUpdate(*baseline, base_update_number);
+
+        oa << BOOST_SERIALIZATION_NVP(update_number)
+           << BOOST_SERIALIZATION_NVP(base_update_number);
+        if (baseline) {
+            SerializeDelta(oa, universe, *baseline);
+            baseline->last_update_number = update_number;
+        } else {
+            Serialize(oa, universe);
+        }
     }
-    return Message(Message::TURN_PARTIAL_UPDATE, Networking::INVALID_PLAYER_ID, player_id, os.str());
+    return Message(Message::TURN_PARTIAL_UPDATE, Networking::INVALID_PLAYER_ID, player_id, os);
+}
+
+Message TurnUpdateAckMessage(int sender, int update_number, bool applied) {
+    MessageOStream os;
+    {
+        FREEORION_OARCHIVE_TYPE oa(os);
+        oa << BOOST_SERIALIZATION_NVP(update_number)
+           << BOOST_SERIALIZATION_NVP(applied);
+    }
+    return Message(Message::TURN_UPDATE_ACK, sender, Networking::INVALID_PLAYER_ID, os);
+}
+
+Message CompressionSetupMessage() {
+    return Message(Message::COMPRESSION_SETUP, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID,
+                   boost::lexical_cast<std::string>(AvailableCompressions()));
+}
+
+Message AIPoolReadyMessage()
+{ return Message(Message::AI_POOL_READY, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, ""); }
+
+Message AIPoolAssignMessage(const std::string& player_name, int max_aggression) {
+    MessageOStream os;
+    {
+        FREEORION_OARCHIVE_TYPE oa(os);
+        oa << BOOST_SERIALIZATION_NVP(player_name)
+           << BOOST_SERIALIZATION_NVP(max_aggression);
+    }
+    return Message(Message::AI_POOL_ASSIGN, Networking::INVALID_PLAYER_ID, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message ClientSaveDataMessage(int sender, const OrderSet& orders, const SaveGameUIData& ui_data) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         Serialize(oa, orders);
@@ -443,11 +802,11 @@ Message ClientSaveDataMessage(int sender, const OrderSet& orders, const SaveGame
            << BOOST_SERIALIZATION_NVP(ui_data)
            << BOOST_SERIALIZATION_NVP(save_state_string_available);
     }
-    return Message(Message::CLIENT_SAVE_DATA, sender, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::CLIENT_SAVE_DATA, sender, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message ClientSaveDataMessage(int sender, const OrderSet& orders, const std::string& save_state_string) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         Serialize(oa, orders);
@@ -457,11 +816,11 @@ Message ClientSaveDataMessage(int sender, const OrderSet& orders, const std::str
            << BOOST_SERIALIZATION_NVP(save_state_string_available)
            << BOOST_SERIALIZATION_NVP(save_state_string);
     }
-    return Message(Message::CLIENT_SAVE_DATA, sender, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::CLIENT_SAVE_DATA, sender, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message ClientSaveDataMessage(int sender, const OrderSet& orders) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         Serialize(oa, orders);
@@ -470,7 +829,7 @@ Message ClientSaveDataMessage(int sender, const OrderSet& orders) {
         oa << BOOST_SERIALIZATION_NVP(ui_data_available)
            << BOOST_SERIALIZATION_NVP(save_state_string_available);
     }
-    return Message(Message::CLIENT_SAVE_DATA, sender, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::CLIENT_SAVE_DATA, sender, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message RequestNewObjectIDMessage(int sender)
@@ -502,89 +861,89 @@ Message SingleRecipientChatMessage(int sender, int receiver, const std::string&
 { return Message(Message::PLAYER_CHAT, sender, receiver, msg); }
 
 Message DiplomacyMessage(int sender, int receiver, const DiplomaticMessage& diplo_message) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << diplo_message;
     }
-    return Message(Message::DIPLOMACY, sender, receiver, os.str());
+    return Message(Message::DIPLOMACY, sender, receiver, os);
 }
 
 Message DiplomaticStatusMessage(int receiver, const DiplomaticStatusUpdateInfo& diplo_update) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(diplo_update.empire1_id)
            << BOOST_SERIALIZATION_NVP(diplo_update.empire2_id)
            << BOOST_SERIALIZATION_NVP(diplo_update.diplo_status);
     }
-    return Message(Message::DIPLOMATIC_STATUS, Networking::INVALID_PLAYER_ID, receiver, os.str());
+    return Message(Message::DIPLOMATIC_STATUS, Networking::INVALID_PLAYER_ID, receiver, os);
 }
 
 Message VictoryDefeatMessage(int receiver, Message::VictoryOrDefeat victory_or_defeat,
                              const std::string& reason_string, int empire_id)
 {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(victory_or_defeat)
            << BOOST_SERIALIZATION_NVP(reason_string)
            << BOOST_SERIALIZATION_NVP(empire_id);
     }
-    return Message(Message::VICTORY_DEFEAT, Networking::INVALID_PLAYER_ID, receiver, os.str());
+    return Message(Message::VICTORY_DEFEAT, Networking::INVALID_PLAYER_ID, receiver, os);
 }
 
 Message PlayerEliminatedMessage(int receiver, int empire_id, const std::string& empire_name) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(empire_id)
            << BOOST_SERIALIZATION_NVP(empire_name);
     }
-    return Message(Message::PLAYER_ELIMINATED, Networking::INVALID_PLAYER_ID, receiver, os.str());
+    return Message(Message::PLAYER_ELIMINATED, Networking::INVALID_PLAYER_ID, receiver, os);
 }
 
 Message EndGameMessage(int receiver, Message::EndGameReason reason,
                        const std::string& reason_player_name/* = ""*/)
 {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(reason)
            << BOOST_SERIALIZATION_NVP(reason_player_name);
     }
-    return Message(Message::END_GAME, Networking::INVALID_PLAYER_ID, receiver, os.str());
+    return Message(Message::END_GAME, Networking::INVALID_PLAYER_ID, receiver, os);
 }
 
 Message ModeratorActionMessage(int sender, const Moderator::ModeratorAction& action) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         const Moderator::ModeratorAction* mod_action = &action;
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(mod_action);
     }
-    return Message(Message::MODERATOR_ACTION, sender, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::MODERATOR_ACTION, sender, Networking::INVALID_PLAYER_ID, os);
 }
 
 ////////////////////////////////////////////////
 // Multiplayer Lobby Message named ctors
 ////////////////////////////////////////////////
 Message LobbyUpdateMessage(int sender, const MultiplayerLobbyData& lobby_data) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(lobby_data);
     }
-    return Message(Message::LOBBY_UPDATE, sender, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::LOBBY_UPDATE, sender, Networking::INVALID_PLAYER_ID, os);
 }
 
 Message ServerLobbyUpdateMessage(int receiver, const MultiplayerLobbyData& lobby_data) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(lobby_data);
     }
-    return Message(Message::LOBBY_UPDATE, Networking::INVALID_PLAYER_ID, receiver, os.str());
+    return Message(Message::LOBBY_UPDATE, Networking::INVALID_PLAYER_ID, receiver, os);
 }
 
 Message LobbyChatMessage(int sender, int receiver, const std::string& data)
@@ -601,7 +960,7 @@ Message ServerCombatStartMessage(int receiver, int empire_id,
                                  const std::vector<CombatSetupGroup>& setup_groups,
                                  const ShipDesignMap& foreign_designs)
 {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         GetUniverse().EncodingEmpire() = empire_id;
@@ -609,29 +968,29 @@ Message ServerCombatStartMessage(int receiver, int empire_id,
            << BOOST_SERIALIZATION_NVP(setup_groups)
            << BOOST_SERIALIZATION_NVP(foreign_designs);
     }
-    return Message(Message::COMBAT_START, Networking::INVALID_PLAYER_ID, receiver, os.str());
+    return Message(Message::COMBAT_START, Networking::INVALID_PLAYER_ID, receiver, os);
 }
 
 Message ServerCombatUpdateMessage(int receiver, int empire_id, const CombatData& combat_data) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         GetUniverse().EncodingEmpire() = empire_id;
         oa << BOOST_SERIALIZATION_NVP(combat_data);
     }
-    return Message(Message::COMBAT_TURN_UPDATE, Networking::INVALID_PLAYER_ID, receiver, os.str());
+    return Message(Message::COMBAT_TURN_UPDATE, Networking::INVALID_PLAYER_ID, receiver, os);
 }
 
 Message ServerCombatEndMessage(int receiver)
 { return Message(Message::COMBAT_END, Networking::INVALID_PLAYER_ID, receiver, DUMMY_EMPTY_MESSAGE); }
 
 Message CombatTurnOrdersMessage(int sender, const CombatOrderSet& combat_orders) {
-    std::ostringstream os;
+    MessageOStream os;
     {
         FREEORION_OARCHIVE_TYPE oa(os);
         oa << BOOST_SERIALIZATION_NVP(combat_orders);
     }
-    return Message(Message::COMBAT_TURN_ORDERS, sender, Networking::INVALID_PLAYER_ID, os.str());
+    return Message(Message::COMBAT_TURN_ORDERS, sender, Networking::INVALID_PLAYER_ID, os);
 }
 
 ////////////////////////////////////////////////
@@ -639,7 +998,7 @@ Message CombatTurnOrdersMessage(int sender, const CombatOrderSet& combat_orders)
 ////////////////////////////////////////////////
 void ExtractMessageData(const Message& msg, std::string& problem, bool& fatal) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(problem)
            >> BOOST_SERIALIZATION_NVP(fatal);
@@ -654,7 +1013,7 @@ void ExtractMessageData(const Message& msg, std::string& problem, bool& fatal) {
 
 void ExtractMessageData(const Message& msg, MultiplayerLobbyData& lobby_data) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(lobby_data);
     } catch (const std::exception& err) {
@@ -674,7 +1033,7 @@ void ExtractMessageData(const Message& msg, bool& single_player_game, int& empir
                         std::string& save_state_string)
 {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(single_player_game)
            >> BOOST_SERIALIZATION_NVP(empire_id)
@@ -721,7 +1080,7 @@ void ExtractMessageData(const Message& msg, bool& single_player_game, int& empir
 
 void ExtractMessageData(const Message& msg, std::string& player_name, Networking::ClientType& client_type) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(player_name)
            >> BOOST_SERIALIZATION_NVP(client_type);
@@ -736,7 +1095,7 @@ void ExtractMessageData(const Message& msg, std::string& player_name, Networking
 
 void ExtractMessageData(const Message& msg, OrderSet& orders) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         Deserialize(ia, orders);
     } catch (const std::exception& err) {
@@ -748,38 +1107,109 @@ void ExtractMessageData(const Message& msg, OrderSet& orders) {
     }
 }
 
-void ExtractMessageData(const Message& msg, int empire_id, int& current_turn,
+bool ExtractMessageData(const Message& msg, int empire_id, int& current_turn,
                         EmpireManager& empires, Universe& universe,
-                        SpeciesManager& species, std::map<int, PlayerInfo>& players)
+                        SpeciesManager& species, std::map<int, PlayerInfo>& players,
+                        int last_update_number, int& update_number)
 {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         GetUniverse().EncodingEmpire() = empire_id;
+        int base_update_number;
         ia >> BOOST_SERIALIZATION_NVP(current_turn)
-           >> BOOST_SERIALIZATION_NVP(empires)
-           >> BOOST_SERIALIZATION_NVP(species);
-        Deserialize(ia, universe);
+           >> BOOST_SERIALIZATION_NVP(update_number)
+           >> BOOST_SERIALIZATION_NVP(base_update_number);
+        if (!CanApplyTurnUpdate(update_number, base_update_number, last_update_number))
+            return false;
+        if (update_number != INVALID_TURN_UPDATE_NUMBER) {
+            bool empires_applied = DeserializeDelta(ia, empires);
+            ia >> BOOST_SERIALIZATION_NVP(species);
+            if (!DeserializeDelta(ia, universe) || !empires_applied)
+                return false;
+        } else {
+            ia >> BOOST_SERIALIZATION_NVP(empires)
+               >> BOOST_SERIALIZATION_NVP(species);
+            Deserialize(ia, universe);
+        }
         ia >> BOOST_SERIALIZATION_NVP(players);
     } catch (const std::exception& err) {
         Logger().errorStream() << "ExtractMessageData(const Message& msg, int empire_id, int& "
                                << "current_turn, EmpireManager& empires, Universe& universe, "
-                               << "std::map<int, PlayerInfo>& players) failed!  Message:\n"
+                               << "std::map<int, PlayerInfo>& players, int last_update_number, "
+                               << "int& update_number) failed!  Message:\n"
                                << msg.Text() << "\n"
                                << "Error: " << err.what();
         throw err;
     }
+    return true;
 }
 
-void ExtractMessageData(const Message& msg, int empire_id, Universe& universe) {
+bool ExtractMessageData(const Message& msg, int empire_id, Universe& universe,
+                        int last_update_number, int& update_number)
+{
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         GetUniverse().EncodingEmpire() = empire_id;
-        Deserialize(ia, universe);
+        int base_update_number;
+        ia >> BOOST_SERIALIZATION_NVP(update_number)
+           >> BOOST_SERIALIZATION_NVP(base_update_number);
+        if (!CanApplyTurnUpdate(update_number, base_update_number, last_update_number))
+            return false;
+        if (update_number != INVALID_TURN_UPDATE_NUMBER) {
+            if (!DeserializeDelta(ia, universe))
+                return false;
+        } else {
+            Deserialize(ia, universe);
+        }
     } catch (const std::exception& err) {
         Logger().errorStream() << "ExtractMessageData(const Message& msg, int empire_id, "
-                               << "Universe& universe) failed!  Message:\n"
+                               << "Universe& universe, int last_update_number, "
+                               << "int& update_number) failed!  Message:\n"
+                               << msg.Text() << "\n"
+                               << "Error: " << err.what();
+        throw err;
+    }
+    return true;
+}
+
+void ExtractMessageData(const Message& msg, int& update_number, bool& applied) {
+    try {
+        MessageIStream is(msg);
+        FREEORION_IARCHIVE_TYPE ia(is);
+        ia >> BOOST_SERIALIZATION_NVP(update_number)
+           >> BOOST_SERIALIZATION_NVP(applied);
+    } catch (const std::exception& err) {
+        Logger().errorStream() << "ExtractMessageData(const Message& msg, int& update_number, "
+                               << "bool& applied) failed!  Message:\n"
+                               << msg.Text() << "\n"
+                               << "Error: " << err.what();
+        throw err;
+    }
+}
+
+void ExtractMessageData(const Message& msg, unsigned int& compressions) {
+    try {
+        compressions = boost::lexical_cast<unsigned int>(msg.Text());
+    } catch (const std::exception& err) {
+        Logger().errorStream() << "ExtractMessageData(const Message& msg, unsigned int& compressions) "
+                               << "failed!  Message:\n"
+                               << msg.Text() << "\n"
+                               << "Error: " << err.what();
+        throw err;
+    }
+}
+
+void ExtractMessageData(const Message& msg, std::string& player_name, int& max_aggression) {
+    try {
+        MessageIStream is(msg);
+        FREEORION_IARCHIVE_TYPE ia(is);
+        ia >> BOOST_SERIALIZATION_NVP(player_name)
+           >> BOOST_SERIALIZATION_NVP(max_aggression);
+    } catch (const std::exception& err) {
+        Logger().errorStream() << "ExtractMessageData(const Message& msg, std::string& player_name, "
+                               << "int& max_aggression) failed!  Message:\n"
                                << msg.Text() << "\n"
                                << "Error: " << err.what();
         throw err;
@@ -791,7 +1221,7 @@ void ExtractMessageData(const Message& msg, OrderSet& orders, bool& ui_data_avai
                         std::string& save_state_string)
 {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         Deserialize(ia, orders);
         ia >> BOOST_SERIALIZATION_NVP(ui_data_available);
@@ -813,7 +1243,7 @@ void ExtractMessageData(const Message& msg, OrderSet& orders, bool& ui_data_avai
 
 void ExtractMessageData(const Message& msg, Message::TurnProgressPhase& phase_id) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(phase_id);
     } catch (const std::exception& err) {
@@ -827,7 +1257,7 @@ void ExtractMessageData(const Message& msg, Message::TurnProgressPhase& phase_id
 
 void ExtractMessageData(const Message& msg, int& about_player_id, Message::PlayerStatus& status) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(about_player_id)
            >> BOOST_SERIALIZATION_NVP(status);
@@ -842,7 +1272,7 @@ void ExtractMessageData(const Message& msg, int& about_player_id, Message::Playe
 
 void ExtractMessageData(const Message& msg, SinglePlayerSetupData& setup_data) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(setup_data);
     } catch (const std::exception& err) {
@@ -858,7 +1288,7 @@ void ExtractMessageData(const Message& msg, Message::EndGameReason& reason,
                         std::string& reason_player_name)
 {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(reason)
            >> BOOST_SERIALIZATION_NVP(reason_player_name);
@@ -873,7 +1303,7 @@ void ExtractMessageData(const Message& msg, Message::EndGameReason& reason,
 
 void ExtractMessageData(const Message& msg, Moderator::ModeratorAction*& mod_action) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(mod_action);
     } catch (const std::exception& err) {
@@ -886,7 +1316,7 @@ void ExtractMessageData(const Message& msg, Moderator::ModeratorAction*& mod_act
 
 void ExtractMessageData(const Message& msg, int& empire_id, std::string& empire_name) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(empire_id)
            >> BOOST_SERIALIZATION_NVP(empire_name);
@@ -901,7 +1331,7 @@ void ExtractMessageData(const Message& msg, int& empire_id, std::string& empire_
 
 void ExtractMessageData(const Message& msg, DiplomaticMessage& diplo_message) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(diplo_message);
     } catch (const std::exception& err) {
@@ -915,7 +1345,7 @@ void ExtractMessageData(const Message& msg, DiplomaticMessage& diplo_message) {
 
 void ExtractMessageData(const Message& msg, DiplomaticStatusUpdateInfo& diplo_update) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(diplo_update.empire1_id)
            >> BOOST_SERIALIZATION_NVP(diplo_update.empire2_id)
@@ -933,7 +1363,7 @@ void ExtractMessageData(const Message& msg, Message::VictoryOrDefeat& victory_or
                         std::string& reason_string, int& empire_id)
 {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(victory_or_defeat)
            >> BOOST_SERIALIZATION_NVP(reason_string)
@@ -953,7 +1383,7 @@ void ExtractMessageData(const Message& msg, CombatData& combat_data,
                         ShipDesignMap& foreign_designs)
 {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(combat_data)
            >> BOOST_SERIALIZATION_NVP(setup_groups)
@@ -970,7 +1400,7 @@ void ExtractMessageData(const Message& msg, CombatData& combat_data,
 
 void ExtractMessageData(const Message& msg, CombatOrderSet& order_set) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(order_set);
     } catch (const std::exception& err) {
@@ -984,7 +1414,7 @@ void ExtractMessageData(const Message& msg, CombatOrderSet& order_set) {
 
 void ExtractMessageData(const Message& msg, CombatData& combat_data) {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(combat_data);
     } catch (const std::exception& err) {
@@ -1000,7 +1430,7 @@ void ExtractMessageData(const Message& msg, System*& system,
                         std::map<int, UniverseObject*>& combat_universe)
 {
     try {
-        std::istringstream is(msg.Text());
+        MessageIStream is(msg);
         FREEORION_IARCHIVE_TYPE ia(is);
         ia >> BOOST_SERIALIZATION_NVP(system);
         Deserialize(ia, combat_universe);
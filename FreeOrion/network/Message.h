@@ -10,12 +10,15 @@
 
 #include "Networking.h"
 
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/shared_array.hpp>
 
 #if defined(_MSC_VER) && defined(int64_t)
 #undef int64_t
 #endif
 
+#include <istream>
+#include <ostream>
 #include <string>
 #include <map>
 #include <vector>
@@ -33,6 +36,7 @@ struct SaveGameUIData;
 struct SinglePlayerSetupData;
 class ShipDesign;
 class System;
+struct TurnUpdateBaseline;
 class Universe;
 class UniverseObject;
 class DiplomaticMessage;
@@ -44,6 +48,68 @@ namespace Moderator {
 typedef std::vector<CombatOrder> CombatOrderSet;
 typedef std::map<int, ShipDesign*> ShipDesignMap;
 
+/** A stream buffer that grows as it is written to, and whose contents can be
+  * taken over by a Message without being copied. */
+class MessageBodyBuffer : public std::streambuf {
+public:
+    MessageBodyBuffer();
+    virtual ~MessageBodyBuffer();
+
+    /** Returns the number of chars written so far. */
+    std::size_t Size() const;
+
+    /** Returns the chars written so far, in a buffer allocated with
+      * std::malloc() that the caller must std::free(), and leaves this
+      * buffer empty. */
+    char*       Release();
+
+protected:
+    virtual int_type        overflow(int_type c);
+    virtual std::streamsize xsputn(const char* s, std::streamsize n);
+
+private:
+    void        Reserve(std::size_t capacity);
+
+    char*       m_data;
+};
+
+/** An output stream for serializing a message body.  Passing it to the
+  * Message ctor hands its contents over to the Message, rather than copying
+  * them out with str() as with a std::ostringstream.  The time from the
+  * stream's creation until then is recorded as the message's serialization
+  * time in GetMessageStatistics(). */
+class MessageOStream : public std::ostream {
+public:
+    MessageOStream();
+
+private:
+    MessageBodyBuffer           m_buffer;
+    boost::posix_time::ptime    m_creation_time;
+
+    friend class Message;
+};
+
+/** An input stream that reads a message body in place from the Message's
+  * buffer, rather than from a copy of it as with a std::istringstream.  The
+  * Message must outlive the stream.  The stream's lifetime is recorded as the
+  * message's deserialization time in GetMessageStatistics(). */
+class MessageIStream : public std::istream {
+public:
+    explicit MessageIStream(const Message& message);
+    ~MessageIStream();
+
+private:
+    struct Buffer : std::streambuf {
+        Buffer(const char* data, std::size_t size);
+    };
+    Buffer                      m_buffer;
+    const Message&              m_message;
+    boost::posix_time::ptime    m_creation_time;
+};
+
+/** The number of ints in a message header, as sent over the network. */
+const int MESSAGE_HEADER_INTS = 6;
+
 /** Fills in the relevant portions of \a message with the values in the buffer \a header_buf. */
 void BufferToHeader(const int* header_buf, Message& message);
 
@@ -93,7 +159,11 @@ public:
         VICTORY_DEFEAT,         ///< sent by server to all clients when one or more players have met victory or defeat conditions
         PLAYER_ELIMINATED,      ///< sent by server to all clients (except the eliminated player) when a player is eliminated
         END_GAME,               ///< sent by the server when the current game is to ending (see EndGameReason for the possible reasons this message is sent out)
-        MODERATOR_ACTION        ///< sent by client to server when a moderator edits the universe
+        MODERATOR_ACTION,       ///< sent by client to server when a moderator edits the universe
+        TURN_UPDATE_ACK,        ///< sent to the server by a client after it applies, or fails to apply, a delta-encoded TURN_UPDATE or TURN_PARTIAL_UPDATE
+        COMPRESSION_SETUP,      ///< sent by a client to the server just after connecting, and by the server in reply, listing the compression codecs the sender can decode; handled by the networking code, not passed on
+        AI_POOL_READY,          ///< sent to the server by an AI client of the server's AI client pool when it is ready to be assigned a player; handled by the networking code, not passed on
+        AI_POOL_ASSIGN          ///< sent by the server to a ready AI client of its AI client pool, naming the AI player it is to join the next game as
     };
 
     enum TurnProgressPhase {
@@ -126,6 +196,12 @@ public:
         DEFEAT                  ///< a player or players have met a defeat condition
     };
 
+    enum Compression {
+        NO_COMPRESSION,         ///< the body is sent as is
+        ZLIB_COMPRESSION,       ///< the body is compressed with zlib
+        LZ4_COMPRESSION         ///< the body is compressed with LZ4, which is faster than zlib but compresses less; only available in builds with LZ4
+    };
+
     /** \name Structors */ //@{
     Message(); ///< Default ctor.
 
@@ -135,6 +211,14 @@ public:
             int receiving_player,
             const std::string& text,
             bool synchronous_response = false);
+
+    /** Ctor that takes over the contents of \a body as the message's text,
+      * leaving \a body empty. */
+    Message(MessageType message_type,
+            int sending_player,
+            int receiving_player,
+            MessageOStream& body,
+            bool synchronous_response = false);
     //@}
 
     /** \name Accessors */ //@{
@@ -142,6 +226,7 @@ public:
     int         SendingPlayer() const;      ///< Returns the ID of the sending player.
     int         ReceivingPlayer() const;    ///< Returns the ID of the receiving player.
     bool        SynchronousResponse() const;///< Returns true if this message is in reponse to a synchronous message
+    Compression BodyCompression() const;    ///< Returns the codec the body is compressed with, if any
     std::size_t Size() const;               ///< Returns the size of the underlying buffer.
     const char* Data() const;               ///< Returns the underlying buffer.
     std::string Text() const;               ///< Returns the underlying buffer as a std::string.
@@ -158,11 +243,14 @@ private:
     int           m_sending_player;
     int           m_receiving_player;
     bool          m_synchronous_response;
+    Compression   m_compression;
     int           m_message_size;
 
     boost::shared_array<char> m_message_text;
 
     friend void BufferToHeader(const int* header_buf, Message& message);
+    friend Message CompressMessage(const Message& message, Compression compression);
+    friend Message DecompressMessage(const Message& message);
 };
 
 bool operator==(const Message& lhs, const Message& rhs);
@@ -182,6 +270,32 @@ std::string MessageTypeStr(Message::MessageType type);
 std::ostream& operator<<(std::ostream& os, const Message& msg);
 
 
+////////////////////////////////////////////////
+// Message compression
+////////////////////////////////////////////////
+
+/** Returns the compression codecs this build can encode and decode, as a
+  * bitmask with bit (1 << c) set for each Message::Compression c. */
+unsigned int AvailableCompressions();
+
+/** Returns the codec to use for messages sent to a peer that can decode the
+  * codecs in \a peer_compressions (a bitmask, as returned by
+  * AvailableCompressions()), according to the network-compression option. */
+Message::Compression ChooseCompression(unsigned int peer_compressions);
+
+/** Returns \a message with its body compressed with \a compression, if the
+  * body is at least network-compression-threshold bytes long and compressing
+  * it makes it smaller.  Otherwise returns \a message unchanged.  A
+  * compressed body consists of the size of the uncompressed body, as an int,
+  * followed by the compressed data. */
+Message CompressMessage(const Message& message, Message::Compression compression);
+
+/** Returns \a message with its body decompressed, or \a message itself if
+  * its body is not compressed.  Throws std::runtime_error if the body can't
+  * be decompressed. */
+Message DecompressMessage(const Message& message);
+
+
 ////////////////////////////////////////////////
 // Message named ctors
 ////////////////////////////////////////////////
@@ -240,13 +354,36 @@ Message TurnProgressMessage(Message::TurnProgressPhase phase_id, int player_id =
 /** creates a PLAYER_STATUS message. */
 Message PlayerStatusMessage(int player_id, int about_player_id, Message::PlayerStatus player_status);
 
-/** creates a TURN_UPDATE message. */
+/** creates a TURN_UPDATE message.  If \a baseline is given, the message
+  * contains only what has changed since the state recorded in \a baseline,
+  * which is then updated to match what the message contains.  A full snapshot
+  * is sent instead if \a baseline is empty, or if the client has not
+  * acknowledged applying the previous TURN_UPDATE. */
 Message TurnUpdateMessage(int player_id, int empire_id, int current_turn, const EmpireManager& empires,
                           const Universe& universe, const SpeciesManager& species,
-                          const std::map<int, PlayerInfo>& players);
+                          const std::map<int, PlayerInfo>& players, TurnUpdateBaseline* baseline = 0);
+
+/** create a TURN_PARTIAL_UPDATE message.  If \a baseline is given and not
+  * empty, the message contains only what has changed since the state recorded
+  * in \a baseline, which is then updated to match what the message contains. */
+Message TurnPartialUpdateMessage(int player_id, int empire_id, const Universe& universe,
+                                 TurnUpdateBaseline* baseline = 0);
+
+/** creates a TURN_UPDATE_ACK message, telling the server whether the client
+  * applied the delta-encoded turn update numbered \a update_number. */
+Message TurnUpdateAckMessage(int sender, int update_number, bool applied);
 
-/** create a TURN_PARTIAL_UPDATE message. */
-Message TurnPartialUpdateMessage(int player_id, int empire_id, const Universe& universe);
+/** creates a COMPRESSION_SETUP message, listing the compression codecs this
+  * build can decode. */
+Message CompressionSetupMessage();
+
+/** creates an AI_POOL_READY message, telling the server that this pooled AI
+  * client is initialized and waiting to be assigned a player. */
+Message AIPoolReadyMessage();
+
+/** creates an AI_POOL_ASSIGN message, assigning a pooled AI client the AI
+  * player named \a player_name, playing with aggression up to \a max_aggression. */
+Message AIPoolAssignMessage(const std::string& player_name, int max_aggression);
 
 /** creates a CLIENT_SAVE_DATA message, including UI data but without a state string. */
 Message ClientSaveDataMessage(int sender, const OrderSet& orders, const SaveGameUIData& ui_data);
@@ -380,10 +517,27 @@ void ExtractMessageData(const Message& msg, std::string& player_name, Networking
 
 void ExtractMessageData(const Message& msg, OrderSet& orders);
 
-void ExtractMessageData(const Message& msg, int empire_id, int& current_turn, EmpireManager& empires,
-                        Universe& universe, SpeciesManager& species, std::map<int, PlayerInfo>& players);
+/** Extracts the contents of a TURN_UPDATE message.  \a update_number is set
+  * to the number of the update, or INVALID_TURN_UPDATE_NUMBER if it is not
+  * delta-encoded.  Returns false, leaving the gamestate unchanged, if the
+  * update is a delta against an update other than \a last_update_number, the
+  * number of the last one this client applied, or, leaving the gamestate
+  * partly updated, if the result of applying a delta differs from the
+  * server's gamestate.  Either way, the client needs a full snapshot. */
+bool ExtractMessageData(const Message& msg, int empire_id, int& current_turn, EmpireManager& empires,
+                        Universe& universe, SpeciesManager& species, std::map<int, PlayerInfo>& players,
+                        int last_update_number, int& update_number);
+
+/** Extracts the contents of a TURN_PARTIAL_UPDATE message; \a last_update_number,
+  * \a update_number and the return value are as for TURN_UPDATE messages. */
+bool ExtractMessageData(const Message& msg, int empire_id, Universe& universe,
+                        int last_update_number, int& update_number);
+
+void ExtractMessageData(const Message& msg, int& update_number, bool& applied);
+
+void ExtractMessageData(const Message& msg, unsigned int& compressions);
 
-void ExtractMessageData(const Message& msg, int empire_id, Universe& universe);
+void ExtractMessageData(const Message& msg, std::string& player_name, int& max_aggression);
 
 void ExtractMessageData(const Message& msg, OrderSet& orders, bool& ui_data_available,
                         SaveGameUIData& ui_data, bool& save_state_string_available,
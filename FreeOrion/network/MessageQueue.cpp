@@ -1,55 +1,222 @@
 #include "MessageQueue.h"
 
-#include "Message.h"
+#include <boost/thread/thread_time.hpp>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 
 namespace {
-    struct SynchronousResponseMessage {
-        bool operator()(const Message& message) const
-        { return message.SynchronousResponse(); }
-    };
+    const std::size_t MESSAGE_CAPACITY = 4096;
+    const std::size_t SYNCHRONOUS_RESPONSE_CAPACITY = 16;
+
+    // On MSVC, volatile accesses already have acquire and release semantics,
+    // so only the compiler needs to be kept from reordering around them.
+    // Elsewhere, a full barrier is used.
+    std::size_t LoadAcquire(const volatile std::size_t& value) {
+        std::size_t retval = value;
+#if defined(_MSC_VER)
+        _ReadWriteBarrier();
+#else
+        __sync_synchronize();
+#endif
+        return retval;
+    }
+
+    void StoreRelease(volatile std::size_t& target, std::size_t value) {
+#if defined(_MSC_VER)
+        _ReadWriteBarrier();
+#else
+        __sync_synchronize();
+#endif
+        target = value;
+    }
+
+    /** Keeps stores before the barrier from being reordered with loads after
+        it, which acquire and release semantics alone don't. */
+    void FullBarrier() {
+#if defined(_MSC_VER)
+        _mm_mfence();
+#else
+        __sync_synchronize();
+#endif
+    }
+
+    /** Returns true iff index \a lhs comes before index \a rhs, allowing for
+        the indices wrapping around. */
+    bool Before(std::size_t lhs, std::size_t rhs)
+    { return static_cast<std::ptrdiff_t>(lhs - rhs) < 0; }
 }
 
-MessageQueue::MessageQueue(boost::mutex& monitor) :
-    m_monitor(monitor)
+////////////////////////////////////////////////
+// MessageQueue::Ring
+////////////////////////////////////////////////
+MessageQueue::Ring::Ring(std::size_t capacity) :
+    m_slots(capacity),
+    m_mask(capacity - 1),
+    m_head(0),
+    m_tail(0),
+    m_discard_before(0),
+    m_spilling(false),
+    m_overflow_size(0)
 {}
 
-bool MessageQueue::Empty() const {
-    boost::mutex::scoped_lock lock(m_monitor);
-    return m_queue.empty();
+bool MessageQueue::Ring::Empty() const {
+    SkipDiscarded();
+    return m_head == LoadAcquire(m_tail) && !LoadAcquire(m_overflow_size);
+}
+
+std::size_t MessageQueue::Ring::Size() const {
+    SkipDiscarded();
+    return LoadAcquire(m_tail) - m_head + LoadAcquire(m_overflow_size);
+}
+
+void MessageQueue::Ring::Push(Message& message) {
+    if (m_spilling) {
+        // only the consumer takes messages off the overflow, so once it has
+        // been seen empty here, it stays empty until this thread spills again
+        boost::mutex::scoped_lock lock(m_overflow_mutex);
+        if (!m_overflow.empty()) {
+            Spill(message);
+            return;
+        }
+        m_spilling = false;
+    }
+    if (TryPushToRing(message))
+        return;
+    boost::mutex::scoped_lock lock(m_overflow_mutex);
+    m_spilling = true;
+    Spill(message);
+}
+
+bool MessageQueue::Ring::TryPushToRing(Message& message) {
+    const std::size_t tail = m_tail;
+    if (tail - LoadAcquire(m_head) == m_slots.size())
+        return false;
+    swap(m_slots[tail & m_mask], message);
+    StoreRelease(m_tail, tail + 1);
+    return true;
+}
+
+void MessageQueue::Ring::Spill(Message& message) {
+    m_overflow.push_back(Message());
+    swap(m_overflow.back(), message);
+    StoreRelease(m_overflow_size, m_overflow_size + 1);
+}
+
+bool MessageQueue::Ring::TryPop(Message& message) {
+    SkipDiscarded();
+    std::size_t head = m_head;
+    if (head == LoadAcquire(m_tail)) {
+        if (!LoadAcquire(m_overflow_size))
+            return false;
+        // the producer may have filled the ring and spilled since it was
+        // checked above; with the mutex held, the ring can't gain messages
+        // while the overflow is nonempty, and its messages are the older
+        boost::mutex::scoped_lock lock(m_overflow_mutex);
+        SkipDiscarded();
+        head = m_head;
+        if (head == LoadAcquire(m_tail)) {
+            if (m_overflow.empty())
+                return false;
+            swap(message, m_overflow.front());
+            m_overflow.pop_front();
+            StoreRelease(m_overflow_size, m_overflow_size - 1);
+            return true;
+        }
+    }
+    Message& slot = m_slots[head & m_mask];
+    swap(message, slot);
+    slot = Message();
+    StoreRelease(m_head, head + 1);
+    return true;
+}
+
+void MessageQueue::Ring::Discard() {
+    {
+        boost::mutex::scoped_lock lock(m_overflow_mutex);
+        m_overflow.clear();
+        StoreRelease(m_overflow_size, 0);
+        m_spilling = false;
+    }
+    StoreRelease(m_discard_before, m_tail);
 }
 
-std::size_t MessageQueue::Size() const {
-    boost::mutex::scoped_lock lock(m_monitor);
-    return m_queue.size();
+void MessageQueue::Ring::SkipDiscarded() const {
+    const std::size_t discard_before = LoadAcquire(m_discard_before);
+    std::size_t head = m_head;
+    if (!Before(head, discard_before))
+        return;
+    for (; head != discard_before; ++head)
+        m_slots[head & m_mask] = Message();
+    StoreRelease(m_head, head);
 }
 
+////////////////////////////////////////////////
+// MessageQueue
+////////////////////////////////////////////////
+MessageQueue::MessageQueue() :
+    m_messages(MESSAGE_CAPACITY),
+    m_synchronous_responses(SYNCHRONOUS_RESPONSE_CAPACITY),
+    m_consumer_waiting(0)
+{}
+
+bool MessageQueue::Empty() const
+{ return m_messages.Empty(); }
+
+std::size_t MessageQueue::Size() const
+{ return m_messages.Size(); }
+
 void MessageQueue::Clear() {
-    boost::mutex::scoped_lock lock(m_monitor);
-    m_queue.clear();
+    m_messages.Discard();
+    m_synchronous_responses.Discard();
 }
 
 void MessageQueue::PushBack(Message& message) {
-    boost::mutex::scoped_lock lock(m_monitor);
-    m_queue.push_back(Message());
-    swap(m_queue.back(), message);
-    if (m_queue.back().SynchronousResponse())
+    const bool synchronous_response = message.SynchronousResponse();
+    Ring& ring = synchronous_response ? m_synchronous_responses : m_messages;
+    ring.Push(message);
+
+    if (synchronous_response) {
+        // the consumer checks the ring with this mutex held before waiting,
+        // so taking it here ensures the notification can't be missed
+        boost::mutex::scoped_lock lock(m_synchronous_response_mutex);
         m_have_synchronous_response.notify_one();
+    } else {
+        // either the consumer sees the message when it checks the ring after
+        // setting m_consumer_waiting, or this sees m_consumer_waiting set and
+        // takes the mutex, which the consumer only releases by waiting
+        FullBarrier();
+        if (m_consumer_waiting) {
+            boost::mutex::scoped_lock lock(m_message_mutex);
+            m_have_message.notify_one();
+        }
+    }
 }
 
-void MessageQueue::PopFront(Message& message) {
-    boost::mutex::scoped_lock lock(m_monitor);
-    swap(message, m_queue.front());
-    m_queue.pop_front();
+void MessageQueue::PopFront(Message& message)
+{ m_messages.TryPop(message); }
+
+bool MessageQueue::WaitForMessage(int timeout_ms) {
+    if (!m_messages.Empty())
+        return true;
+    const boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeout_ms);
+    boost::mutex::scoped_lock lock(m_message_mutex);
+    m_consumer_waiting = 1;
+    FullBarrier();
+    while (m_messages.Empty()) {
+        if (!m_have_message.timed_wait(lock, deadline))
+            break;
+    }
+    m_consumer_waiting = 0;
+    return !m_messages.Empty();
 }
 
 void MessageQueue::EraseFirstSynchronousResponse(Message& message) {
-    boost::mutex::scoped_lock lock(m_monitor);
-    std::list<Message>::iterator it = std::find_if(m_queue.begin(), m_queue.end(), SynchronousResponseMessage());
-    while (it == m_queue.end()) {
+    if (m_synchronous_responses.TryPop(message))
+        return;
+    boost::mutex::scoped_lock lock(m_synchronous_response_mutex);
+    while (!m_synchronous_responses.TryPop(message))
         m_have_synchronous_response.wait(lock);
-        it = std::find_if(m_queue.begin(), m_queue.end(), SynchronousResponseMessage());
-    }
-    swap(message, *it);
-    m_queue.erase(it);
 }
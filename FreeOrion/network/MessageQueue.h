@@ -2,43 +2,103 @@
 #ifndef _MessageQueue_h_
 #define _MessageQueue_h_
 
+#include "Message.h"
+
 #include <boost/thread/condition.hpp>
 #include <boost/thread/mutex.hpp>
 
 #include <list>
+#include <vector>
 
 
-class Message;
-
-/** A thread-safe message queue.  The entire public interface is guarded with mutex locks. */
+/** A thread-safe queue that passes messages from a single producer thread
+    (the networking thread) to a single consumer thread (the main thread).
+    Messages are kept in fixed-size ring buffers, so passing a message along
+    takes no locks, and the consumer never waits for the producer except in
+    WaitForMessage() and EraseFirstSynchronousResponse().  Synchronous responses are kept in a
+    separate ring, so that EraseFirstSynchronousResponse() doesn't have to
+    search the others for them.  If a ring is full, PushBack() spills messages
+    to an unbounded list behind it, which takes a lock, rather than waiting
+    for the consumer: the consumer may itself be waiting in
+    EraseFirstSynchronousResponse() for a response that is yet to be
+    pushed. */
 class MessageQueue
 {
 public:
-    MessageQueue(boost::mutex& monitor);
+    MessageQueue();
 
-    /** Returns true iff the queue is empty. */
+    /** Returns true iff the queue is empty.  Consumer only. */
     bool Empty() const;
 
-    /** Returns the number of messages in the queue. */
+    /** Returns the number of messages in the queue, other than synchronous
+        responses.  Consumer only. */
     std::size_t Size() const;
 
-    /** Empties the queue. */
+    /** Empties the queue.  Producer only. */
     void Clear();
 
-    /** Adds \a message to the end of the queue. */
+    /** Adds \a message to the end of the queue.  Producer only. */
     void PushBack(Message& message);
 
-    /** Returns the front message in the queue. */
+    /** Returns the front message in the queue.  Consumer only. */
     void PopFront(Message& message);
 
+    /** Returns true iff the queue is not empty, first blocking the calling
+        thread until a message other than a synchronous response is added, or
+        until \a timeout_ms milliseconds have passed, if it is.  Consumer
+        only. */
+    bool WaitForMessage(int timeout_ms);
+
     /** Returns the first synchronous repsonse message in the queue.  If no such message is found, this function blocks
-        the calling thread until a synchronous response element is added. */
+        the calling thread until a synchronous response element is added.  Consumer only. */
     void EraseFirstSynchronousResponse(Message& message);
 
 private:
-    std::list<Message> m_queue;
-    boost::condition   m_have_synchronous_response;
-    boost::mutex&      m_monitor;
+    /** A bounded single-producer, single-consumer ring buffer of messages.
+        The head and tail indices only ever increase; each is written by one
+        thread only, and published to the other with a memory barrier.
+        Messages pushed while the ring is full go to a mutex-guarded overflow
+        list, as do all messages pushed after them until the consumer has
+        emptied it, so every message in the overflow is newer than every
+        message in the ring. */
+    class Ring {
+    public:
+        explicit Ring(std::size_t capacity);    ///< \a capacity must be a power of two
+
+        bool        Empty() const;
+        std::size_t Size() const;
+        void        Push(Message& message);     ///< producer; swaps \a message into the ring, or the overflow if the ring is full
+        bool        TryPop(Message& message);   ///< consumer; swaps the front message into \a message, unless empty
+        void        Discard();                  ///< producer; marks all messages pushed so far to be dropped
+
+    private:
+        bool        TryPushToRing(Message& message);    ///< producer; swaps \a message into the ring, unless it is full
+        void        Spill(Message& message);            ///< producer; swaps \a message onto the overflow; m_overflow_mutex must be held
+        void        SkipDiscarded() const;              ///< consumer; drops messages marked by Discard()
+
+        enum { CACHE_LINE_SIZE = 64 };
+
+        mutable std::vector<Message>    m_slots;
+        std::size_t                     m_mask;
+        char                            m_pad0[CACHE_LINE_SIZE];
+        mutable volatile std::size_t    m_head;             ///< index of the next message to pop; written by the consumer
+        char                            m_pad1[CACHE_LINE_SIZE];
+        volatile std::size_t            m_tail;             ///< index of the next slot to push into; written by the producer
+        volatile std::size_t            m_discard_before;   ///< messages before this index are to be dropped; written by the producer
+        bool                            m_spilling;         ///< true iff the overflow may be nonempty; producer only
+        char                            m_pad2[CACHE_LINE_SIZE];
+        std::list<Message>              m_overflow;
+        volatile std::size_t            m_overflow_size;    ///< written with m_overflow_mutex held, so it can be checked without it
+        mutable boost::mutex            m_overflow_mutex;   ///< guards m_overflow
+    };
+
+    Ring                m_messages;
+    Ring                m_synchronous_responses;
+    boost::mutex        m_synchronous_response_mutex;
+    boost::condition    m_have_synchronous_response;
+    boost::mutex        m_message_mutex;
+    boost::condition    m_have_message;
+    volatile std::size_t m_consumer_waiting;   ///< nonzero while the consumer is in WaitForMessage(); written by the consumer
 };
 
 
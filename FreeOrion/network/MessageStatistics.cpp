@@ -0,0 +1,168 @@
+#include "MessageStatistics.h"
+
+#include "../util/AppInterface.h"
+#include "../util/OptionsDB.h"
+
+#include <boost/thread/once.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+
+namespace {
+    void AddOptions(OptionsDB& db) {
+        db.Add("network-stats-log-interval", "OPTIONS_DB_NETWORK_STATS_LOG_INTERVAL", 300, RangedValidator<int>(0, 86400));
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
+
+    boost::posix_time::ptime Now()
+    { return boost::posix_time::microsec_clock::universal_time(); }
+
+    const char* STAGE_NAMES[MessageStatistics::NUM_STAGES] = {
+        "serialize",
+        "send",
+        "receive",
+        "deserialize"
+    };
+
+    // GetMessageStatistics() is first called from whichever thread records
+    // the first message, possibly several at once, so the instance is created
+    // with call_once rather than as a function-local static, which not all of
+    // our compilers initialize thread-safely.  It is never destroyed, so
+    // messages recorded during shutdown still have somewhere to go.
+    MessageStatistics*  s_statistics = 0;
+    boost::once_flag    s_statistics_once = BOOST_ONCE_INIT;
+
+    void CreateMessageStatistics()
+    { s_statistics = new MessageStatistics; }
+}
+
+////////////////////////////////////////////////
+// MessageStatistics::StageTotals
+////////////////////////////////////////////////
+MessageStatistics::StageTotals::StageTotals() :
+    count(0),
+    bytes(0),
+    total_seconds(0.0),
+    max_seconds(0.0)
+{}
+
+void MessageStatistics::StageTotals::Add(std::size_t bytes_, double seconds) {
+    ++count;
+    bytes += bytes_;
+    total_seconds += seconds;
+    max_seconds = std::max(max_seconds, seconds);
+}
+
+////////////////////////////////////////////////
+// MessageStatistics
+////////////////////////////////////////////////
+MessageStatistics::MessageStatistics() :
+    m_summary_interval(boost::posix_time::not_a_date_time),
+    m_last_summary(Now())
+{}
+
+MessageStatistics::TotalsMap MessageStatistics::GetTotals() const {
+    boost::mutex::scoped_lock lock(m_mutex);
+    return m_totals;
+}
+
+void MessageStatistics::LogSummary(const std::string& heading) const {
+    TotalsMap totals = GetTotals();
+    if (totals.empty())
+        return;
+
+    // sum over players
+    std::map<Message::MessageType, Totals> type_totals;
+    for (TotalsMap::const_iterator it = totals.begin(); it != totals.end(); ++it) {
+        Totals& sum = type_totals[it->first.first];
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            const StageTotals& stage_totals = it->second.stages[stage];
+            sum.stages[stage].count += stage_totals.count;
+            sum.stages[stage].bytes += stage_totals.bytes;
+            sum.stages[stage].total_seconds += stage_totals.total_seconds;
+            sum.stages[stage].max_seconds = std::max(sum.stages[stage].max_seconds, stage_totals.max_seconds);
+        }
+    }
+
+    std::ostringstream os;
+    os << heading << " (count / KB / total ms / max ms):";
+    os << std::fixed << std::setprecision(1);
+    for (std::map<Message::MessageType, Totals>::const_iterator it = type_totals.begin(); it != type_totals.end(); ++it) {
+        os << "\n    " << MessageTypeStr(it->first) << ":";
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            const StageTotals& stage_totals = it->second.stages[stage];
+            if (!stage_totals.count)
+                continue;
+            os << " " << STAGE_NAMES[stage] << " " << stage_totals.count
+               << " / " << stage_totals.bytes / 1024.0
+               << " / " << stage_totals.total_seconds * 1000.0
+               << " / " << stage_totals.max_seconds * 1000.0 << ";";
+        }
+    }
+    Logger().debugStream() << os.str();
+}
+
+void MessageStatistics::WriteCSV(std::ostream& os, int turn, bool header) const {
+    TotalsMap totals = GetTotals();
+    if (header)
+        os << "turn,stage,message_type,player_id,count,bytes,total_ms,max_ms\n";
+    for (TotalsMap::const_iterator it = totals.begin(); it != totals.end(); ++it) {
+        for (int stage = 0; stage < NUM_STAGES; ++stage) {
+            const StageTotals& stage_totals = it->second.stages[stage];
+            if (!stage_totals.count)
+                continue;
+            os << turn << ","
+               << STAGE_NAMES[stage] << ","
+               << MessageTypeStr(it->first.first) << ","
+               << it->first.second << ","
+               << stage_totals.count << ","
+               << stage_totals.bytes << ","
+               << stage_totals.total_seconds * 1000.0 << ","
+               << stage_totals.max_seconds * 1000.0 << "\n";
+        }
+    }
+}
+
+void MessageStatistics::Record(Stage stage, Message::MessageType type, int player_id, std::size_t bytes,
+                               double seconds)
+{
+    bool log_summary = false;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_totals[std::make_pair(type, player_id)].stages[stage].Add(bytes, seconds);
+
+        // the interval is read on first use, by which time the command line
+        // has been parsed
+        if (m_summary_interval.is_special())
+            m_summary_interval = boost::posix_time::seconds(GetOptionsDB().Get<int>("network-stats-log-interval"));
+        if (m_summary_interval.total_seconds()) {
+            const boost::posix_time::ptime now = Now();
+            if (m_summary_interval <= now - m_last_summary) {
+                m_last_summary = now;
+                log_summary = true;
+            }
+        }
+    }
+    if (log_summary)
+        LogSummary("Message statistics");
+}
+
+void MessageStatistics::Record(Stage stage, const Message& message, std::size_t bytes, double seconds) {
+    int player_id = message.SendingPlayer();
+    if (player_id == Networking::INVALID_PLAYER_ID)
+        player_id = message.ReceivingPlayer();
+    Record(stage, message.Type(), player_id, bytes, seconds);
+}
+
+void MessageStatistics::Clear() {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_totals.clear();
+}
+
+MessageStatistics& GetMessageStatistics() {
+    boost::call_once(s_statistics_once, &CreateMessageStatistics);
+    return *s_statistics;
+}
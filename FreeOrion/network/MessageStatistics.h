@@ -0,0 +1,107 @@
+// -*- C++ -*-
+#ifndef _MessageStatistics_h_
+#define _MessageStatistics_h_
+
+#include "Message.h"
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <iosfwd>
+#include <map>
+
+
+/** Running totals of the time and bytes spent on the messages passing through
+    this process, by message type and player, which show where the time
+    between the server and clients goes.  Each message goes through up to four
+    stages in a process:
+
+    - SERIALIZE: from the creation of the MessageOStream for its body until
+      the Message is constructed from it.
+    - SEND: from being queued for sending until completely written to the
+      socket or shared memory, including compression.
+    - RECEIVE: from its header being read until its body has been read and
+      decompressed.
+    - DESERIALIZE: from the creation of the MessageIStream on its body until
+      that stream is destroyed, at the end of ExtractMessageData().
+
+    Sizes are of the serialized body for SERIALIZE and DESERIALIZE, and of
+    what went over the connection, including the header, for SEND and
+    RECEIVE.  Players are the client end of each message: on the server the
+    player connected to, and on clients the client's own player.  The
+    recording functions may be called from any thread.  Every
+    network-stats-log-interval seconds, a summary is written to the log. */
+class MessageStatistics {
+public:
+    enum Stage {
+        SERIALIZE,
+        SEND,
+        RECEIVE,
+        DESERIALIZE,
+        NUM_STAGES
+    };
+
+    /** Totals for one stage of one type of message. */
+    struct StageTotals {
+        StageTotals();
+        void                Add(std::size_t bytes, double seconds);
+
+        int                 count;
+        long long           bytes;
+        double              total_seconds;
+        double              max_seconds;
+    };
+
+    /** Totals for each stage of one type of message to or from one player. */
+    struct Totals {
+        StageTotals         stages[NUM_STAGES];
+    };
+
+    /** Totals keyed by message type and player id. */
+    typedef std::map<std::pair<Message::MessageType, int>, Totals> TotalsMap;
+
+    /** \name Structors */ //@{
+    MessageStatistics();
+    //@}
+
+    /** \name Accessors */ //@{
+    /** Returns a copy of the totals recorded so far. */
+    TotalsMap       GetTotals() const;
+
+    /** Writes a summary of the totals for each type of message, over all
+        players, to the log, headed by \a heading. */
+    void            LogSummary(const std::string& heading) const;
+
+    /** Writes a line of comma-separated values to \a os for each stage of each
+        type of message to or from each player, prefixed with \a turn: turn,
+        stage, message type, player id, count, bytes, total and maximum
+        milliseconds.  If \a header is true, a line naming the columns comes
+        first. */
+    void            WriteCSV(std::ostream& os, int turn, bool header) const;
+    //@}
+
+    /** \name Mutators */ //@{
+    /** Records that stage \a stage of a message of type \a type to or from
+        player \a player_id took \a seconds and handled \a bytes bytes. */
+    void            Record(Stage stage, Message::MessageType type, int player_id, std::size_t bytes,
+                           double seconds);
+
+    /** Records \a stage of \a message, which is to or from the player who
+        sent it, or if the server sent it, the player receiving it. */
+    void            Record(Stage stage, const Message& message, std::size_t bytes, double seconds);
+
+    /** Forgets everything recorded. */
+    void            Clear();
+    //@}
+
+private:
+    TotalsMap                           m_totals;
+    boost::posix_time::time_duration    m_summary_interval;     ///< not_a_date_time until the option is read
+    boost::posix_time::ptime            m_last_summary;
+    mutable boost::mutex                m_mutex;
+};
+
+/** Returns the process's MessageStatistics. */
+MessageStatistics& GetMessageStatistics();
+
+#endif
@@ -1,7 +1,10 @@
 #include "ServerNetworking.h"
 
+#include "MessageStatistics.h"
+
 #include "../util/AppInterface.h"
 #include "../util/MultiplayerCommon.h"
+#include "../util/OptionsDB.h"
 
 #include <GG/SignalsAndSlots.h>
 
@@ -14,6 +17,12 @@ using namespace Networking;
 
 namespace {
     const bool TRACE_EXECUTION = true;
+
+    void AddOptions(OptionsDB& db) {
+        db.Add("network-send-queue-max-messages", "OPTIONS_DB_NETWORK_SEND_QUEUE_MAX_MESSAGES", 1000, RangedValidator<int>(1, 1000000));
+        db.Add("network-send-queue-max-mb", "OPTIONS_DB_NETWORK_SEND_QUEUE_MAX_MB", 256, RangedValidator<int>(1, 4096));
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
 }
 
 /** A simple server that listens for FreeOrion-server-discovery UDP datagrams
@@ -32,15 +41,6 @@ private:
 };
 
 namespace {
-    void WriteMessage(boost::asio::ip::tcp::socket& socket, const Message& message) {
-        int header_buf[5];
-        HeaderToBuffer(message, header_buf);
-        std::vector<boost::asio::const_buffer> buffers;
-        buffers.push_back(boost::asio::buffer(header_buf));
-        buffers.push_back(boost::asio::buffer(message.Data(), message.Size()));
-        boost::asio::write(socket, buffers);
-    }
-
     struct PlayerID {
         PlayerID(int id) : m_id(id) {}
         bool operator()(const PlayerConnectionPtr& player_connection)
@@ -53,6 +53,16 @@ namespace {
 ////////////////////////////////////////////////////////////////////////////////
 // PlayerConnection
 ////////////////////////////////////////////////////////////////////////////////
+PlayerConnection::SendStats::SendStats() :
+    messages_sent(0),
+    bytes_sent(0),
+    messages_queued(0),
+    bytes_queued(0),
+    max_bytes_queued(0),
+    total_latency(boost::posix_time::time_duration()),
+    max_latency(boost::posix_time::time_duration())
+{}
+
 PlayerConnection::PlayerConnection(boost::asio::io_service& io_service,
                                    MessageAndConnectionFn nonplayer_message_callback,
                                    MessageAndConnectionFn player_message_callback,
@@ -61,6 +71,11 @@ PlayerConnection::PlayerConnection(boost::asio::io_service& io_service,
     m_ID(INVALID_PLAYER_ID),
     m_new_connection(true),
     m_client_type(Networking::INVALID_CLIENT_TYPE),
+    m_send_compression(Message::NO_COMPRESSION),
+    m_messages_being_written(0),
+    m_write_failed(false),
+    m_disconnect_signalled(false),
+    m_ready_pooled_ai_client(false),
     m_nonplayer_message_callback(nonplayer_message_callback),
     m_player_message_callback(player_message_callback),
     m_disconnected_callback(disconnected_callback)
@@ -82,13 +97,57 @@ Networking::ClientType PlayerConnection::GetClientType() const
 { return m_client_type; }
 
 bool PlayerConnection::IsLocalConnection() const
-{ return (m_socket.remote_endpoint().address().is_loopback()); }
+{ return m_shared_memory_stream || m_socket.remote_endpoint().address().is_loopback(); }
+
+const PlayerConnection::SendStats& PlayerConnection::GetSendStats() const
+{ return m_send_stats; }
+
+bool PlayerConnection::Disconnected() const
+{ return m_disconnect_signalled; }
+
+bool PlayerConnection::ReadyPooledAIClient() const
+{ return m_ready_pooled_ai_client; }
 
 void PlayerConnection::Start()
 { AsyncReadMessage(); }
 
-void PlayerConnection::SendMessage(const Message& message)
-{ WriteMessage(m_socket, message); }
+void PlayerConnection::SendMessage(const Message& uncompressed_message) {
+    if (m_write_failed)
+        return;
+
+    const Message message = CompressMessage(uncompressed_message, m_send_compression);
+
+    const std::size_t MAX_MESSAGES = GetOptionsDB().Get<int>("network-send-queue-max-messages");
+    const std::size_t MAX_BYTES = GetOptionsDB().Get<int>("network-send-queue-max-mb") * std::size_t(1024 * 1024);
+    const std::size_t size = HEADER_SIZE + message.Size();
+
+    // a single message is always accepted, no matter how big it is
+    if (!m_outgoing_messages.empty() &&
+        (MAX_MESSAGES <= m_send_stats.messages_queued || MAX_BYTES < m_send_stats.bytes_queued + size))
+    {
+        Logger().errorStream() << "PlayerConnection::SendMessage : player " << m_ID << " has "
+                               << m_send_stats.messages_queued << " messages (" << m_send_stats.bytes_queued
+                               << " bytes) waiting to be sent; disconnecting it";
+        m_write_failed = true;
+        DropQueuedMessages();
+        Shutdown();
+        SignalDisconnected();
+        return;
+    }
+
+    m_outgoing_messages.push_back(OutgoingMessage());
+    OutgoingMessage& outgoing = m_outgoing_messages.back();
+    HeaderToBuffer(message, outgoing.header.c_array());
+    outgoing.message = message;
+    outgoing.queued_time = boost::posix_time::microsec_clock::universal_time();
+
+    ++m_send_stats.messages_queued;
+    m_send_stats.bytes_queued += size;
+    m_send_stats.max_bytes_queued = std::max(m_send_stats.max_bytes_queued, m_send_stats.bytes_queued);
+
+    if (!m_messages_being_written)
+        AsyncWriteQueuedMessages();
+}
 
 void PlayerConnection::EstablishPlayer(int id, const std::string& player_name,
                                        Networking::ClientType client_type)
@@ -127,6 +186,9 @@ void PlayerConnection::SetClientType(Networking::ClientType client_type) {
         Logger().errorStream() << "PlayerConnection client type set to INVALID_CLIENT_TYPE...?";
 }
 
+void PlayerConnection::ClearReadyPooledAIClient()
+{ m_ready_pooled_ai_client = false; }
+
 PlayerConnectionPtr
 PlayerConnection::NewConnection(boost::asio::io_service& io_service,
                                 MessageAndConnectionFn nonplayer_message_callback,
@@ -146,7 +208,7 @@ void PlayerConnection::HandleMessageBodyRead(boost::system::error_code error,
     if (error) {
         if (error == boost::asio::error::eof ||
             error == boost::asio::error::connection_reset)
-            EventSignal(boost::bind(m_disconnected_callback, shared_from_this()));
+            SignalDisconnected();
         else
             Logger().errorStream() << "PlayerConnection::HandleMessageBodyRead(): error \""
                                    << error << "\"";
@@ -156,14 +218,35 @@ void PlayerConnection::HandleMessageBodyRead(boost::system::error_code error,
             //if (TRACE_EXECUTION)
                 //Logger().debugStream() << "PlayerConnection::HandleMessageBodyRead(): "
                 //                       << "received message " << m_incoming_message;
-            if (EstablishedPlayer()) {
-                EventSignal(boost::bind(m_player_message_callback,
-                                        m_incoming_message,
-                                        shared_from_this()));
-            } else {
-                EventSignal(boost::bind(m_nonplayer_message_callback,
-                                        m_incoming_message,
-                                        shared_from_this()));
+            try {
+                Message message = DecompressMessage(m_incoming_message);
+                boost::posix_time::time_duration elapsed =
+                    boost::posix_time::microsec_clock::universal_time() - m_incoming_header_time;
+                GetMessageStatistics().Record(MessageStatistics::RECEIVE, message.Type(), m_ID,
+                                              HEADER_SIZE + bytes_transferred,
+                                              elapsed.total_microseconds() / 1.0e6);
+                if (message.Type() == Message::COMPRESSION_SETUP) {
+                    HandleCompressionSetup(message);
+                } else if (message.Type() == Message::AI_POOL_READY && !EstablishedPlayer()) {
+                    // only AI clients the server started itself may join the pool
+                    if (IsLocalConnection())
+                        m_ready_pooled_ai_client = true;
+                    else
+                        Logger().errorStream() << "PlayerConnection::HandleMessageBodyRead(): ignoring "
+                                               << "AI_POOL_READY message from a remote client";
+                } else if (EstablishedPlayer()) {
+                    EventSignal(boost::bind(m_player_message_callback,
+                                            message,
+                                            shared_from_this()));
+                } else {
+                    EventSignal(boost::bind(m_nonplayer_message_callback,
+                                            message,
+                                            shared_from_this()));
+                }
+            } catch (const std::exception& e) {
+                Logger().errorStream() << "PlayerConnection::HandleMessageBodyRead(): dropping "
+                                       << MessageTypeStr(m_incoming_message.Type())
+                                       << " message: " << e.what();
             }
             m_incoming_message = Message();
             AsyncReadMessage();
@@ -182,14 +265,14 @@ void PlayerConnection::HandleMessageHeaderRead(boost::system::error_code error,
         // whay this is so, but putting a pause in place seems to at least
         // mask the problem.  For now, this is sufficient, since rapid
         // connects and disconnects are not a priority.
-        if (m_new_connection) {
+        if (m_new_connection && !m_shared_memory_stream) {
             // wait half a second if the first data read is an error; we
             // probably just need more setup time
             Sleep(500);
         } else {
             if (error == boost::asio::error::eof ||
                 error == boost::asio::error::connection_reset)
-                EventSignal(boost::bind(m_disconnected_callback, shared_from_this()));
+                SignalDisconnected();
             else
                 Logger().errorStream() << "PlayerConnection::HandleMessageHeaderRead(): "
                                        << "error \"" << error << "\"";
@@ -198,23 +281,137 @@ void PlayerConnection::HandleMessageHeaderRead(boost::system::error_code error,
         m_new_connection = false;
         assert(static_cast<int>(bytes_transferred) <= HEADER_SIZE);
         if (static_cast<int>(bytes_transferred) == HEADER_SIZE) {
+            m_incoming_header_time = boost::posix_time::microsec_clock::universal_time();
             BufferToHeader(m_incoming_header_buffer.c_array(), m_incoming_message);
             m_incoming_message.Resize(m_incoming_header_buffer[4]);
-            boost::asio::async_read(
-                m_socket,
-                boost::asio::buffer(m_incoming_message.Data(), m_incoming_message.Size()),
-                boost::bind(&PlayerConnection::HandleMessageBodyRead, this,
-                            boost::asio::placeholders::error,
-                            boost::asio::placeholders::bytes_transferred));
+            AsyncRead(boost::asio::buffer(m_incoming_message.Data(), m_incoming_message.Size()),
+                      boost::bind(&PlayerConnection::HandleMessageBodyRead, this, _1, _2));
         }
     }
 }
 
 void PlayerConnection::AsyncReadMessage() {
-    boost::asio::async_read(m_socket, boost::asio::buffer(m_incoming_header_buffer),
-                            boost::bind(&PlayerConnection::HandleMessageHeaderRead, this,
-                                        boost::asio::placeholders::error,
-                                        boost::asio::placeholders::bytes_transferred));
+    AsyncRead(boost::asio::buffer(m_incoming_header_buffer),
+              boost::bind(&PlayerConnection::HandleMessageHeaderRead, this, _1, _2));
+}
+
+void PlayerConnection::HandleCompressionSetup(const Message& message) {
+    unsigned int peer_compressions = 0;
+    ExtractMessageData(message, peer_compressions);
+
+    // compression costs more than it saves on loopback connections
+    boost::system::error_code error;
+    const bool local = m_shared_memory_stream || m_socket.remote_endpoint(error).address().is_loopback();
+    m_send_compression = local ? Message::NO_COMPRESSION : ChooseCompression(peer_compressions);
+    if (TRACE_EXECUTION)
+        Logger().debugStream() << "PlayerConnection(@ " << this << ")::HandleCompressionSetup : "
+                               << "sending messages with compression " << m_send_compression;
+
+    SendMessage(CompressionSetupMessage());
+}
+
+void PlayerConnection::HandleMessagesWritten(boost::system::error_code error,
+                                             std::size_t bytes_transferred)
+{
+    m_send_stats.bytes_sent += bytes_transferred;
+
+    if (error) {
+        // a closed connection is reported by the pending read, so there is no
+        // need to signal a disconnection here
+        if (error != boost::asio::error::eof &&
+            error != boost::asio::error::connection_reset &&
+            error != boost::asio::error::broken_pipe &&
+            error != boost::asio::error::operation_aborted)
+        {
+            Logger().errorStream() << "PlayerConnection::HandleMessagesWritten(): error \""
+                                   << error << "\"";
+        }
+        m_write_failed = true;
+        m_messages_being_written = 0;
+        DropQueuedMessages();
+        return;
+    }
+
+    const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+    for (; m_messages_being_written; --m_messages_being_written) {
+        const OutgoingMessage& sent = m_outgoing_messages.front();
+        boost::posix_time::time_duration latency = now - sent.queued_time;
+        m_send_stats.total_latency += latency;
+        m_send_stats.max_latency = std::max(m_send_stats.max_latency, latency);
+        GetMessageStatistics().Record(MessageStatistics::SEND, sent.message.Type(), m_ID,
+                                      HEADER_SIZE + sent.message.Size(),
+                                      latency.total_microseconds() / 1.0e6);
+        ++m_send_stats.messages_sent;
+        --m_send_stats.messages_queued;
+        m_send_stats.bytes_queued -= HEADER_SIZE + sent.message.Size();
+        m_outgoing_messages.pop_front();
+    }
+
+    if (!m_outgoing_messages.empty())
+        AsyncWriteQueuedMessages();
+}
+
+void PlayerConnection::AsyncWriteQueuedMessages() {
+    // all queued messages go out in a single write, with each header and body
+    // as separate buffers; the bodies are shared with the callers' Messages,
+    // not copied
+    std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(2 * m_outgoing_messages.size());
+    for (std::deque<OutgoingMessage>::const_iterator it = m_outgoing_messages.begin();
+         it != m_outgoing_messages.end(); ++it)
+    {
+        buffers.push_back(boost::asio::buffer(it->header));
+        buffers.push_back(boost::asio::buffer(it->message.Data(), it->message.Size()));
+    }
+    m_messages_being_written = m_outgoing_messages.size();
+
+    // the handler holds a reference to this connection, so that it outlives
+    // the write even if it is disconnected in the meantime
+    AsyncWrite(buffers, boost::bind(&PlayerConnection::HandleMessagesWritten, shared_from_this(), _1, _2));
+}
+
+void PlayerConnection::AsyncRead(const boost::asio::mutable_buffer& buffer,
+                                 const SharedMemoryStream::CompletionHandler& handler)
+{
+    if (m_shared_memory_stream)
+        m_shared_memory_stream->AsyncRead(buffer, handler);
+    else
+        boost::asio::async_read(m_socket, boost::asio::mutable_buffers_1(buffer), handler);
+}
+
+void PlayerConnection::AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers,
+                                  const SharedMemoryStream::CompletionHandler& handler)
+{
+    if (m_shared_memory_stream)
+        m_shared_memory_stream->AsyncWrite(buffers, handler);
+    else
+        boost::asio::async_write(m_socket, buffers, handler);
+}
+
+void PlayerConnection::Shutdown() {
+    if (m_shared_memory_stream) {
+        m_shared_memory_stream->Close();
+    } else {
+        boost::system::error_code ignored_error;
+        m_socket.shutdown(tcp::socket::shutdown_both, ignored_error);
+    }
+}
+
+void PlayerConnection::DropQueuedMessages() {
+    // messages being written can't be removed until the write completes, as
+    // the socket may still be reading from them
+    while (m_messages_being_written < m_outgoing_messages.size()) {
+        --m_send_stats.messages_queued;
+        m_send_stats.bytes_queued -= HEADER_SIZE + m_outgoing_messages.back().message.Size();
+        m_outgoing_messages.pop_back();
+    }
+}
+
+void PlayerConnection::SignalDisconnected() {
+    if (m_disconnect_signalled)
+        return;
+    m_disconnect_signalled = true;
+    EventSignal(boost::bind(m_disconnected_callback, shared_from_this()));
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -326,6 +523,27 @@ bool ServerNetworking::ModeratorsInGame() const {
     return false;
 }
 
+bool ServerNetworking::OutgoingMessagesPending() const {
+    for (PlayerConnections::const_iterator it = m_player_connections.begin();
+         it != m_player_connections.end(); ++it)
+    {
+        if ((*it)->GetSendStats().messages_queued)
+            return true;
+    }
+    return false;
+}
+
+std::size_t ServerNetworking::NumReadyPooledAIClients() const {
+    std::size_t retval = 0;
+    for (PlayerConnections::const_iterator it = m_player_connections.begin();
+         it != m_player_connections.end(); ++it)
+    {
+        if ((*it)->ReadyPooledAIClient())
+            ++retval;
+    }
+    return retval;
+}
+
 void ServerNetworking::SendMessage(const Message& message,
                                    PlayerConnectionPtr player_connection)
 {
@@ -359,6 +577,24 @@ void ServerNetworking::SendMessage(const Message& message) {
     }
 }
 
+std::string ServerNetworking::AddSharedMemoryConnection(std::size_t buffer_size) {
+    boost::asio::io_service& io_service = m_player_connection_acceptor.get_io_service();
+    PlayerConnectionPtr player_connection =
+        PlayerConnection::NewConnection(
+            io_service,
+            m_nonplayer_message_callback,
+            m_player_message_callback,
+            boost::bind(&ServerNetworking::DisconnectImpl, this, _1));
+    player_connection->m_shared_memory_stream = SharedMemoryStream::Create(io_service, buffer_size);
+    GG::Connect(player_connection->EventSignal, &ServerNetworking::EnqueueEvent, this);
+    if (TRACE_EXECUTION)
+        Logger().debugStream() << "ServerNetworking::AddSharedMemoryConnection : waiting for "
+                               << "new player on " << player_connection->m_shared_memory_stream->Name();
+    m_player_connections.insert(player_connection);
+    player_connection->Start();
+    return player_connection->m_shared_memory_stream->Name();
+}
+
 void ServerNetworking::Disconnect(int id) {
     established_iterator it = GetPlayer(id);
     if (it == established_end()) {
@@ -416,6 +652,62 @@ void ServerNetworking::HandleNextEvent() {
 void ServerNetworking::SetHostPlayerID(int host_player_id)
 { m_host_player_id = host_player_id; }
 
+void ServerNetworking::FlushOutgoingMessages(int timeout_ms) {
+    const boost::posix_time::ptime deadline =
+        boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(timeout_ms);
+    boost::asio::io_service& io_service = m_player_connection_acceptor.get_io_service();
+    while (OutgoingMessagesPending() && boost::posix_time::microsec_clock::universal_time() < deadline) {
+        if (!io_service.poll_one())
+            Sleep(1);
+    }
+}
+
+bool ServerNetworking::WaitForDisconnections(const std::vector<PlayerConnectionPtr>& player_connections,
+                                             int timeout_ms)
+{
+    const boost::posix_time::ptime deadline =
+        boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(timeout_ms);
+    boost::asio::io_service& io_service = m_player_connection_acceptor.get_io_service();
+    std::vector<PlayerConnectionPtr>::const_iterator first_connected = player_connections.begin();
+    while (true) {
+        while (first_connected != player_connections.end() && (*first_connected)->Disconnected())
+            ++first_connected;
+        if (first_connected == player_connections.end())
+            return true;
+        if (deadline <= boost::posix_time::microsec_clock::universal_time())
+            return false;
+        if (!io_service.poll_one())
+            Sleep(1);
+    }
+}
+
+bool ServerNetworking::WaitForReadyPooledAIClients(std::size_t count, int timeout_ms) {
+    const boost::posix_time::ptime deadline =
+        boost::posix_time::microsec_clock::universal_time() + boost::posix_time::milliseconds(timeout_ms);
+    boost::asio::io_service& io_service = m_player_connection_acceptor.get_io_service();
+    while (NumReadyPooledAIClients() < count) {
+        if (deadline <= boost::posix_time::microsec_clock::universal_time())
+            return false;
+        if (!io_service.poll_one())
+            Sleep(1);
+    }
+    return true;
+}
+
+PlayerConnectionPtr ServerNetworking::AssignPooledAIClient(const std::string& player_name, int max_aggression) {
+    for (PlayerConnections::iterator it = m_player_connections.begin();
+         it != m_player_connections.end(); ++it)
+    {
+        PlayerConnectionPtr player_connection = *it;
+        if (!player_connection->ReadyPooledAIClient() || player_connection->Disconnected())
+            continue;
+        player_connection->ClearReadyPooledAIClient();
+        player_connection->SendMessage(AIPoolAssignMessage(player_name, max_aggression));
+        return player_connection;
+    }
+    return PlayerConnectionPtr();
+}
+
 void ServerNetworking::Init() {
     tcp::endpoint endpoint(tcp::v4(), MESSAGE_PORT);
     m_player_connection_acceptor.open(endpoint.protocol());
@@ -463,6 +755,13 @@ void ServerNetworking::DisconnectImpl(PlayerConnectionPtr player_connection) {
     if (TRACE_EXECUTION)
         Logger().debugStream() << "ServerNetworking::DisconnectImpl : disconnecting player "
                                << player_connection->PlayerID();
+    const PlayerConnection::SendStats& stats = player_connection->GetSendStats();
+    Logger().debugStream() << "ServerNetworking::DisconnectImpl : sent player "
+                           << player_connection->PlayerID() << " " << stats.messages_sent
+                           << " messages (" << stats.bytes_sent << " bytes); mean latency "
+                           << (stats.messages_sent ? stats.total_latency.total_microseconds() / stats.messages_sent : 0)
+                           << " us, max latency " << stats.max_latency.total_microseconds()
+                           << " us, max queued " << stats.max_bytes_queued << " bytes";
     m_player_connections.erase(player_connection);
     m_disconnected_callback(player_connection);
 }
@@ -3,16 +3,20 @@
 #define _ServerNetworking_h_
 
 #include "Message.h"
+#include "SharedMemoryStream.h"
 
 #include <boost/array.hpp>
 #include <boost/asio.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/function.hpp>
 #include <boost/iterator/filter_iterator.hpp>
 #include <boost/signal.hpp>
 
+#include <deque>
 #include <queue>
 #include <set>
+#include <vector>
 
 
 class DiscoveryServer;
@@ -88,6 +92,14 @@ public:
 
     /** Returns whether there are any moderators in the game. */
     bool ModeratorsInGame() const;
+
+    /** Returns true iff any PlayerConnection has messages that have not yet
+        been completely written to its socket. */
+    bool OutgoingMessagesPending() const;
+
+    /** Returns the number of connections whose pooled AI clients are ready to
+        be assigned players. */
+    std::size_t NumReadyPooledAIClients() const;
     //@}
 
     /** \name Mutators */ //@{
@@ -97,6 +109,14 @@ public:
     /** Sends message \a message to the player indicated in the message. */
     void SendMessage(const Message& message);
 
+    /** Creates a connection for a client on this machine that connects
+        through shared memory instead of TCP, with ring buffers of \a
+        buffer_size bytes in each direction, and returns the name the client
+        should pass to ClientNetworking::ConnectToSharedMemoryServer().  From
+        then on the connection is treated like any TCP connection.  Throws
+        std::runtime_error if the shared memory can't be created. */
+    std::string AddSharedMemoryConnection(std::size_t buffer_size);
+
     /** Disconnects the server from player \a id. */
     void Disconnect(int id);
 
@@ -130,6 +150,33 @@ public:
 
     /** Sets Host player ID. */
     void SetHostPlayerID(int host_player_id);
+
+    /** Handles network events until all queued outgoing messages have been
+        written, or until \a timeout_ms milliseconds have passed.  Other
+        events that occur in the meantime are queued as usual.  Used before
+        the server exits or kills processes whose clients should first
+        receive some final messages. */
+    void FlushOutgoingMessages(int timeout_ms);
+
+    /** Handles network events until every connection in \a player_connections
+        has been closed by its client, or until \a timeout_ms milliseconds
+        have passed, and returns true iff they all were.  As with
+        FlushOutgoingMessages(), other events are queued as usual, including
+        the disconnections themselves.  Used to wait for clients that have
+        been told to exit to do so. */
+    bool WaitForDisconnections(const std::vector<PlayerConnectionPtr>& player_connections, int timeout_ms);
+
+    /** Handles network events until at least \a count pooled AI clients are
+        ready to be assigned players, or until \a timeout_ms milliseconds have
+        passed, and returns true iff they are.  Other events are queued as
+        with FlushOutgoingMessages(). */
+    bool WaitForReadyPooledAIClients(std::size_t count, int timeout_ms);
+
+    /** Assigns a ready pooled AI client the AI player named \a player_name,
+        by sending it an AI_POOL_ASSIGN message, and returns its connection.
+        The client then joins the game like any AI client.  Returns a null
+        pointer if no pooled AI client is ready. */
+    PlayerConnectionPtr AssignPooledAIClient(const std::string& player_name, int max_aggression);
     //@}
 
 private:
@@ -158,11 +205,28 @@ private:
     newly-constructed PlayerConnection has no associated player ID, player
     name, nor host-player status.  Once a PlayerConnection is accepted by the
     server as an actual player in a game, EstablishPlayer() should be called.
-    This establishes the aforementioned properties. */
+    This establishes the aforementioned properties.  A connection normally
+    uses a TCP socket, but may instead use a SharedMemoryStream to a client
+    on the same machine; the rest of the server can't tell the difference. */
 class PlayerConnection :
     public boost::enable_shared_from_this<PlayerConnection>
 {
 public:
+    /** Counters of the messages sent on a connection.  Latency is measured
+        from the call to SendMessage() until the whole message has been
+        written to the socket. */
+    struct SendStats {
+        SendStats();
+
+        std::size_t                         messages_sent;
+        std::size_t                         bytes_sent;         ///< including headers
+        std::size_t                         messages_queued;    ///< queued or being written
+        std::size_t                         bytes_queued;       ///< queued or being written, including headers
+        std::size_t                         max_bytes_queued;
+        boost::posix_time::time_duration    total_latency;
+        boost::posix_time::time_duration    max_latency;
+    };
+
     /** \name Structors */ //@{
     ~PlayerConnection(); ///< Dtor.
     //@}
@@ -187,13 +251,31 @@ public:
     /** Checks if client associated with this connection runs on the same
         physical machine as the server */
     bool IsLocalConnection() const;
+
+    /** Returns the counters of messages sent on this connection. */
+    const SendStats& GetSendStats() const;
+
+    /** Returns true iff the connection has been closed by the client or lost,
+        and its disconnection signalled. */
+    bool Disconnected() const;
+
+    /** Returns true iff the client is an AI client of the server's AI client
+        pool that has said it is ready, and has not yet been assigned a
+        player. */
+    bool ReadyPooledAIClient() const;
     //@}
 
     /** \name Mutators */ //@{
     /** Starts the connection reading incoming messages on its socket. */
     void Start();
 
-    /** Sends \a message to out on the connection. */
+    /** Queues \a message to be sent out on the connection, and returns
+        without waiting for it to be sent.  Queued messages are written
+        asynchronously, in the order they were queued.  If the queue grows
+        beyond the limits set by the network-send-queue-max-messages and
+        network-send-queue-max-mb options, the client is considered too slow
+        to keep up and is disconnected.  Large messages are compressed with
+        the codec negotiated when the client connected, if any. */
     void SendMessage(const Message& message);
 
     /** Establishes a connection as a player with a specific name and id.
@@ -202,6 +284,10 @@ public:
 
     /** Sets this connection's client type. */
     void SetClientType(Networking::ClientType client_type);
+
+    /** Marks the connection's pooled AI client as assigned a player, so that
+        it is no longer ReadyPooledAIClient(). */
+    void ClearReadyPooledAIClient();
     //@}
 
     mutable boost::signal<void (const NullaryFn&)> EventSignal;
@@ -214,7 +300,13 @@ public:
                   ConnectionFn disconnected_callback);
 
 private:
-    typedef boost::array<int, 5> MessageHeaderBuffer;
+    typedef boost::array<int, MESSAGE_HEADER_INTS> MessageHeaderBuffer;
+
+    struct OutgoingMessage {
+        MessageHeaderBuffer         header;
+        Message                     message;
+        boost::posix_time::ptime    queued_time;
+    };
 
     PlayerConnection(boost::asio::io_service& io_service,
                      MessageAndConnectionFn nonplayer_message_callback,
@@ -225,14 +317,35 @@ private:
     void HandleMessageHeaderRead(boost::system::error_code error,
                                  std::size_t bytes_transferred);
     void AsyncReadMessage();
+    void HandleCompressionSetup(const Message& message);
+    void AsyncRead(const boost::asio::mutable_buffer& buffer,
+                   const SharedMemoryStream::CompletionHandler& handler);
+    void AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers,
+                    const SharedMemoryStream::CompletionHandler& handler);
+    void Shutdown();
+    void HandleMessagesWritten(boost::system::error_code error,
+                               std::size_t bytes_transferred);
+    void AsyncWriteQueuedMessages();
+    void DropQueuedMessages();
+    void SignalDisconnected();
 
     boost::asio::ip::tcp::socket    m_socket;
+    SharedMemoryStreamPtr           m_shared_memory_stream;     ///< used instead of m_socket, if set
     MessageHeaderBuffer             m_incoming_header_buffer;
     Message                         m_incoming_message;
+    boost::posix_time::ptime        m_incoming_header_time;
     int                             m_ID;
     std::string                     m_player_name;
     bool                            m_new_connection;
     Networking::ClientType          m_client_type;
+    Message::Compression            m_send_compression;
+
+    std::deque<OutgoingMessage>     m_outgoing_messages;
+    std::size_t                     m_messages_being_written;   ///< number of messages at the front of m_outgoing_messages being written
+    bool                            m_write_failed;
+    bool                            m_disconnect_signalled;
+    bool                            m_ready_pooled_ai_client;
+    SendStats                       m_send_stats;
 
     MessageAndConnectionFn m_nonplayer_message_callback;
     MessageAndConnectionFn m_player_message_callback;
@@ -0,0 +1,491 @@
+#ifdef FREEORION_WIN32
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#include "SharedMemoryStream.h"
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/sync/interprocess_condition.hpp>
+#include <boost/interprocess/sync/interprocess_mutex.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <cstring>
+#include <deque>
+#include <new>
+#include <stdexcept>
+
+#ifdef FREEORION_WIN32
+#include <windows.h>
+#else
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+
+namespace bip = boost::interprocess;
+
+namespace {
+    /** How often each process updates its heartbeat, and blocked operations
+        check the other's. */
+    const boost::posix_time::milliseconds POLL_INTERVAL(250);
+
+    /** How long the creator of a segment waits for another process to open
+        it, and how long either waits after the other's heartbeat stops,
+        before considering it gone.  A process that has exited is noticed
+        sooner, unless it is a zombie that hasn't been reaped yet. */
+    const boost::posix_time::seconds OPEN_TIMEOUT(60);
+    const boost::posix_time::seconds PEER_TIMEOUT(30);
+
+    boost::posix_time::ptime Now()
+    { return boost::posix_time::microsec_clock::universal_time(); }
+
+    int CurrentProcessID() {
+#ifdef FREEORION_WIN32
+        return static_cast<int>(GetCurrentProcessId());
+#else
+        return getpid();
+#endif
+    }
+
+    bool ProcessExists(int pid) {
+#ifdef FREEORION_WIN32
+        HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, static_cast<DWORD>(pid));
+        if (!process)
+            return GetLastError() == ERROR_ACCESS_DENIED;
+        const bool retval = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+        CloseHandle(process);
+        return retval;
+#else
+        return kill(pid, 0) == 0 || errno == EPERM;
+#endif
+    }
+
+    /** One direction of the stream.  The positions only ever increase; the
+        bytes between read_pos and write_pos are in the ring buffer, at their
+        positions modulo the buffer size. */
+    struct Channel {
+        Channel() :
+            read_pos(0),
+            write_pos(0),
+            closed(false)
+        {}
+
+        bip::interprocess_mutex     mutex;
+        bip::interprocess_condition changed;
+        std::size_t                 read_pos;
+        std::size_t                 write_pos;
+        bool                        closed;
+    };
+
+    /** The start of a shared memory segment.  The ring buffers for each
+        direction follow it, at SEGMENT_DATA_OFFSET. */
+    struct SegmentHeader {
+        explicit SegmentHeader(std::size_t buffer_size_) :
+            buffer_size(buffer_size_),
+            creator_pid(CurrentProcessID()),
+            opener_pid(0),
+            creator_heartbeat(0),
+            opener_heartbeat(0)
+        {}
+
+        std::size_t                 buffer_size;
+        int                         creator_pid;
+        volatile int                opener_pid;         ///< 0 until the segment is opened
+        volatile boost::uint32_t    creator_heartbeat;
+        volatile boost::uint32_t    opener_heartbeat;
+        Channel                     to_opener;
+        Channel                     to_creator;
+    };
+
+    const std::size_t SEGMENT_DATA_OFFSET = (sizeof(SegmentHeader) + 63) & ~std::size_t(63);
+
+    /** Runs posted operations one at a time, in order, in its own thread. */
+    class Worker {
+    public:
+        Worker() :
+            m_stop(false),
+            m_thread(boost::bind(&Worker::Run, this))
+        {}
+
+        /** Runs the operations already posted, then stops the thread. */
+        ~Worker() {
+            {
+                boost::mutex::scoped_lock lock(m_mutex);
+                m_stop = true;
+                m_operation_posted.notify_one();
+            }
+            m_thread.join();
+        }
+
+        void Post(const boost::function<void ()>& operation) {
+            boost::mutex::scoped_lock lock(m_mutex);
+            m_operations.push_back(operation);
+            m_operation_posted.notify_one();
+        }
+
+    private:
+        void Run() {
+            while (true) {
+                boost::function<void ()> operation;
+                {
+                    boost::mutex::scoped_lock lock(m_mutex);
+                    while (m_operations.empty() && !m_stop)
+                        m_operation_posted.wait(lock);
+                    if (m_operations.empty())
+                        return;
+                    operation = m_operations.front();
+                    m_operations.pop_front();
+                }
+                operation();
+            }
+        }
+
+        boost::mutex                            m_mutex;
+        boost::condition                        m_operation_posted;
+        std::deque<boost::function<void ()> >   m_operations;
+        bool                                    m_stop;
+        boost::thread                           m_thread;
+    };
+
+    typedef boost::shared_ptr<boost::asio::io_service::work> WorkPtr;
+}
+
+////////////////////////////////////////////////
+// SharedMemoryStream::Impl
+////////////////////////////////////////////////
+class SharedMemoryStream::Impl {
+public:
+    /** Creates the segment \a name, with ring buffers of \a buffer_size
+        bytes, if \a create is true, or opens it otherwise.  Throws
+        bip::interprocess_exception on failure. */
+    Impl(boost::asio::io_service& io_service, const std::string& name, bool create, std::size_t buffer_size);
+    ~Impl();
+
+    const std::string& Name() const
+    { return m_name; }
+
+    void AsyncRead(const boost::asio::mutable_buffer& buffer, const CompletionHandler& handler);
+    void AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers, const CompletionHandler& handler);
+    void Close();
+
+private:
+    void        Read(const boost::asio::mutable_buffer& buffer, WorkPtr work);
+    void        Write(const std::vector<boost::asio::const_buffer>& buffers, WorkPtr work);
+    std::size_t Receive(char* data, std::size_t size, boost::system::error_code& error);
+    std::size_t Send(const char* data, std::size_t size, boost::system::error_code& error);
+    bool        WaitForPeer(Channel& channel, bip::scoped_lock<bip::interprocess_mutex>& lock);
+    bool        PeerAlive();
+    void        Heartbeat();
+
+    // called through the io_service; the handlers are only ever copied and
+    // destroyed in its thread, so the worker threads never hold the last
+    // reference to the object that started an operation
+    static void ReadComplete(boost::shared_ptr<bool> alive, Impl* impl,
+                             boost::system::error_code error, std::size_t bytes);
+    static void WriteComplete(boost::shared_ptr<bool> alive, Impl* impl,
+                              boost::system::error_code error, std::size_t bytes);
+
+    boost::asio::io_service&    m_io_service;
+    const std::string           m_name;
+    const bool                  m_creator;
+    bip::shared_memory_object   m_shared_memory;
+    bip::mapped_region          m_region;
+    SegmentHeader*              m_header;
+    Channel*                    m_incoming;
+    Channel*                    m_outgoing;
+    char*                       m_incoming_data;
+    char*                       m_outgoing_data;
+
+    /** Set to false when the stream is destroyed, so that completions
+        already posted to the io_service are dropped. */
+    boost::shared_ptr<bool>     m_alive;
+
+    CompletionHandler           m_read_handler;
+    CompletionHandler           m_write_handler;
+
+    boost::mutex                m_peer_mutex;
+    boost::uint32_t             m_peer_heartbeat;
+    boost::posix_time::ptime    m_peer_heartbeat_time;
+    const boost::posix_time::ptime  m_start_time;
+
+    boost::thread               m_heartbeat_thread;
+    Worker*                     m_reader;
+    Worker*                     m_writer;
+};
+
+SharedMemoryStream::Impl::Impl(boost::asio::io_service& io_service, const std::string& name,
+                               bool create, std::size_t buffer_size) :
+    m_io_service(io_service),
+    m_name(name),
+    m_creator(create),
+    m_header(0),
+    m_incoming(0),
+    m_outgoing(0),
+    m_incoming_data(0),
+    m_outgoing_data(0),
+    m_alive(new bool(true)),
+    m_peer_heartbeat(0),
+    m_start_time(Now()),
+    m_reader(0),
+    m_writer(0)
+{
+    if (m_creator) {
+        bip::shared_memory_object shared_memory(bip::create_only, m_name.c_str(), bip::read_write);
+        m_shared_memory.swap(shared_memory);
+        m_shared_memory.truncate(SEGMENT_DATA_OFFSET + 2 * buffer_size);
+        bip::mapped_region region(m_shared_memory, bip::read_write);
+        m_region.swap(region);
+        m_header = new (m_region.get_address()) SegmentHeader(buffer_size);
+    } else {
+        bip::shared_memory_object shared_memory(bip::open_only, m_name.c_str(), bip::read_write);
+        m_shared_memory.swap(shared_memory);
+        bip::mapped_region region(m_shared_memory, bip::read_write);
+        m_region.swap(region);
+        m_header = static_cast<SegmentHeader*>(m_region.get_address());
+        if (m_region.get_size() < SEGMENT_DATA_OFFSET ||
+            m_region.get_size() < SEGMENT_DATA_OFFSET + 2 * m_header->buffer_size)
+        { throw bip::interprocess_exception("shared memory segment is too small"); }
+        m_header->opener_pid = CurrentProcessID();
+    }
+
+    char* data = static_cast<char*>(m_region.get_address()) + SEGMENT_DATA_OFFSET;
+    char* to_opener_data = data;
+    char* to_creator_data = data + m_header->buffer_size;
+    m_incoming =        m_creator ? &m_header->to_creator : &m_header->to_opener;
+    m_outgoing =        m_creator ? &m_header->to_opener : &m_header->to_creator;
+    m_incoming_data =   m_creator ? to_creator_data : to_opener_data;
+    m_outgoing_data =   m_creator ? to_opener_data : to_creator_data;
+
+    boost::thread(boost::bind(&SharedMemoryStream::Impl::Heartbeat, this)).swap(m_heartbeat_thread);
+    m_reader = new Worker;
+    m_writer = new Worker;
+}
+
+SharedMemoryStream::Impl::~Impl() {
+    *m_alive = false;
+    Close();
+    delete m_reader;
+    delete m_writer;
+    m_heartbeat_thread.interrupt();
+    m_heartbeat_thread.join();
+    if (m_creator)
+        bip::shared_memory_object::remove(m_name.c_str());
+}
+
+void SharedMemoryStream::Impl::AsyncRead(const boost::asio::mutable_buffer& buffer,
+                                         const CompletionHandler& handler)
+{
+    m_read_handler = handler;
+    WorkPtr work(new boost::asio::io_service::work(m_io_service));
+    m_reader->Post(boost::bind(&SharedMemoryStream::Impl::Read, this, buffer, work));
+}
+
+void SharedMemoryStream::Impl::AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers,
+                                          const CompletionHandler& handler)
+{
+    m_write_handler = handler;
+    WorkPtr work(new boost::asio::io_service::work(m_io_service));
+    m_writer->Post(boost::bind(&SharedMemoryStream::Impl::Write, this, buffers, work));
+}
+
+void SharedMemoryStream::Impl::Close() {
+    Channel* channels[2] = {m_incoming, m_outgoing};
+    for (int i = 0; i < 2; ++i) {
+        bip::scoped_lock<bip::interprocess_mutex> lock(channels[i]->mutex);
+        channels[i]->closed = true;
+        channels[i]->changed.notify_all();
+    }
+}
+
+void SharedMemoryStream::Impl::Read(const boost::asio::mutable_buffer& buffer, WorkPtr work) {
+    boost::system::error_code error;
+    std::size_t bytes = Receive(boost::asio::buffer_cast<char*>(buffer),
+                                boost::asio::buffer_size(buffer), error);
+    m_io_service.post(boost::bind(&SharedMemoryStream::Impl::ReadComplete, m_alive, this, error, bytes));
+}
+
+void SharedMemoryStream::Impl::Write(const std::vector<boost::asio::const_buffer>& buffers, WorkPtr work) {
+    boost::system::error_code error;
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < buffers.size() && !error; ++i) {
+        bytes += Send(boost::asio::buffer_cast<const char*>(buffers[i]),
+                      boost::asio::buffer_size(buffers[i]), error);
+    }
+    m_io_service.post(boost::bind(&SharedMemoryStream::Impl::WriteComplete, m_alive, this, error, bytes));
+}
+
+std::size_t SharedMemoryStream::Impl::Receive(char* data, std::size_t size,
+                                              boost::system::error_code& error)
+{
+    const std::size_t buffer_size = m_header->buffer_size;
+    std::size_t received = 0;
+    bip::scoped_lock<bip::interprocess_mutex> lock(m_incoming->mutex);
+    while (received < size) {
+        const std::size_t read_pos = m_incoming->read_pos;
+        const std::size_t available = m_incoming->write_pos - read_pos;
+        if (!available) {
+            if (m_incoming->closed) {
+                error = boost::asio::error::eof;
+                break;
+            }
+            if (!WaitForPeer(*m_incoming, lock))
+                m_incoming->closed = true;
+            continue;
+        }
+
+        // only this thread moves read_pos, and the writer doesn't touch the
+        // bytes before write_pos, so they can be copied without the lock
+        const std::size_t offset = read_pos % buffer_size;
+        const std::size_t n = std::min(std::min(available, size - received), buffer_size - offset);
+        lock.unlock();
+        std::memcpy(data + received, m_incoming_data + offset, n);
+        lock.lock();
+        m_incoming->read_pos = read_pos + n;
+        m_incoming->changed.notify_all();
+        received += n;
+    }
+    return received;
+}
+
+std::size_t SharedMemoryStream::Impl::Send(const char* data, std::size_t size,
+                                           boost::system::error_code& error)
+{
+    const std::size_t buffer_size = m_header->buffer_size;
+    std::size_t sent = 0;
+    bip::scoped_lock<bip::interprocess_mutex> lock(m_outgoing->mutex);
+    while (sent < size) {
+        if (m_outgoing->closed) {
+            error = boost::asio::error::broken_pipe;
+            break;
+        }
+        const std::size_t write_pos = m_outgoing->write_pos;
+        const std::size_t space = buffer_size - (write_pos - m_outgoing->read_pos);
+        if (!space) {
+            if (!WaitForPeer(*m_outgoing, lock))
+                m_outgoing->closed = true;
+            continue;
+        }
+
+        const std::size_t offset = write_pos % buffer_size;
+        const std::size_t n = std::min(std::min(space, size - sent), buffer_size - offset);
+        lock.unlock();
+        std::memcpy(m_outgoing_data + offset, data + sent, n);
+        lock.lock();
+        m_outgoing->write_pos = write_pos + n;
+        m_outgoing->changed.notify_all();
+        sent += n;
+    }
+    return sent;
+}
+
+bool SharedMemoryStream::Impl::WaitForPeer(Channel& channel, bip::scoped_lock<bip::interprocess_mutex>& lock)
+{ return channel.changed.timed_wait(lock, Now() + POLL_INTERVAL) || PeerAlive(); }
+
+bool SharedMemoryStream::Impl::PeerAlive() {
+    const int pid = m_creator ? m_header->opener_pid : m_header->creator_pid;
+    if (pid && !ProcessExists(pid))
+        return false;
+
+    const boost::uint32_t heartbeat = m_creator ? m_header->opener_heartbeat : m_header->creator_heartbeat;
+    const boost::posix_time::ptime now = Now();
+    boost::mutex::scoped_lock lock(m_peer_mutex);
+    if (heartbeat != m_peer_heartbeat) {
+        m_peer_heartbeat = heartbeat;
+        m_peer_heartbeat_time = now;
+        return true;
+    }
+    if (m_peer_heartbeat_time.is_not_a_date_time())
+        return now < m_start_time + OPEN_TIMEOUT;
+    return now < m_peer_heartbeat_time + PEER_TIMEOUT;
+}
+
+void SharedMemoryStream::Impl::Heartbeat() {
+    volatile boost::uint32_t& heartbeat = m_creator ? m_header->creator_heartbeat : m_header->opener_heartbeat;
+    // runs until interrupted, during the sleep
+    while (true) {
+        ++heartbeat;
+        boost::this_thread::sleep(POLL_INTERVAL);
+    }
+}
+
+void SharedMemoryStream::Impl::ReadComplete(boost::shared_ptr<bool> alive, Impl* impl,
+                                            boost::system::error_code error, std::size_t bytes)
+{
+    if (!*alive)
+        return;
+    CompletionHandler handler;
+    handler.swap(impl->m_read_handler);
+    handler(error, bytes);
+}
+
+void SharedMemoryStream::Impl::WriteComplete(boost::shared_ptr<bool> alive, Impl* impl,
+                                             boost::system::error_code error, std::size_t bytes)
+{
+    if (!*alive)
+        return;
+    CompletionHandler handler;
+    handler.swap(impl->m_write_handler);
+    handler(error, bytes);
+}
+
+////////////////////////////////////////////////
+// SharedMemoryStream
+////////////////////////////////////////////////
+SharedMemoryStream::SharedMemoryStream(Impl* impl) :
+    m_impl(impl)
+{}
+
+SharedMemoryStream::~SharedMemoryStream()
+{ delete m_impl; }
+
+const std::string& SharedMemoryStream::Name() const
+{ return m_impl->Name(); }
+
+void SharedMemoryStream::AsyncRead(const boost::asio::mutable_buffer& buffer,
+                                   const CompletionHandler& handler)
+{ m_impl->AsyncRead(buffer, handler); }
+
+void SharedMemoryStream::AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers,
+                                    const CompletionHandler& handler)
+{ m_impl->AsyncWrite(buffers, handler); }
+
+void SharedMemoryStream::Close()
+{ m_impl->Close(); }
+
+SharedMemoryStreamPtr SharedMemoryStream::Create(boost::asio::io_service& io_service,
+                                                 std::size_t buffer_size)
+{
+    static int s_next_segment = 0;
+    const std::string name = "FreeOrion-" + boost::lexical_cast<std::string>(CurrentProcessID()) +
+                             "-" + boost::lexical_cast<std::string>(s_next_segment++);
+    // a segment with this name can only be left over from an earlier
+    // process with the same ID that didn't exit cleanly
+    bip::shared_memory_object::remove(name.c_str());
+    try {
+        return SharedMemoryStreamPtr(new SharedMemoryStream(new Impl(io_service, name, true, std::max<std::size_t>(buffer_size, 1))));
+    } catch (const bip::interprocess_exception& e) {
+        bip::shared_memory_object::remove(name.c_str());
+        throw std::runtime_error("SharedMemoryStream::Create : unable to create shared memory segment \"" +
+                                 name + "\": " + e.what());
+    }
+}
+
+SharedMemoryStreamPtr SharedMemoryStream::Open(boost::asio::io_service& io_service,
+                                               const std::string& name)
+{
+    try {
+        return SharedMemoryStreamPtr(new SharedMemoryStream(new Impl(io_service, name, false, 0)));
+    } catch (const bip::interprocess_exception& e) {
+        throw std::runtime_error("SharedMemoryStream::Open : unable to open shared memory segment \"" +
+                                 name + "\": " + e.what());
+    }
+}
@@ -0,0 +1,75 @@
+// -*- C++ -*-
+#ifndef _SharedMemoryStream_h_
+#define _SharedMemoryStream_h_
+
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+
+class SharedMemoryStream;
+typedef boost::shared_ptr<SharedMemoryStream> SharedMemoryStreamPtr;
+
+/** A bidirectional byte stream between two processes on the same machine,
+    carried by a pair of ring buffers in a named shared memory segment.  It is
+    used in place of a TCP socket to connect the server to the AI clients it
+    starts, which saves the trip through the operating system's network stack
+    for each message.
+
+    One process creates the segment with Create(), and passes its name to the
+    other, which opens it with Open().  Reads and writes are made in the same
+    way as with boost::asio::async_read() and boost::asio::async_write(): the
+    handler is called through the io_service once the whole buffer has been
+    transferred, or the stream has failed.  At most one read and one write may
+    be outstanding at a time.  A read fails with boost::asio::error::eof once
+    the other process closes the stream, exits or dies, or if it never opens
+    the stream. */
+class SharedMemoryStream {
+public:
+    typedef boost::function<void (boost::system::error_code, std::size_t)> CompletionHandler;
+
+    /** \name Structors */ //@{
+    ~SharedMemoryStream(); ///< Dtor.  Closes the stream; handlers of outstanding operations are not called.
+    //@}
+
+    /** \name Accessors */ //@{
+    /** Returns the name of the shared memory segment, to be passed to Open()
+        by the other process. */
+    const std::string& Name() const;
+    //@}
+
+    /** \name Mutators */ //@{
+    /** Reads until \a buffer is full, then calls \a handler. */
+    void AsyncRead(const boost::asio::mutable_buffer& buffer, const CompletionHandler& handler);
+
+    /** Writes all of \a buffers, then calls \a handler.  The buffers must
+        remain valid until then. */
+    void AsyncWrite(const std::vector<boost::asio::const_buffer>& buffers, const CompletionHandler& handler);
+
+    /** Closes the stream in both directions.  Outstanding operations complete
+        with an error, and so do the other process's reads once it has read
+        everything written before the stream was closed. */
+    void Close();
+    //@}
+
+    /** Creates a new shared memory segment with ring buffers of \a
+        buffer_size bytes in each direction.  Throws std::runtime_error on
+        failure. */
+    static SharedMemoryStreamPtr Create(boost::asio::io_service& io_service, std::size_t buffer_size);
+
+    /** Opens the shared memory segment named \a name, created by another
+        process with Create().  Throws std::runtime_error on failure. */
+    static SharedMemoryStreamPtr Open(boost::asio::io_service& io_service, const std::string& name);
+
+private:
+    class Impl;
+
+    explicit SharedMemoryStream(Impl* impl);
+
+    Impl* m_impl;
+};
+
+#endif
@@ -10,25 +10,49 @@
 #include "../universe/ShipDesign.h"
 #include "../universe/System.h"
 #include "../universe/Species.h"
+#include "../util/BlockCompression.h"
+#include "../util/OptionsDB.h"
 #include "../util/OrderSet.h"
 #include "../util/Serialize.h"
 
 #include <GG/utf8/checked.h>
 
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/filesystem/fstream.hpp>
+#include <boost/iostreams/device/array.hpp>
+#include <boost/iostreams/stream.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/serialization/deque.hpp>
 #include <boost/serialization/list.hpp>
 #include <boost/serialization/map.hpp>
 #include <boost/serialization/set.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/static_assert.hpp>
 
+#include <log4cpp/Priority.hh>
+
+#include <cstring>
 #include <fstream>
 
+#ifdef FREEORION_LINUX
+#include <cerrno>
+#include <cstdio>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 
 namespace fs = boost::filesystem;
 
 namespace {
+    void AddOptions(OptionsDB& db) {
+        db.Add("save-compression", "OPTIONS_DB_SAVE_COMPRESSION", std::string("lz4"));
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
+
     std::map<int, SaveGameEmpireData> CompileSaveGameEmpireData(const EmpireManager& empire_manager) {
         std::map<int, SaveGameEmpireData> retval;
         const EmpireManager& empires = Empires();
@@ -37,6 +61,221 @@ namespace {
         return retval;
     }
     const std::string UNABLE_TO_OPEN_FILE("Unable to open file");
+
+    fs::path SaveFilePath(const std::string& filename) {
+#ifdef FREEORION_WIN32
+        // convert UTF-8 file name to UTF-16
+        fs::path::string_type file_name_native;
+        utf8::utf8to16(filename.begin(), filename.end(), std::back_inserter(file_name_native));
+        return fs::path(file_name_native);
+#else
+        return fs::path(filename);
+#endif
+    }
+
+    // Save files start with a table of their sections, each of which is a
+    // separate archive, so that the player and empire data shown when
+    // choosing a game to load can be read without reading the rest.  The
+    // latest known objects of all empires are in one section, as their
+    // differences from the universe section's records of the objects and
+    // from each other; older files have a section for each empire's,
+    // deserialized when needed.
+    // Files without the table are read as the single archive that older
+    // versions wrote, with the same contents in the same order.  Each section
+    // may be compressed, as a stream of blocks written by
+    // BlockCompressingStreambuf, with the codec given in the header.
+    const char  SAVE_FILE_MAGIC[8] = { 'F', 'O', 'S', 'A', 'V', 'E', 'G', 'M' };
+
+    /** Incremented whenever the layout of the file changes incompatibly.
+      * Version 1 files have no codec in their header, and are uncompressed.
+      * Version 3 files have an EMPIRE_KNOWN_OBJECT_DIFFERENCES_SECTION in
+      * place of EMPIRE_KNOWN_OBJECTS_SECTIONs, and store each object in the
+      * UNIVERSE_SECTION as a separate record, which the differences refer
+      * to. */
+    const int   SAVE_FILE_VERSION = 3;
+
+    enum SectionType {
+        SERVER_DATA_SECTION,
+        PLAYER_DATA_SECTION,
+        EMPIRE_DATA_SECTION,
+        EMPIRE_MANAGER_SECTION,
+        SPECIES_MANAGER_SECTION,
+        UNIVERSE_SECTION,               ///< without the latest known objects of empires
+        EMPIRE_KNOWN_OBJECTS_SECTION,   ///< one per empire with latest known objects, before version 3
+        EMPIRE_KNOWN_OBJECT_DIFFERENCES_SECTION ///< the latest known objects of all empires
+    };
+
+    struct FileHeader {
+        char            magic[8];
+        int             version;
+        int             section_count;
+        int             codec;      ///< a BlockCompression::Codec
+        int             reserved;
+    };
+
+    /** The size of the header of version 1 files, which ends before codec. */
+    const std::size_t VERSION_1_HEADER_SIZE = 16;
+
+    struct SectionEntry {
+        int             type;
+        int             empire_id;  ///< for EMPIRE_KNOWN_OBJECTS_SECTION; ALL_EMPIRES otherwise
+        boost::uint64_t offset;     ///< from the start of the file
+        boost::uint64_t size;
+    };
+
+    BOOST_STATIC_ASSERT(sizeof(FileHeader) == 24);
+    BOOST_STATIC_ASSERT(sizeof(SectionEntry) == 24);
+
+    /** Writes a save file's sections to a stream, preceded by their table,
+      * compressing each with \a codec. */
+    class SectionWriter {
+    public:
+        SectionWriter(std::ostream& os, int section_count, BlockCompression::Codec codec) :
+            m_os(os),
+            m_start(os.tellp()),
+            m_codec(codec)
+        {
+            m_sections.reserve(section_count);
+            // the table is filled in once the sizes of the sections are known
+            std::vector<char> placeholder(sizeof(FileHeader) + section_count * sizeof(SectionEntry));
+            m_os.write(&placeholder[0], placeholder.size());
+        }
+
+        /** Starts a section, returning the archive to write it to, which is
+          * valid until EndSection(). */
+        FREEORION_OARCHIVE_TYPE& BeginSection(SectionType type, int empire_id = ALL_EMPIRES) {
+            SectionEntry entry;
+            entry.type = type;
+            entry.empire_id = empire_id;
+            entry.offset = static_cast<boost::uint64_t>(m_os.tellp() - m_start);
+            entry.size = 0;
+            m_sections.push_back(entry);
+            if (m_codec == BlockCompression::NO_CODEC) {
+                m_archive.reset(new FREEORION_OARCHIVE_TYPE(m_os));
+            } else {
+                m_compressor.reset(new BlockCompressingStreambuf(m_os, m_codec));
+                m_section_stream.reset(new std::ostream(m_compressor.get()));
+                m_archive.reset(new FREEORION_OARCHIVE_TYPE(*m_section_stream));
+            }
+            return *m_archive;
+        }
+
+        void EndSection() {
+            m_archive.reset();
+            if (m_compressor) {
+                m_section_stream->flush();
+                m_compressor->Finish();
+                m_section_stream.reset();
+                m_compressor.reset();
+            }
+            SectionEntry& entry = m_sections.back();
+            entry.size = static_cast<boost::uint64_t>(m_os.tellp() - m_start) - entry.offset;
+        }
+
+        /** Writes the table of the sections written. */
+        void Finish() {
+            FileHeader header;
+            std::memcpy(header.magic, SAVE_FILE_MAGIC, sizeof(SAVE_FILE_MAGIC));
+            header.version = SAVE_FILE_VERSION;
+            header.section_count = static_cast<int>(m_sections.size());
+            header.codec = m_codec;
+            header.reserved = 0;
+            const std::streampos end = m_os.tellp();
+            m_os.seekp(m_start);
+            m_os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            if (!m_sections.empty())
+                m_os.write(reinterpret_cast<const char*>(&m_sections[0]), m_sections.size() * sizeof(SectionEntry));
+            m_os.seekp(end);
+            if (!m_os)
+                throw std::runtime_error("Unable to write save file");
+        }
+
+    private:
+        std::ostream&                                   m_os;
+        const std::streampos                            m_start;
+        const BlockCompression::Codec                   m_codec;
+        std::vector<SectionEntry>                       m_sections;
+        boost::scoped_ptr<BlockCompressingStreambuf>    m_compressor;
+        boost::scoped_ptr<std::ostream>                 m_section_stream;
+        boost::scoped_ptr<FREEORION_OARCHIVE_TYPE>      m_archive;
+    };
+
+    /** Reads the table of sections at the start of the save file open in
+      * \a is into \a sections, and the codec they are compressed with into
+      * \a codec, and returns the file's version, or returns 0 if the file is
+      * an older file without one. */
+    int ReadSectionTable(std::istream& is, std::vector<SectionEntry>& sections, BlockCompression::Codec& codec) {
+        sections.clear();
+        codec = BlockCompression::NO_CODEC;
+        FileHeader header;
+        if (!is.read(reinterpret_cast<char*>(&header), VERSION_1_HEADER_SIZE) ||
+            std::memcmp(header.magic, SAVE_FILE_MAGIC, sizeof(SAVE_FILE_MAGIC)))
+        {
+            is.clear();
+            is.seekg(0);
+            return 0;
+        }
+        if (header.version < 1 || SAVE_FILE_VERSION < header.version || header.section_count < 0)
+            throw std::runtime_error("Unsupported save file version");
+        if (2 <= header.version) {
+            if (!is.read(reinterpret_cast<char*>(&header) + VERSION_1_HEADER_SIZE,
+                         sizeof(header) - VERSION_1_HEADER_SIZE))
+            { throw std::runtime_error("Save file header is truncated"); }
+            codec = static_cast<BlockCompression::Codec>(header.codec);
+        }
+        sections.resize(header.section_count);
+        if (!sections.empty() &&
+            !is.read(reinterpret_cast<char*>(&sections[0]), sections.size() * sizeof(SectionEntry)))
+        { throw std::runtime_error("Save file section table is truncated"); }
+        return header.version;
+    }
+
+    const SectionEntry& FindSection(const std::vector<SectionEntry>& sections, SectionType type,
+                                    int empire_id = ALL_EMPIRES)
+    {
+        for (std::vector<SectionEntry>::const_iterator it = sections.begin(); it != sections.end(); ++it)
+            if (it->type == type && it->empire_id == empire_id)
+                return *it;
+        throw std::runtime_error("Save file is missing a section");
+    }
+
+    /** Positions \a is at the start of the section of type \a type. */
+    void SeekSection(std::istream& is, const std::vector<SectionEntry>& sections, SectionType type) {
+        is.seekg(static_cast<std::streamoff>(FindSection(sections, type).offset));
+        if (!is)
+            throw std::runtime_error("Save file is truncated");
+    }
+
+    /** The contents of a save file section, decompressed if need be, read
+      * from a stream positioned at its start. */
+    class SectionIStream : public std::istream {
+    public:
+        SectionIStream(std::istream& is, BlockCompression::Codec codec) :
+            std::istream(0)
+        {
+            if (codec == BlockCompression::NO_CODEC) {
+                rdbuf(is.rdbuf());
+            } else {
+                m_decompressor.reset(new BlockDecompressingStreambuf(is, codec));
+                rdbuf(m_decompressor.get());
+            }
+        }
+
+    private:
+        boost::scoped_ptr<BlockDecompressingStreambuf> m_decompressor;
+    };
+
+    /** Deserializes \a objects from \a data, the contents of an
+      * EMPIRE_KNOWN_OBJECTS_SECTION compressed with \a codec; used to load
+      * them when first needed. */
+    void LoadEmpireKnownObjects(boost::shared_ptr<const std::string> data, BlockCompression::Codec codec,
+                                ObjectMap& objects)
+    {
+        boost::iostreams::stream<boost::iostreams::array_source> is(data->data(), data->size());
+        SectionIStream section_is(is, codec);
+        FREEORION_IARCHIVE_TYPE ia(section_is);
+        Deserialize(ia, objects);
+    }
 }
 
 void SaveGame(const std::string& filename, const ServerSaveGameData& server_save_game_data,
@@ -49,38 +288,123 @@ void SaveGame(const std::string& filename, const ServerSaveGameData& server_save
     std::map<int, SaveGameEmpireData> empire_save_game_data = CompileSaveGameEmpireData(empire_manager);
 
     try {
-#ifdef FREEORION_WIN32
-        // convert UTF-8 file name to UTF-16
-        fs::path::string_type file_name_native;
-        utf8::utf8to16(filename.begin(), filename.end(), std::back_inserter(file_name_native));
-        fs::path path = fs::path(file_name_native);
-#else
-        fs::path path = fs::path(filename);
-#endif
-        fs::ofstream ofs(path, std::ios_base::binary);
+        fs::ofstream ofs(SaveFilePath(filename), std::ios_base::binary);
 
         if (!ofs)
             throw std::runtime_error(UNABLE_TO_OPEN_FILE);
 
-        FREEORION_OARCHIVE_TYPE oa(ofs);
-        oa << BOOST_SERIALIZATION_NVP(server_save_game_data);
-        oa << BOOST_SERIALIZATION_NVP(player_save_game_data);
-        oa << BOOST_SERIALIZATION_NVP(empire_save_game_data);
-        oa << BOOST_SERIALIZATION_NVP(empire_manager);
-        oa << BOOST_SERIALIZATION_NVP(species_manager);
-        Serialize(oa, universe);
+        // every section up to the universe's, and the empires' known objects
+        SectionWriter writer(ofs, UNIVERSE_SECTION + 2,
+                             BlockCompression::CodecFromName(GetOptionsDB().Get<std::string>("save-compression")));
+
+        writer.BeginSection(SERVER_DATA_SECTION) << BOOST_SERIALIZATION_NVP(server_save_game_data);
+        writer.EndSection();
+        writer.BeginSection(PLAYER_DATA_SECTION) << BOOST_SERIALIZATION_NVP(player_save_game_data);
+        writer.EndSection();
+        writer.BeginSection(EMPIRE_DATA_SECTION) << BOOST_SERIALIZATION_NVP(empire_save_game_data);
+        writer.EndSection();
+        writer.BeginSection(EMPIRE_MANAGER_SECTION) << BOOST_SERIALIZATION_NVP(empire_manager);
+        writer.EndSection();
+        writer.BeginSection(SPECIES_MANAGER_SECTION) << BOOST_SERIALIZATION_NVP(species_manager);
+        writer.EndSection();
+        SerializeWithoutEmpireKnownObjects(writer.BeginSection(UNIVERSE_SECTION), universe);
+        writer.EndSection();
+        SerializeEmpireKnownObjectDifferences(writer.BeginSection(EMPIRE_KNOWN_OBJECT_DIFFERENCES_SECTION), universe);
+        writer.EndSection();
+        writer.Finish();
     } catch (const std::exception& e) {
         Logger().errorStream() << UserString("UNABLE_TO_WRITE_SAVE_FILE") << " SaveGame exception: " << ": " << e.what();
         throw e;
     }
 }
 
+#ifdef FREEORION_LINUX
+namespace {
+    // the background save in progress, if any, and the one whose result has
+    // not yet been returned by PollBackgroundSave
+    pid_t       g_background_save_pid = -1;
+    std::string g_background_save_filename;
+}
+
+bool SaveGameInBackground(const std::string& filename, const ServerSaveGameData& server_save_game_data,
+                          const std::vector<PlayerSaveGameData>& player_save_game_data,
+                          const Universe& universe, const EmpireManager& empire_manager,
+                          const SpeciesManager& species_manager)
+{
+    std::string previous_filename;
+    PollBackgroundSave(true, previous_filename);
+
+    const pid_t pid = fork();
+    if (pid < 0) {
+        Logger().errorStream() << "SaveGameInBackground : unable to fork: " << std::strerror(errno);
+        return false;
+    }
+
+    if (!pid) {
+        // Only this thread exists in the child, and other server threads may
+        // have held the logger's lock when it forked, so log nothing from here.
+        // The child also must not run the server's atexit handlers or
+        // destructors, which would close connections and remove shared memory
+        // still in use by the parent.
+        Logger().setPriority(log4cpp::Priority::FATAL);
+        const std::string temp_filename = filename + ".tmp";
+        int exit_code = 1;
+        try {
+            SaveGame(temp_filename, server_save_game_data, player_save_game_data,
+                     universe, empire_manager, species_manager);
+            if (!std::rename(SaveFilePath(temp_filename).string().c_str(), SaveFilePath(filename).string().c_str()))
+                exit_code = 0;
+        } catch (...) {}
+        if (exit_code)
+            std::remove(SaveFilePath(temp_filename).string().c_str());
+        _exit(exit_code);
+    }
+
+    Logger().debugStream() << "SaveGameInBackground : saving to " << filename << " in process " << pid;
+    g_background_save_pid = pid;
+    g_background_save_filename = filename;
+    return true;
+}
+
+BackgroundSaveStatus PollBackgroundSave(bool wait, std::string& filename) {
+    filename = g_background_save_filename;
+    if (g_background_save_pid < 0)
+        return BACKGROUND_SAVE_NONE;
+
+    int status = 0;
+    pid_t result = 0;
+    do {
+        result = waitpid(g_background_save_pid, &status, wait ? 0 : WNOHANG);
+    } while (result < 0 && errno == EINTR);
+    if (!result)
+        return BACKGROUND_SAVE_RUNNING;
+
+    g_background_save_pid = -1;
+    g_background_save_filename.clear();
+    if (result < 0 || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        Logger().errorStream() << UserString("UNABLE_TO_WRITE_SAVE_FILE") << " background save to " << filename << " failed";
+        return BACKGROUND_SAVE_FAILED;
+    }
+    Logger().debugStream() << "PollBackgroundSave : finished saving to " << filename;
+    return BACKGROUND_SAVE_SUCCEEDED;
+}
+#else
+bool SaveGameInBackground(const std::string& filename, const ServerSaveGameData& server_save_game_data,
+                          const std::vector<PlayerSaveGameData>& player_save_game_data,
+                          const Universe& universe, const EmpireManager& empire_manager,
+                          const SpeciesManager& species_manager)
+{ return false; }
+
+BackgroundSaveStatus PollBackgroundSave(bool wait, std::string& filename) {
+    filename.clear();
+    return BACKGROUND_SAVE_NONE;
+}
+#endif
+
 void LoadGame(const std::string& filename, ServerSaveGameData& server_save_game_data,
               std::vector<PlayerSaveGameData>& player_save_game_data,
               Universe& universe, EmpireManager& empire_manager, SpeciesManager& species_manager)
 {
-    Sleep(5000);
-
     // player notifications
     if (ServerApp* server = ServerApp::GetApp())
         server->Networking().SendMessage(TurnProgressMessage(Message::LOADING_GAME));
@@ -93,31 +417,87 @@ void LoadGame(const std::string& filename, ServerSaveGameData& server_save_game_
     universe.Clear();
 
     try {
-#ifdef FREEORION_WIN32
-        // convert UTF-8 file name to UTF-16
-        fs::path::string_type file_name_native;
-        utf8::utf8to16(filename.begin(), filename.end(), std::back_inserter(file_name_native));
-        fs::path path = fs::path(file_name_native);
-#else
-        fs::path path = fs::path(filename);
-#endif
-        fs::ifstream ifs(path, std::ios_base::binary);
+        fs::ifstream ifs(SaveFilePath(filename), std::ios_base::binary);
 
         if (!ifs)
             throw std::runtime_error(UNABLE_TO_OPEN_FILE);
-        FREEORION_IARCHIVE_TYPE ia(ifs);
-        Logger().debugStream() << "LoadGame : Reading Server Save Game Data";
-        ia >> BOOST_SERIALIZATION_NVP(server_save_game_data);
-        Logger().debugStream() << "LoadGame : Reading Player Save Game Data";
-        ia >> BOOST_SERIALIZATION_NVP(player_save_game_data);
-        Logger().debugStream() << "LoadGame : Reading Empire Save Game Data (Ignored)";
-        ia >> BOOST_SERIALIZATION_NVP(ignored_save_game_empire_data);
-        Logger().debugStream() << "LoadGame : Reading Empires Data";
-        ia >> BOOST_SERIALIZATION_NVP(empire_manager);
-        Logger().debugStream() << "LoadGame : Reading Species Data";
-        ia >> BOOST_SERIALIZATION_NVP(species_manager);
-        Logger().debugStream() << "LoadGame : Reading Universe Data";
-        Deserialize(ia, universe);
+
+        std::vector<SectionEntry> sections;
+        BlockCompression::Codec codec;
+        const int version = ReadSectionTable(ifs, sections, codec);
+        if (!version) {
+            Logger().debugStream() << "LoadGame : Reading save file without sections";
+            FREEORION_IARCHIVE_TYPE ia(ifs);
+            ia >> BOOST_SERIALIZATION_NVP(server_save_game_data);
+            ia >> BOOST_SERIALIZATION_NVP(player_save_game_data);
+            ia >> BOOST_SERIALIZATION_NVP(ignored_save_game_empire_data);
+            ia >> BOOST_SERIALIZATION_NVP(empire_manager);
+            ia >> BOOST_SERIALIZATION_NVP(species_manager);
+            Deserialize(ia, universe);
+        } else {
+            Logger().debugStream() << "LoadGame : Reading Server Save Game Data";
+            SeekSection(ifs, sections, SERVER_DATA_SECTION);
+            {
+                SectionIStream is(ifs, codec);
+                FREEORION_IARCHIVE_TYPE ia(is);
+                ia >> BOOST_SERIALIZATION_NVP(server_save_game_data);
+            }
+            Logger().debugStream() << "LoadGame : Reading Player Save Game Data";
+            SeekSection(ifs, sections, PLAYER_DATA_SECTION);
+            {
+                SectionIStream is(ifs, codec);
+                FREEORION_IARCHIVE_TYPE ia(is);
+                ia >> BOOST_SERIALIZATION_NVP(player_save_game_data);
+            }
+            Logger().debugStream() << "LoadGame : Reading Empires Data";
+            SeekSection(ifs, sections, EMPIRE_MANAGER_SECTION);
+            {
+                SectionIStream is(ifs, codec);
+                FREEORION_IARCHIVE_TYPE ia(is);
+                ia >> BOOST_SERIALIZATION_NVP(empire_manager);
+            }
+            Logger().debugStream() << "LoadGame : Reading Species Data";
+            SeekSection(ifs, sections, SPECIES_MANAGER_SECTION);
+            {
+                SectionIStream is(ifs, codec);
+                FREEORION_IARCHIVE_TYPE ia(is);
+                ia >> BOOST_SERIALIZATION_NVP(species_manager);
+            }
+            Logger().debugStream() << "LoadGame : Reading Universe Data";
+            SeekSection(ifs, sections, UNIVERSE_SECTION);
+            {
+                SectionIStream is(ifs, codec);
+                FREEORION_IARCHIVE_TYPE ia(is);
+                DeserializeWithoutEmpireKnownObjects(ia, universe, 3 <= version);
+            }
+
+            // the differences are decoded against the object records just
+            // read from the universe section
+            Logger().debugStream() << "LoadGame : Reading Empire Known Objects Data";
+            for (std::vector<SectionEntry>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+                if (it->type != EMPIRE_KNOWN_OBJECT_DIFFERENCES_SECTION)
+                    continue;
+                ifs.seekg(static_cast<std::streamoff>(it->offset));
+                SectionIStream is(ifs, codec);
+                FREEORION_IARCHIVE_TYPE ia(is);
+                DeserializeEmpireKnownObjectDifferences(ia, universe);
+            }
+
+            // in older files, each empire's latest known objects are read now,
+            // in case the file is overwritten, but only deserialized when
+            // first needed
+            for (std::vector<SectionEntry>::const_iterator it = sections.begin(); it != sections.end(); ++it) {
+                if (it->type != EMPIRE_KNOWN_OBJECTS_SECTION)
+                    continue;
+                boost::shared_ptr<std::string> data(new std::string(static_cast<std::size_t>(it->size), '\0'));
+                ifs.seekg(static_cast<std::streamoff>(it->offset));
+                if (!data->empty() && !ifs.read(&(*data)[0], data->size()))
+                    throw std::runtime_error("Save file is truncated");
+                universe.SetDeferredEmpireKnownObjects(
+                    it->empire_id, boost::bind(&LoadEmpireKnownObjects,
+                                               boost::shared_ptr<const std::string>(data), codec, _1));
+            }
+        }
     } catch (const std::exception& e) {
         Logger().errorStream() << UserString("UNABLE_TO_READ_SAVE_FILE") << " LoadGame exception: " << ": " << e.what();
         throw e;
@@ -129,22 +509,24 @@ void LoadPlayerSaveGameData(const std::string& filename, std::vector<PlayerSaveG
     ServerSaveGameData ignored_server_save_game_data;
 
     try {
-#ifdef FREEORION_WIN32
-        // convert UTF-8 file name to UTF-16
-        fs::path::string_type file_name_native;
-        utf8::utf8to16(filename.begin(), filename.end(), std::back_inserter(file_name_native));
-        fs::path path = fs::path(file_name_native);
-#else
-        fs::path path = fs::path(filename);
-#endif
-        fs::ifstream ifs(path, std::ios_base::binary);
+        fs::ifstream ifs(SaveFilePath(filename), std::ios_base::binary);
 
         if (!ifs)
             throw std::runtime_error(UNABLE_TO_OPEN_FILE);
-        FREEORION_IARCHIVE_TYPE ia(ifs);
-        ia >> BOOST_SERIALIZATION_NVP(ignored_server_save_game_data);
-        ia >> BOOST_SERIALIZATION_NVP(player_save_game_data);
-        // skipping additional deserialization which is not needed for this function
+
+        std::vector<SectionEntry> sections;
+        BlockCompression::Codec codec;
+        if (ReadSectionTable(ifs, sections, codec)) {
+            SeekSection(ifs, sections, PLAYER_DATA_SECTION);
+            SectionIStream is(ifs, codec);
+            FREEORION_IARCHIVE_TYPE ia(is);
+            ia >> BOOST_SERIALIZATION_NVP(player_save_game_data);
+        } else {
+            FREEORION_IARCHIVE_TYPE ia(ifs);
+            ia >> BOOST_SERIALIZATION_NVP(ignored_server_save_game_data);
+            ia >> BOOST_SERIALIZATION_NVP(player_save_game_data);
+            // skipping additional deserialization which is not needed for this function
+        }
     } catch (const std::exception& e) {
         Logger().errorStream() << UserString("UNABLE_TO_READ_SAVE_FILE") << " LoadPlayerSaveGameData exception: " << ": " << e.what();
         throw e;
@@ -156,26 +538,27 @@ void LoadEmpireSaveGameData(const std::string& filename, std::map<int, SaveGameE
     std::vector<PlayerSaveGameData> ignored_player_save_game_data;
 
     try {
-#ifdef FREEORION_WIN32
-        // convert UTF-8 file name to UTF-16
-        fs::path::string_type file_name_native;
-        utf8::utf8to16(filename.begin(), filename.end(), std::back_inserter(file_name_native));
-        fs::path path = fs::path(file_name_native);
-#else
-        fs::path path = fs::path(filename);
-#endif
-        fs::ifstream ifs(path, std::ios_base::binary);
+        fs::ifstream ifs(SaveFilePath(filename), std::ios_base::binary);
 
         if (!ifs)
             throw std::runtime_error(UNABLE_TO_OPEN_FILE);
-        FREEORION_IARCHIVE_TYPE ia(ifs);
-        ia >> BOOST_SERIALIZATION_NVP(ignored_server_save_game_data);
-        ia >> BOOST_SERIALIZATION_NVP(ignored_player_save_game_data);
-        ia >> BOOST_SERIALIZATION_NVP(empire_save_game_data);
-        // skipping additional deserialization which is not needed for this function
+
+        std::vector<SectionEntry> sections;
+        BlockCompression::Codec codec;
+        if (ReadSectionTable(ifs, sections, codec)) {
+            SeekSection(ifs, sections, EMPIRE_DATA_SECTION);
+            SectionIStream is(ifs, codec);
+            FREEORION_IARCHIVE_TYPE ia(is);
+            ia >> BOOST_SERIALIZATION_NVP(empire_save_game_data);
+        } else {
+            FREEORION_IARCHIVE_TYPE ia(ifs);
+            ia >> BOOST_SERIALIZATION_NVP(ignored_server_save_game_data);
+            ia >> BOOST_SERIALIZATION_NVP(ignored_player_save_game_data);
+            ia >> BOOST_SERIALIZATION_NVP(empire_save_game_data);
+            // skipping additional deserialization which is not needed for this function
+        }
     } catch (const std::exception& e) {
         Logger().errorStream() << UserString("UNABLE_TO_READ_SAVE_FILE") << " LoadEmpireSaveGameData exception: " << ": " << e.what();
         throw e;
     }
 }
-
@@ -21,6 +21,37 @@ void SaveGame(const std::string& filename,
               const EmpireManager& empire_manager,
               const SpeciesManager& species_manager);
 
+/** The state of the save most recently started by SaveGameInBackground(). */
+enum BackgroundSaveStatus {
+    BACKGROUND_SAVE_NONE,       ///< no background save has been started, or its result has already been returned
+    BACKGROUND_SAVE_RUNNING,    ///< the save is still being written
+    BACKGROUND_SAVE_SUCCEEDED,  ///< the save was written
+    BACKGROUND_SAVE_FAILED      ///< the save could not be written
+};
+
+/** Saves the provided data to savefile \a filename as SaveGame() does, but
+  * from a forked copy of the server process, so that the server can continue
+  * with the game while the file is written.  The file is written under a
+  * temporary name and renamed once complete, so that an incomplete save never
+  * replaces an existing one.  Waits for any previous background save to finish
+  * first; callers that report failed saves should collect its result with
+  * PollBackgroundSave() beforehand.  Returns false if the save could not be started, or if background
+  * saving is not supported on this platform, in which case the caller should
+  * save with SaveGame() instead. */
+bool SaveGameInBackground(const std::string& filename,
+                          const ServerSaveGameData& server_save_game_data,
+                          const std::vector<PlayerSaveGameData>& player_save_game_data,
+                          const Universe& universe,
+                          const EmpireManager& empire_manager,
+                          const SpeciesManager& species_manager);
+
+/** Returns the state of the save most recently started by
+  * SaveGameInBackground(), waiting for it to finish if \a wait is true, and
+  * sets \a filename to its file name.  Once BACKGROUND_SAVE_SUCCEEDED or
+  * BACKGROUND_SAVE_FAILED has been returned for a save, later calls return
+  * BACKGROUND_SAVE_NONE until another is started. */
+BackgroundSaveStatus PollBackgroundSave(bool wait, std::string& filename);
+
 /** Loads the indicated data from savefile \a filename. */
 void LoadGame(const std::string& filename,
               ServerSaveGameData& server_save_game_data,
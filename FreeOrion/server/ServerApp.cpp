@@ -5,6 +5,7 @@
 #include "../combat/CombatSystem.h"
 #include "../universe/Building.h"
 #include "../universe/Effect.h"
+#include "../universe/ObjectPool.h"
 #include "../universe/Fleet.h"
 #include "../universe/Ship.h"
 #include "../universe/Planet.h"
@@ -13,6 +14,7 @@
 #include "../universe/System.h"
 #include "../universe/Species.h"
 #include "../Empire/Empire.h"
+#include "../network/MessageStatistics.h"
 #include "../util/Directories.h"
 #include "../util/MultiplayerCommon.h"
 #include "../util/OptionsDB.h"
@@ -25,6 +27,7 @@
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/operations.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/thread.hpp>
 
 #include <log4cpp/Appender.hh>
 #include <log4cpp/Category.hh>
@@ -36,6 +39,16 @@
 
 namespace fs = boost::filesystem;
 
+namespace {
+    /** How long AI clients are given to exit by themselves at the end of a
+      * game before they are killed. */
+    const int AI_EXIT_TIMEOUT_MS = 2000;
+
+    /** How long CreateAIClients() waits for pooled AI clients to become
+      * ready, before starting new processes for the AI players left. */
+    const int AI_POOL_READY_TIMEOUT_MS = 10000;
+}
+
 
 ////////////////////////////////////////////////
 // PlayerSaveGameData
@@ -88,7 +101,9 @@ ServerApp::ServerApp() :
                  boost::bind(&ServerApp::PlayerDisconnected, this, _1)),
     m_fsm(new ServerFSM(*this)),
     m_current_turn(INVALID_GAME_TURN),
-    m_single_player_game(false)
+    m_single_player_game(false),
+    m_ai_client_process_players(0),
+    m_pooled_ai_clients_assigned(0)
 {
     if (s_app)
         throw std::runtime_error("Attempted to construct a second instance of singleton class ServerApp");
@@ -118,6 +133,7 @@ ServerApp::ServerApp() :
 
 ServerApp::~ServerApp() {
     Logger().debugStream() << "ServerApp::~ServerApp";
+    CheckBackgroundSave(true);
     CleanupAIs();
     delete m_fsm;
 }
@@ -127,6 +143,8 @@ void ServerApp::operator()()
 
 void ServerApp::Exit(int code) {
     Logger().fatalStream() << "Initiating Exit (code " << code << " - " << (code ? "error" : "normal") << " termination)";
+    CheckBackgroundSave(true);
+    m_networking.FlushOutgoingMessages(2000);
     exit(code);
 }
 
@@ -139,6 +157,39 @@ namespace {
         return (GetBinDir() / "freeorionca").string();
 #endif
     }
+
+    /** Returns the command line of an AI client playing as the players named
+      * \a player_names.  The AI client hosts all the players after the first
+      * as well as the first. */
+    std::vector<std::string> AIClientArgs(const std::string& ai_client_exe,
+                                          const std::vector<std::string>& player_names,
+                                          int max_aggression)
+    {
+        // TODO: add other command line args to AI client invocation as needed
+        std::vector<std::string> args;
+        args.push_back("\"" + ai_client_exe + "\"");
+        args.push_back(player_names.front());
+        args.push_back(boost::lexical_cast<std::string>(max_aggression));
+        args.insert(args.end(), player_names.begin() + 1, player_names.end());
+        args.push_back("--resource-dir");
+        args.push_back("\"" + GetOptionsDB().Get<std::string>("resource-dir") + "\"");
+        args.push_back("--log-level");
+        args.push_back(GetOptionsDB().Get<std::string>("log-level"));
+        return args;
+    }
+
+    void SetProcessPriorityToLow(Process& process, bool set_to_low) {
+        if (!process.SetLowPriority(set_to_low)) {
+            if (set_to_low)
+                Logger().errorStream() << "ServerApp::SetAIsProcessPriorityToLow : failed to lower priority for AI process";
+            else
+#ifdef FREEORION_WIN32
+                Logger().errorStream() << "ServerApp::SetAIsProcessPriorityToLow : failed to raise priority for AI process";
+#else
+                Logger().errorStream() << "ServerApp::SetAIsProcessPriorityToLow : cannot raise priority for AI process, requires superuser privileges on this system";
+#endif
+        }
+    }
 }
 
 #ifdef FREEORION_MACOSX
@@ -178,7 +229,25 @@ void ServerApp::CreateAIClients(const std::vector<PlayerSetupData>& player_setup
     // binary / executable to run for AI clients
     const std::string AI_CLIENT_EXE = AIClientExe();
 
-    // for each AI client player, create a new AI client process
+    // AI clients of the pool that are still returning from the last game
+    // are waited for, as that is quicker than starting new ones
+    if (!m_ai_client_pool_processes.empty()) {
+        std::size_t num_AIs = 0;
+        for (int i = 0; i < static_cast<int>(player_setup_data.size()); ++i) {
+            if (player_setup_data.at(i).m_client_type == Networking::CLIENT_TYPE_AI_PLAYER)
+                ++num_AIs;
+        }
+        if (!m_networking.WaitForReadyPooledAIClients(std::min(num_AIs, m_ai_client_pool_processes.size()),
+                                                      AI_POOL_READY_TIMEOUT_MS))
+        {
+            Logger().errorStream() << "ServerApp::CreateAIClients : only " << m_networking.NumReadyPooledAIClients()
+                                   << " of " << m_ai_client_pool_processes.size() << " pooled AI clients are ready";
+        }
+    }
+
+    // for each AI client player, assign a pooled AI client, or if none is
+    // ready, have a new AI client process play it
+    std::vector<std::string> new_process_player_names;
     for (int i = 0; i < static_cast<int>(player_setup_data.size()); ++i) {
         const PlayerSetupData& psd = player_setup_data.at(i);
 
@@ -192,23 +261,46 @@ void ServerApp::CreateAIClients(const std::vector<PlayerSetupData>& player_setup
             return;
         }
 
-        // TODO: add other command line args to AI client invocation as needed
-        std::vector<std::string> args;
-        args.push_back("\"" + AI_CLIENT_EXE + "\"");
-        args.push_back(player_name);
-        std::stringstream maxAggrStr;
-        maxAggrStr << maxAggr;
-        args.push_back(maxAggrStr.str());
-        args.push_back("--resource-dir");
-        args.push_back("\"" + GetOptionsDB().Get<std::string>("resource-dir") + "\"");
-        args.push_back("--log-level");
-        args.push_back(GetOptionsDB().Get<std::string>("log-level"));
+        if (m_networking.AssignPooledAIClient(player_name, maxAggr)) {
+            Logger().debugStream() << "assigned " << player_name << " to a pooled AI client";
+            ++m_pooled_ai_clients_assigned;
+            continue;
+        }
+
+        new_process_player_names.push_back(player_name);
+    }
+
+    // an AI client process may host several AI players, which then share its
+    // content and Python interpreter
+    const std::size_t players_per_process = GetOptionsDB().Get<int>("ai-players-per-process");
+    for (std::size_t i = 0; i < new_process_player_names.size(); i += players_per_process) {
+        std::vector<std::string> player_names(
+            new_process_player_names.begin() + i,
+            new_process_player_names.begin() + std::min(i + players_per_process, new_process_player_names.size()));
+        const std::string& player_name = player_names.front();
+        std::vector<std::string> args = AIClientArgs(AI_CLIENT_EXE, player_names, maxAggr);
+
+        if (GetOptionsDB().Get<bool>("ai-shared-memory")) {
+            // the AI connects through shared memory created for it here,
+            // rather than through the TCP port
+            try {
+                const std::size_t buffer_size =
+                    GetOptionsDB().Get<int>("ai-shared-memory-buffer-mb") * std::size_t(1024 * 1024);
+                const std::string shared_memory_name = m_networking.AddSharedMemoryConnection(buffer_size);
+                args.push_back("--shared-memory-server");
+                args.push_back(shared_memory_name);
+            } catch (const std::exception& e) {
+                Logger().errorStream() << "ServerApp::CreateAIClients : " << player_name
+                                       << " will connect over TCP instead: " << e.what();
+            }
+        }
 
         Logger().debugStream() << "starting " << AI_CLIENT_EXE << " with GameSetup.ai-aggression set to " << maxAggr;
 
         m_ai_client_processes.push_back(Process(AI_CLIENT_EXE, args));
+        m_ai_client_process_players += player_names.size();
 
-        Logger().debugStream() << "done starting " << AI_CLIENT_EXE;
+        Logger().debugStream() << "done starting " << AI_CLIENT_EXE << " for " << player_names.size() << " AI players";
     }
 
     // set initial AI process priority to low
@@ -231,6 +323,8 @@ ServerNetworking& ServerApp::Networking()
 { return s_app->m_networking; }
 
 void ServerApp::Run() {
+    StartAIClientPool();
+
     Logger().debugStream() << "FreeOrion server waiting for network events";
     std::cout << "FreeOrion server waiting for network events" << std::endl;
     while (1) {
@@ -243,21 +337,25 @@ void ServerApp::Run() {
 
 void ServerApp::CleanupAIs() {
     Logger().debugStream() << "ServerApp::CleanupAIs() telling AIs game is ending";
-    bool ai_connection_lingering = false;
+    std::vector<PlayerConnectionPtr> ai_connections;
     try {
         for (ServerNetworking::const_iterator it = m_networking.begin(); it != m_networking.end(); ++it) {
             PlayerConnectionPtr player = *it;
             if (player->GetClientType() == Networking::CLIENT_TYPE_AI_PLAYER) {
                 player->SendMessage(EndGameMessage(player->PlayerID(), Message::YOU_ARE_ELIMINATED));
-                ai_connection_lingering = true;
+                ai_connections.push_back(player);
             }
         }
     } catch (...) {
         Logger().errorStream() << "ServerApp::CleanupAIs() exception while sending end game messages";
     }
 
-    if (ai_connection_lingering)
-        Sleep(1000);    // time for AIs to react?
+    // AI clients exit when they receive the end game message, which closes
+    // their connections, so they are done once all those connections have
+    // closed.  Any that haven't done so in time are killed below.
+    if (!ai_connections.empty() &&
+        !m_networking.WaitForDisconnections(ai_connections, AI_EXIT_TIMEOUT_MS))
+    { Logger().debugStream() << "ServerApp::CleanupAIs() AI clients did not all exit in time"; }
 
     Logger().debugStream() << "ServerApp::CleanupAIs() killing " << m_ai_client_processes.size() << " AI clients.";
     try {
@@ -273,21 +371,59 @@ void ServerApp::CleanupAIs() {
     } catch (...) {
         Logger().errorStream() << "ServerApp::CleanupAIs() exception while clearing client processes";
     }
+
+    m_ai_client_process_players = 0;
+
+    // pooled AI clients have returned to the pool, rather than exiting
+    m_pooled_ai_clients_assigned = 0;
 }
 
-void ServerApp::SetAIsProcessPriorityToLow(bool set_to_low) {
-    for (std::vector<Process>::iterator it = m_ai_client_processes.begin(); it != m_ai_client_processes.end(); ++it) {
-        if(!(it->SetLowPriority(set_to_low))) {
-            if (set_to_low)
-                Logger().errorStream() << "ServerApp::SetAIsProcessPriorityToLow : failed to lower priority for AI process";
-            else
-#ifdef FREEORION_WIN32
-                Logger().errorStream() << "ServerApp::SetAIsProcessPriorityToLow : failed to raise priority for AI process";
-#else
-                Logger().errorStream() << "ServerApp::SetAIsProcessPriorityToLow : cannot raise priority for AI process, requires superuser privileges on this system";
+void ServerApp::StartAIClientPool() {
+    const int pool_size = GetOptionsDB().Get<int>("ai-client-pool-size");
+    if (pool_size <= 0)
+        return;
+
+#ifdef FREEORION_MACOSX
+    // see CreateAIClients()
+    setenv("DYLD_LIBRARY_PATH", GetPythonHome().string().c_str(), 1);
 #endif
+
+    // pooled AI clients connect over TCP, as they reconnect for each game.
+    // Until they are assigned players, their names only name their logs.
+    const std::string AI_CLIENT_EXE = AIClientExe();
+    for (int i = 1; i <= pool_size; ++i) {
+        std::vector<std::string> args =
+            AIClientArgs(AI_CLIENT_EXE, std::vector<std::string>(1, "AI_pool_" + boost::lexical_cast<std::string>(i)), 0);
+        args.push_back("--ai-pool-client");
+        try {
+            m_ai_client_pool_processes.push_back(Process(AI_CLIENT_EXE, args));
+        } catch (const std::exception& e) {
+            Logger().errorStream() << "ServerApp::StartAIClientPool : unable to start pooled AI client: " << e.what();
+            break;
         }
     }
+    Logger().debugStream() << "ServerApp::StartAIClientPool : started " << m_ai_client_pool_processes.size()
+                           << " pooled AI clients";
+    SetAIsProcessPriorityToLow(true);
+}
+
+std::size_t ServerApp::NumAIClients() const
+{ return m_ai_client_process_players + m_pooled_ai_clients_assigned; }
+
+void ServerApp::SetAIsProcessPriorityToLow(bool set_to_low) {
+    for (std::vector<Process>::iterator it = m_ai_client_processes.begin(); it != m_ai_client_processes.end(); ++it)
+        SetProcessPriorityToLow(*it, set_to_low);
+    for (std::vector<Process>::iterator it = m_ai_client_pool_processes.begin(); it != m_ai_client_pool_processes.end(); ++it)
+        SetProcessPriorityToLow(*it, set_to_low);
+}
+
+void ServerApp::CheckBackgroundSave(bool wait) {
+    std::string filename;
+    if (PollBackgroundSave(wait, filename) != BACKGROUND_SAVE_FAILED)
+        return;
+    for (ServerNetworking::const_established_iterator player_it = m_networking.established_begin();
+         player_it != m_networking.established_end(); ++player_it)
+    { (*player_it)->SendMessage(ErrorMessage("UNABLE_TO_WRITE_SAVE_FILE", false)); }
 }
 
 void ServerApp::HandleMessage(Message msg, PlayerConnectionPtr player_connection) {
@@ -300,6 +436,8 @@ void ServerApp::HandleMessage(Message msg, PlayerConnectionPtr player_connection
 
     //Logger().debugStream() << "ServerApp::HandleMessage type " << boost::lexical_cast<std::string>(msg.Type());
 
+    CheckBackgroundSave(false);
+
     switch (msg.Type()) {
     case Message::HOST_SP_GAME:             m_fsm->process_event(HostSPGame(msg, player_connection));       break;
     case Message::START_MP_GAME:            m_fsm->process_event(StartMPGame(msg, player_connection));      break;
@@ -314,6 +452,7 @@ void ServerApp::HandleMessage(Message msg, PlayerConnectionPtr player_connection
     case Message::REQUEST_NEW_OBJECT_ID:    m_fsm->process_event(RequestObjectID(msg, player_connection));  break;
     case Message::REQUEST_NEW_DESIGN_ID:    m_fsm->process_event(RequestDesignID(msg, player_connection));  break;
     case Message::MODERATOR_ACTION:         m_fsm->process_event(ModeratorAct(msg, player_connection));     break;
+    case Message::TURN_UPDATE_ACK:          HandleTurnUpdateAck(msg, player_connection);                    break;
 
     // TODO: For prototyping only.
     case Message::COMBAT_END:               m_fsm->process_event(CombatComplete()); break;
@@ -342,8 +481,224 @@ void ServerApp::HandleNonPlayerMessage(Message msg, PlayerConnectionPtr player_c
     }
 }
 
-void ServerApp::PlayerDisconnected(PlayerConnectionPtr player_connection)
-{ m_fsm->process_event(Disconnection(player_connection)); }
+void ServerApp::PlayerDisconnected(PlayerConnectionPtr player_connection) {
+    // an idle pooled AI client isn't part of any game
+    if (player_connection->ReadyPooledAIClient()) {
+        Logger().errorStream() << "ServerApp::PlayerDisconnected : lost a pooled AI client";
+        return;
+    }
+    m_turn_update_baselines.erase(player_connection->PlayerID());
+    m_fsm->process_event(Disconnection(player_connection));
+}
+
+void ServerApp::HandleTurnUpdateAck(const Message& msg, PlayerConnectionPtr player_connection) {
+    int update_number = INVALID_TURN_UPDATE_NUMBER;
+    bool applied = false;
+    ExtractMessageData(msg, update_number, applied);
+
+    int player_id = player_connection->PlayerID();
+    std::map<int, TurnUpdateBaseline>::iterator it = m_turn_update_baselines.find(player_id);
+    if (it == m_turn_update_baselines.end())
+        return;
+    TurnUpdateBaseline& baseline = it->second;
+
+    if (applied) {
+        if (update_number == baseline.turn_update_number)
+            baseline.acknowledged_turn = baseline.turn;
+        return;
+    }
+
+    // ignore failures of updates that preceded the latest full snapshot, as
+    // that has replaced whatever the client failed to apply
+    if (baseline.Empty() || update_number < baseline.snapshot_update_number)
+        return;
+
+    Logger().debugStream() << "ServerApp::HandleTurnUpdateAck : player " << player_id
+                           << " could not apply turn update " << update_number
+                           << "; sending a full snapshot next";
+    bool resend_turn_update = update_number == baseline.turn_update_number;
+    baseline.Clear();
+
+    // the client can't submit orders until it has this turn's update, so the
+    // gamestate is still that of this turn
+    if (resend_turn_update) {
+        player_connection->SendMessage(TurnUpdateMessage(player_id,
+                                                         PlayerEmpireID(player_id),
+                                                         m_current_turn,
+                                                         m_empires,
+                                                         m_universe,
+                                                         GetSpeciesManager(),
+                                                         GetPlayerInfoMap(),
+                                                         &baseline));
+    }
+}
+
+std::map<int, PlayerInfo> ServerApp::GetPlayerInfoMap() const {
+    std::map<int, PlayerInfo> players;
+    for (ServerNetworking::const_established_iterator player_it = m_networking.established_begin();
+         player_it != m_networking.established_end(); ++player_it)
+    {
+        PlayerConnectionPtr player = *player_it;
+        int player_id = player->PlayerID();
+        players[player_id] = PlayerInfo(player->PlayerName(),
+                                        PlayerEmpireID(player_id),
+                                        player->GetClientType(),
+                                        m_networking.PlayerIsHost(player_id));
+    }
+    return players;
+}
+
+namespace {
+    void AddOptions(OptionsDB& db) {
+        db.Add("turn-update-threads", "OPTIONS_DB_TURN_UPDATE_THREADS", 0, RangedValidator<int>(0, 64));
+        db.Add("ai-shared-memory", "OPTIONS_DB_AI_SHARED_MEMORY", false, Validator<bool>());
+        db.Add("ai-shared-memory-buffer-mb", "OPTIONS_DB_AI_SHARED_MEMORY_BUFFER_MB", 4, RangedValidator<int>(1, 256));
+        db.Add("ai-client-pool-size", "OPTIONS_DB_AI_CLIENT_POOL_SIZE", 0, RangedValidator<int>(0, 64));
+        db.Add("ai-players-per-process", "OPTIONS_DB_AI_PLAYERS_PER_PROCESS", 1, RangedValidator<int>(1, 16));
+        db.Add("network-stats-dump", "OPTIONS_DB_NETWORK_STATS_DUMP", false, Validator<bool>());
+        db.Add("save-in-background", "OPTIONS_DB_SAVE_IN_BACKGROUND", false, Validator<bool>());
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
+
+    /** Appends the message statistics gathered so far, labelled with turn
+      * \a turn, to network-stats.csv in the user directory, if
+      * network-stats-dump is set.  The first dump of each server run replaces
+      * the file's previous contents. */
+    void DumpMessageStatistics(int turn) {
+        if (!GetOptionsDB().Get<bool>("network-stats-dump"))
+            return;
+        static bool first_dump = true;
+        const fs::path path = GetUserDir() / "network-stats.csv";
+        fs::ofstream ofs(path, first_dump ? std::ios_base::out | std::ios_base::trunc : std::ios_base::out | std::ios_base::app);
+        if (!ofs) {
+            Logger().errorStream() << "DumpMessageStatistics : unable to open " << path.string();
+            return;
+        }
+        GetMessageStatistics().WriteCSV(ofs, turn, first_dump);
+        first_dump = false;
+    }
+
+    /** A turn update to be created for one player. */
+    struct TurnUpdateJob {
+        TurnUpdateJob() :
+            player_id(Networking::INVALID_PLAYER_ID),
+            empire_id(ALL_EMPIRES),
+            baseline(0)
+        {}
+        int                 player_id;
+        int                 empire_id;
+        TurnUpdateBaseline* baseline;
+        Message             message;
+        std::string         error;      ///< set if creating the message threw
+    };
+
+    /** Creates the messages for every \a stride 'th job, starting with job
+      * \a first.  Several of these may run at once on different threads, as
+      * each job has its own baseline, and serialization of the gamestate for
+      * an empire only reads it and the thread's own encoding empire. */
+    struct TurnUpdateBuilder {
+        TurnUpdateBuilder(std::vector<TurnUpdateJob>& jobs, std::size_t first, std::size_t stride,
+                          bool partial, int current_turn, const EmpireManager& empires,
+                          const Universe& universe, const SpeciesManager& species,
+                          const std::map<int, PlayerInfo>& players) :
+            m_jobs(&jobs),
+            m_first(first),
+            m_stride(stride),
+            m_partial(partial),
+            m_current_turn(current_turn),
+            m_empires(&empires),
+            m_universe(&universe),
+            m_species(&species),
+            m_players(&players)
+        {}
+
+        void operator()() const {
+            for (std::size_t i = m_first; i < m_jobs->size(); i += m_stride) {
+                TurnUpdateJob& job = (*m_jobs)[i];
+                try {
+                    job.message = Create(job);
+                } catch (const std::exception& e) {
+                    job.error = e.what();
+                } catch (...) {
+                    job.error = "unknown exception";
+                }
+            }
+        }
+
+        Message Create(TurnUpdateJob& job) const {
+            if (m_partial)
+                return TurnPartialUpdateMessage(job.player_id, job.empire_id, *m_universe, job.baseline);
+            return TurnUpdateMessage(job.player_id, job.empire_id, m_current_turn, *m_empires,
+                                     *m_universe, *m_species, *m_players, job.baseline);
+        }
+
+        std::vector<TurnUpdateJob>*         m_jobs;
+        std::size_t                         m_first;
+        std::size_t                         m_stride;
+        bool                                m_partial;
+        int                                 m_current_turn;
+        const EmpireManager*                m_empires;
+        const Universe*                     m_universe;
+        const SpeciesManager*               m_species;
+        const std::map<int, PlayerInfo>*    m_players;
+    };
+}
+
+void ServerApp::SendTurnUpdates(bool partial) {
+    std::map<int, PlayerInfo> players;
+    if (!partial)
+        players = GetPlayerInfoMap();
+
+    // the baselines are all looked up (and created if need be) here, so that
+    // the map isn't modified while the messages are being created
+    std::vector<TurnUpdateJob> jobs;
+    std::vector<PlayerConnectionPtr> recipients;
+    for (ServerNetworking::const_established_iterator player_it = m_networking.established_begin();
+         player_it != m_networking.established_end(); ++player_it)
+    {
+        PlayerConnectionPtr player = *player_it;
+        TurnUpdateJob job;
+        job.player_id = player->PlayerID();
+        job.empire_id = PlayerEmpireID(job.player_id);
+        job.baseline = &m_turn_update_baselines[job.player_id];
+        // the empire's latest known objects, if not yet loaded from a save
+        // file, are loaded here rather than by the thread creating its update
+        if (job.empire_id != ALL_EMPIRES)
+            m_universe.LoadDeferredEmpireKnownObjects(job.empire_id);
+        jobs.push_back(job);
+        recipients.push_back(player);
+    }
+
+    std::size_t threads = GetOptionsDB().Get<int>("turn-update-threads");
+    if (!threads || jobs.size() < threads)
+        threads = jobs.size();
+
+    if (threads <= 1) {
+        TurnUpdateBuilder(jobs, 0, 1, partial, m_current_turn, m_empires, m_universe,
+                          GetSpeciesManager(), players)();
+    } else {
+        boost::thread_group thread_group;
+        for (std::size_t i = 0; i < threads; ++i)
+            thread_group.create_thread(TurnUpdateBuilder(jobs, i, threads, partial, m_current_turn,
+                                                         m_empires, m_universe, GetSpeciesManager(),
+                                                         players));
+        thread_group.join_all();
+    }
+
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        TurnUpdateJob& job = jobs[i];
+        if (!job.error.empty()) {
+            // retry here, so that the exception propagates as it would have
+            // had the message been created on this thread in the first place
+            Logger().errorStream() << "ServerApp::SendTurnUpdates : creating turn update for player "
+                                   << job.player_id << " failed: " << job.error;
+            job.baseline->Clear();
+            job.message = TurnUpdateBuilder(jobs, i, 1, partial, m_current_turn, m_empires, m_universe,
+                                            GetSpeciesManager(), players).Create(job);
+        }
+        recipients[i]->SendMessage(job.message);
+    }
+}
 
 void ServerApp::SelectNewHost() {
     int new_host_id = Networking::INVALID_PLAYER_ID;
@@ -562,6 +917,7 @@ void ServerApp::NewGameInit(const GalaxySetupData& galaxy_setup_data, const std:
     m_turn_sequence.clear();
     m_eliminated_players.clear();
     m_player_empire_ids.clear();
+    m_turn_update_baselines.clear();    // clients get the new gamestate in full in game start messages
 
 
     // set server state info for new game
@@ -914,6 +1270,7 @@ void ServerApp::LoadGameInit(const std::vector<PlayerSaveGameData>& player_save_
     m_turn_sequence.clear();
     m_eliminated_players.clear();
     m_player_empire_ids.clear();
+    m_turn_update_baselines.clear();    // clients get the new gamestate in full in game start messages
 
 
     // restore server state info from save
@@ -2076,6 +2433,11 @@ namespace {
 void ServerApp::PreCombatProcessTurns() {
     ObjectMap& objects = m_universe.Objects();
 
+    // all orders are in, so the statistics cover this turn's updates and orders
+    DumpMessageStatistics(m_current_turn);
+
+    CheckBackgroundSave(false);
+
 
     m_universe.UpdateEmpireVisibilityFilteredSystemGraphs();
 
@@ -2193,14 +2555,7 @@ void ServerApp::PreCombatProcessTurns() {
     m_networking.SendMessage(TurnProgressMessage(Message::DOWNLOADING));
 
     // send partial turn updates to all players after orders and movement
-    for (ServerNetworking::const_established_iterator player_it = m_networking.established_begin();
-         player_it != m_networking.established_end(); ++player_it)
-    {
-        PlayerConnectionPtr player = *player_it;
-        int player_id = player->PlayerID();
-        player->SendMessage(TurnPartialUpdateMessage(player_id, PlayerEmpireID(player_id),
-                                                     m_universe));
-    }
+    SendTurnUpdates(true);
 }
 
 void ServerApp::ProcessCombats() {
@@ -2466,34 +2821,10 @@ void ServerApp::PostCombatProcessTurns() {
     m_networking.SendMessage(TurnProgressMessage(Message::DOWNLOADING));
 
 
-    // compile map of PlayerInfo, indexed by player ID
-    std::map<int, PlayerInfo> players;
-    for (ServerNetworking::const_established_iterator player_it = m_networking.established_begin();
-         player_it != m_networking.established_end(); ++player_it)
-    {
-        PlayerConnectionPtr player = *player_it;
-        int player_id = player->PlayerID();
-        players[player_id] = PlayerInfo(player->PlayerName(),
-                                        PlayerEmpireID(player_id),
-                                        player->GetClientType(),
-                                        m_networking.PlayerIsHost(player_id));
-    }
-
     Logger().debugStream() << "ServerApp::PostCombatProcessTurns Sending turn updates to players";
     // send new-turn updates to all players
-    for (ServerNetworking::const_established_iterator player_it = m_networking.established_begin();
-         player_it != m_networking.established_end(); ++player_it)
-    {
-        PlayerConnectionPtr player = *player_it;
-        int player_id = player->PlayerID();
-        player->SendMessage(TurnUpdateMessage(player_id,
-                                              PlayerEmpireID(player_id),
-                                              m_current_turn,
-                                              m_empires,
-                                              m_universe,
-                                              GetSpeciesManager(),
-                                              players));
-    }
+    SendTurnUpdates(false);
+    Logger().debugStream() << "ServerApp::PostCombatProcessTurns object pools:\n" << ObjectPools::StatsReport();
     Logger().debugStream() << "ServerApp::PostCombatProcessTurns done";
 }
 
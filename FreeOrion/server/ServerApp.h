@@ -9,6 +9,7 @@
 #include "../network/ServerNetworking.h"
 #include "../universe/Universe.h"
 #include "../util/MultiplayerCommon.h"
+#include "../util/Serialize.h"
 #include "ServerFSM.h"
 
 #include <set>
@@ -87,6 +88,10 @@ public:
     void    operator()();               ///< external interface to Run()
     void    Exit(int code);             ///< does basic clean-up, then calls exit(); callable from anywhere in user code via GetApp()
 
+    /** Sets the current turn.  Used by tools that set up a game and process
+      * its turns without players, such as benchmarks. */
+    void    SetCurrentTurn(int turn) { m_current_turn = turn; }
+
     /** creates an AI client child process for each element of \a AIs*/
     void    CreateAIClients(const std::vector<PlayerSetupData>& player_setup_data, int maxAggr=4);
 
@@ -192,9 +197,24 @@ private:
 
     void    CleanupAIs();   ///< cleans up AI processes: kills the process and empties the container of AI processes
 
+    /** Starts the AI clients of the AI client pool, if ai-client-pool-size
+      * is set.  Pooled AI clients connect and initialize once, then wait to
+      * be assigned AI players by CreateAIClients(), and return to the pool
+      * when told the game has ended instead of exiting. */
+    void    StartAIClientPool();
+
+    /** Returns the number of AI clients started for the current game,
+      * whether as new processes or assigned from the AI client pool. */
+    std::size_t NumAIClients() const;
+
     /** Sets the priority for all AI processes */
     void    SetAIsProcessPriorityToLow(bool set_to_low);
 
+    /** Collects the result of the save being written in the background, if
+      * it has finished (or once it has, if \a wait is true), and tells all
+      * players if it failed. */
+    void    CheckBackgroundSave(bool wait);
+
     /** Handles an incoming message from the server with the appropriate action
       * or response */
     void    HandleMessage(Message msg, PlayerConnectionPtr player_connection);
@@ -206,6 +226,21 @@ private:
     /** Called by ServerNetworking when a player's TCP connection is closed*/
     void    PlayerDisconnected(PlayerConnectionPtr player_connection);
 
+    /** Handles a client's report of whether it applied a delta-encoded turn
+      * update.  If it did not, the next update sent to it is a full snapshot,
+      * and if the update it failed to apply was the latest TURN_UPDATE, that
+      * is resent immediately as a full snapshot. */
+    void    HandleTurnUpdateAck(const Message& msg, PlayerConnectionPtr player_connection);
+
+    /** Returns info about all established players, as sent to clients in
+      * turn updates. */
+    std::map<int, PlayerInfo>   GetPlayerInfoMap() const;
+
+    /** Sends a TURN_UPDATE (or TURN_PARTIAL_UPDATE, if \a partial is true)
+      * to each established player.  The messages are created on up to
+      * turn-update-threads threads at once, and then sent in turn. */
+    void    SendTurnUpdates(bool partial);
+
     /** Called when the host player has disconnected.  Select a new host player*/
     void    SelectNewHost();
 
@@ -227,6 +262,9 @@ private:
     std::map<int, int>      m_player_empire_ids;    ///< map from player id to empire id that the player controls.
     int                     m_current_turn;         ///< current turn number
     std::vector<Process>    m_ai_client_processes;  ///< AI client child processes
+    std::size_t             m_ai_client_process_players;    ///< number of AI players in the current game played by m_ai_client_processes
+    std::vector<Process>    m_ai_client_pool_processes;     ///< AI client child processes of the AI client pool, which are kept between games
+    std::size_t             m_pooled_ai_clients_assigned;   ///< number of AI players in the current game played by pooled AI clients
     bool                    m_single_player_game;   ///< true when the game being played is single-player
 
     /** Turn sequence map is used for turn processing. Each empire is added at
@@ -237,6 +275,7 @@ private:
     std::map<int, CombatOrderSet*>          m_combat_turn_sequence;
     std::map<int, std::set<std::string> >   m_victors;              ///< for each player id, the victory types that player has achived
     std::set<int>                           m_eliminated_players;   ///< ids of players whose connections have been severed by the server after they were eliminated
+    std::map<int, TurnUpdateBaseline>       m_turn_update_baselines;///< for each player id, the gamestate last sent to that player, against which delta turn updates are encoded
     static ServerApp*                       s_app;
 
     // Give FSM and its states direct access.  We are using the FSM code as a
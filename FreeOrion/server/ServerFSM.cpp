@@ -227,9 +227,10 @@ void ServerFSM::HandleNonLobbyDisconnection(const Disconnection& d) {
     }
 
     // independently of everything else, if there are no humans left, it's time to terminate
-    if (m_server.m_networking.empty() || m_server.m_ai_client_processes.size() == m_server.m_networking.NumEstablishedPlayers()) {
+    if (m_server.m_networking.empty() || m_server.NumAIClients() == m_server.m_networking.NumEstablishedPlayers()) {
         Logger().debugStream() << "ServerFSM::HandleNonLobbyDisconnection : All human players disconnected; server terminating.";
-        Sleep(2000); // HACK! Pause for a bit to let the player disconnected and end game messages propogate.
+        // let the player disconnected and end game messages reach the remaining players
+        m_server.m_networking.FlushOutgoingMessages(2000);
         m_server.Exit(1);
     }
 }
@@ -360,7 +361,7 @@ sc::result MPLobby::react(const Disconnection& d) {
     }
 
     // if there are no humans left, it's time to terminate
-    if (server.m_networking.empty() || server.m_ai_client_processes.size() == server.m_networking.NumEstablishedPlayers()) {
+    if (server.m_networking.empty() || server.NumAIClients() == server.m_networking.NumEstablishedPlayers()) {
         Logger().debugStream() << "MPLobby.Disconnection : All human players disconnected; server terminating.";
         server.Exit(1);
     }
@@ -1106,7 +1107,8 @@ sc::result PlayingGame::react(const ModeratorAct& msg) {
         // update player(s) of changed gamestate as result of action
         server.m_networking.SendMessage(TurnProgressMessage(Message::DOWNLOADING, player_id));
         server.m_networking.SendMessage(TurnPartialUpdateMessage(player_id, server.PlayerEmpireID(player_id),
-                                                                 GetUniverse()));
+                                                                 GetUniverse(),
+                                                                 &server.m_turn_update_baselines[player_id]));
     }
 
     delete action;
@@ -1379,12 +1381,20 @@ sc::result WaitingForSaveData::react(const ClientSaveData& msg) {
         // set in WaitingForTurnEndIdle::react(const SaveGameRequest& msg)
         const std::string& save_filename = context<WaitingForTurnEnd>().m_save_filename;
 
-        // save game...
-        try {
-            SaveGame(save_filename,     server_data,    m_player_save_game_data,
-                     GetUniverse(),     Empires(),      GetSpeciesManager());
-        } catch (const std::exception&) {
-            SendMessageToAllPlayers(ErrorMessage("UNABLE_TO_WRITE_SAVE_FILE", false));
+        // save game, in the background if possible, so that the next turn
+        // can start while the file is written.  failures of background saves
+        // are reported to players when ServerApp next checks on them.
+        server.CheckBackgroundSave(true);
+        if (!GetOptionsDB().Get<bool>("save-in-background") ||
+            !SaveGameInBackground(save_filename,    server_data,    m_player_save_game_data,
+                                  GetUniverse(),    Empires(),      GetSpeciesManager()))
+        {
+            try {
+                SaveGame(save_filename,     server_data,    m_player_save_game_data,
+                         GetUniverse(),     Empires(),      GetSpeciesManager());
+            } catch (const std::exception&) {
+                SendMessageToAllPlayers(ErrorMessage("UNABLE_TO_WRITE_SAVE_FILE", false));
+            }
         }
 
         context<WaitingForTurnEnd>().m_save_filename = "";
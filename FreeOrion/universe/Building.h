@@ -3,6 +3,7 @@
 #define _Building_h_
 
 #include "UniverseObject.h"
+#include "ObjectPool.h"
 #include "ValueRefFwd.h"
 
 class BuildingType;
@@ -15,7 +16,7 @@ namespace Condition {
 }
 
 /** A Building UniverseObject type. */
-class Building : public UniverseObject {
+class Building : public UniverseObject, public PooledObject<Building> {
 public:
     /** \name Structors */ //@{
     Building() :
@@ -3,9 +3,10 @@
 #define _Field_h_
 
 #include "UniverseObject.h"
+#include "ObjectPool.h"
 
 /** a class representing a region of space */
-class Field : public UniverseObject {
+class Field : public UniverseObject, public PooledObject<Field> {
 public:
     /** \name Structors */ //@{
     Field();                                        ///< default ctor
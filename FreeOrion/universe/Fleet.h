@@ -3,6 +3,7 @@
 #define _Fleet_h_
 
 #include "UniverseObject.h"
+#include "ObjectPool.h"
 
 ////////////////////////////////////////////////
 // MovePathNode
@@ -23,7 +24,7 @@ struct MovePathNode {
 
 /** Encapsulates data for a FreeOrion fleet.  Fleets are basically a group of
   * ships that travel together. */
-class Fleet : public UniverseObject {
+class Fleet : public UniverseObject, public PooledObject<Fleet> {
 public:
     typedef std::set<int>               ShipIDSet;
     typedef ShipIDSet::iterator         iterator;                       ///< an iterator to the ships in the fleet
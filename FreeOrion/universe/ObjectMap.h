@@ -7,6 +7,7 @@
 #include <string>
 
 #include <boost/serialization/access.hpp>
+#include <boost/serialization/version.hpp>
 
 class Universe;
 struct UniverseObjectVisitor;
@@ -235,6 +236,8 @@ private:
     void serialize(Archive& ar, const unsigned int version);
 };
 
+BOOST_CLASS_VERSION(ObjectMap, 1)
+
 // template implementations
 #if (10 * __GNUC__ + __GNUC_MINOR__ > 33) && (!defined _UniverseObject_h_)
 #  include "UniverseObject.h"
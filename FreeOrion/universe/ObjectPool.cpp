@@ -0,0 +1,35 @@
+#include "ObjectPool.h"
+
+#include "Building.h"
+#include "Field.h"
+#include "Fleet.h"
+#include "Planet.h"
+#include "Ship.h"
+
+#include <sstream>
+
+
+namespace {
+    template <class T>
+    void AddStats(std::ostringstream& os, const char* type_name) {
+        const ObjectPoolStats stats = ObjectPool<T>::Stats();
+        os << type_name << ": " << stats.allocations << " allocated, " << stats.deallocations << " freed, "
+           << stats.allocations - stats.deallocations << " live, " << stats.global_allocations
+           << " heap allocations of " << stats.global_bytes << " bytes\n";
+    }
+}
+
+bool& ObjectPools::Enabled() {
+    static bool enabled = true;
+    return enabled;
+}
+
+std::string ObjectPools::StatsReport() {
+    std::ostringstream os;
+    AddStats<Ship>(os, "Ship");
+    AddStats<Fleet>(os, "Fleet");
+    AddStats<Planet>(os, "Planet");
+    AddStats<Building>(os, "Building");
+    AddStats<Field>(os, "Field");
+    return os.str();
+}
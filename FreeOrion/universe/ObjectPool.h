@@ -0,0 +1,169 @@
+// -*- C++ -*-
+#ifndef _ObjectPool_h_
+#define _ObjectPool_h_
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+#include <boost/type_traits/alignment_of.hpp>
+
+#include <new>
+#include <string>
+
+
+/** Counts of what an ObjectPool has done since the program started. */
+struct ObjectPoolStats {
+    ObjectPoolStats() :
+        allocations(0),
+        deallocations(0),
+        global_allocations(0),
+        global_bytes(0)
+    {}
+
+    std::size_t allocations;        ///< objects allocated
+    std::size_t deallocations;      ///< objects freed
+    std::size_t global_allocations; ///< calls to the global operator new, for slabs or, if pools are disabled, objects
+    std::size_t global_bytes;       ///< bytes allocated by those calls
+};
+
+namespace ObjectPools {
+    /** Returns whether objects of pooled types are allocated from slabs, which
+      * is true unless set false before the first object of a type is
+      * allocated, which fixes it for that type.  Used to compare the two. */
+    bool&       Enabled();
+
+    /** Returns the statistics of the pool of each pooled UniverseObject
+      * subclass, one line per type. */
+    std::string StatsReport();
+}
+
+/** Allocates objects of type \a T from slabs holding many of them, so that
+  * objects of the same type lie together in memory, and freed objects are
+  * reused by the next allocations, rather than going back to the heap.
+  * Slabs are never freed.  Safe to use from several threads at once. */
+template <class T>
+class ObjectPool {
+public:
+    static void* Allocate(std::size_t size) {
+        // classes derived from T, which are larger, aren't pooled
+        if (size != sizeof(T))
+            return ::operator new(size);
+        return Instance().AllocateSlot();
+    }
+
+    static void Deallocate(void* p, std::size_t size) {
+        if (!p)
+            return;
+        if (size != sizeof(T)) {
+            ::operator delete(p);
+            return;
+        }
+        Instance().FreeSlot(p);
+    }
+
+    static ObjectPoolStats Stats() {
+        ObjectPool& pool = Instance();
+        boost::mutex::scoped_lock lock(pool.m_mutex);
+        return pool.m_stats;
+    }
+
+private:
+    /** Freed slots hold the next free slot. */
+    struct FreeSlotLink {
+        FreeSlotLink* next;
+    };
+
+    static const std::size_t ALIGNMENT = boost::alignment_of<T>::value < boost::alignment_of<FreeSlotLink>::value ?
+        boost::alignment_of<FreeSlotLink>::value : boost::alignment_of<T>::value;
+    static const std::size_t SLOT_SIZE =
+        ((sizeof(T) < sizeof(FreeSlotLink) ? sizeof(FreeSlotLink) : sizeof(T)) + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    static const std::size_t SLAB_BYTES = 64 * 1024;
+    static const std::size_t SLOTS_PER_SLAB = SLOT_SIZE < SLAB_BYTES / 16 ? SLAB_BYTES / SLOT_SIZE : 16;
+
+    ObjectPool() :
+        m_enabled(ObjectPools::Enabled()),
+        m_free_slots(0)
+    {}
+
+    /** Creates the pool on first use, which may happen on several threads at
+      * once, so a function-local static, which not all of our compilers
+      * initialize thread-safely, can't be used.  The pool is never destroyed,
+      * so objects freed during static destruction still have one. */
+    static ObjectPool& Instance() {
+        boost::call_once(s_instance_once, &ObjectPool::CreateInstance);
+        return *s_instance;
+    }
+
+    static void CreateInstance()
+    { s_instance = new ObjectPool; }
+
+    void* AllocateSlot() {
+        boost::mutex::scoped_lock lock(m_mutex);
+        ++m_stats.allocations;
+        if (!m_enabled) {
+            ++m_stats.global_allocations;
+            m_stats.global_bytes += sizeof(T);
+            lock.unlock();
+            return ::operator new(sizeof(T));
+        }
+        if (!m_free_slots)
+            AddSlab();
+        FreeSlotLink* retval = m_free_slots;
+        m_free_slots = retval->next;
+        return retval;
+    }
+
+    void FreeSlot(void* p) {
+        boost::mutex::scoped_lock lock(m_mutex);
+        ++m_stats.deallocations;
+        if (!m_enabled) {
+            lock.unlock();
+            ::operator delete(p);
+            return;
+        }
+        FreeSlotLink* slot = static_cast<FreeSlotLink*>(p);
+        slot->next = m_free_slots;
+        m_free_slots = slot;
+    }
+
+    /** Adds the slots of a new slab to the free list, so that they are
+      * allocated in address order. */
+    void AddSlab() {
+        char* slab = static_cast<char*>(::operator new(SLOTS_PER_SLAB * SLOT_SIZE));
+        ++m_stats.global_allocations;
+        m_stats.global_bytes += SLOTS_PER_SLAB * SLOT_SIZE;
+        for (std::size_t i = SLOTS_PER_SLAB; i--; ) {
+            FreeSlotLink* slot = reinterpret_cast<FreeSlotLink*>(slab + i * SLOT_SIZE);
+            slot->next = m_free_slots;
+            m_free_slots = slot;
+        }
+    }
+
+    const bool      m_enabled;
+    boost::mutex    m_mutex;        ///< guards the members below
+    FreeSlotLink*   m_free_slots;
+    ObjectPoolStats m_stats;
+
+    static ObjectPool*      s_instance;
+    static boost::once_flag s_instance_once;
+};
+
+template <class T>
+ObjectPool<T>* ObjectPool<T>::s_instance = 0;
+
+template <class T>
+boost::once_flag ObjectPool<T>::s_instance_once = BOOST_ONCE_INIT;
+
+/** Base class for a class \a T whose objects are allocated from
+  * ObjectPool<T>, however they are created: by new, Clone() or
+  * deserialization. */
+template <class T>
+class PooledObject {
+public:
+    static void* operator new(std::size_t size)
+    { return ObjectPool<T>::Allocate(size); }
+
+    static void operator delete(void* p, std::size_t size)
+    { ObjectPool<T>::Deallocate(p, size); }
+};
+
+#endif // _ObjectPool_h_
@@ -3,6 +3,7 @@
 #define _Planet_h_
 
 #include "UniverseObject.h"
+#include "ObjectPool.h"
 #include "PopCenter.h"
 #include "ResourceCenter.h"
 #include "Meter.h"
@@ -77,7 +78,8 @@ public:
 class Planet :
     public UniverseObject,
     public PopCenter,
-    public ResourceCenter
+    public ResourceCenter,
+    public PooledObject<Planet>
 {
 public:
     /** \name Structors */ //@{
@@ -3,6 +3,7 @@
 #define _Ship_h_
 
 #include "UniverseObject.h"
+#include "ObjectPool.h"
 #include "Meter.h"
 
 class Fighter;
@@ -10,7 +11,7 @@ class Fleet;
 class ShipDesign;
 
 /** a class representing a single FreeOrion ship*/
-class Ship : public UniverseObject {
+class Ship : public UniverseObject, public PooledObject<Ship> {
 public:
     // map from part type name to (number of parts in the design of that type,
     // number of fighters (or missiles) available of that type) pairs
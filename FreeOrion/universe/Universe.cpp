@@ -408,7 +408,6 @@ Universe::Universe() :
     m_last_allocated_design_id(-1), // same, but for ShipDesign::INVALID_DESIGN_ID
     m_universe_width(1000.0),
     m_inhibit_universe_object_signals(false),
-    m_encoding_empire(ALL_EMPIRES),
     m_all_objects_visible(false)
 {}
 
@@ -423,6 +422,8 @@ void Universe::Clear() {
     for (EmpireObjectMap::iterator it = m_empire_latest_known_objects.begin(); it != m_empire_latest_known_objects.end(); ++it)
         it->second.Clear();
     m_empire_latest_known_objects.clear();
+    m_deferred_empire_known_objects.clear();
+    m_object_records.clear();
 
     // clean up ship designs
     for (ShipDesignMap::iterator it = m_ship_designs.begin(); it != m_ship_designs.end(); ++it)
@@ -436,6 +437,7 @@ const ObjectMap& Universe::EmpireKnownObjects(int empire_id) const {
     if (empire_id == ALL_EMPIRES)
         return m_objects;
 
+    LoadDeferredEmpireKnownObjects(empire_id);
     EmpireObjectMap::const_iterator it = m_empire_latest_known_objects.find(empire_id);
     if (it != m_empire_latest_known_objects.end())
         return it->second;
@@ -448,6 +450,7 @@ ObjectMap& Universe::EmpireKnownObjects(int empire_id) {
     if (empire_id == ALL_EMPIRES)
         return m_objects;
 
+    LoadDeferredEmpireKnownObjects(empire_id);
     EmpireObjectMap::iterator it = m_empire_latest_known_objects.find(empire_id);
     if (it != m_empire_latest_known_objects.end()) {
         return it->second;
@@ -458,6 +461,49 @@ ObjectMap& Universe::EmpireKnownObjects(int empire_id) {
     return empty_map;
 }
 
+std::vector<int> Universe::EmpireKnownObjectsEmpireIDs() const {
+    std::vector<int> retval;
+    for (EmpireObjectMap::const_iterator it = m_empire_latest_known_objects.begin();
+         it != m_empire_latest_known_objects.end(); ++it)
+    { retval.push_back(it->first); }
+    return retval;
+}
+
+void Universe::SetDeferredEmpireKnownObjects(int empire_id, const boost::function<void (ObjectMap&)>& loader) {
+    // the empire's entry is created now, so that loading it later doesn't
+    // change the structure of m_empire_latest_known_objects
+    ObjectMap& objects = m_empire_latest_known_objects[empire_id];
+    objects.Clear();
+    m_deferred_empire_known_objects[empire_id] = loader;
+}
+
+void Universe::LoadDeferredEmpireKnownObjects(int empire_id/* = ALL_EMPIRES*/) const {
+    if (m_deferred_empire_known_objects.empty())
+        return;
+
+    std::map<int, boost::function<void (ObjectMap&)> > loaders;
+    if (empire_id == ALL_EMPIRES) {
+        loaders.swap(m_deferred_empire_known_objects);
+    } else {
+        std::map<int, boost::function<void (ObjectMap&)> >::iterator it = m_deferred_empire_known_objects.find(empire_id);
+        if (it == m_deferred_empire_known_objects.end())
+            return;
+        loaders[empire_id].swap(it->second);
+        m_deferred_empire_known_objects.erase(it);
+    }
+
+    for (std::map<int, boost::function<void (ObjectMap&)> >::iterator it = loaders.begin(); it != loaders.end(); ++it) {
+        ObjectMap& objects = m_empire_latest_known_objects[it->first];
+        try {
+            it->second(objects);
+        } catch (const std::exception& e) {
+            Logger().errorStream() << "Universe::LoadDeferredEmpireKnownObjects : loading latest known objects of empire "
+                                   << it->first << " failed: " << e.what();
+            objects.Clear();
+        }
+    }
+}
+
 std::set<int> Universe::EmpireVisibleObjectIDs(int empire_id/* = ALL_EMPIRES*/) const {
     std::set<int> retval;
 
@@ -2217,6 +2263,8 @@ void Universe::UpdateEmpireObjectVisibilities() {
 void Universe::UpdateEmpireLatestKnownObjectsAndVisibilityTurns() {
     //Logger().debugStream() << "Universe::UpdateEmpireLatestKnownObjectsAndVisibilityTurns()";
 
+    LoadDeferredEmpireKnownObjects();
+
     // assumes m_empire_object_visibility has been updated
 
     //  for each object in universe
@@ -2301,6 +2349,7 @@ void Universe::UpdateEmpireStaleObjectKnowledge() {
     const std::map<int, std::map<std::pair<double, double>, float> >
         empire_location_detection_ranges = GetEmpiresPositionDetectionRanges();
 
+    LoadDeferredEmpireKnownObjects();
     for (EmpireObjectMap::iterator empire_it = m_empire_latest_known_objects.begin();
          empire_it != m_empire_latest_known_objects.end(); ++empire_it)
     {
@@ -2693,8 +2742,14 @@ void Universe::UpdateEmpireVisibilityFilteredSystemGraphs(int for_empire_id) {
     }
 }
 
-int& Universe::EncodingEmpire()
-{ return m_encoding_empire; }
+int& Universe::EncodingEmpire() {
+    if (!m_encoding_empire.get())
+        m_encoding_empire.reset(new int(ALL_EMPIRES));
+    return *m_encoding_empire;
+}
+
+int Universe::EncodingEmpire() const
+{ return m_encoding_empire.get() ? *m_encoding_empire : ALL_EMPIRES; }
 
 double Universe::UniverseWidth() const
 { return m_universe_width; }
@@ -2743,6 +2798,7 @@ void Universe::GetObjectsToSerialize(ObjectMap& objects, int encoding_empire) co
         // if encoding for a specific empire with memory...
 
         // find indicated empire's knowledge about objects, current and previous
+        LoadDeferredEmpireKnownObjects(encoding_empire);
         EmpireObjectMap::const_iterator it = m_empire_latest_known_objects.find(encoding_empire);
         if (it == m_empire_latest_known_objects.end())
             return;                 // empire has no object knowledge, so there is nothing to send
@@ -2782,6 +2838,7 @@ void Universe::GetEmpireKnownObjectsToSerialize(EmpireObjectMap& empire_latest_k
 
     if (encoding_empire == ALL_EMPIRES) {
         // copy all ObjectMaps' contents
+        LoadDeferredEmpireKnownObjects();
         for (EmpireObjectMap::const_iterator it = m_empire_latest_known_objects.begin(); it != m_empire_latest_known_objects.end(); ++it) {
             int empire_id = it->first;
             const ObjectMap& map = it->second;
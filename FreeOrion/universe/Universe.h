@@ -8,6 +8,7 @@
 #include "ObjectMap.h"
 #include "../util/AppInterface.h"
 
+#include <boost/function.hpp>
 #include <boost/signal.hpp>
 #include <boost/unordered_map.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
@@ -16,6 +17,7 @@
 #include <boost/serialization/nvp.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/type_traits/remove_const.hpp>
+#include <boost/thread/tss.hpp>
 
 #include <vector>
 #include <list>
@@ -30,6 +32,7 @@
 #endif
 
 struct PlayerSetupData;
+struct TurnUpdateBaseline;
 class Empire;
 struct UniverseObjectVisitor;
 class XMLElement;
@@ -241,12 +244,15 @@ public:
 
     /** Generates systems and planets, assigns homeworlds and populates them
       * with people, industry and bases, and places starting fleets.  Uses
-      * predefined galaxy shapes. */
+      * predefined galaxy shapes.  If \a seed is nonzero, the random number
+      * generator is seeded with it, so that the same universe is generated
+      * each time; otherwise release builds seed it from the clock. */
     void            CreateUniverse(int size, Shape shape,
                                    GalaxySetupOption age, GalaxySetupOption starlane_freq,
                                    GalaxySetupOption planet_density, GalaxySetupOption specials_freq,
                                    GalaxySetupOption monster_freq, GalaxySetupOption native_freq,
-                                   const std::map<int, PlayerSetupData>& player_setup_data);
+                                   const std::map<int, PlayerSetupData>& player_setup_data,
+                                   unsigned int seed = 0);
 
     /** Clears main ObjectMap, empires' latest known objects map, and
       * ShipDesign map. */
@@ -398,8 +404,64 @@ public:
       * Universe, so that only the relevant parts of the Universe are
       * serialized.  The use of this global variable is done just so I don't
       * have to rewrite any custom boost::serialization classes that implement
-      * empire-dependent visibility. */
+      * empire-dependent visibility.  Each thread has its own encoding empire,
+      * initially ALL_EMPIRES, so that several threads can serialize the
+      * gamestate for different empires at once. */
     int&            EncodingEmpire();
+    int             EncodingEmpire() const;
+
+    /** Writes to \a ar the changes to the gamestate known to the encoding
+      * empire since the state recorded in \a baseline, and records the new
+      * state in \a baseline.  The encoding empire must not be ALL_EMPIRES.
+      * Used for delta turn updates; see SerializeDelta in Serialize.h. */
+    template <class Archive>
+    void            SerializeDelta(Archive& ar, TurnUpdateBaseline& baseline) const;
+
+    /** Applies changes written by SerializeDelta to this Universe.
+      * Returns false if the result differs from what was serialized. */
+    template <class Archive>
+    bool            DeserializeDelta(Archive& ar);
+
+    /** Writes to \a ar the latest known objects of all empires, each as the
+      * difference of its serialized form from the object's record written by
+      * the last SerializeWithoutEmpireKnownObjects() with \a object_records,
+      * or from another empire's version of it.  Used for saved games; see
+      * SerializeEmpireKnownObjectDifferences in Serialize.h. */
+    template <class Archive>
+    void            SerializeEmpireKnownObjectDifferences(Archive& ar) const;
+
+    /** Replaces the latest known objects of the empires written by
+      * SerializeEmpireKnownObjectDifferences with deferred ones; see
+      * SetDeferredEmpireKnownObjects().  Each empire's are decoded, against
+      * the object records read by the last SerializeWithoutEmpireKnownObjects()
+      * with \a object_records, when first needed. */
+    template <class Archive>
+    void            DeserializeEmpireKnownObjectDifferences(Archive& ar);
+
+    /** Serializes the Universe to or from \a ar, as serialization through
+      * boost does, but without the latest known objects of empires.  Save
+      * files store each empire's latest known objects in a separate section;
+      * see SetDeferredEmpireKnownObjects().  If \a object_records is true,
+      * each object is a separate record, as serialized by
+      * SerializeStandalone(), and the records are kept for the empires'
+      * latest known objects to be encoded or decoded against. */
+    template <class Archive>
+    void            SerializeWithoutEmpireKnownObjects(Archive& ar, bool object_records);
+
+    /** Returns the ids of the empires that have latest known objects. */
+    std::vector<int> EmpireKnownObjectsEmpireIDs() const;
+
+    /** Arranges for the latest known objects of empire \a empire_id to be
+      * filled in by \a loader when they are first needed, rather than now, so
+      * that those of empires nobody asks about are never deserialized.
+      * Deferred objects are loaded on whichever thread first needs them, so
+      * LoadDeferredEmpireKnownObjects() must be called for an empire before
+      * several threads use its latest known objects at once. */
+    void            SetDeferredEmpireKnownObjects(int empire_id, const boost::function<void (ObjectMap&)>& loader);
+
+    /** Loads the deferred latest known objects of empire \a empire_id, or of
+      * all empires if \a empire_id is ALL_EMPIRES, if not already loaded. */
+    void            LoadDeferredEmpireKnownObjects(int empire_id = ALL_EMPIRES) const;
 
     double          UniverseWidth() const;
     bool            AllObjectsVisible() const { return m_all_objects_visible; }
@@ -528,7 +590,11 @@ private:
     void    GenerateEmpires(std::vector<int>& homeworld_planet_ids, const std::map<int, PlayerSetupData>& player_setup_data);
 
     ObjectMap                       m_objects;                          ///< map from object id to UniverseObjects in the universe.  for the server: all of them, up to date and true information about object is stored;  for clients, only limited information based on what the client knows about is sent.
-    EmpireObjectMap                 m_empire_latest_known_objects;      ///< map from empire id to (map from object id to latest known information about each object by that empire)
+    mutable EmpireObjectMap         m_empire_latest_known_objects;      ///< map from empire id to (map from object id to latest known information about each object by that empire); mutable so that deferred objects can be loaded on first use
+    mutable std::map<int, boost::function<void (ObjectMap&)> >
+                                    m_deferred_empire_known_objects;    ///< loaders of latest known objects not yet loaded, by empire id; see SetDeferredEmpireKnownObjects()
+    mutable std::map<int, std::string>
+                                    m_object_records;                   ///< records of objects last written or read by SerializeWithoutEmpireKnownObjects(), by object id, until the empires' latest known objects are encoded or decoded against them
 
     std::set<int>                   m_destroyed_object_ids;             ///< all ids of objects that have been destroyed (on server) or that a player knows were destroyed (on clients)
 
@@ -559,7 +625,7 @@ private:
 
     double                          m_universe_width;
     bool                            m_inhibit_universe_object_signals;
-    int                             m_encoding_empire;
+    mutable boost::thread_specific_ptr<int> m_encoding_empire;      ///< per-thread encoding empire; see EncodingEmpire()
     bool                            m_all_objects_visible;
 
     /** Fills \a designs_to_serialize with ShipDesigns known to the empire with
@@ -597,6 +663,9 @@ private:
     friend class boost::serialization::access;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version);
+
+    template <class Archive>
+    void Serialize(Archive& ar, bool empire_known_objects, bool object_records);
 };
 
 /** A combination of names of ShipDesign that can be put together to make a
@@ -1481,10 +1481,14 @@ namespace {
 void Universe::CreateUniverse(int size, Shape shape, GalaxySetupOption age, GalaxySetupOption starlane_freq,
                               GalaxySetupOption planet_density, GalaxySetupOption specials_freq,
                               GalaxySetupOption monster_freq, GalaxySetupOption native_freq,
-                              const std::map<int, PlayerSetupData>& player_setup_data)
+                              const std::map<int, PlayerSetupData>& player_setup_data,
+                              unsigned int seed/* = 0*/)
 {
+    if (seed)
+        Seed(seed);
 #ifdef FREEORION_RELEASE
-    ClockSeed();
+    else
+        ClockSeed();
 #endif
 
     m_objects.Clear();  // wipe out anything present in the object map
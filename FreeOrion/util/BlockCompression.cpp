@@ -0,0 +1,297 @@
+#include "BlockCompression.h"
+
+#include <boost/bind.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <zlib.h>
+#ifdef FREEORION_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+
+
+namespace {
+    const std::size_t BLOCK_HEADER_SIZE = 8;
+
+    /** Blocks larger than this are assumed to be corrupt, rather than
+      * allocating however much memory their header asks for. */
+    const boost::uint32_t MAX_BLOCK_SIZE = 1u << 28;
+
+    /** The number of full blocks that may wait for the compression thread
+      * before writing through a BlockCompressingStreambuf blocks. */
+    const std::size_t MAX_QUEUED_BLOCKS = 2;
+
+    void PutUInt32(boost::uint32_t value, char* dest) {
+        for (int i = 0; i < 4; ++i)
+            dest[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+
+    boost::uint32_t GetUInt32(const char* src) {
+        boost::uint32_t retval = 0;
+        for (int i = 0; i < 4; ++i)
+            retval |= static_cast<boost::uint32_t>(static_cast<unsigned char>(src[i])) << (8 * i);
+        return retval;
+    }
+}
+
+////////////////////////////////////////////////
+// BlockCompression
+////////////////////////////////////////////////
+bool BlockCompression::CodecAvailable(Codec codec) {
+    switch (codec) {
+    case NO_CODEC:
+    case ZLIB_CODEC:
+        return true;
+#ifdef FREEORION_HAVE_LZ4
+    case LZ4_CODEC:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+BlockCompression::Codec BlockCompression::CodecFromName(const std::string& name) {
+    if (name == "none")
+        return NO_CODEC;
+    if (name == "lz4" && CodecAvailable(LZ4_CODEC))
+        return LZ4_CODEC;
+    return ZLIB_CODEC;
+}
+
+std::string BlockCompression::CodecName(Codec codec) {
+    switch (codec) {
+    case NO_CODEC:      return "none";
+    case ZLIB_CODEC:    return "zlib";
+    case LZ4_CODEC:     return "lz4";
+    default:            return "unknown";
+    }
+}
+
+////////////////////////////////////////////////
+// BlockCompressingStreambuf
+////////////////////////////////////////////////
+const std::size_t BlockCompressingStreambuf::DEFAULT_BLOCK_SIZE;
+
+BlockCompressingStreambuf::BlockCompressingStreambuf(std::ostream& os, BlockCompression::Codec codec,
+                                                     std::size_t block_size/* = DEFAULT_BLOCK_SIZE*/) :
+    m_os(os),
+    m_codec(codec),
+    m_block_size(std::max<std::size_t>(1, std::min<std::size_t>(block_size, MAX_BLOCK_SIZE))),
+    m_block(m_block_size),
+    m_finishing(false)
+{
+    if (!BlockCompression::CodecAvailable(m_codec))
+        throw std::runtime_error("BlockCompressingStreambuf : codec " + BlockCompression::CodecName(m_codec) +
+                                 " is not available in this build");
+    setp(&m_block[0], &m_block[0] + m_block.size());
+    m_thread.reset(new boost::thread(boost::bind(&BlockCompressingStreambuf::CompressBlocks, this)));
+}
+
+BlockCompressingStreambuf::~BlockCompressingStreambuf() {
+    try {
+        Finish();
+    } catch (...) {}
+}
+
+void BlockCompressingStreambuf::Finish() {
+    if (!m_thread)
+        return;
+    QueueBlock();
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_finishing = true;
+    }
+    m_condition.notify_all();
+    m_thread->join();
+    m_thread.reset();
+    setp(0, 0);
+    if (!m_error.empty())
+        throw std::runtime_error(m_error);
+}
+
+BlockCompressingStreambuf::int_type BlockCompressingStreambuf::overflow(int_type c) {
+    if (!m_thread)
+        return traits_type::eof();
+    QueueBlock();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+void BlockCompressingStreambuf::QueueBlock() {
+    const std::size_t size = pptr() - pbase();
+    if (!size)
+        return;
+    {
+        boost::mutex::scoped_lock lock(m_mutex);
+        while (MAX_QUEUED_BLOCKS <= m_queued_blocks.size())
+            m_condition.wait(lock);
+        m_queued_blocks.push_back(std::make_pair(std::vector<char>(), size));
+        m_queued_blocks.back().first.swap(m_block);
+        if (!m_free_blocks.empty()) {
+            m_block.swap(m_free_blocks.back());
+            m_free_blocks.pop_back();
+        }
+    }
+    m_condition.notify_all();
+    m_block.resize(m_block_size);
+    setp(&m_block[0], &m_block[0] + m_block.size());
+}
+
+void BlockCompressingStreambuf::CompressBlocks() {
+    std::vector<char> compressed;
+    while (true) {
+        std::pair<std::vector<char>, std::size_t> block;
+        bool write = false;
+        {
+            boost::mutex::scoped_lock lock(m_mutex);
+            while (m_queued_blocks.empty() && !m_finishing)
+                m_condition.wait(lock);
+            if (m_queued_blocks.empty())
+                break;
+            block.first.swap(m_queued_blocks.front().first);
+            block.second = m_queued_blocks.front().second;
+            m_queued_blocks.pop_front();
+            // after an error, blocks are discarded so that the writing thread
+            // isn't left waiting for room in the queue
+            write = m_error.empty();
+        }
+        m_condition.notify_all();
+
+        if (write) {
+            try {
+                WriteBlock(block.first, block.second, compressed);
+            } catch (const std::exception& e) {
+                boost::mutex::scoped_lock lock(m_mutex);
+                m_error = e.what();
+            }
+        }
+
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_free_blocks.push_back(std::vector<char>());
+        m_free_blocks.back().swap(block.first);
+    }
+
+    // the end of the stream
+    if (m_error.empty()) {
+        char header[BLOCK_HEADER_SIZE] = { 0 };
+        if (!m_os.write(header, BLOCK_HEADER_SIZE))
+            m_error = "BlockCompressingStreambuf : unable to write to stream";
+    }
+}
+
+void BlockCompressingStreambuf::WriteBlock(const std::vector<char>& block, std::size_t size,
+                                           std::vector<char>& compressed)
+{
+    std::size_t compressed_size = size;
+    switch (m_codec) {
+    case BlockCompression::ZLIB_CODEC: {
+        uLongf dest_len = compressBound(size);
+        compressed.resize(BLOCK_HEADER_SIZE + dest_len);
+        // favour speed, as the point of compressing saves is to write them faster
+        if (compress2(reinterpret_cast<Bytef*>(&compressed[BLOCK_HEADER_SIZE]), &dest_len,
+                      reinterpret_cast<const Bytef*>(&block[0]), size, Z_BEST_SPEED) != Z_OK)
+        { throw std::runtime_error("BlockCompressingStreambuf : zlib failed to compress block"); }
+        compressed_size = dest_len;
+        break;
+    }
+#ifdef FREEORION_HAVE_LZ4
+    case BlockCompression::LZ4_CODEC: {
+        const int bound = LZ4_compressBound(static_cast<int>(size));
+        compressed.resize(BLOCK_HEADER_SIZE + bound);
+        const int result = LZ4_compress_default(&block[0], &compressed[BLOCK_HEADER_SIZE], static_cast<int>(size), bound);
+        if (result <= 0)
+            throw std::runtime_error("BlockCompressingStreambuf : LZ4 failed to compress block");
+        compressed_size = result;
+        break;
+    }
+#endif
+    default:
+        break;
+    }
+
+    // blocks that don't get smaller are stored as they are
+    if (size <= compressed_size) {
+        compressed.resize(BLOCK_HEADER_SIZE + size);
+        std::memcpy(&compressed[BLOCK_HEADER_SIZE], &block[0], size);
+        compressed_size = size;
+    }
+    PutUInt32(static_cast<boost::uint32_t>(size), &compressed[0]);
+    PutUInt32(static_cast<boost::uint32_t>(compressed_size), &compressed[4]);
+    if (!m_os.write(&compressed[0], BLOCK_HEADER_SIZE + compressed_size))
+        throw std::runtime_error("BlockCompressingStreambuf : unable to write to stream");
+}
+
+////////////////////////////////////////////////
+// BlockDecompressingStreambuf
+////////////////////////////////////////////////
+BlockDecompressingStreambuf::BlockDecompressingStreambuf(std::istream& is, BlockCompression::Codec codec) :
+    m_is(is),
+    m_codec(codec),
+    m_at_end(false)
+{
+    if (!BlockCompression::CodecAvailable(m_codec))
+        throw std::runtime_error("BlockDecompressingStreambuf : data is compressed with codec " +
+                                 BlockCompression::CodecName(m_codec) + ", which is not available in this build");
+    setg(0, 0, 0);
+}
+
+BlockDecompressingStreambuf::int_type BlockDecompressingStreambuf::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+    if (m_at_end)
+        return traits_type::eof();
+
+    char header[BLOCK_HEADER_SIZE];
+    if (!m_is.read(header, BLOCK_HEADER_SIZE))
+        throw std::runtime_error("BlockDecompressingStreambuf : compressed data is truncated");
+    const boost::uint32_t size = GetUInt32(header);
+    const boost::uint32_t stored_size = GetUInt32(header + 4);
+    if (!size) {
+        m_at_end = true;
+        return traits_type::eof();
+    }
+    if (MAX_BLOCK_SIZE < size || size < stored_size)
+        throw std::runtime_error("BlockDecompressingStreambuf : invalid block header");
+
+    m_block.resize(size);
+    if (stored_size == size) {
+        if (!m_is.read(&m_block[0], size))
+            throw std::runtime_error("BlockDecompressingStreambuf : compressed data is truncated");
+    } else {
+        m_compressed.resize(stored_size);
+        if (stored_size && !m_is.read(&m_compressed[0], stored_size))
+            throw std::runtime_error("BlockDecompressingStreambuf : compressed data is truncated");
+        switch (m_codec) {
+        case BlockCompression::ZLIB_CODEC: {
+            uLongf dest_len = size;
+            if (uncompress(reinterpret_cast<Bytef*>(&m_block[0]), &dest_len,
+                           reinterpret_cast<const Bytef*>(m_compressed.empty() ? 0 : &m_compressed[0]), stored_size) != Z_OK ||
+                dest_len != size)
+            { throw std::runtime_error("BlockDecompressingStreambuf : zlib failed to decompress block"); }
+            break;
+        }
+#ifdef FREEORION_HAVE_LZ4
+        case BlockCompression::LZ4_CODEC:
+            if (LZ4_decompress_safe(m_compressed.empty() ? 0 : &m_compressed[0], &m_block[0],
+                                    static_cast<int>(stored_size), static_cast<int>(size)) != static_cast<int>(size))
+            { throw std::runtime_error("BlockDecompressingStreambuf : LZ4 failed to decompress block"); }
+            break;
+#endif
+        default:
+            throw std::runtime_error("BlockDecompressingStreambuf : compressed block in uncompressed data");
+        }
+    }
+
+    setg(&m_block[0], &m_block[0], &m_block[0] + m_block.size());
+    return traits_type::to_int_type(*gptr());
+}
@@ -0,0 +1,106 @@
+// -*- C++ -*-
+#ifndef _BlockCompression_h_
+#define _BlockCompression_h_
+
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <deque>
+#include <iosfwd>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace boost { class thread; }
+
+
+/** \file
+  * Stream buffers that compress data written through them, and decompress it
+  * again, as a sequence of independently compressed blocks.  Each block is
+  * written as its uncompressed size and its stored size, as 32-bit
+  * little-endian integers, followed by its stored bytes.  A block whose stored
+  * size equals its uncompressed size is stored uncompressed.  A block with an
+  * uncompressed size of zero ends the stream, so that a compressed stream can
+  * be followed by other data. */
+
+namespace BlockCompression {
+    /** The codecs blocks can be compressed with.  These values are stored in
+      * files, so must not change. */
+    enum Codec {
+        NO_CODEC =      0,
+        ZLIB_CODEC =    1,
+        LZ4_CODEC =     2   ///< only available in builds with LZ4
+    };
+
+    /** Returns true iff \a codec can be used in this build. */
+    bool CodecAvailable(Codec codec);
+
+    /** Returns the codec named \a name ("none", "zlib" or "lz4"), or zlib for
+      * any other name, or if LZ4 is named and unavailable. */
+    Codec CodecFromName(const std::string& name);
+
+    /** Returns the name of \a codec, as accepted by CodecFromName(). */
+    std::string CodecName(Codec codec);
+}
+
+/** Output stream buffer that compresses what is written to it in blocks and
+  * writes them to another stream.  Compression and writing happen on a
+  * separate thread, so that the data can be produced while the previous
+  * blocks are compressed. */
+class BlockCompressingStreambuf : public std::streambuf {
+public:
+    BlockCompressingStreambuf(std::ostream& os, BlockCompression::Codec codec,
+                              std::size_t block_size = DEFAULT_BLOCK_SIZE);
+    ~BlockCompressingStreambuf();   ///< calls Finish(), ignoring errors
+
+    /** Compresses and writes the data not yet written, followed by the end of
+      * the stream, and waits until all of it has been written to the
+      * underlying stream.  Throws std::runtime_error if it could not be.
+      * Nothing more may be written through this buffer afterwards. */
+    void Finish();
+
+    static const std::size_t DEFAULT_BLOCK_SIZE = 1 << 20;
+
+protected:
+    virtual int_type        overflow(int_type c);
+
+private:
+    void    QueueBlock();       ///< passes the block being filled to the compression thread
+    void    CompressBlocks();   ///< the compression thread's function
+    void    WriteBlock(const std::vector<char>& block, std::size_t size, std::vector<char>& compressed);
+
+    std::ostream&                           m_os;
+    const BlockCompression::Codec           m_codec;
+    const std::size_t                       m_block_size;
+    std::vector<char>                       m_block;            ///< the block being filled
+
+    boost::mutex                            m_mutex;            ///< guards the members below
+    boost::condition_variable               m_condition;
+    std::deque<std::pair<std::vector<char>, std::size_t> > m_queued_blocks;    ///< full blocks and their sizes
+    std::vector<std::vector<char> >         m_free_blocks;      ///< blocks already written, for reuse
+    bool                                    m_finishing;
+    std::string                             m_error;
+
+    boost::scoped_ptr<boost::thread>        m_thread;
+};
+
+/** Input stream buffer that reads and decompresses blocks written by
+  * BlockCompressingStreambuf from another stream, up to the end of the
+  * compressed stream. */
+class BlockDecompressingStreambuf : public std::streambuf {
+public:
+    BlockDecompressingStreambuf(std::istream& is, BlockCompression::Codec codec);
+
+protected:
+    virtual int_type        underflow();
+
+private:
+    std::istream&                   m_is;
+    const BlockCompression::Codec   m_codec;
+    std::vector<char>               m_block;
+    std::vector<char>               m_compressed;
+    bool                            m_at_end;
+};
+
+#endif // _BlockCompression_h_
@@ -0,0 +1,151 @@
+#include "CompactArchive.h"
+
+#include <boost/archive/impl/archive_serializer_map.ipp>
+#include <boost/archive/impl/basic_binary_iarchive.ipp>
+#include <boost/archive/impl/basic_binary_iprimitive.ipp>
+#include <boost/archive/impl/basic_binary_oarchive.ipp>
+#include <boost/archive/impl/basic_binary_oprimitive.ipp>
+
+
+namespace {
+    unsigned long long ZigZagEncode(long long value)
+    { return (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63); }
+
+    long long ZigZagDecode(unsigned long long value)
+    { return static_cast<long long>(value >> 1) ^ -static_cast<long long>(value & 1); }
+
+    void ThrowInputStreamError()
+    {
+        boost::serialization::throw_exception(
+            boost::archive::archive_exception(boost::archive::archive_exception::input_stream_error));
+    }
+}
+
+////////////////////////////////////////////////
+// CompactOArchive
+////////////////////////////////////////////////
+CompactOArchive::CompactOArchive(std::ostream& os, unsigned int flags/* = 0*/) :
+    Base(os, flags)
+{ init(flags); }
+
+CompactOArchive::CompactOArchive(std::streambuf& sb, unsigned int flags/* = 0*/) :
+    Base(sb, flags)
+{ init(flags); }
+
+void CompactOArchive::save(const int& t)
+{ SaveVarint(ZigZagEncode(t)); }
+
+void CompactOArchive::save(const unsigned int& t)
+{ SaveVarint(t); }
+
+void CompactOArchive::save(const long long& t)
+{ SaveVarint(ZigZagEncode(t)); }
+
+void CompactOArchive::save(const unsigned long long& t)
+{ SaveVarint(t); }
+
+void CompactOArchive::save(const boost::serialization::collection_size_type& t)
+{ SaveVarint(static_cast<std::size_t>(t)); }
+
+void CompactOArchive::save(const boost::serialization::item_version_type& t)
+{ SaveVarint(static_cast<unsigned int>(t)); }
+
+void CompactOArchive::save(const std::string& s) {
+    // 0 precedes a string not yet in the dictionary; otherwise the index of
+    // the string plus one is written
+    std::map<std::string, unsigned int>::const_iterator it = m_string_indices.find(s);
+    if (it != m_string_indices.end()) {
+        SaveVarint(it->second + 1ull);
+        return;
+    }
+    const unsigned int index = static_cast<unsigned int>(m_string_indices.size());
+    m_string_indices[s] = index;
+    SaveVarint(0);
+    SaveVarint(s.size());
+    save_binary(s.data(), s.size());
+}
+
+void CompactOArchive::SaveVarint(unsigned long long value) {
+    unsigned char bytes[10];
+    std::size_t size = 0;
+    while (0x80 <= value) {
+        bytes[size++] = static_cast<unsigned char>(value | 0x80);
+        value >>= 7;
+    }
+    bytes[size++] = static_cast<unsigned char>(value);
+    save_binary(bytes, size);
+}
+
+////////////////////////////////////////////////
+// CompactIArchive
+////////////////////////////////////////////////
+CompactIArchive::CompactIArchive(std::istream& is, unsigned int flags/* = 0*/) :
+    Base(is, flags)
+{ init(flags); }
+
+CompactIArchive::CompactIArchive(std::streambuf& sb, unsigned int flags/* = 0*/) :
+    Base(sb, flags)
+{ init(flags); }
+
+void CompactIArchive::load(int& t)
+{ t = static_cast<int>(ZigZagDecode(LoadVarint())); }
+
+void CompactIArchive::load(unsigned int& t)
+{ t = static_cast<unsigned int>(LoadVarint()); }
+
+void CompactIArchive::load(long long& t)
+{ t = ZigZagDecode(LoadVarint()); }
+
+void CompactIArchive::load(unsigned long long& t)
+{ t = LoadVarint(); }
+
+void CompactIArchive::load(boost::serialization::collection_size_type& t)
+{ t = boost::serialization::collection_size_type(static_cast<std::size_t>(LoadVarint())); }
+
+void CompactIArchive::load(boost::serialization::item_version_type& t)
+{ t = boost::serialization::item_version_type(static_cast<unsigned int>(LoadVarint())); }
+
+void CompactIArchive::load(std::string& s) {
+    const unsigned long long index_plus_one = LoadVarint();
+    if (index_plus_one) {
+        if (m_strings.size() < index_plus_one)
+            ThrowInputStreamError();
+        s = m_strings[static_cast<std::size_t>(index_plus_one - 1)];
+        return;
+    }
+    const unsigned long long size = LoadVarint();
+    s.resize(static_cast<std::size_t>(size));
+    if (size)
+        load_binary(&s[0], static_cast<std::size_t>(size));
+    m_strings.push_back(s);
+}
+
+unsigned long long CompactIArchive::LoadVarint() {
+    unsigned long long value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        unsigned char byte = 0;
+        load_binary(&byte, 1);
+        value |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+    ThrowInputStreamError();
+    return value;
+}
+
+////////////////////////////////////////////////
+// Explicit Instantiations
+////////////////////////////////////////////////
+// these are the parts of the archives that Boost.Serialization only builds
+// into its library for its own archive types
+namespace boost { namespace archive {
+    template class detail::archive_serializer_map<CompactOArchive>;
+    template class basic_binary_oprimitive<CompactOArchive, char, std::char_traits<char> >;
+    template class basic_binary_oarchive<CompactOArchive>;
+    template class binary_oarchive_impl<CompactOArchive, char, std::char_traits<char> >;
+
+    template class detail::archive_serializer_map<CompactIArchive>;
+    template class basic_binary_iprimitive<CompactIArchive, char, std::char_traits<char> >;
+    template class basic_binary_iarchive<CompactIArchive>;
+    template class binary_iarchive_impl<CompactIArchive, char, std::char_traits<char> >;
+} }
@@ -0,0 +1,204 @@
+// -*- C++ -*-
+#ifndef _CompactArchive_h_
+#define _CompactArchive_h_
+
+#include <boost/archive/binary_iarchive_impl.hpp>
+#include <boost/archive/binary_oarchive_impl.hpp>
+#include <boost/archive/archive_exception.hpp>
+#include <boost/archive/detail/register_archive.hpp>
+#include <boost/mpl/bool.hpp>
+#include <boost/serialization/collection_size_type.hpp>
+#include <boost/serialization/item_version_type.hpp>
+#include <boost/serialization/level.hpp>
+#include <boost/serialization/serialization.hpp>
+#include <boost/serialization/tracking.hpp>
+#include <boost/serialization/version.hpp>
+#include <boost/type_traits/is_array.hpp>
+#include <boost/type_traits/is_enum.hpp>
+#include <boost/type_traits/is_pointer.hpp>
+#include <boost/type_traits/remove_const.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+
+/** \file
+  * Binary archives that store the universe in less space than
+  * boost::archive::binary_oarchive, selected in place of the binary archives
+  * by defining FREEORION_COMPACT_SERIALIZATION (see Serialize.h).  They
+  * differ from the binary archives in three ways:
+  *
+  * - ints, unsigned ints, long longs and collection sizes are written as
+  *   variable-length integers, so that ids, turns and small counts take one or
+  *   two bytes.  Signed values are zigzag-encoded, so INVALID_OBJECT_ID and
+  *   other small negative numbers are small too.
+  *
+  * - strings are dictionary-coded: the first occurrence of a string in an
+  *   archive is written in full, and later occurrences as its index.  Species,
+  *   special, hull and part names repeat throughout the universe.
+  *
+  * - objects of class types serialized by value rather than through a pointer
+  *   are not tracked, so no tracking flag is written for their class and
+  *   their addresses are not recorded.  Their class version is written once
+  *   per archive, as with the binary archives.  Objects that are pointed to
+  *   must be serialized through pointers, so that the pointers can be
+  *   restored; UniverseObjects and the other shared objects in FreeOrion are.
+  *
+  * Everything else, including pointer tracking and the archive header, is as
+  * in the binary archives.  Archives written by one kind cannot be read by
+  * the other. */
+
+namespace CompactArchiveDetail {
+    /** Orders type_infos, for recording the classes whose version has been
+      * written or read. */
+    struct TypeInfoLess {
+        bool operator()(const std::type_info* lhs, const std::type_info* rhs) const
+        { return lhs->before(*rhs) != 0; }
+    };
+
+    /** True for the types CompactOArchive and CompactIArchive serialize
+      * without tracking or per-object class information: classes serialized
+      * by value, whose serialization would otherwise be tracked if any are
+      * serialized through pointers. */
+    template <class T>
+    struct IsUntrackedValue :
+        boost::mpl::bool_<
+            !boost::is_pointer<T>::value &&
+            !boost::is_enum<T>::value &&
+            !boost::is_array<T>::value &&
+            boost::serialization::implementation_level<T>::value == boost::serialization::object_class_info &&
+            boost::serialization::tracking_level<T>::value == boost::serialization::track_selectively
+        >
+    {};
+}
+
+/** Output archive that writes compact binary archives; see CompactArchive.h. */
+class CompactOArchive :
+    public boost::archive::binary_oarchive_impl<CompactOArchive, char, std::char_traits<char> >
+{
+public:
+    typedef boost::archive::binary_oarchive_impl<CompactOArchive, char, std::char_traits<char> > Base;
+
+    explicit CompactOArchive(std::ostream& os, unsigned int flags = 0);
+    explicit CompactOArchive(std::streambuf& sb, unsigned int flags = 0);
+
+#ifndef BOOST_NO_MEMBER_TEMPLATE_FRIENDS
+protected:
+    friend class boost::archive::detail::interface_oarchive<CompactOArchive>;
+    friend class boost::archive::basic_binary_oarchive<CompactOArchive>;
+    friend class boost::archive::basic_binary_oprimitive<CompactOArchive, char, std::char_traits<char> >;
+    friend class boost::archive::save_access;
+#endif
+
+    template <class T>
+    void save_override(T& t)
+    { SaveOverride(t, CompactArchiveDetail::IsUntrackedValue<typename boost::remove_const<T>::type>()); }
+
+    template <class T>
+    void save(const T& t)
+    { Base::save(t); }
+
+    void save(const bool t)
+    { Base::save(t); }
+    void save(const int& t);
+    void save(const unsigned int& t);
+    void save(const long long& t);
+    void save(const unsigned long long& t);
+    void save(const boost::serialization::collection_size_type& t);
+    void save(const boost::serialization::item_version_type& t);
+    void save(const std::string& s);
+
+private:
+    template <class T>
+    void SaveOverride(T& t, boost::mpl::false_)
+    { Base::save_override(t); }
+
+    template <class T>
+    void SaveOverride(T& t, boost::mpl::true_)
+    {
+        typedef typename boost::remove_const<T>::type Value;
+        const unsigned int version = boost::serialization::version<Value>::value;
+        if (m_versioned_classes.insert(&typeid(Value)).second)
+            SaveVarint(version);
+        boost::serialization::serialize_adl(*this, const_cast<Value&>(t), version);
+    }
+
+    void SaveVarint(unsigned long long value);
+
+    std::map<std::string, unsigned int>                                         m_string_indices;
+    std::set<const std::type_info*, CompactArchiveDetail::TypeInfoLess>        m_versioned_classes;
+};
+
+/** Input archive that reads archives written by CompactOArchive. */
+class CompactIArchive :
+    public boost::archive::binary_iarchive_impl<CompactIArchive, char, std::char_traits<char> >
+{
+public:
+    typedef boost::archive::binary_iarchive_impl<CompactIArchive, char, std::char_traits<char> > Base;
+
+    explicit CompactIArchive(std::istream& is, unsigned int flags = 0);
+    explicit CompactIArchive(std::streambuf& sb, unsigned int flags = 0);
+
+#ifndef BOOST_NO_MEMBER_TEMPLATE_FRIENDS
+protected:
+    friend class boost::archive::detail::interface_iarchive<CompactIArchive>;
+    friend class boost::archive::basic_binary_iarchive<CompactIArchive>;
+    friend class boost::archive::basic_binary_iprimitive<CompactIArchive, char, std::char_traits<char> >;
+    friend class boost::archive::load_access;
+#endif
+
+    template <class T>
+    void load_override(T& t)
+    { LoadOverride(t, CompactArchiveDetail::IsUntrackedValue<T>()); }
+
+    template <class T>
+    void load(T& t)
+    { Base::load(t); }
+
+    void load(bool& t)
+    { Base::load(t); }
+    void load(int& t);
+    void load(unsigned int& t);
+    void load(long long& t);
+    void load(unsigned long long& t);
+    void load(boost::serialization::collection_size_type& t);
+    void load(boost::serialization::item_version_type& t);
+    void load(std::string& s);
+
+private:
+    template <class T>
+    void LoadOverride(T& t, boost::mpl::false_)
+    { Base::load_override(t); }
+
+    template <class T>
+    void LoadOverride(T& t, boost::mpl::true_)
+    {
+        unsigned int version = 0;
+        std::map<const std::type_info*, unsigned int, CompactArchiveDetail::TypeInfoLess>::const_iterator it =
+            m_class_versions.find(&typeid(T));
+        if (it != m_class_versions.end()) {
+            version = it->second;
+        } else {
+            version = static_cast<unsigned int>(LoadVarint());
+            if (boost::serialization::version<T>::value < version)
+                boost::serialization::throw_exception(
+                    boost::archive::archive_exception(boost::archive::archive_exception::unsupported_class_version,
+                                                      typeid(T).name()));
+            m_class_versions[&typeid(T)] = version;
+        }
+        boost::serialization::serialize_adl(*this, t, version);
+    }
+
+    unsigned long long LoadVarint();
+
+    std::vector<std::string>                                                        m_strings;
+    std::map<const std::type_info*, unsigned int, CompactArchiveDetail::TypeInfoLess> m_class_versions;
+};
+
+BOOST_SERIALIZATION_REGISTER_ARCHIVE(CompactOArchive)
+BOOST_SERIALIZATION_REGISTER_ARCHIVE(CompactIArchive)
+
+#endif // _CompactArchive_h_
@@ -5,7 +5,18 @@
 // Set this to true to do all serialization using binary archives.  Otherwise, XML archives will be used.
 #define FREEORION_BINARY_SERIALIZATION 1
 
-#if FREEORION_BINARY_SERIALIZATION
+// Define this to 1, along with FREEORION_BINARY_SERIALIZATION, to use the
+// compact binary archives in CompactArchive.h instead of the Boost binary
+// archives.  Saves and messages written with one cannot be read by the other.
+#ifndef FREEORION_COMPACT_SERIALIZATION
+#  define FREEORION_COMPACT_SERIALIZATION 0
+#endif
+
+#if FREEORION_BINARY_SERIALIZATION && FREEORION_COMPACT_SERIALIZATION
+#  include "CompactArchive.h"
+#  define FREEORION_IARCHIVE_TYPE CompactIArchive
+#  define FREEORION_OARCHIVE_TYPE CompactOArchive
+#elif FREEORION_BINARY_SERIALIZATION
 #  include <boost/archive/binary_iarchive.hpp>
 #  include <boost/archive/binary_oarchive.hpp>
 #  define FREEORION_IARCHIVE_TYPE boost::archive::binary_iarchive
@@ -17,14 +28,87 @@
 #  define FREEORION_OARCHIVE_TYPE boost::archive::xml_oarchive
 #endif
 
+// Define FREEORION_ALTERNATE_ARCHIVES, along with
+// FREEORION_BINARY_SERIALIZATION, to also instantiate the serialization of
+// ObjectMap, ShipDesign and Empire for whichever binary archives are not
+// selected above, so that both can be tested against the game's own classes.
+#if FREEORION_BINARY_SERIALIZATION && defined(FREEORION_ALTERNATE_ARCHIVES)
+#  if FREEORION_COMPACT_SERIALIZATION
+#    include <boost/archive/binary_iarchive.hpp>
+#    include <boost/archive/binary_oarchive.hpp>
+#    define FREEORION_ALTERNATE_IARCHIVE_TYPE boost::archive::binary_iarchive
+#    define FREEORION_ALTERNATE_OARCHIVE_TYPE boost::archive::binary_oarchive
+#  else
+#    include "CompactArchive.h"
+#    define FREEORION_ALTERNATE_IARCHIVE_TYPE CompactIArchive
+#    define FREEORION_ALTERNATE_OARCHIVE_TYPE CompactOArchive
+#  endif
+#endif
+
+#include <boost/cstdint.hpp>
+
 #include <vector>
 #include <map>
+#include <set>
 
+class EmpireManager;
+class ObjectMap;
 class OrderSet;
 class PathingEngine;
 class Universe;
 class UniverseObject;
 
+/** 64-bit digest of serialized gamestate, by which TurnUpdateBaseline
+  * records what was sent. */
+typedef boost::uint64_t TurnUpdateDigest;
+
+/** What the server last sent to one client of the gamestate known to that
+  * client's empire, recorded so that later TURN_UPDATE and TURN_PARTIAL_UPDATE
+  * messages to the client need only contain what has changed since.  Objects,
+  * ship designs and empires are recorded as digests of their serialized
+  * forms, so that anything that would serialize differently is resent.  Each
+  * update also carries a digest of the whole state sent, which the client
+  * checks its own state against after applying it, so that a client left
+  * with a different state, however that came about, asks for a full snapshot
+  * instead of carrying on with it.  An empty baseline causes the next update
+  * to be a full snapshot. */
+struct TurnUpdateBaseline {
+    TurnUpdateBaseline();
+
+    /** Returns true if nothing has been recorded since construction or the
+      * last Clear(), meaning the next update must be a full snapshot. */
+    bool    Empty() const;
+
+    /** Returns true if the next TURN_UPDATE can be sent as a delta: there is
+      * a baseline to send it against, and the client acknowledged applying
+      * the last TURN_UPDATE. */
+    bool    DeltaAllowed() const;
+
+    /** Forgets everything recorded, so that the next update is a full
+      * snapshot.  Update numbers keep counting up, so that acknowledgements of
+      * updates sent before the Clear() can be recognized as stale. */
+    void    Clear();
+
+    int                             next_update_number;         ///< number to give the next update sent to the client
+    int                             last_update_number;         ///< number of the last update recorded, or INVALID_TURN_UPDATE_NUMBER if empty
+    int                             snapshot_update_number;     ///< number of the full snapshot the recorded updates are deltas against
+    int                             turn_update_number;         ///< number of the last TURN_UPDATE (rather than TURN_PARTIAL_UPDATE) recorded
+    int                             turn;                       ///< turn of the last TURN_UPDATE recorded
+    int                             acknowledged_turn;          ///< turn of the last TURN_UPDATE the client acknowledged applying
+
+    std::map<int, TurnUpdateDigest> objects;                    ///< digests of objects, keyed by object id
+    std::map<int, TurnUpdateDigest> object_visibilities;        ///< digests of the empire's visibility of objects, keyed by object id
+    std::map<int, TurnUpdateDigest> object_visibility_turns;    ///< digests of the turns on which the empire last saw objects, keyed by object id
+    std::set<int>                   destroyed_object_ids;       ///< ids of objects the empire knows to be destroyed
+    std::set<int>                   stale_object_ids;           ///< ids of objects the empire has stale knowledge of
+    std::map<int, TurnUpdateDigest> ship_designs;               ///< digests of ship designs, keyed by design id
+    std::map<int, TurnUpdateDigest> empires;                    ///< digests of empires, keyed by empire id
+};
+
+/** Update number of a turn update that is not a delta against, or recorded
+  * in, any TurnUpdateBaseline. */
+extern const int INVALID_TURN_UPDATE_NUMBER;
+
 // NB: Do not try to serialize types that contain longs, since longs are different sizes on 32- and 64-bit
 // architectures.  Replace your longs with long longs for portability.  See longer note in Serialize.cpp for more info.
 
@@ -34,18 +118,73 @@ void Serialize(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe);
 /** Serializes \a object_map to output archive \a oa. */
 void Serialize(FREEORION_OARCHIVE_TYPE& oa, const std::map<int, UniverseObject*>& objects);
 
+/** Serializes \a objects to output archive \a oa. */
+void Serialize(FREEORION_OARCHIVE_TYPE& oa, const ObjectMap& objects);
+
+/** Serializes \a universe to output archive \a oa, except for the latest
+  * known objects of empires, which save files store separately.  Each object
+  * is written as a separate record, which SerializeEmpireKnownObjectDifferences()
+  * then encodes the empires' versions of it against. */
+void SerializeWithoutEmpireKnownObjects(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe);
+
 /** Serializes \a order_set to output archive \a oa. */
 void Serialize(FREEORION_OARCHIVE_TYPE& oa, const OrderSet& order_set);
 
 /** Serializes \a pathing_engine to output archive \a oa. */
 void Serialize(FREEORION_OARCHIVE_TYPE& oa, const PathingEngine& pathing_engine);
 
+/** Serializes the latest known objects of all empires in \a universe to
+  * output archive \a oa, each as what differs between it and the record of
+  * the same object just written by SerializeWithoutEmpireKnownObjects() or
+  * as known to another empire.  This is much smaller than
+  * each empire's ObjectMap serialized on its own when, as is usual, most of
+  * what empires know about is unchanged or slightly stale. */
+void SerializeEmpireKnownObjectDifferences(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe);
+
+/** Serializes to output archive \a oa what has changed in \a universe, as
+  * known to the current encoding empire, since the state recorded in
+  * \a baseline, and records the serialized state in \a baseline.  If
+  * \a baseline is empty, everything is serialized, along with an instruction
+  * to the receiver to discard its previous contents. */
+void SerializeDelta(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe, TurnUpdateBaseline& baseline);
+
+/** Serializes to output archive \a oa what has changed in \a empires, as
+  * known to the current encoding empire, since the state recorded in
+  * \a baseline, and records the serialized state in \a baseline. */
+void SerializeDelta(FREEORION_OARCHIVE_TYPE& oa, const EmpireManager& empires, TurnUpdateBaseline& baseline);
+
 /** Deserializes \a universe from input archive \a ia. */
 void Deserialize(FREEORION_IARCHIVE_TYPE& ia, Universe& universe);
 
+/** Applies to \a universe changes serialized by SerializeDelta.  Returns
+  * false if \a universe then differs from what the server serialized, in
+  * which case it needs to be replaced by a full snapshot. */
+bool DeserializeDelta(FREEORION_IARCHIVE_TYPE& ia, Universe& universe);
+
+/** Applies to \a empires changes serialized by SerializeDelta.  Returns false
+  * if \a empires then differs from what the server serialized, in which case
+  * it needs to be replaced by a full snapshot. */
+bool DeserializeDelta(FREEORION_IARCHIVE_TYPE& ia, EmpireManager& empires);
+
 /** Serializes \a object_map from input archive \a ia. */
 void Deserialize(FREEORION_IARCHIVE_TYPE& ia, std::map<int, UniverseObject*>& objects);
 
+/** Deserializes \a objects from input archive \a ia. */
+void Deserialize(FREEORION_IARCHIVE_TYPE& ia, ObjectMap& objects);
+
+/** Deserializes \a universe, as serialized by
+  * SerializeWithoutEmpireKnownObjects(), from input archive \a ia.
+  * \a object_records is false for archives written before objects were
+  * stored as separate records, which hold an ObjectMap instead. */
+void DeserializeWithoutEmpireKnownObjects(FREEORION_IARCHIVE_TYPE& ia, Universe& universe, bool object_records);
+
+/** Deserializes into \a universe the latest known objects of empires, as
+  * serialized by SerializeEmpireKnownObjectDifferences(), from input archive
+  * \a ia.  The differences are decoded against the object records read by
+  * DeserializeWithoutEmpireKnownObjects(), so this must follow it.  Each
+  * empire's objects are only decoded when first needed. */
+void DeserializeEmpireKnownObjectDifferences(FREEORION_IARCHIVE_TYPE& ia, Universe& universe);
+
 /** Deserializes \a order_set from input archive \a ia. */
 void Deserialize(FREEORION_IARCHIVE_TYPE& ia, OrderSet& order_set);
 
@@ -13,6 +13,11 @@
 #include <boost/serialization/weak_ptr.hpp>
 #include <boost/ptr_container/serialize_ptr_vector.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+
 // some endianness and size checks to ensure portability of binary save files;
 // of one or more of these fails, it means that FreeOrion is not supported on
 // your platform/compiler pair, and must be modified to provide data of the
@@ -49,3 +54,128 @@ namespace boost { namespace serialization {
     }
 
 } }
+
+// helpers for the delta encoding of turn updates; see TurnUpdateBaseline
+namespace {
+    /** Returns \a t serialized on its own, without an archive header, so that
+      * it can be checksummed and embedded as a string in a delta update. */
+    template <class T>
+    std::string SerializeStandalone(const T& t)
+    {
+        std::ostringstream os;
+        {
+            FREEORION_OARCHIVE_TYPE oa(os, boost::archive::no_header);
+            oa << BOOST_SERIALIZATION_NVP(t);
+        }
+        return os.str();
+    }
+
+    /** Deserializes \a t from \a str, as produced by SerializeStandalone(). */
+    template <class T>
+    void DeserializeStandalone(const std::string& str, T& t)
+    {
+        std::istringstream is(str);
+        FREEORION_IARCHIVE_TYPE ia(is, boost::archive::no_header);
+        ia >> BOOST_SERIALIZATION_NVP(t);
+    }
+
+    /** Returns the digest of the \a size bytes at \a data, continuing from
+      * \a seed so that digests of several pieces of data can be chained.
+      * This is MurmurHash64A, whose 64 well-mixed bits make it vanishingly
+      * unlikely that a change to an item goes unnoticed. */
+    inline TurnUpdateDigest Digest(const char* data, std::size_t size, TurnUpdateDigest seed = 0)
+    {
+        const TurnUpdateDigest M = 0xc6a4a7935bd1e995ULL;
+        const int R = 47;
+
+        TurnUpdateDigest h = seed ^ (static_cast<TurnUpdateDigest>(size) * M);
+        const char* end = data + (size & ~static_cast<std::size_t>(7));
+        for (; data != end; data += 8) {
+            TurnUpdateDigest k;
+            std::memcpy(&k, data, sizeof(k));   // little endian; see checks above
+            k *= M;
+            k ^= k >> R;
+            k *= M;
+            h ^= k;
+            h *= M;
+        }
+        switch (size & 7) {
+        case 7: h ^= static_cast<TurnUpdateDigest>(static_cast<unsigned char>(data[6])) << 48;
+        case 6: h ^= static_cast<TurnUpdateDigest>(static_cast<unsigned char>(data[5])) << 40;
+        case 5: h ^= static_cast<TurnUpdateDigest>(static_cast<unsigned char>(data[4])) << 32;
+        case 4: h ^= static_cast<TurnUpdateDigest>(static_cast<unsigned char>(data[3])) << 24;
+        case 3: h ^= static_cast<TurnUpdateDigest>(static_cast<unsigned char>(data[2])) << 16;
+        case 2: h ^= static_cast<TurnUpdateDigest>(static_cast<unsigned char>(data[1])) << 8;
+        case 1: h ^= static_cast<TurnUpdateDigest>(static_cast<unsigned char>(data[0]));
+                h *= M;
+        }
+        h ^= h >> R;
+        h *= M;
+        h ^= h >> R;
+        return h;
+    }
+
+    inline TurnUpdateDigest Digest(const std::string& str)
+    { return Digest(str.data(), str.size()); }
+
+    /** Returns the digest of \a value, which must be of a type without
+      * padding or pointers, such as int, continuing from \a seed. */
+    template <class T>
+    TurnUpdateDigest DigestValue(const T& value, TurnUpdateDigest seed)
+    { return Digest(reinterpret_cast<const char*>(&value), sizeof(value), seed); }
+
+    /** Returns the digest of the ids and digests in \a digests, continuing
+      * from \a seed; the digest of the state they are digests of. */
+    inline TurnUpdateDigest Digest(const std::map<int, TurnUpdateDigest>& digests, TurnUpdateDigest seed)
+    {
+        seed = DigestValue(static_cast<boost::uint64_t>(digests.size()), seed);
+        for (std::map<int, TurnUpdateDigest>::const_iterator it = digests.begin(); it != digests.end(); ++it) {
+            seed = DigestValue(it->first, seed);
+            seed = DigestValue(it->second, seed);
+        }
+        return seed;
+    }
+
+    /** Returns the digest of the ids in \a ids, continuing from \a seed. */
+    inline TurnUpdateDigest Digest(const std::set<int>& ids, TurnUpdateDigest seed)
+    {
+        seed = DigestValue(static_cast<boost::uint64_t>(ids.size()), seed);
+        for (std::set<int>::const_iterator it = ids.begin(); it != ids.end(); ++it)
+            seed = DigestValue(*it, seed);
+        return seed;
+    }
+
+    /** Records in \a digests the digest of \a str, the serialized form of
+      * the item with id \a id, and appends \a str to \a changed if that
+      * digest differs from the one for \a id in \a old_digests. */
+    inline void AddIfChanged(int id, const std::string& str, const std::map<int, TurnUpdateDigest>& old_digests,
+                             std::map<int, TurnUpdateDigest>& digests, std::vector<std::string>& changed)
+    {
+        TurnUpdateDigest digest = Digest(str);
+        digests[id] = digest;
+        std::map<int, TurnUpdateDigest>::const_iterator it = old_digests.find(id);
+        if (it == old_digests.end() || it->second != digest)
+            changed.push_back(str);
+    }
+
+    /** Fills \a removed with the keys of \a old_map that are not in \a map. */
+    template <class T, class U>
+    void GetRemovedKeys(const std::map<int, T>& old_map, const std::map<int, U>& map, std::set<int>& removed)
+    {
+        for (typename std::map<int, T>::const_iterator it = old_map.begin(); it != old_map.end(); ++it)
+            if (map.find(it->first) == map.end())
+                removed.insert(it->first);
+    }
+
+    /** Fills \a added with the elements of \a set not in \a old_set, and
+      * \a removed with the elements of \a old_set not in \a set. */
+    template <class T>
+    void GetSetChanges(const std::set<T>& old_set, const std::set<T>& set,
+                       std::set<T>& added, std::set<T>& removed)
+    {
+        std::set_difference(set.begin(), set.end(), old_set.begin(), old_set.end(),
+                            std::inserter(added, added.end()));
+        std::set_difference(old_set.begin(), old_set.end(), set.begin(), set.end(),
+                            std::inserter(removed, removed.end()));
+    }
+}
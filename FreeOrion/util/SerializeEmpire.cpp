@@ -114,6 +114,11 @@ void Empire::serialize(Archive& ar, const unsigned int version)
 template void Empire::serialize<FREEORION_OARCHIVE_TYPE>(FREEORION_OARCHIVE_TYPE&, const unsigned int);
 template void Empire::serialize<FREEORION_IARCHIVE_TYPE>(FREEORION_IARCHIVE_TYPE&, const unsigned int);
 
+#ifdef FREEORION_ALTERNATE_OARCHIVE_TYPE
+template void Empire::serialize<FREEORION_ALTERNATE_OARCHIVE_TYPE>(FREEORION_ALTERNATE_OARCHIVE_TYPE&, const unsigned int);
+template void Empire::serialize<FREEORION_ALTERNATE_IARCHIVE_TYPE>(FREEORION_ALTERNATE_IARCHIVE_TYPE&, const unsigned int);
+#endif
+
 template <class Archive>
 void EmpireManager::serialize(Archive& ar, const unsigned int version)
 {
@@ -137,6 +142,90 @@ void EmpireManager::serialize(Archive& ar, const unsigned int version)
 template void EmpireManager::serialize<FREEORION_OARCHIVE_TYPE>(FREEORION_OARCHIVE_TYPE&, const unsigned int);
 template void EmpireManager::serialize<FREEORION_IARCHIVE_TYPE>(FREEORION_IARCHIVE_TYPE&, const unsigned int);
 
+template <class Archive>
+void EmpireManager::SerializeDelta(Archive& ar, TurnUpdateBaseline& baseline) const
+{
+    bool full_snapshot = baseline.Empty();
+
+    // the encoding empire is always resent, as its client executes orders,
+    // such as production queue changes, on its own copy of it
+    const int encoding_empire = GetUniverse().EncodingEmpire();
+    const std::map<int, TurnUpdateDigest> NO_DIGESTS;
+
+    std::map<int, TurnUpdateDigest> empire_digests;
+    std::vector<std::string> changed_empires;
+    std::set<int> removed_empire_ids;
+    for (std::map<int, Empire*>::const_iterator it = m_empire_map.begin(); it != m_empire_map.end(); ++it)
+        AddIfChanged(it->first, SerializeStandalone(it->second),
+                     it->first == encoding_empire ? NO_DIGESTS : baseline.empires,
+                     empire_digests, changed_empires);
+    GetRemovedKeys(baseline.empires, empire_digests, removed_empire_ids);
+
+    std::map<std::pair<int, int>, DiplomaticMessage> messages;
+    GetDiplomaticMessagesToSerialize(messages, encoding_empire);
+    TurnUpdateDigest state_digest = Digest(empire_digests, 0);
+
+    ar  << BOOST_SERIALIZATION_NVP(full_snapshot)
+        << BOOST_SERIALIZATION_NVP(changed_empires)
+        << BOOST_SERIALIZATION_NVP(removed_empire_ids)
+        << BOOST_SERIALIZATION_NVP(m_eliminated_empires)
+        << BOOST_SERIALIZATION_NVP(m_empire_diplomatic_statuses)
+        << BOOST_SERIALIZATION_NVP(messages)
+        << BOOST_SERIALIZATION_NVP(state_digest);
+
+    baseline.empires.swap(empire_digests);
+}
+
+template <class Archive>
+bool EmpireManager::DeserializeDelta(Archive& ar)
+{
+    bool full_snapshot;
+    std::vector<std::string> changed_empires;
+    std::set<int> removed_empire_ids;
+    std::map<std::pair<int, int>, DiplomaticMessage> messages;
+    TurnUpdateDigest state_digest;
+
+    ar  >> BOOST_SERIALIZATION_NVP(full_snapshot)
+        >> BOOST_SERIALIZATION_NVP(changed_empires)
+        >> BOOST_SERIALIZATION_NVP(removed_empire_ids);
+
+    if (full_snapshot)
+        Clear();
+
+    ar  >> BOOST_SERIALIZATION_NVP(m_eliminated_empires)
+        >> BOOST_SERIALIZATION_NVP(m_empire_diplomatic_statuses)
+        >> BOOST_SERIALIZATION_NVP(messages)
+        >> BOOST_SERIALIZATION_NVP(state_digest);
+    m_diplomatic_messages = messages;
+
+    for (std::set<int>::const_iterator it = removed_empire_ids.begin(); it != removed_empire_ids.end(); ++it) {
+        std::map<int, Empire*>::iterator empire_it = m_empire_map.find(*it);
+        if (empire_it != m_empire_map.end()) {
+            delete empire_it->second;
+            m_empire_map.erase(empire_it);
+        }
+    }
+    for (std::vector<std::string>::const_iterator it = changed_empires.begin(); it != changed_empires.end(); ++it) {
+        Empire* empire = 0;
+        DeserializeStandalone(*it, empire);
+        if (!empire)
+            continue;
+        Empire*& stored_empire = m_empire_map[empire->EmpireID()];
+        delete stored_empire;
+        stored_empire = empire;
+    }
+
+    // check the result against what the server serialized
+    std::map<int, TurnUpdateDigest> empire_digests;
+    for (std::map<int, Empire*>::const_iterator it = m_empire_map.begin(); it != m_empire_map.end(); ++it)
+        empire_digests[it->first] = Digest(SerializeStandalone(it->second));
+    if (state_digest != Digest(empire_digests, 0)) {
+        Logger().errorStream() << "EmpireManager::DeserializeDelta : state differs from the server's after applying update";
+        return false;
+    }
+    return true;
+}
+
 template <class Archive>
 void DiplomaticMessage::serialize(Archive& ar, const unsigned int version)
 {
@@ -148,6 +237,11 @@ void DiplomaticMessage::serialize(Archive& ar, const unsigned int version)
 template void DiplomaticMessage::serialize<FREEORION_OARCHIVE_TYPE>(FREEORION_OARCHIVE_TYPE&, const unsigned int);
 template void DiplomaticMessage::serialize<FREEORION_IARCHIVE_TYPE>(FREEORION_IARCHIVE_TYPE&, const unsigned int);
 
+void SerializeDelta(FREEORION_OARCHIVE_TYPE& oa, const EmpireManager& empires, TurnUpdateBaseline& baseline)
+{ empires.SerializeDelta(oa, baseline); }
+
+bool DeserializeDelta(FREEORION_IARCHIVE_TYPE& ia, EmpireManager& empires)
+{ return empires.DeserializeDelta(ia); }
 
 #if 0
 void Serialize(FREEORION_OARCHIVE_TYPE& oa, const Empire& empire)
@@ -32,7 +32,6 @@ template <class Archive>
 void CombatShip::serialize(Archive& ar, const unsigned int version)
 {
     ar  & BOOST_SERIALIZATION_BASE_OBJECT_NVP(CombatObject)
-        & BOOST_SERIALIZATION_NVP(m_proximity_token)
         & BOOST_SERIALIZATION_NVP(m_empire_id)
         & BOOST_SERIALIZATION_NVP(m_ship_id)
         & BOOST_SERIALIZATION_NVP(m_last_steer)
@@ -73,7 +72,6 @@ template <class Archive>
 void CombatFighter::serialize(Archive& ar, const unsigned int version)
 {
     ar  & BOOST_SERIALIZATION_BASE_OBJECT_NVP(CombatObject)
-        & BOOST_SERIALIZATION_NVP(m_proximity_token)
         & BOOST_SERIALIZATION_NVP(m_leader)
         & BOOST_SERIALIZATION_NVP(m_part_name)
         & BOOST_SERIALIZATION_NVP(m_empire_id)
@@ -99,7 +97,6 @@ template <class Archive>
 void Missile::serialize(Archive& ar, const unsigned int version)
 {
     ar  & BOOST_SERIALIZATION_BASE_OBJECT_NVP(CombatObject)
-        & BOOST_SERIALIZATION_NVP(m_proximity_token)
         & BOOST_SERIALIZATION_NVP(m_empire_id)
         & BOOST_SERIALIZATION_NVP(m_last_steer)
         & BOOST_SERIALIZATION_NVP(m_destination)
@@ -131,10 +128,22 @@ void PathingEngine::serialize(Archive& ar, const unsigned int version)
         & BOOST_SERIALIZATION_NVP(m_obstacles);
 
     if (Archive::is_loading::value) {
+        std::map<OpenSteer::AbstractVehicle*, ProximityDBToken*> proximity_tokens;
+        m_proximity_database->Tokens(proximity_tokens);
+
+        m_batched_obstacles.clear();
+        for (ObstacleVec::const_iterator it = m_obstacles.begin(); it != m_obstacles.end(); ++it)
+            m_batched_obstacles.push_back(&*it);
+
         m_objects.swap(objects);
         for (std::set<CombatObjectPtr>::iterator it = m_objects.begin();
              it != m_objects.end();
              ++it) {
+            std::map<OpenSteer::AbstractVehicle*, ProximityDBToken*>::iterator token_it =
+                proximity_tokens.find(it->get());
+            if (token_it != proximity_tokens.end())
+                (*it)->SetProximityToken(token_it->second);
+
             if ((*it)->IsShip()) {
                 assert(boost::dynamic_pointer_cast<CombatShip>(*it));
                 CombatShipPtr ship = boost::static_pointer_cast<CombatShip>(*it);
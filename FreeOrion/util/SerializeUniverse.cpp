@@ -9,6 +9,12 @@
 #include "../universe/ShipDesign.h"
 #include "../universe/System.h"
 #include "../universe/Field.h"
+#include "OptionsDB.h"
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/thread.hpp>
 
 BOOST_CLASS_EXPORT(System)
 BOOST_CLASS_EXPORT(Field)
@@ -20,10 +26,176 @@ BOOST_CLASS_VERSION(Ship, 1)
 //BOOST_CLASS_EXPORT(ShipDesign)
 //BOOST_CLASS_VERSION(ShipDesign, 1)
 
+const int INVALID_TURN_UPDATE_NUMBER = -1;
+
+namespace {
+    void AddOptions(OptionsDB& db) {
+        db.Add("serialization-object-chunk-size", "OPTIONS_DB_SERIALIZATION_OBJECT_CHUNK_SIZE", 0, RangedValidator<int>(0, 1 << 20));
+        db.Add("deserialization-threads", "OPTIONS_DB_DESERIALIZATION_THREADS", 1, RangedValidator<int>(0, 64));
+    }
+    bool temp_bool = RegisterOptions(&AddOptions);
+
+    /** Deserializes every \a stride'th of \a records, starting with the
+      * \a first, into the corresponding element of \a results; one of the
+      * threads run by DeserializeConcurrently(). */
+    template <class T>
+    struct StandaloneDeserializer {
+        StandaloneDeserializer(const std::vector<std::string>& records, std::vector<T>& results,
+                               std::vector<std::string>& errors, std::size_t first, std::size_t stride) :
+            m_records(&records),
+            m_results(&results),
+            m_errors(&errors),
+            m_first(first),
+            m_stride(stride)
+        {}
+
+        void operator()() const {
+            for (std::size_t i = m_first; i < m_records->size(); i += m_stride) {
+                try {
+                    DeserializeStandalone((*m_records)[i], (*m_results)[i]);
+                } catch (const std::exception& e) {
+                    (*m_errors)[i] = e.what();
+                } catch (...) {
+                    (*m_errors)[i] = "unknown exception";
+                }
+            }
+        }
+
+        const std::vector<std::string>* m_records;
+        std::vector<T>*                 m_results;
+        std::vector<std::string>*       m_errors;
+        std::size_t                     m_first;
+        std::size_t                     m_stride;
+    };
+
+    /** Deserializes each of \a records, as produced by SerializeStandalone(),
+      * into the corresponding element of \a results, on up to
+      * deserialization-threads threads at once, each given at least
+      * \a min_records_per_thread records.  Throws std::runtime_error if any
+      * record can't be deserialized, once all have been tried, leaving the
+      * results of the others in \a results. */
+    template <class T>
+    void DeserializeConcurrently(const std::vector<std::string>& records, std::vector<T>& results,
+                                 std::size_t min_records_per_thread)
+    {
+        results.resize(records.size());
+        std::vector<std::string> errors(records.size());
+
+        std::size_t threads = GetOptionsDB().Get<int>("deserialization-threads");
+        if (!threads)
+            threads = std::max(1u, boost::thread::hardware_concurrency());
+        threads = std::min(threads, records.size() / std::max<std::size_t>(1, min_records_per_thread));
+
+        if (threads <= 1) {
+            StandaloneDeserializer<T>(records, results, errors, 0, 1)();
+        } else {
+            boost::thread_group thread_group;
+            for (std::size_t i = 0; i < threads; ++i)
+                thread_group.create_thread(StandaloneDeserializer<T>(records, results, errors, i, threads));
+            thread_group.join_all();
+        }
+
+        for (std::size_t i = 0; i < errors.size(); ++i)
+            if (!errors[i].empty())
+                throw std::runtime_error("DeserializeConcurrently : " + errors[i]);
+    }
+
+    /** Records of single objects, as in turn updates, are deserialized on
+      * more than one thread only if each thread gets at least this many. */
+    const std::size_t MIN_OBJECT_RECORDS_PER_THREAD = 256;
+
+    /** Splits \a objects into chunks of serialization-object-chunk-size
+      * objects, each serialized on its own with SerializeStandalone(), so
+      * that they can be deserialized concurrently. */
+    void SerializeObjectChunks(const std::map<int, UniverseObject*>& objects, std::vector<std::string>& chunks) {
+        const std::size_t chunk_size = GetOptionsDB().Get<int>("serialization-object-chunk-size");
+        std::map<int, UniverseObject*> chunk;
+        for (std::map<int, UniverseObject*>::const_iterator it = objects.begin(); it != objects.end(); ++it) {
+            chunk.insert(chunk.end(), *it);
+            if (chunk.size() == chunk_size) {
+                chunks.push_back(SerializeStandalone(chunk));
+                chunk.clear();
+            }
+        }
+        if (!chunk.empty())
+            chunks.push_back(SerializeStandalone(chunk));
+    }
+
+    /** Replaces the contents of \a objects with the objects in \a chunks, as
+      * serialized by SerializeObjectChunks().  Each thread deserializes whole
+      * chunks into maps of its own, which are then merged, so no locking is
+      * needed. */
+    void DeserializeObjectChunks(const std::vector<std::string>& chunks, std::map<int, UniverseObject*>& objects) {
+        objects.clear();
+        std::vector<std::map<int, UniverseObject*> > chunk_objects;
+        try {
+            DeserializeConcurrently(chunks, chunk_objects, 1);
+        } catch (...) {
+            for (std::size_t i = 0; i < chunk_objects.size(); ++i)
+                for (std::map<int, UniverseObject*>::iterator it = chunk_objects[i].begin(); it != chunk_objects[i].end(); ++it)
+                    delete it->second;
+            throw;
+        }
+        // chunks hold consecutive ranges of ids, so each is inserted at the end
+        for (std::size_t i = 0; i < chunk_objects.size(); ++i)
+            for (std::map<int, UniverseObject*>::const_iterator it = chunk_objects[i].begin(); it != chunk_objects[i].end(); ++it)
+                objects.insert(objects.end(), *it);
+    }
+}
+
+TurnUpdateBaseline::TurnUpdateBaseline() :
+    next_update_number(0),
+    last_update_number(INVALID_TURN_UPDATE_NUMBER),
+    snapshot_update_number(INVALID_TURN_UPDATE_NUMBER),
+    turn_update_number(INVALID_TURN_UPDATE_NUMBER),
+    turn(INVALID_GAME_TURN),
+    acknowledged_turn(INVALID_GAME_TURN)
+{}
+
+bool TurnUpdateBaseline::Empty() const
+{ return last_update_number == INVALID_TURN_UPDATE_NUMBER; }
+
+bool TurnUpdateBaseline::DeltaAllowed() const
+{ return !Empty() && turn != INVALID_GAME_TURN && acknowledged_turn == turn; }
+
+void TurnUpdateBaseline::Clear() {
+    last_update_number = INVALID_TURN_UPDATE_NUMBER;
+    snapshot_update_number = INVALID_TURN_UPDATE_NUMBER;
+    turn_update_number = INVALID_TURN_UPDATE_NUMBER;
+    turn = INVALID_GAME_TURN;
+    acknowledged_turn = INVALID_GAME_TURN;
+    objects.clear();
+    object_visibilities.clear();
+    object_visibility_turns.clear();
+    destroyed_object_ids.clear();
+    stale_object_ids.clear();
+    ship_designs.clear();
+    empires.clear();
+}
+
 template <class Archive>
 void ObjectMap::serialize(Archive& ar, const unsigned int version)
 {
-    ar & BOOST_SERIALIZATION_NVP(m_objects);
+    // Version 1 added the option of serializing the objects as a sequence of
+    // separately serialized chunks, which are deserialized concurrently.
+    bool chunked = false;
+    if (Archive::is_saving::value) {
+        const std::size_t chunk_size = GetOptionsDB().Get<int>("serialization-object-chunk-size");
+        chunked = chunk_size && chunk_size < m_objects.size();
+    }
+    if (1 <= version)
+        ar & BOOST_SERIALIZATION_NVP(chunked);
+
+    if (!chunked) {
+        ar & BOOST_SERIALIZATION_NVP(m_objects);
+    } else {
+        std::vector<std::string> chunks;
+        if (Archive::is_saving::value)
+            SerializeObjectChunks(m_objects, chunks);
+        ar & BOOST_SERIALIZATION_NVP(chunks);
+        if (Archive::is_loading::value)
+            DeserializeObjectChunks(chunks, m_objects);
+    }
 
     // If loading from the archive, propagate the changes to the specialized maps.
     // This involves a lot of casting, 
@@ -34,6 +206,14 @@ void ObjectMap::serialize(Archive& ar, const unsigned int version)
 
 template <class Archive>
 void Universe::serialize(Archive& ar, const unsigned int version)
+{ Serialize(ar, true, false); }
+
+template <class Archive>
+void Universe::SerializeWithoutEmpireKnownObjects(Archive& ar, bool object_records)
+{ Serialize(ar, false, object_records); }
+
+template <class Archive>
+void Universe::Serialize(Archive& ar, bool empire_known_objects, bool object_records)
 {
     ObjectMap                       objects;
     std::set<int>                   destroyed_object_ids;
@@ -46,16 +226,19 @@ void Universe::serialize(Archive& ar, const unsigned int version)
 
     ar.template register_type<System>();
 
+    const int encoding_empire = EncodingEmpire();
+
     if (Archive::is_saving::value) {
         Logger().debugStream() << "Universe::serialize : Getting gamestate data";
-        GetObjectsToSerialize(              objects,                            m_encoding_empire);
-        GetDestroyedObjectsToSerialize(     destroyed_object_ids,               m_encoding_empire);
-        GetEmpireKnownObjectsToSerialize(   empire_latest_known_objects,        m_encoding_empire);
-        GetEmpireObjectVisibilityMap(       empire_object_visibility,           m_encoding_empire);
-        GetEmpireObjectVisibilityTurnMap(   empire_object_visibility_turns,     m_encoding_empire);
-        GetEmpireKnownDestroyedObjects(     empire_known_destroyed_object_ids,  m_encoding_empire);
-        GetEmpireStaleKnowledgeObjects(     empire_stale_knowledge_object_ids,  m_encoding_empire);
-        GetShipDesignsToSerialize(          ship_designs,                       m_encoding_empire);
+        GetObjectsToSerialize(              objects,                            encoding_empire);
+        GetDestroyedObjectsToSerialize(     destroyed_object_ids,               encoding_empire);
+        if (empire_known_objects)
+            GetEmpireKnownObjectsToSerialize(empire_latest_known_objects,       encoding_empire);
+        GetEmpireObjectVisibilityMap(       empire_object_visibility,           encoding_empire);
+        GetEmpireObjectVisibilityTurnMap(   empire_object_visibility_turns,     encoding_empire);
+        GetEmpireKnownDestroyedObjects(     empire_known_destroyed_object_ids,  encoding_empire);
+        GetEmpireStaleKnowledgeObjects(     empire_stale_knowledge_object_ids,  encoding_empire);
+        GetShipDesignsToSerialize(          ship_designs,                       encoding_empire);
     }
 
     if (Archive::is_loading::value) {
@@ -73,10 +256,43 @@ void Universe::serialize(Archive& ar, const unsigned int version)
     ar  & BOOST_SERIALIZATION_NVP(empire_known_destroyed_object_ids);
     ar  & BOOST_SERIALIZATION_NVP(empire_stale_knowledge_object_ids);
     Logger().debugStream() << "Universe::serialize : (de)serializing actual objects";
-    ar  & BOOST_SERIALIZATION_NVP(objects)
-        & BOOST_SERIALIZATION_NVP(destroyed_object_ids);
-    Logger().debugStream() << "Universe::serialize : (de)serializing empre known objects";
-    ar  & BOOST_SERIALIZATION_NVP(empire_latest_known_objects);
+    std::map<int, std::string> records_by_id;
+    if (!object_records) {
+        ar  & BOOST_SERIALIZATION_NVP(objects);
+    } else {
+        // each object is a separate record, which the latest known objects
+        // of empires are encoded against, so they are kept until then
+        std::vector<std::string> records;
+        std::vector<UniverseObject*> record_objects;
+        if (Archive::is_saving::value)
+            for (ObjectMap::const_iterator<> it = objects.const_begin(); it != objects.const_end(); ++it)
+                records.push_back(SerializeStandalone(*it));
+        ar  & BOOST_SERIALIZATION_NVP(records);
+        if (Archive::is_loading::value) {
+            try {
+                DeserializeConcurrently(records, record_objects, MIN_OBJECT_RECORDS_PER_THREAD);
+            } catch (...) {
+                for (std::vector<UniverseObject*>::iterator it = record_objects.begin(); it != record_objects.end(); ++it)
+                    delete *it;
+                throw;
+            }
+            for (std::size_t i = 0; i < record_objects.size(); ++i) {
+                if (!record_objects[i])
+                    continue;
+                records_by_id[record_objects[i]->ID()].swap(records[i]);
+                delete objects.Insert(record_objects[i]);
+            }
+        } else {
+            ObjectMap::const_iterator<> it = objects.const_begin();
+            for (std::size_t i = 0; i < records.size(); ++i, ++it)
+                records_by_id[it->ID()].swap(records[i]);
+        }
+    }
+    ar  & BOOST_SERIALIZATION_NVP(destroyed_object_ids);
+    if (empire_known_objects) {
+        Logger().debugStream() << "Universe::serialize : (de)serializing empre known objects";
+        ar  & BOOST_SERIALIZATION_NVP(empire_latest_known_objects);
+    }
     Logger().debugStream() << "Universe::serialize : (de)serializing last allocated ids";
     ar  & BOOST_SERIALIZATION_NVP(m_last_allocated_object_id);
     ar  & BOOST_SERIALIZATION_NVP(m_last_allocated_design_id);
@@ -102,6 +318,688 @@ void Universe::serialize(Archive& ar, const unsigned int version)
         m_empire_stale_knowledge_object_ids.swap(empire_stale_knowledge_object_ids);
         m_ship_designs.swap(ship_designs);
     }
+
+    if (object_records)
+        m_object_records.swap(records_by_id);
+}
+
+namespace {
+    /** Records in \a digests the digest \a digest of \a value, the entry
+      * for id \a id, and adds \a value to \a changed if that digest differs
+      * from the one for \a id in \a old_digests. */
+    template <class T>
+    void AddEntryIfChanged(int id, const T& value, TurnUpdateDigest digest,
+                           const std::map<int, TurnUpdateDigest>& old_digests,
+                           std::map<int, TurnUpdateDigest>& digests, std::map<int, T>& changed)
+    {
+        digests[id] = digest;
+        std::map<int, TurnUpdateDigest>::const_iterator it = old_digests.find(id);
+        if (it == old_digests.end() || it->second != digest)
+            changed[id] = value;
+    }
+
+    TurnUpdateDigest VisibilityTurnsDigest(const Universe::VisibilityTurnMap& visibility_turns) {
+        TurnUpdateDigest seed = 0;
+        for (Universe::VisibilityTurnMap::const_iterator it = visibility_turns.begin();
+             it != visibility_turns.end(); ++it)
+        {
+            seed = DigestValue(static_cast<int>(it->first), seed);
+            seed = DigestValue(it->second, seed);
+        }
+        return seed;
+    }
+
+    /** Returns the digest of one empire's knowledge of the universe, from
+      * the digests of its parts, as recorded in a TurnUpdateBaseline. */
+    TurnUpdateDigest UniverseStateDigest(const std::map<int, TurnUpdateDigest>& ship_designs,
+                                         const std::map<int, TurnUpdateDigest>& object_visibilities,
+                                         const std::map<int, TurnUpdateDigest>& object_visibility_turns,
+                                         const std::set<int>& destroyed_object_ids,
+                                         const std::set<int>& stale_object_ids,
+                                         const std::map<int, TurnUpdateDigest>& objects)
+    {
+        TurnUpdateDigest seed = Digest(ship_designs, 0);
+        seed = Digest(object_visibilities, seed);
+        seed = Digest(object_visibility_turns, seed);
+        seed = Digest(destroyed_object_ids, seed);
+        seed = Digest(stale_object_ids, seed);
+        return Digest(objects, seed);
+    }
+}
+
+template <class Archive>
+void Universe::SerializeDelta(Archive& ar, TurnUpdateBaseline& baseline) const
+{
+    const int empire_id = EncodingEmpire();
+    bool full_snapshot = baseline.Empty();
+
+    // ship designs
+    ShipDesignMap ship_designs;
+    GetShipDesignsToSerialize(ship_designs, empire_id);
+    std::map<int, TurnUpdateDigest> ship_design_digests;
+    std::vector<std::string> changed_ship_designs;
+    std::set<int> removed_ship_design_ids;
+    for (ShipDesignMap::const_iterator it = ship_designs.begin(); it != ship_designs.end(); ++it)
+        AddIfChanged(it->first, SerializeStandalone(it->second), baseline.ship_designs,
+                     ship_design_digests, changed_ship_designs);
+    GetRemovedKeys(baseline.ship_designs, ship_design_digests, removed_ship_design_ids);
+
+    // visibility
+    EmpireObjectVisibilityMap empire_object_visibility;
+    GetEmpireObjectVisibilityMap(empire_object_visibility, empire_id);
+    const ObjectVisibilityMap& object_visibility = empire_object_visibility[empire_id];
+    std::map<int, TurnUpdateDigest> visibility_digests;
+    ObjectVisibilityMap changed_visibility;
+    std::set<int> removed_visibility_ids;
+    for (ObjectVisibilityMap::const_iterator it = object_visibility.begin(); it != object_visibility.end(); ++it)
+        AddEntryIfChanged(it->first, it->second, static_cast<TurnUpdateDigest>(it->second),
+                          baseline.object_visibilities, visibility_digests, changed_visibility);
+    GetRemovedKeys(baseline.object_visibilities, visibility_digests, removed_visibility_ids);
+
+    EmpireObjectVisibilityTurnMap empire_object_visibility_turns;
+    GetEmpireObjectVisibilityTurnMap(empire_object_visibility_turns, empire_id);
+    const ObjectVisibilityTurnMap& object_visibility_turns = empire_object_visibility_turns[empire_id];
+    std::map<int, TurnUpdateDigest> visibility_turn_digests;
+    ObjectVisibilityTurnMap changed_visibility_turns;
+    std::set<int> removed_visibility_turn_ids;
+    for (ObjectVisibilityTurnMap::const_iterator it = object_visibility_turns.begin();
+         it != object_visibility_turns.end(); ++it)
+    {
+        AddEntryIfChanged(it->first, it->second, VisibilityTurnsDigest(it->second),
+                          baseline.object_visibility_turns, visibility_turn_digests,
+                          changed_visibility_turns);
+    }
+    GetRemovedKeys(baseline.object_visibility_turns, visibility_turn_digests, removed_visibility_turn_ids);
+
+    // destroyed and stale object knowledge
+    std::set<int> destroyed_object_ids;
+    GetDestroyedObjectsToSerialize(destroyed_object_ids, empire_id);
+    std::set<int> added_destroyed_object_ids, removed_destroyed_object_ids;
+    GetSetChanges(baseline.destroyed_object_ids, destroyed_object_ids,
+                  added_destroyed_object_ids, removed_destroyed_object_ids);
+
+    ObjectKnowledgeMap empire_stale_knowledge_object_ids;
+    GetEmpireStaleKnowledgeObjects(empire_stale_knowledge_object_ids, empire_id);
+    const std::set<int>& stale_object_ids = empire_stale_knowledge_object_ids[empire_id];
+    std::set<int> added_stale_object_ids, removed_stale_object_ids;
+    GetSetChanges(baseline.stale_object_ids, stale_object_ids,
+                  added_stale_object_ids, removed_stale_object_ids);
+
+    // objects
+    ObjectMap objects;
+    GetObjectsToSerialize(objects, empire_id);
+
+    // clients execute their orders on their own copies of objects, so objects
+    // the empire's orders may have altered are always resent, whether or not
+    // they changed here: the empire's own objects, and other objects in the
+    // same systems as them, such as planets targeted for colonization
+    std::set<int> order_target_system_ids;
+    for (ObjectMap::iterator<> it = objects.begin(); it != objects.end(); ++it)
+        if (it->OwnedBy(empire_id) && it->SystemID() != INVALID_OBJECT_ID)
+            order_target_system_ids.insert(it->SystemID());
+    const std::map<int, TurnUpdateDigest> NO_DIGESTS;
+
+    std::map<int, TurnUpdateDigest> object_digests;
+    std::vector<std::string> changed_objects;
+    std::set<int> removed_object_ids;
+    for (ObjectMap::iterator<> it = objects.begin(); it != objects.end(); ++it) {
+        UniverseObject* obj = *it;
+        bool resend = obj->OwnedBy(empire_id) ||
+                      order_target_system_ids.find(obj->SystemID()) != order_target_system_ids.end() ||
+                      order_target_system_ids.find(obj->ID()) != order_target_system_ids.end();
+        AddIfChanged(obj->ID(), SerializeStandalone(obj), resend ? NO_DIGESTS : baseline.objects,
+                     object_digests, changed_objects);
+    }
+    GetRemovedKeys(baseline.objects, object_digests, removed_object_ids);
+    objects.Clear();
+
+    TurnUpdateDigest state_digest = UniverseStateDigest(ship_design_digests, visibility_digests,
+                                                        visibility_turn_digests, destroyed_object_ids,
+                                                        stale_object_ids, object_digests);
+
+    Logger().debugStream() << "Universe::SerializeDelta : " << changed_objects.size() << " of "
+                           << object_digests.size() << " objects and " << changed_ship_designs.size()
+                           << " of " << ship_design_digests.size() << " ship designs changed for empire "
+                           << empire_id << (full_snapshot ? " (full snapshot)" : "");
+
+    ar  << BOOST_SERIALIZATION_NVP(full_snapshot)
+        << BOOST_SERIALIZATION_NVP(m_universe_width)
+        << BOOST_SERIALIZATION_NVP(changed_ship_designs)
+        << BOOST_SERIALIZATION_NVP(removed_ship_design_ids)
+        << BOOST_SERIALIZATION_NVP(m_empire_known_ship_design_ids)
+        << BOOST_SERIALIZATION_NVP(changed_visibility)
+        << BOOST_SERIALIZATION_NVP(removed_visibility_ids)
+        << BOOST_SERIALIZATION_NVP(changed_visibility_turns)
+        << BOOST_SERIALIZATION_NVP(removed_visibility_turn_ids)
+        << BOOST_SERIALIZATION_NVP(added_destroyed_object_ids)
+        << BOOST_SERIALIZATION_NVP(removed_destroyed_object_ids)
+        << BOOST_SERIALIZATION_NVP(added_stale_object_ids)
+        << BOOST_SERIALIZATION_NVP(removed_stale_object_ids)
+        << BOOST_SERIALIZATION_NVP(changed_objects)
+        << BOOST_SERIALIZATION_NVP(removed_object_ids)
+        << BOOST_SERIALIZATION_NVP(m_last_allocated_object_id)
+        << BOOST_SERIALIZATION_NVP(m_last_allocated_design_id)
+        << BOOST_SERIALIZATION_NVP(state_digest);
+
+    baseline.ship_designs.swap(ship_design_digests);
+    baseline.object_visibilities.swap(visibility_digests);
+    baseline.object_visibility_turns.swap(visibility_turn_digests);
+    baseline.destroyed_object_ids.swap(destroyed_object_ids);
+    baseline.stale_object_ids = stale_object_ids;
+    baseline.objects.swap(object_digests);
+}
+
+template <class Archive>
+bool Universe::DeserializeDelta(Archive& ar)
+{
+    const int empire_id = EncodingEmpire();
+
+    bool                        full_snapshot;
+    std::vector<std::string>    changed_ship_designs;
+    std::set<int>               removed_ship_design_ids;
+    ObjectVisibilityMap         changed_visibility;
+    std::set<int>               removed_visibility_ids;
+    ObjectVisibilityTurnMap     changed_visibility_turns;
+    std::set<int>               removed_visibility_turn_ids;
+    std::set<int>               added_destroyed_object_ids;
+    std::set<int>               removed_destroyed_object_ids;
+    std::set<int>               added_stale_object_ids;
+    std::set<int>               removed_stale_object_ids;
+    std::vector<std::string>    changed_objects;
+    std::set<int>               removed_object_ids;
+    TurnUpdateDigest            state_digest;
+
+    ar  >> BOOST_SERIALIZATION_NVP(full_snapshot)
+        >> BOOST_SERIALIZATION_NVP(m_universe_width)
+        >> BOOST_SERIALIZATION_NVP(changed_ship_designs)
+        >> BOOST_SERIALIZATION_NVP(removed_ship_design_ids)
+        >> BOOST_SERIALIZATION_NVP(m_empire_known_ship_design_ids)
+        >> BOOST_SERIALIZATION_NVP(changed_visibility)
+        >> BOOST_SERIALIZATION_NVP(removed_visibility_ids)
+        >> BOOST_SERIALIZATION_NVP(changed_visibility_turns)
+        >> BOOST_SERIALIZATION_NVP(removed_visibility_turn_ids)
+        >> BOOST_SERIALIZATION_NVP(added_destroyed_object_ids)
+        >> BOOST_SERIALIZATION_NVP(removed_destroyed_object_ids)
+        >> BOOST_SERIALIZATION_NVP(added_stale_object_ids)
+        >> BOOST_SERIALIZATION_NVP(removed_stale_object_ids)
+        >> BOOST_SERIALIZATION_NVP(changed_objects)
+        >> BOOST_SERIALIZATION_NVP(removed_object_ids)
+        >> BOOST_SERIALIZATION_NVP(m_last_allocated_object_id)
+        >> BOOST_SERIALIZATION_NVP(m_last_allocated_design_id)
+        >> BOOST_SERIALIZATION_NVP(state_digest);
+
+    if (full_snapshot) {
+        Clear();
+        m_empire_object_visibility.clear();
+        m_empire_object_visibility_turns.clear();
+        m_empire_known_destroyed_object_ids.clear();
+        m_empire_stale_knowledge_object_ids.clear();
+    }
+
+    // ship designs
+    for (std::set<int>::const_iterator it = removed_ship_design_ids.begin(); it != removed_ship_design_ids.end(); ++it) {
+        ShipDesignMap::iterator design_it = m_ship_designs.find(*it);
+        if (design_it != m_ship_designs.end()) {
+            delete design_it->second;
+            m_ship_designs.erase(design_it);
+        }
+    }
+    for (std::vector<std::string>::const_iterator it = changed_ship_designs.begin(); it != changed_ship_designs.end(); ++it) {
+        ShipDesign* design = 0;
+        DeserializeStandalone(*it, design);
+        if (!design)
+            continue;
+        ShipDesign*& stored_design = m_ship_designs[design->ID()];
+        delete stored_design;
+        stored_design = design;
+    }
+
+    // visibility
+    ObjectVisibilityMap& object_visibility = m_empire_object_visibility[empire_id];
+    for (std::set<int>::const_iterator it = removed_visibility_ids.begin(); it != removed_visibility_ids.end(); ++it)
+        object_visibility.erase(*it);
+    for (ObjectVisibilityMap::const_iterator it = changed_visibility.begin(); it != changed_visibility.end(); ++it)
+        object_visibility[it->first] = it->second;
+
+    ObjectVisibilityTurnMap& object_visibility_turns = m_empire_object_visibility_turns[empire_id];
+    for (std::set<int>::const_iterator it = removed_visibility_turn_ids.begin(); it != removed_visibility_turn_ids.end(); ++it)
+        object_visibility_turns.erase(*it);
+    for (ObjectVisibilityTurnMap::const_iterator it = changed_visibility_turns.begin(); it != changed_visibility_turns.end(); ++it)
+        object_visibility_turns[it->first] = it->second;
+
+    // destroyed and stale object knowledge.  a client's destroyed object ids
+    // are those its empire knows to have been destroyed.
+    std::set<int>& known_destroyed_object_ids = m_empire_known_destroyed_object_ids[empire_id];
+    for (std::set<int>::const_iterator it = removed_destroyed_object_ids.begin(); it != removed_destroyed_object_ids.end(); ++it) {
+        known_destroyed_object_ids.erase(*it);
+        m_destroyed_object_ids.erase(*it);
+    }
+    known_destroyed_object_ids.insert(added_destroyed_object_ids.begin(), added_destroyed_object_ids.end());
+    m_destroyed_object_ids.insert(added_destroyed_object_ids.begin(), added_destroyed_object_ids.end());
+
+    std::set<int>& stale_object_ids = m_empire_stale_knowledge_object_ids[empire_id];
+    for (std::set<int>::const_iterator it = removed_stale_object_ids.begin(); it != removed_stale_object_ids.end(); ++it)
+        stale_object_ids.erase(*it);
+    stale_object_ids.insert(added_stale_object_ids.begin(), added_stale_object_ids.end());
+
+    // objects
+    for (std::set<int>::const_iterator it = removed_object_ids.begin(); it != removed_object_ids.end(); ++it)
+        m_objects.Delete(*it);
+    std::vector<UniverseObject*> changed_object_ptrs;
+    try {
+        DeserializeConcurrently(changed_objects, changed_object_ptrs, MIN_OBJECT_RECORDS_PER_THREAD);
+    } catch (...) {
+        for (std::vector<UniverseObject*>::iterator it = changed_object_ptrs.begin(); it != changed_object_ptrs.end(); ++it)
+            delete *it;
+        throw;
+    }
+    for (std::vector<UniverseObject*>::iterator it = changed_object_ptrs.begin(); it != changed_object_ptrs.end(); ++it)
+        if (*it)
+            delete m_objects.Insert(*it);
+
+    Logger().debugStream() << "Universe::DeserializeDelta : applied " << changed_objects.size()
+                           << " changed and " << removed_object_ids.size() << " removed objects"
+                           << (full_snapshot ? " (full snapshot)" : "");
+
+    // check the result against what the server serialized, so that any
+    // difference, such as from an object whose change went unnoticed, is
+    // replaced by a full snapshot rather than kept until the next one
+    ShipDesignMap ship_designs;
+    GetShipDesignsToSerialize(ship_designs, empire_id);
+    std::map<int, TurnUpdateDigest> ship_design_digests;
+    for (ShipDesignMap::const_iterator it = ship_designs.begin(); it != ship_designs.end(); ++it)
+        ship_design_digests[it->first] = Digest(SerializeStandalone(it->second));
+
+    std::map<int, TurnUpdateDigest> visibility_digests;
+    for (ObjectVisibilityMap::const_iterator it = object_visibility.begin(); it != object_visibility.end(); ++it)
+        visibility_digests[it->first] = static_cast<TurnUpdateDigest>(it->second);
+
+    std::map<int, TurnUpdateDigest> visibility_turn_digests;
+    for (ObjectVisibilityTurnMap::const_iterator it = object_visibility_turns.begin();
+         it != object_visibility_turns.end(); ++it)
+    { visibility_turn_digests[it->first] = VisibilityTurnsDigest(it->second); }
+
+    std::map<int, TurnUpdateDigest> object_digests;
+    for (ObjectMap::iterator<> it = m_objects.begin(); it != m_objects.end(); ++it) {
+        UniverseObject* obj = *it;
+        object_digests[obj->ID()] = Digest(SerializeStandalone(obj));
+    }
+
+    if (state_digest != UniverseStateDigest(ship_design_digests, visibility_digests, visibility_turn_digests,
+                                            known_destroyed_object_ids, stale_object_ids, object_digests))
+    {
+        Logger().errorStream() << "Universe::DeserializeDelta : state differs from the server's after applying update";
+        return false;
+    }
+    return true;
+}
+
+namespace {
+    /** Differences of records shorter than this between two changed bytes
+      * are stored as changed, rather than as a copy from the reference. */
+    const std::size_t MIN_DIFFERENCE_COPY_SIZE = 8;
+
+    void AppendVarint(std::string& str, std::size_t value) {
+        while (0x80 <= value) {
+            str.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        str.push_back(static_cast<char>(value));
+    }
+
+    std::size_t ReadVarint(const std::string& str, std::size_t& pos) {
+        std::size_t retval = 0;
+        for (int shift = 0; pos < str.size() && shift < 64; shift += 7) {
+            const unsigned char byte = static_cast<unsigned char>(str[pos++]);
+            retval |= static_cast<std::size_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return retval;
+        }
+        throw std::runtime_error("ReadVarint : truncated difference");
+    }
+
+    /** Appends to \a difference an operation that copies \a copy bytes from
+      * the reference, skips \a skip more of them, and then appends the
+      * \a literal_size bytes at \a literal. */
+    void AppendDifferenceOp(std::string& difference, std::size_t copy, std::size_t skip,
+                            const char* literal, std::size_t literal_size)
+    {
+        AppendVarint(difference, copy);
+        AppendVarint(difference, skip);
+        AppendVarint(difference, literal_size);
+        difference.append(literal, literal_size);
+    }
+
+    /** Returns the differences of \a record from \a reference, from which
+      * ApplyDifference() recreates \a record.  Records of the same size are
+      * compared byte by byte, so that fields changed in place, such as meters
+      * and positions, are all that is stored; otherwise everything between
+      * the bytes they start and end with in common is. */
+    std::string EncodeDifference(const std::string& reference, const std::string& record) {
+        const std::size_t size = record.size();
+        const std::size_t reference_size = reference.size();
+        std::size_t prefix = 0;
+        while (prefix < size && prefix < reference_size && record[prefix] == reference[prefix])
+            ++prefix;
+        std::size_t suffix = 0;
+        while (suffix < size - prefix && suffix < reference_size - prefix &&
+               record[size - 1 - suffix] == reference[reference_size - 1 - suffix])
+        { ++suffix; }
+
+        std::string retval;
+        std::size_t copy = prefix;
+        if (size == reference_size) {
+            const std::size_t end = size - suffix;
+            std::size_t i = prefix;
+            while (i < end) {
+                // record[i] differs; find where the run of differences ends
+                std::size_t last_changed = i;
+                for (std::size_t j = i + 1; j < end && j - last_changed <= MIN_DIFFERENCE_COPY_SIZE; ++j) {
+                    if (record[j] != reference[j])
+                        last_changed = j;
+                }
+                const std::size_t changed = last_changed + 1 - i;
+                AppendDifferenceOp(retval, copy, changed, &record[i], changed);
+                i += changed;
+                copy = 0;
+                while (i < end && record[i] == reference[i]) {
+                    ++i;
+                    ++copy;
+                }
+            }
+            copy += suffix;
+        } else {
+            AppendDifferenceOp(retval, copy, reference_size - prefix - suffix,
+                               record.data() + prefix, size - prefix - suffix);
+            copy = suffix;
+        }
+        if (copy)
+            AppendDifferenceOp(retval, copy, 0, 0, 0);
+        return retval;
+    }
+
+    /** Returns the record \a difference was encoded from by
+      * EncodeDifference(), given the same \a reference. */
+    std::string ApplyDifference(const std::string& reference, const std::string& difference) {
+        std::string retval;
+        std::size_t reference_pos = 0;
+        std::size_t pos = 0;
+        while (pos < difference.size()) {
+            const std::size_t copy = ReadVarint(difference, pos);
+            const std::size_t skip = ReadVarint(difference, pos);
+            const std::size_t literal_size = ReadVarint(difference, pos);
+            if (reference.size() - reference_pos < copy ||
+                reference.size() - reference_pos - copy < skip ||
+                difference.size() - pos < literal_size)
+            { throw std::runtime_error("ApplyDifference : difference doesn't match its reference"); }
+            retval.append(reference, reference_pos, copy);
+            reference_pos += copy + skip;
+            retval.append(difference, pos, literal_size);
+            pos += literal_size;
+        }
+        return retval;
+    }
+
+    /** One empire's version of an object in its latest known objects, stored
+      * as the difference of its record from that of another version. */
+    struct KnownObjectVersion {
+        enum ReferenceType {
+            NO_REFERENCE,       ///< the difference is from an empty record
+            UNIVERSE_REFERENCE, ///< from the object's record in the universe section
+            EMPIRE_REFERENCE    ///< from the version of reference_empire_id, which comes before this one
+        };
+
+        KnownObjectVersion() :
+            empire_id(ALL_EMPIRES),
+            reference_type(NO_REFERENCE),
+            reference_empire_id(ALL_EMPIRES),
+            difference()
+        {}
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version) {
+            ar  & BOOST_SERIALIZATION_NVP(empire_id)
+                & BOOST_SERIALIZATION_NVP(reference_type)
+                & BOOST_SERIALIZATION_NVP(reference_empire_id)
+                & BOOST_SERIALIZATION_NVP(difference);
+        }
+
+        int         empire_id;
+        int         reference_type;
+        int         reference_empire_id;
+        std::string difference;
+    };
+
+    /** The versions of an object in the latest known objects of empires. */
+    struct KnownObject {
+        KnownObject() :
+            object_id(INVALID_OBJECT_ID),
+            versions()
+        {}
+
+        template <class Archive>
+        void serialize(Archive& ar, const unsigned int version) {
+            ar  & BOOST_SERIALIZATION_NVP(object_id)
+                & BOOST_SERIALIZATION_NVP(versions);
+        }
+
+        int                             object_id;
+        std::vector<KnownObjectVersion> versions;
+    };
+
+    /** Fills \a known_object with \a versions, each an empire id and that
+      * empire's version of the object, encoded as the smallest difference
+      * from the object's record in the universe section, \a universe_record,
+      * if any, or any distinct version before it. */
+    void EncodeKnownObject(const std::string* universe_record,
+                           const std::vector<std::pair<int, const UniverseObject*> >& versions,
+                           KnownObject& known_object)
+    {
+        const std::string NO_RECORD;
+
+        // the versions differing from the universe's and each other, and the
+        // first empire with each
+        std::vector<std::pair<int, std::string> > distinct_records;
+
+        known_object.versions.resize(versions.size());
+        for (std::size_t i = 0; i < versions.size(); ++i) {
+            const std::string record = SerializeStandalone(versions[i].second);
+            KnownObjectVersion& version = known_object.versions[i];
+            version.empire_id = versions[i].first;
+
+            if (universe_record && record == *universe_record) {
+                version.reference_type = KnownObjectVersion::UNIVERSE_REFERENCE;
+                version.difference = EncodeDifference(*universe_record, record);
+                continue;
+            }
+            std::vector<std::pair<int, std::string> >::const_iterator same_it = distinct_records.begin();
+            while (same_it != distinct_records.end() && same_it->second != record)
+                ++same_it;
+            if (same_it != distinct_records.end()) {
+                version.reference_type = KnownObjectVersion::EMPIRE_REFERENCE;
+                version.reference_empire_id = same_it->first;
+                version.difference = EncodeDifference(record, record);
+                continue;
+            }
+
+            version.difference = EncodeDifference(NO_RECORD, record);
+            if (universe_record) {
+                std::string difference = EncodeDifference(*universe_record, record);
+                if (difference.size() < version.difference.size()) {
+                    version.reference_type = KnownObjectVersion::UNIVERSE_REFERENCE;
+                    version.difference.swap(difference);
+                }
+            }
+            for (std::vector<std::pair<int, std::string> >::const_iterator it = distinct_records.begin();
+                 it != distinct_records.end(); ++it)
+            {
+                std::string difference = EncodeDifference(it->second, record);
+                if (difference.size() < version.difference.size()) {
+                    version.reference_type = KnownObjectVersion::EMPIRE_REFERENCE;
+                    version.reference_empire_id = it->first;
+                    version.difference.swap(difference);
+                }
+            }
+            distinct_records.push_back(std::make_pair(version.empire_id, record));
+        }
+    }
+
+    /** Returns the record of the version at \a index in \a known_object,
+      * decoding as many of the versions before it as it refers to.
+      * \a universe_record is the object's record in the universe section, if
+      * any. */
+    std::string DecodeKnownObjectVersion(const std::string* universe_record, const KnownObject& known_object,
+                                         std::size_t index)
+    {
+        // the versions from the one with no reference, or a reference to the
+        // universe's, to the one at index, each referring to the one before
+        std::vector<std::size_t> chain(1, index);
+        for (;;) {
+            const KnownObjectVersion& version = known_object.versions[chain.back()];
+            if (version.reference_type != KnownObjectVersion::EMPIRE_REFERENCE)
+                break;
+            std::size_t reference_index = 0;
+            while (reference_index < chain.back() &&
+                   known_object.versions[reference_index].empire_id != version.reference_empire_id)
+            { ++reference_index; }
+            if (reference_index == chain.back())
+                throw std::runtime_error("DecodeKnownObjectVersion : object " + boost::lexical_cast<std::string>(known_object.object_id) +
+                                         " refers to an unknown version");
+            chain.push_back(reference_index);
+        }
+
+        std::string record;
+        const KnownObjectVersion& first_version = known_object.versions[chain.back()];
+        switch (first_version.reference_type) {
+        case KnownObjectVersion::NO_REFERENCE:
+            record = ApplyDifference(std::string(), first_version.difference);
+            break;
+        case KnownObjectVersion::UNIVERSE_REFERENCE:
+            if (!universe_record)
+                throw std::runtime_error("DecodeKnownObjectVersion : object " + boost::lexical_cast<std::string>(known_object.object_id) +
+                                         " refers to an object not in the universe");
+            record = ApplyDifference(*universe_record, first_version.difference);
+            break;
+        default:
+            throw std::runtime_error("DecodeKnownObjectVersion : unknown reference type");
+        }
+        for (std::vector<std::size_t>::reverse_iterator it = chain.rbegin() + 1; it != chain.rend(); ++it)
+            record = ApplyDifference(record, known_object.versions[*it].difference);
+        return record;
+    }
+
+    /** The latest known objects of empires read from a save file, kept
+      * encoded until each empire's are first needed. */
+    struct EmpireKnownObjectDifferences {
+        std::vector<KnownObject>    known_objects;
+        std::map<int, std::string>  object_records; ///< records of the universe section, which versions may refer to
+    };
+
+    /** Decodes the versions of empire \a empire_id in \a differences and
+      * inserts them into \a objects; the loader given to
+      * Universe::SetDeferredEmpireKnownObjects() for each empire. */
+    void DecodeEmpireKnownObjects(const boost::shared_ptr<const EmpireKnownObjectDifferences>& differences,
+                                  int empire_id, ObjectMap& objects)
+    {
+        std::vector<std::string> records;
+        for (std::vector<KnownObject>::const_iterator it = differences->known_objects.begin();
+             it != differences->known_objects.end(); ++it)
+        {
+            std::size_t index = 0;
+            while (index < it->versions.size() && it->versions[index].empire_id != empire_id)
+                ++index;
+            if (index == it->versions.size())
+                continue;
+            std::map<int, std::string>::const_iterator record_it = differences->object_records.find(it->object_id);
+            records.push_back(DecodeKnownObjectVersion(record_it != differences->object_records.end() ? &record_it->second : 0,
+                                                       *it, index));
+        }
+
+        std::vector<UniverseObject*> decoded_objects;
+        try {
+            DeserializeConcurrently(records, decoded_objects, MIN_OBJECT_RECORDS_PER_THREAD);
+        } catch (...) {
+            for (std::vector<UniverseObject*>::iterator it = decoded_objects.begin(); it != decoded_objects.end(); ++it)
+                delete *it;
+            throw;
+        }
+        for (std::vector<UniverseObject*>::iterator it = decoded_objects.begin(); it != decoded_objects.end(); ++it)
+            if (*it)
+                delete objects.Insert(*it);
+
+        Logger().debugStream() << "DecodeEmpireKnownObjects : decoded " << records.size()
+                               << " latest known objects of empire " << empire_id;
+    }
+}
+
+template <class Archive>
+void Universe::SerializeEmpireKnownObjectDifferences(Archive& ar) const
+{
+    LoadDeferredEmpireKnownObjects();
+
+    std::vector<int> empire_ids;
+    std::map<int, std::vector<std::pair<int, const UniverseObject*> > > object_versions;
+    for (EmpireObjectMap::const_iterator empire_it = m_empire_latest_known_objects.begin();
+         empire_it != m_empire_latest_known_objects.end(); ++empire_it)
+    {
+        empire_ids.push_back(empire_it->first);
+        for (ObjectMap::const_iterator<> it = empire_it->second.const_begin(); it != empire_it->second.const_end(); ++it)
+            object_versions[it->ID()].push_back(std::make_pair(empire_it->first, *it));
+    }
+
+    int object_count = static_cast<int>(object_versions.size());
+    ar  << BOOST_SERIALIZATION_NVP(empire_ids)
+        << BOOST_SERIALIZATION_NVP(object_count);
+
+    // objects are encoded and written one at a time, so that only one
+    // object's records are in memory at once
+    std::size_t version_count = 0;
+    std::size_t difference_bytes = 0;
+    for (std::map<int, std::vector<std::pair<int, const UniverseObject*> > >::const_iterator it = object_versions.begin();
+         it != object_versions.end(); ++it)
+    {
+        KnownObject known_object;
+        known_object.object_id = it->first;
+        std::map<int, std::string>::const_iterator record_it = m_object_records.find(it->first);
+        EncodeKnownObject(record_it != m_object_records.end() ? &record_it->second : 0, it->second, known_object);
+        ar << BOOST_SERIALIZATION_NVP(known_object);
+
+        version_count += known_object.versions.size();
+        for (std::vector<KnownObjectVersion>::const_iterator version_it = known_object.versions.begin();
+             version_it != known_object.versions.end(); ++version_it)
+        { difference_bytes += version_it->difference.size(); }
+    }
+
+    Logger().debugStream() << "Universe::SerializeEmpireKnownObjectDifferences : " << version_count
+                           << " versions of " << object_count << " objects known to " << empire_ids.size()
+                           << " empires encoded in " << difference_bytes << " bytes of differences";
+    m_object_records.clear();
+}
+
+template <class Archive>
+void Universe::DeserializeEmpireKnownObjectDifferences(Archive& ar)
+{
+    std::vector<int> empire_ids;
+    int object_count = 0;
+    ar  >> BOOST_SERIALIZATION_NVP(empire_ids)
+        >> BOOST_SERIALIZATION_NVP(object_count);
+
+    // the differences are only read now; each empire's versions are decoded
+    // and deserialized when its latest known objects are first needed
+    boost::shared_ptr<EmpireKnownObjectDifferences> differences(new EmpireKnownObjectDifferences);
+    differences->known_objects.resize(object_count);
+    for (int i = 0; i < object_count; ++i) {
+        KnownObject& known_object = differences->known_objects[i];
+        ar >> BOOST_SERIALIZATION_NVP(known_object);
+    }
+    differences->object_records.swap(m_object_records);
+
+    boost::shared_ptr<const EmpireKnownObjectDifferences> const_differences(differences);
+    for (std::vector<int>::const_iterator it = empire_ids.begin(); it != empire_ids.end(); ++it)
+        SetDeferredEmpireKnownObjects(*it, boost::bind(&DecodeEmpireKnownObjects, const_differences, *it, _1));
+
+    Logger().debugStream() << "Universe::DeserializeEmpireKnownObjectDifferences : read differences of "
+                           << object_count << " objects known to " << empire_ids.size() << " empires";
 }
 
 template <class Archive>
@@ -227,14 +1125,57 @@ void System::serialize<FREEORION_OARCHIVE_TYPE>(FREEORION_OARCHIVE_TYPE& ar, con
 template
 void System::serialize<FREEORION_IARCHIVE_TYPE>(FREEORION_IARCHIVE_TYPE& ar, const unsigned int version);
 
+template void ObjectMap::serialize<FREEORION_OARCHIVE_TYPE>(FREEORION_OARCHIVE_TYPE&, const unsigned int);
+template void ObjectMap::serialize<FREEORION_IARCHIVE_TYPE>(FREEORION_IARCHIVE_TYPE&, const unsigned int);
+template void ShipDesign::serialize<FREEORION_OARCHIVE_TYPE>(FREEORION_OARCHIVE_TYPE&, const unsigned int);
+template void ShipDesign::serialize<FREEORION_IARCHIVE_TYPE>(FREEORION_IARCHIVE_TYPE&, const unsigned int);
+
+#ifdef FREEORION_ALTERNATE_OARCHIVE_TYPE
+// for the serialization tests; the objects in an ObjectMap are serialized
+// through the pointer serializers that the BOOST_CLASS_EXPORTs above register
+// for every archive included by Serialize.h
+template
+void System::serialize<FREEORION_ALTERNATE_OARCHIVE_TYPE>(FREEORION_ALTERNATE_OARCHIVE_TYPE& ar, const unsigned int version);
+template
+void System::serialize<FREEORION_ALTERNATE_IARCHIVE_TYPE>(FREEORION_ALTERNATE_IARCHIVE_TYPE& ar, const unsigned int version);
+template void ObjectMap::serialize<FREEORION_ALTERNATE_OARCHIVE_TYPE>(FREEORION_ALTERNATE_OARCHIVE_TYPE&, const unsigned int);
+template void ObjectMap::serialize<FREEORION_ALTERNATE_IARCHIVE_TYPE>(FREEORION_ALTERNATE_IARCHIVE_TYPE&, const unsigned int);
+template void ShipDesign::serialize<FREEORION_ALTERNATE_OARCHIVE_TYPE>(FREEORION_ALTERNATE_OARCHIVE_TYPE&, const unsigned int);
+template void ShipDesign::serialize<FREEORION_ALTERNATE_IARCHIVE_TYPE>(FREEORION_ALTERNATE_IARCHIVE_TYPE&, const unsigned int);
+#endif
+
 void Serialize(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe)
 { oa << BOOST_SERIALIZATION_NVP(universe); }
 
 void Serialize(FREEORION_OARCHIVE_TYPE& oa, const std::map<int, UniverseObject*>& objects)
 { oa << BOOST_SERIALIZATION_NVP(objects); }
 
+void SerializeDelta(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe, TurnUpdateBaseline& baseline)
+{ universe.SerializeDelta(oa, baseline); }
+
 void Deserialize(FREEORION_IARCHIVE_TYPE& ia, Universe& universe)
 { ia >> BOOST_SERIALIZATION_NVP(universe); }
 
+bool DeserializeDelta(FREEORION_IARCHIVE_TYPE& ia, Universe& universe)
+{ return universe.DeserializeDelta(ia); }
+
 void Deserialize(FREEORION_IARCHIVE_TYPE& ia, std::map<int, UniverseObject*>& objects)
 { ia >> BOOST_SERIALIZATION_NVP(objects); }
+
+void SerializeWithoutEmpireKnownObjects(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe)
+{ const_cast<Universe&>(universe).SerializeWithoutEmpireKnownObjects(oa, true); }
+
+void DeserializeWithoutEmpireKnownObjects(FREEORION_IARCHIVE_TYPE& ia, Universe& universe, bool object_records)
+{ universe.SerializeWithoutEmpireKnownObjects(ia, object_records); }
+
+void Serialize(FREEORION_OARCHIVE_TYPE& oa, const ObjectMap& objects)
+{ oa << BOOST_SERIALIZATION_NVP(objects); }
+
+void SerializeEmpireKnownObjectDifferences(FREEORION_OARCHIVE_TYPE& oa, const Universe& universe)
+{ universe.SerializeEmpireKnownObjectDifferences(oa); }
+
+void DeserializeEmpireKnownObjectDifferences(FREEORION_IARCHIVE_TYPE& ia, Universe& universe)
+{ universe.DeserializeEmpireKnownObjectDifferences(ia); }
+
+void Deserialize(FREEORION_IARCHIVE_TYPE& ia, ObjectMap& objects)
+{ ia >> BOOST_SERIALIZATION_NVP(objects); }
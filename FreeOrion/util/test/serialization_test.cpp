@@ -0,0 +1,402 @@
+#include "../Serialize.h"
+
+#include "../../Empire/Empire.h"
+#include "../../Empire/EmpireManager.h"
+#include "../../parse/Parse.h"
+#include "../../server/ServerApp.h"
+#include "../../universe/Building.h"
+#include "../../universe/Field.h"
+#include "../../universe/Fleet.h"
+#include "../../universe/Planet.h"
+#include "../../universe/Ship.h"
+#include "../../universe/ShipDesign.h"
+#include "../../universe/System.h"
+#include "../AppInterface.h"
+#include "../CompactArchive.h"
+#include "../Directories.h"
+#include "../OptionsDB.h"
+
+#include <GG/Clr.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/vector.hpp>
+
+#include <climits>
+#include <iostream>
+#include <sstream>
+#include <typeinfo>
+
+#ifndef FREEORION_ALTERNATE_OARCHIVE_TYPE
+#  error "serialization_test needs the core library built with FREEORION_ALTERNATE_ARCHIVES"
+#endif
+
+
+// Round-trip tests of CompactOArchive and CompactIArchive against the binary
+// archives, on the game's own classes: an ObjectMap holding every kind of
+// UniverseObject, with meters, specials, starlanes, contained objects,
+// negative ids and repeated strings, a ShipDesign and an Empire, loaded and
+// saved through pointers as Universe and EmpireManager do.  Run with the
+// content directory as the second argument.
+
+namespace {
+    const char* SPECIES[] = {"SP_HUMAN", "SP_SCYLIOR", "SP_EGASSEM", "SP_LAENFA"};
+    const char* SPECIALS[] = {"GAIA_SPECIAL", "ANCIENT_RUINS_SPECIAL", "MINERALS_SPECIAL"};
+    const char* PARTS[] = {"SR_WEAPON_1", "AR_LEAD_PLATE", "DT_DETECTOR_1"};
+    const int SYSTEMS = 12;
+    const int EMPIRES = 3;
+
+    /** Fills the universe and creates the empires whose serialization is
+      * tested.  Returns the empire whose serialization is tested. */
+    const Empire* Populate() {
+        Universe& universe = GetUniverse();
+        EmpireManager& empires = Empires();
+
+        std::vector<int> design_ids;
+        for (int i = 0; i < 3; ++i) {
+            std::vector<std::string> parts;
+            for (int j = 0; j <= i % 2; ++j)
+                parts.push_back(PARTS[(i + j) % 3]);
+            ShipDesign* design = new ShipDesign("Design " + boost::lexical_cast<std::string>(i), "",
+                                                i - 1, i, i % 2 ? "SH_BASIC_MEDIUM" : "SH_ROBOTIC",
+                                                parts, "", "");
+            const int design_id = universe.GenerateDesignID();
+            universe.InsertShipDesignID(design, design_id);
+            design_ids.push_back(design_id);
+        }
+
+        for (int empire_id = 0; empire_id < EMPIRES; ++empire_id) {
+            Empire* empire = empires.CreateEmpire(empire_id, empire_id == 1 ? "" : "Empire",
+                                                  "Player " + boost::lexical_cast<std::string>(empire_id),
+                                                  GG::Clr(64 * empire_id, 255, 0, 255));
+            for (std::size_t i = 0; i <= static_cast<std::size_t>(empire_id) && i < design_ids.size(); ++i)
+                empire->AddShipDesign(design_ids[i]);
+        }
+
+        std::vector<System*> systems;
+        for (int i = 0; i < SYSTEMS; ++i) {
+            System* system = new System(i % 2 ? STAR_YELLOW : STAR_RED, 3,
+                                        "System " + boost::lexical_cast<std::string>(i),
+                                        100.0 * i, -50.0 * (i % 3));
+            universe.Insert(system);
+            if (i) {
+                system->AddStarlane(systems.back()->ID());
+                systems.back()->AddStarlane(system->ID());
+            }
+            systems.push_back(system);
+
+            const int owner = i % (EMPIRES + 1) - 1;   // includes unowned objects
+            for (int orbit = 0; orbit < i % 3; ++orbit) {
+                Planet* planet = new Planet(orbit ? PT_TERRAN : PT_OCEAN, orbit ? SZ_MEDIUM : SZ_LARGE);
+                universe.Insert(planet);
+                system->Insert(planet, orbit);
+                planet->SetOwner(owner);
+                if (owner != ALL_EMPIRES) {
+                    planet->SetSpecies(SPECIES[i % 4]);
+                    planet->GetMeter(METER_POPULATION)->Set(i * 0.5, i * 0.25);
+                    planet->GetMeter(METER_INDUSTRY)->Set(5.0, 4.5);
+                }
+                if (i % 4 == 0)
+                    planet->AddSpecial(SPECIALS[orbit % 3]);
+                if (orbit == 1) {
+                    Building* building = new Building(owner, "BLD_SHIPYARD_BASE", owner);
+                    const int building_id = universe.Insert(building);
+                    planet->AddBuilding(building_id);
+                    building->SetPlanetID(planet->ID());
+                }
+            }
+
+            if (owner != ALL_EMPIRES) {
+                Fleet* fleet = new Fleet("Fleet " + boost::lexical_cast<std::string>(i),
+                                         system->X(), system->Y(), owner);
+                universe.Insert(fleet);
+                system->Insert(fleet);
+                for (int j = 0; j < 1 + i % 4; ++j) {
+                    Ship* ship = new Ship(owner, design_ids[(i + j) % design_ids.size()], SPECIES[j % 4], owner);
+                    ship->Rename("Ship " + boost::lexical_cast<std::string>(j));
+                    fleet->AddShip(universe.Insert(ship));
+                }
+            }
+
+            if (i % 5 == 0)
+                universe.Insert(new Field("FLD_ION_STORM", system->X() + 30.0, system->Y() - 20.0, 40.0 + i));
+        }
+
+        Empire* empire = empires.Lookup(2);
+        for (std::size_t i = 0; i < systems.size(); i += 2)
+            empire->AddExploredSystem(systems[i]->ID());
+        return empire;
+    }
+
+    /** The gamestate loaded from an archive. */
+    struct Loaded {
+        Loaded() : design(0), empire(0) {}
+        ~Loaded() {
+            objects.Clear();
+            delete design;
+            delete empire;
+        }
+
+        ObjectMap   objects;
+        ShipDesign* design;
+        Empire*     empire;
+
+    private:
+        Loaded(const Loaded&);
+        Loaded& operator=(const Loaded&);
+    };
+
+    template <class OArchive>
+    std::string Save(const ObjectMap& objects, const ShipDesign* design, const Empire* empire) {
+        std::ostringstream os;
+        {
+            OArchive oa(os);
+            oa  << BOOST_SERIALIZATION_NVP(objects)
+                << BOOST_SERIALIZATION_NVP(design)
+                << BOOST_SERIALIZATION_NVP(empire);
+        }
+        return os.str();
+    }
+
+    template <class OArchive>
+    std::string Save(const Loaded& loaded)
+    { return Save<OArchive>(loaded.objects, loaded.design, loaded.empire); }
+
+    template <class IArchive>
+    void Load(const std::string& data, Loaded& loaded) {
+        std::istringstream is(data);
+        IArchive ia(is);
+        ia  >> boost::serialization::make_nvp("objects", loaded.objects)
+            >> boost::serialization::make_nvp("design", loaded.design)
+            >> boost::serialization::make_nvp("empire", loaded.empire);
+    }
+
+    /** Checks what saving again cannot: that each object was loaded as its
+      * own class, and a few of the values the game relies on. */
+    bool SpotCheck(const ObjectMap& objects, const ShipDesign* design, const Empire* empire, const Loaded& loaded) {
+        if (loaded.objects.NumObjects() != objects.NumObjects()) {
+            std::cerr << "loaded " << loaded.objects.NumObjects() << " objects of " << objects.NumObjects() << std::endl;
+            return false;
+        }
+        for (ObjectMap::const_iterator<> it = objects.const_begin(); it != objects.const_end(); ++it) {
+            const UniverseObject* object = *it;
+            const UniverseObject* loaded_object = loaded.objects.Object(object->ID());
+            if (!loaded_object || typeid(*loaded_object) != typeid(*object) ||
+                loaded_object->Name() != object->Name() || loaded_object->Owner() != object->Owner() ||
+                loaded_object->SystemID() != object->SystemID() || loaded_object->X() != object->X() ||
+                loaded_object->Specials() != object->Specials())
+            {
+                std::cerr << "object " << object->ID() << " changed" << std::endl;
+                return false;
+            }
+        }
+        if (loaded.objects.NumObjects<Ship>() != objects.NumObjects<Ship>() ||
+            loaded.objects.NumObjects<Planet>() != objects.NumObjects<Planet>())
+        {
+            std::cerr << "specialized object maps not rebuilt" << std::endl;
+            return false;
+        }
+        if (!loaded.design || loaded.design->ID() != design->ID() || loaded.design->Name() != design->Name() ||
+            loaded.design->Hull() != design->Hull() || loaded.design->Parts() != design->Parts())
+        {
+            std::cerr << "ship design changed" << std::endl;
+            return false;
+        }
+        if (!loaded.empire || loaded.empire->EmpireID() != empire->EmpireID() ||
+            loaded.empire->Name() != empire->Name() || loaded.empire->ShipDesigns() != empire->ShipDesigns() ||
+            loaded.empire->ExploredSystems() != empire->ExploredSystems())
+        {
+            std::cerr << "empire changed" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    template <class OArchive, class IArchive>
+    bool RoundTrip(const char* archive_name, const ObjectMap& objects, const ShipDesign* design, const Empire* empire) {
+        const std::string saved = Save<OArchive>(objects, design, empire);
+        Loaded loaded;
+        Load<IArchive>(saved, loaded);
+        if (!SpotCheck(objects, design, empire, loaded)) {
+            std::cerr << archive_name << " round trip changed the gamestate" << std::endl;
+            return false;
+        }
+        if (Save<OArchive>(loaded) != saved) {
+            std::cerr << archive_name << " archive of loaded gamestate differs from original" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /** Loads the gamestate from the compact archive and saves it again with
+      * the binary archive, which must produce what saving the original with
+      * the binary archive did, down to the byte, and the other way around. */
+    bool Equivalence(const ObjectMap& objects, const ShipDesign* design, const Empire* empire) {
+        const std::string binary = Save<boost::archive::binary_oarchive>(objects, design, empire);
+        const std::string compact = Save<CompactOArchive>(objects, design, empire);
+
+        Loaded from_compact;
+        Load<CompactIArchive>(compact, from_compact);
+        if (Save<boost::archive::binary_oarchive>(from_compact) != binary) {
+            std::cerr << "gamestate loaded from compact archive differs from original" << std::endl;
+            return false;
+        }
+
+        Loaded from_binary;
+        Load<boost::archive::binary_iarchive>(binary, from_binary);
+        if (Save<CompactOArchive>(from_binary) != compact) {
+            std::cerr << "compact archive of gamestate loaded from binary archive differs from original" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    bool Size(const ObjectMap& objects, const ShipDesign* design, const Empire* empire) {
+        const std::size_t binary_size = Save<boost::archive::binary_oarchive>(objects, design, empire).size();
+        const std::size_t compact_size = Save<CompactOArchive>(objects, design, empire).size();
+        std::cout << "binary archive: " << binary_size << " bytes; compact archive: " << compact_size << " bytes" << std::endl;
+        if (binary_size <= compact_size) {
+            std::cerr << "compact archive is not smaller than binary archive" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /** Checks the edge values of the variable-length integer and string
+      * dictionary encodings. */
+    bool Primitives() {
+        std::vector<int> ints;
+        ints.push_back(0);
+        ints.push_back(INVALID_OBJECT_ID);
+        ints.push_back(63);
+        ints.push_back(-64);
+        ints.push_back(64);
+        ints.push_back(INT_MAX);
+        ints.push_back(INT_MIN);
+        std::vector<unsigned int> unsigned_ints;
+        unsigned_ints.push_back(0u);
+        unsigned_ints.push_back(127u);
+        unsigned_ints.push_back(128u);
+        unsigned_ints.push_back(UINT_MAX);
+        std::vector<long long> long_longs;
+        long_longs.push_back(LLONG_MAX);
+        long_longs.push_back(LLONG_MIN);
+        long_longs.push_back(-1LL);
+        unsigned long long unsigned_long_long = ULLONG_MAX;
+        std::vector<std::string> strings;
+        strings.push_back("");
+        strings.push_back("SP_HUMAN");
+        strings.push_back("");
+        strings.push_back(std::string(300, 'x'));
+        strings.push_back("SP_HUMAN");
+        strings.push_back(std::string("embedded\0null", 13));
+
+        std::ostringstream os;
+        {
+            CompactOArchive oa(os);
+            oa << ints << unsigned_ints << long_longs << unsigned_long_long << strings;
+        }
+        std::vector<int> loaded_ints;
+        std::vector<unsigned int> loaded_unsigned_ints;
+        std::vector<long long> loaded_long_longs;
+        unsigned long long loaded_unsigned_long_long = 0;
+        std::vector<std::string> loaded_strings;
+        std::istringstream is(os.str());
+        {
+            CompactIArchive ia(is);
+            ia >> loaded_ints >> loaded_unsigned_ints >> loaded_long_longs >> loaded_unsigned_long_long >> loaded_strings;
+        }
+        if (loaded_ints != ints || loaded_unsigned_ints != unsigned_ints || loaded_long_longs != long_longs ||
+            loaded_unsigned_long_long != unsigned_long_long || loaded_strings != strings)
+        {
+            std::cerr << "primitive values changed in round trip" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    /** Checks that an archive from a newer class version is rejected. */
+    bool FutureVersionRejected() {
+        // the version of a Meter is written on its first occurrence, as a
+        // one-byte varint after the header, which an archive without a header
+        // makes easy to find
+        Meter meter(1.0, 2.0);
+        std::ostringstream os;
+        {
+            CompactOArchive oa(os, boost::archive::no_header);
+            oa << meter;
+        }
+        std::string data = os.str();
+        if (data.empty() || data[0] != 0) {
+            std::cerr << "unexpected encoding of Meter version" << std::endl;
+            return false;
+        }
+        data[0] = 1;
+        std::istringstream is(data);
+        try {
+            CompactIArchive ia(is, boost::archive::no_header);
+            ia >> meter;
+        } catch (const boost::archive::archive_exception& e) {
+            if (e.code == boost::archive::archive_exception::unsupported_class_version)
+                return true;
+        }
+        std::cerr << "archive from newer version of Meter was not rejected" << std::endl;
+        return false;
+    }
+
+    /** Runs the test named \a test on the gamestate created by Populate(). */
+    bool RunGamestateTest(const std::string& test) {
+        parse::init();
+
+        ServerApp app;
+        const Empire* empire = Populate();
+        const ObjectMap& objects = GetUniverse().Objects();
+        const ShipDesign* design = GetUniverse().GetShipDesign(*empire->ShipDesigns().rbegin());
+
+        if (test == "binary_round_trip")
+            return RoundTrip<boost::archive::binary_oarchive, boost::archive::binary_iarchive>("binary", objects, design, empire);
+        else if (test == "compact_round_trip")
+            return RoundTrip<CompactOArchive, CompactIArchive>("compact", objects, design, empire);
+        else if (test == "equivalence")
+            return Equivalence(objects, design, empire);
+        else
+            return Size(objects, design, empire);
+    }
+
+    void PrintHelp()
+    { std::cout << "Usage: serialization_test binary_round_trip|compact_round_trip|equivalence|size|primitives|future_version [resource dir]" << std::endl; }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        PrintHelp();
+        return 1;
+    }
+
+    InitDirs(argv[0]);
+    if (3 <= argc)
+        GetOptionsDB().Set<std::string>("resource-dir", argv[2]);
+
+    const std::string test = argv[1];
+    bool passed = false;
+    try {
+        if (test == "binary_round_trip" || test == "compact_round_trip" || test == "equivalence" || test == "size")
+            passed = RunGamestateTest(test);
+        else if (test == "primitives")
+            passed = Primitives();
+        else if (test == "future_version")
+            passed = FutureVersionRejected();
+        else {
+            PrintHelp();
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::cerr << test << " threw: " << e.what() << std::endl;
+        passed = false;
+    }
+
+    return passed ? 0 : 1;
+}